@@ -18,26 +18,16 @@ int main(void) {
     LED0_ON();
     LED1_OFF();
 
-    key_press_t key = KEY_NO_PRESS;
+    static const char *const key_name[] = {"", "KEY0", "KEY1", "Wake Up"};
+    static const char *const event_name[] = {"Pressed", "Released",
+                                             "Long Pressed", "Double Clicked"};
+    key_event_t event;
     uint8_t count = 0;
 
     while (1) {
-        key = key_scan(0);
-        switch (key) {
-            case WKUP_PRESS: {
-                printf("Wake Up Pressed. \r\n");
-            } break;
-
-            case KEY0_PRESS: {
-                printf("KEY0 Pressed. \r\n");
-            } break;
-
-            case KEY1_PRESS: {
-                printf("KEY1 Pressed. \r\n");
-            } break;
-
-            default: {
-            } break;
+        while (key_get_event(&event)) {
+            printf("%s %s. \r\n", key_name[event.key],
+                   event_name[event.type]);
         }
 
         if (count == 100) {
@@ -49,6 +39,9 @@ int main(void) {
             count = 0;
         }
 
+        /* 输出TRACE_LOG记录的二进制日志 */
+        trace_flush();
+
         ++count;
         delay_ms(10);
     }
@@ -0,0 +1,116 @@
+/**
+ * @file    adc.h
+ * @author  Deadline039
+ * @brief   定时器触发的多通道ADC扫描, 循环DMA双缓冲
+ * @version 1.0
+ * @date    2026-10-18
+ *
+ * 定时器以采样率触发一次扫描, 扫描全部通道得到一帧. 循环DMA把结果写入
+ * 两块缓冲区, DMA半满和满中断各交出一块, 抽取后交给回调处理.
+ * 采集过程中CPU不参与, 只在每块结束时处理一次.
+ *
+ * 抽取: 每ADC_DECIMATION帧的同一通道求和后右移ADC_OVERSAMPLE_SHIFT位,
+ * 全部为整数运算. 抽取4^n帧并右移n位可以得到12+n位的结果.
+ *
+ * 双ADC同步模式: ADC1转换ADC_CHANNELS中的偶数项, ADC2同时转换奇数项,
+ * DMA按字传输, 帧内数据顺序与ADC_CHANNELS相同.
+ */
+
+#ifndef __ADC_H
+#define __ADC_H
+
+#include "stm32f1xx_hal.h"
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <o> 采样率(Hz) <16-100000>
+// <i> 每秒扫描的帧数. 触发定时器计数频率为1MHz, 周期取整
+#define ADC_SAMPLE_RATE      10000
+
+// <o ADC_TRIGGER> 触发源
+//      <0=>TIM3 TRGO
+//      <1=>TIM4 CC4
+// <i> TIM3也可以用于其他用途, 此时选择TIM4
+#define ADC_TRIGGER          0
+
+// <o ADC_SAMPLETIME> 采样时间
+//      <ADC_SAMPLETIME_1CYCLE_5=>1.5周期
+//      <ADC_SAMPLETIME_7CYCLES_5=>7.5周期
+//      <ADC_SAMPLETIME_13CYCLES_5=>13.5周期
+//      <ADC_SAMPLETIME_28CYCLES_5=>28.5周期
+//      <ADC_SAMPLETIME_41CYCLES_5=>41.5周期
+//      <ADC_SAMPLETIME_55CYCLES_5=>55.5周期
+//      <ADC_SAMPLETIME_71CYCLES_5=>71.5周期
+//      <ADC_SAMPLETIME_239CYCLES_5=>239.5周期
+// <i> ADC时钟12MHz, 每个通道转换时间为采样时间加12.5周期
+#define ADC_SAMPLETIME       ADC_SAMPLETIME_28CYCLES_5
+
+// <q> 双ADC同步模式
+// <i> ADC1和ADC2同时转换, 扫描时间减半. 通道数必须为偶数
+#define ADC_DUAL_MODE        0
+
+// <o> 每块帧数
+// <i> DMA缓冲区共两块, 回调需要在下一块采集完成前返回
+#define ADC_BLOCK_FRAMES     64
+
+// <o> 抽取倍数
+// <i> 每块帧数必须为抽取倍数的整数倍. 为1时直接交出DMA缓冲区
+#define ADC_DECIMATION       1
+
+// <o> 过采样右移位数 <0-8>
+#define ADC_OVERSAMPLE_SHIFT 0
+
+// <o ADC_DMA_PRIORITY> DMA优先级
+//      <DMA_PRIORITY_LOW=>低
+//      <DMA_PRIORITY_MEDIUM=>中
+//      <DMA_PRIORITY_HIGH=>高
+//      <DMA_PRIORITY_VERY_HIGH=>非常高
+#define ADC_DMA_PRIORITY     DMA_PRIORITY_HIGH
+// <o> DMA中断抢占优先级
+// <i> 块处理回调在此中断中执行
+#define ADC_DMA_IT_PREEMPT   2
+// <o> DMA中断子优先级
+#define ADC_DMA_IT_SUB       1
+
+// <<< end of configuration section >>>
+
+/**
+ * 扫描的通道, 按帧内顺序排列.
+ * 通道0~15对应PA0~PA7, PB0~PB1, PC0~PC5. PA0和PC5为按键
+ */
+#define ADC_CHANNELS                                                           \
+    ADC_CHANNEL_1, ADC_CHANNEL_2, ADC_CHANNEL_3, ADC_CHANNEL_4,                \
+        ADC_CHANNEL_5, ADC_CHANNEL_6, ADC_CHANNEL_7, ADC_CHANNEL_8
+/* 通道数, 与ADC_CHANNELS一致 */
+#define ADC_CHANNEL_NUM       8
+
+/* 触发源 */
+#define ADC_TRIGGER_TIM3_TRGO 0
+#define ADC_TRIGGER_TIM4_CC4  1
+
+/* 每块抽取后的帧数 */
+#define ADC_BLOCK_OUT_FRAMES  (ADC_BLOCK_FRAMES / ADC_DECIMATION)
+
+/**
+ * @brief 块处理回调, 在DMA中断中调用
+ *
+ * @param data 抽取后的数据, 第f帧第k个通道为data[f * ADC_CHANNEL_NUM + k]
+ * @param frames 帧数, 为ADC_BLOCK_OUT_FRAMES
+ * @note 需要在下一块采集完成前返回, 返回后数据会被覆盖
+ */
+typedef void (*adc_block_callback_t)(const uint16_t *data, uint32_t frames);
+
+/**
+ * @brief ADC采集统计
+ */
+typedef struct {
+    uint32_t blocks;   /*!< 处理的块数 */
+    uint32_t overruns; /*!< 处理完成前DMA已覆盖该块的次数 */
+} adc_stats_t;
+
+void adc_init(adc_block_callback_t callback);
+void adc_start(void);
+void adc_stop(void);
+void adc_get_stats(adc_stats_t *stats);
+
+#endif /* __ADC_H */
@@ -13,11 +13,19 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "adc.h"
+#include "can.h"
+#include "crc32.h"
 #include "delay.h"
+#include "i2c.h"
 #include "key.h"
+#include "kv.h"
 #include "led.h"
+#include "spi.h"
 #include "stm32f1xx_hal.h"
+#include "trace_log.h"
 #include "uart.h"
+#include "uart_frame.h"
 
 void bsp_init(void);
 
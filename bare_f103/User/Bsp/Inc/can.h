@@ -0,0 +1,137 @@
+/**
+ * @file    can.h
+ * @author  Deadline039
+ * @brief   CAN收发队列和过滤器分配
+ * @version 1.0
+ * @date    2026-10-18
+ *
+ * 接收: 两个硬件FIFO的中断把报文按过滤器所属的接收类别放入各类别的
+ * 软件队列, 中断只写入, 任务只读出, 不需要关中断.
+ * 不同频率的报文分到不同类别, 高频报文不会挤掉其他报文.
+ *
+ * 发送: 报文按仲裁优先级(ID越小越优先)放入软件队列, 同ID的报文保持提交
+ * 顺序. 三个发送邮箱有空时在发送完成中断中从队列补充.
+ *
+ * 过滤器: `can_filter_add`登记ID和掩码, 按类型打包到14个过滤器组:
+ * 标准帧单个ID每组4个, 标准帧ID加掩码每组2个,
+ * 扩展帧单个ID每组2个, 扩展帧ID加掩码每组1个.
+ *
+ * 总线关闭后由硬件自动恢复, 错误和丢弃计入统计.
+ */
+
+#ifndef __CAN_H
+#define __CAN_H
+
+#include "stm32f1xx_hal.h"
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <o CAN_BAUDRATE> 波特率
+//      <1000000=>1Mbit/s
+//      <500000=>500kbit/s
+//      <250000=>250kbit/s
+//      <125000=>125kbit/s
+// <i> 每位12个时间份额, 采样点75%
+#define CAN_BAUDRATE          1000000
+
+// <o CAN_WORK_MODE> 工作模式
+//      <CAN_MODE_NORMAL=>正常
+//      <CAN_MODE_LOOPBACK=>回环
+//      <CAN_MODE_SILENT_LOOPBACK=>静默回环
+// <i> 回环模式下发送的报文直接被自己接收, 不需要连接总线
+#define CAN_WORK_MODE         CAN_MODE_NORMAL
+
+// <o CAN_PIN_REMAP> 引脚
+//      <0=>PA11(RX) PA12(TX)
+//      <2=>PB8(RX) PB9(TX)
+// <i> PA11和PA12与USB共用
+#define CAN_PIN_REMAP         0
+
+// <o> 接收类别数 <1-8>
+#define CAN_RX_CLASS_NUM      4
+
+// <o> 每个接收类别的队列长度(必须为2的幂次方)
+#define CAN_RX_QUEUE_SIZE     32
+
+// <o> 发送队列长度 <1-255>
+// <i> 不含已经放入发送邮箱的报文
+#define CAN_TX_QUEUE_SIZE     32
+
+// <o> 中断抢占优先级
+// <i> 发送, 接收和错误中断使用相同的优先级, 互相不会打断
+#define CAN_IT_PREEMPT        2
+// <o> 中断子优先级
+#define CAN_IT_SUB            0
+
+// <<< end of configuration section >>>
+
+/* 过滤器登记标志 */
+#define CAN_FILTER_FLAG_EXT   0x01U /* 扩展帧, 否则为标准帧 */
+#define CAN_FILTER_FLAG_FIFO1 0x02U /* 放入FIFO1, 否则为FIFO0 */
+
+/* 过滤器组数 */
+#define CAN_FILTER_BANKS      14U
+/* 最多登记的过滤器数, 全部为标准帧单个ID时 */
+#define CAN_FILTER_MAX        (CAN_FILTER_BANKS * 4U)
+
+/* 标准帧和扩展帧ID的有效位 */
+#define CAN_STD_ID_MASK       0x7FFU
+#define CAN_EXT_ID_MASK       0x1FFFFFFFU
+
+/**
+ * @brief CAN报文
+ */
+typedef struct {
+    uint32_t id;     /*!< 标准帧11位, 扩展帧29位 */
+    uint8_t ide;     /*!< 1: 扩展帧; 0: 标准帧 */
+    uint8_t rtr;     /*!< 1: 远程帧; 0: 数据帧 */
+    uint8_t dlc;     /*!< 数据长度 <0-8> */
+    uint8_t fifo;    /*!< 接收时所在的硬件FIFO */
+    uint8_t data[8]; /*!< 数据 */
+} can_frame_t;
+
+/**
+ * @brief 接收回调, 在接收中断中调用
+ *
+ * @param rx_class 收到报文的接收类别, 报文已放入该类别的队列
+ * @note 一次中断中同一类别收到多帧时只调用一次. 可以在此通知处理任务
+ */
+typedef void (*can_rx_callback_t)(uint32_t rx_class);
+
+/**
+ * @brief CAN统计
+ */
+typedef struct {
+    uint32_t rx_frames;     /*!< 放入接收队列的报文数 */
+    uint32_t rx_drops;      /*!< 接收队列满丢弃的报文数 */
+    uint32_t rx_overruns;   /*!< 硬件FIFO溢出次数, 溢出时丢失报文 */
+    uint32_t tx_frames;     /*!< 发送成功的报文数 */
+    uint32_t tx_drops;      /*!< 发送队列满丢弃的报文数 */
+    uint32_t tx_aborts;     /*!< 已放入发送邮箱但被中止的报文数 */
+    uint32_t bus_errors;    /*!< 总线错误(位, 格式, 填充, 应答, CRC)次数 */
+    uint32_t error_passive; /*!< 进入错误被动状态的次数 */
+    uint32_t bus_off;       /*!< 总线关闭的次数 */
+    uint32_t tx_queue_peak; /*!< 发送队列最大报文数 */
+    uint32_t tec;           /*!< 当前发送错误计数, 不清零 */
+    uint32_t rec;           /*!< 当前接收错误计数, 不清零 */
+} can_stats_t;
+
+extern CAN_HandleTypeDef can1_handle;
+
+void can_init(void);
+void can_start(void);
+void can_stop(void);
+
+uint32_t can_filter_add(uint32_t id, uint32_t mask, uint32_t flags,
+                        uint32_t rx_class);
+void can_filter_reset(void);
+
+void can_rx_set_callback(uint32_t rx_class, can_rx_callback_t callback);
+uint32_t can_receive(uint32_t rx_class, can_frame_t *frame);
+uint32_t can_rx_count(uint32_t rx_class);
+
+uint32_t can_send(const can_frame_t *frame);
+
+void can_get_stats(can_stats_t *stats, uint32_t reset);
+
+#endif /* __CAN_H */
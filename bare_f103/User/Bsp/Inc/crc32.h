@@ -0,0 +1,63 @@
+/**
+ * @file    crc32.h
+ * @author  Deadline039
+ * @brief   CRC32计算, 使用硬件CRC单元, 软件查表兜底
+ * @version 1.0
+ * @date    2026-10-18
+ *
+ * 提供两种CRC:
+ * - crc32_calc: 标准CRC-32(与zlib, Python的binascii.crc32相同),
+ *   适用于任意字节流. 硬件CRC单元按32位字高位在前计算, 不支持输入输出反转,
+ *   由CPU逐字位反转后写入, 不足4字节的部分用软件计算.
+ * - crc32_word_calc: CRC单元的原生结果(CRC-32/MPEG-2, 按小端32位字输入),
+ *   只适用于4字节对齐的数据, 如Flash数据块. 数据较长时由DMA写入CRC单元.
+ *   DMA无法对数据做位反转, 因此标准CRC-32只能由CPU写入.
+ *
+ * CRC单元被占用(其他任务或中断正在计算)或未初始化时自动使用软件计算,
+ * 结果相同. 软件实现不依赖硬件, 可以直接在上位机编译.
+ */
+
+#ifndef __CRC32_H
+#define __CRC32_H
+
+#include <stdint.h>
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <e> 使用硬件CRC单元
+// <i> 关闭后全部使用软件查表计算
+#define CRC32_USE_HW      1
+
+// <e> 使用DMA写入CRC单元
+// <i> 只用于crc32_word_calc. 使用DMA2通道1, 存储器到存储器传输
+#define CRC32_USE_DMA     1
+
+// <o> 使用DMA的最短长度(byte)
+// <i> 短数据配置DMA的开销大于CPU写入
+#define CRC32_DMA_MIN_LEN 256
+
+// </e>
+
+// </e>
+
+// <q> 性能测试
+// <i> 提供crc32_benchmark, 用DWT周期计数器测量每字节耗费的周期数
+#define CRC32_BENCHMARK   0
+
+// <<< end of configuration section >>>
+
+#define CRC32_DMA_CHANNEL DMA2_Channel1
+
+void crc32_init(void);
+
+uint32_t crc32_calc(const void *data, uint32_t len);
+uint32_t crc32_soft_update(uint32_t crc, const void *data, uint32_t len);
+
+uint32_t crc32_word_calc(const uint32_t *data, uint32_t nwords);
+uint32_t crc32_word_soft(const uint32_t *data, uint32_t nwords);
+
+#if (CRC32_BENCHMARK == 1)
+void crc32_benchmark(void);
+#endif /* CRC32_BENCHMARK == 1 */
+
+#endif /* __CRC32_H */
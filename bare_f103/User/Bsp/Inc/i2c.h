@@ -0,0 +1,178 @@
+/**
+ * @file    i2c.h
+ * @author  Deadline039
+ * @brief   I2C DMA传输队列
+ * @version 1.0
+ * @date    2026-10-18
+ *
+ * 每条I2C总线一个传输队列, 多个任务提交的寄存器读写按提交顺序依次执行.
+ * 寄存器地址由中断发送, 数据由DMA收发(只读1字节时用中断),
+ * 一次传输完成后在中断中直接启动下一次, CPU只负责启动和结束.
+ *
+ * 完成方式:
+ * - `i2c_transfer`: 等待传输完成. FreeRTOS中挂起任务, 由中断直接唤醒
+ * - `i2c_submit`: 只入队, 完成后在中断中调用回调函数, 裸机中使用
+ *
+ * 总线错误, 仲裁丢失或等待超时后, 先输出最多9个SCL时钟让从机释放SDA,
+ * 再产生STOP并复位I2C外设.
+ */
+
+#ifndef __I2C_H
+#define __I2C_H
+
+#include "stm32f1xx_hal.h"
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <e> 启用I2C1
+// <i> 使用DMA1通道6(发送)和通道7(接收), 与串口2的DMA冲突
+// ==================
+
+#define I2C1_ENABLE 0
+
+#if (I2C1_ENABLE == 1)
+
+extern I2C_HandleTypeDef i2c1_handle;
+
+//  <o> I2C1时钟频率(Hz) <1-400000>
+//  <i> 超过100000时为快速模式
+#define I2C1_SPEED             400000
+//  <o I2C1_DUTY_CYCLE> I2C1快速模式占空比
+//      <I2C_DUTYCYCLE_2=>Tlow/Thigh = 2
+//      <I2C_DUTYCYCLE_16_9=>Tlow/Thigh = 16/9
+#define I2C1_DUTY_CYCLE        I2C_DUTYCYCLE_2
+//  <o I2C1_DMA_PRIORITY> I2C1 DMA优先级
+//      <DMA_PRIORITY_LOW=>低
+//      <DMA_PRIORITY_MEDIUM=>中
+//      <DMA_PRIORITY_HIGH=>高
+//      <DMA_PRIORITY_VERY_HIGH=>非常高
+#define I2C1_DMA_PRIORITY      DMA_PRIORITY_MEDIUM
+//  <o> I2C1中断抢占优先级
+//  <i> 事件, 错误和DMA中断使用相同的优先级, 互相不会打断
+#define I2C1_IT_PREEMPT        2
+//  <o> I2C1中断子优先级
+#define I2C1_IT_SUB            0
+
+/* I2C1 SCL GPIO */
+#define I2C1_SCL_GPIO_PORT     GPIOB
+#define I2C1_SCL_GPIO_ENABLE() __HAL_RCC_GPIOB_CLK_ENABLE()
+#define I2C1_SCL_GPIO_PIN      GPIO_PIN_6
+/* I2C1 SDA GPIO */
+#define I2C1_SDA_GPIO_PORT     GPIOB
+#define I2C1_SDA_GPIO_ENABLE() __HAL_RCC_GPIOB_CLK_ENABLE()
+#define I2C1_SDA_GPIO_PIN      GPIO_PIN_7
+
+#endif /* I2C1_ENABLE == 1 */
+
+// </e>
+
+// <e> 启用I2C2
+// <i> 使用DMA1通道4(发送)和通道5(接收), 与串口1和SPI2的DMA冲突.
+// <i> 引脚与串口3相同
+// ==================
+
+#define I2C2_ENABLE 0
+
+#if (I2C2_ENABLE == 1)
+
+extern I2C_HandleTypeDef i2c2_handle;
+
+//  <o> I2C2时钟频率(Hz) <1-400000>
+//  <i> 超过100000时为快速模式
+#define I2C2_SPEED             400000
+//  <o I2C2_DUTY_CYCLE> I2C2快速模式占空比
+//      <I2C_DUTYCYCLE_2=>Tlow/Thigh = 2
+//      <I2C_DUTYCYCLE_16_9=>Tlow/Thigh = 16/9
+#define I2C2_DUTY_CYCLE        I2C_DUTYCYCLE_2
+//  <o I2C2_DMA_PRIORITY> I2C2 DMA优先级
+//      <DMA_PRIORITY_LOW=>低
+//      <DMA_PRIORITY_MEDIUM=>中
+//      <DMA_PRIORITY_HIGH=>高
+//      <DMA_PRIORITY_VERY_HIGH=>非常高
+#define I2C2_DMA_PRIORITY      DMA_PRIORITY_MEDIUM
+//  <o> I2C2中断抢占优先级
+//  <i> 事件, 错误和DMA中断使用相同的优先级, 互相不会打断
+#define I2C2_IT_PREEMPT        2
+//  <o> I2C2中断子优先级
+#define I2C2_IT_SUB            0
+
+/* I2C2 SCL GPIO */
+#define I2C2_SCL_GPIO_PORT     GPIOB
+#define I2C2_SCL_GPIO_ENABLE() __HAL_RCC_GPIOB_CLK_ENABLE()
+#define I2C2_SCL_GPIO_PIN      GPIO_PIN_10
+/* I2C2 SDA GPIO */
+#define I2C2_SDA_GPIO_PORT     GPIOB
+#define I2C2_SDA_GPIO_ENABLE() __HAL_RCC_GPIOB_CLK_ENABLE()
+#define I2C2_SDA_GPIO_PIN      GPIO_PIN_11
+
+#endif /* I2C2_ENABLE == 1 */
+
+// </e>
+
+// <o> 传输队列长度(必须为2的幂次方)
+// <i> 每条总线最多排队的传输数, 不含正在进行的传输
+#define I2C_QUEUE_SIZE   8
+
+// <q> 使用FreeRTOS
+// <i> 开启后i2c_transfer挂起任务等待, 由中断通知.
+// <i> 中断的抢占优先级不能高于configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY
+#define I2C_USE_FREERTOS 0
+
+// <<< end of configuration section >>>
+
+/**
+ * @brief 传输状态
+ */
+typedef enum {
+    I2C_XFER_IDLE = 0U, /*!< 未提交 */
+    I2C_XFER_QUEUED,    /*!< 在队列中等待 */
+    I2C_XFER_ACTIVE,    /*!< 正在传输 */
+    I2C_XFER_DONE,      /*!< 传输完成 */
+    I2C_XFER_NACK,      /*!< 从机无应答 */
+    I2C_XFER_ERROR,     /*!< 总线错误, 仲裁丢失或DMA错误, 已恢复总线 */
+    I2C_XFER_TIMEOUT,   /*!< 传输中等待超时, 已中止并恢复总线 */
+    I2C_XFER_CANCELLED  /*!< 等待超时, 未开始传输就被取消 */
+} i2c_xfer_status_t;
+
+typedef struct i2c_xfer i2c_xfer_t;
+
+/**
+ * @brief 传输完成回调, 一般在中断中调用
+ *
+ * @param xfer 完成的传输, 可以在回调中重新提交
+ * @note 等待超时被中止的传输在调用i2c_transfer的任务中回调
+ */
+typedef void (*i2c_callback_t)(i2c_xfer_t *xfer);
+
+/**
+ * @brief I2C寄存器读写, 提交后到完成前不能修改或释放
+ */
+struct i2c_xfer {
+    I2C_HandleTypeDef *hi2c; /*!< 所在总线 */
+    uint16_t dev_addr;       /*!< 7位从机地址, 不含读写位 */
+    uint16_t reg;            /*!< 寄存器地址 */
+    uint8_t reg_size;        /*!< 寄存器地址长度: 0, 1或2, 高字节在前 */
+    uint8_t read;            /*!< 1: 读; 0: 写 */
+    uint16_t len;            /*!< 数据长度, 读时不能为0 */
+    void *buf;               /*!< 数据 */
+    i2c_callback_t callback; /*!< 完成回调, 可以为NULL */
+    void *arg;               /*!< 回调参数 */
+
+    __IO i2c_xfer_status_t status; /*!< 传输状态 */
+    uint32_t error;                /*!< HAL错误码 */
+    void *__IO waiter;             /*!< 等待完成的任务 */
+};
+
+void i2c_bus_init(I2C_HandleTypeDef *hi2c);
+
+uint32_t i2c_submit(i2c_xfer_t *xfer);
+i2c_xfer_status_t i2c_transfer(i2c_xfer_t *xfer, uint32_t timeout);
+i2c_xfer_status_t i2c_mem_read(I2C_HandleTypeDef *hi2c, uint16_t dev_addr,
+                               uint16_t reg, uint8_t reg_size, void *buf,
+                               uint16_t len, uint32_t timeout);
+i2c_xfer_status_t i2c_mem_write(I2C_HandleTypeDef *hi2c, uint16_t dev_addr,
+                                uint16_t reg, uint8_t reg_size,
+                                const void *buf, uint16_t len,
+                                uint32_t timeout);
+
+#endif /* __I2C_H */
@@ -16,10 +16,34 @@ extern "C" {
 #include <stdint.h>
 #include <stdlib.h>
 
+/**
+ * 生产者和消费者位于不同的执行上下文(如中断和任务)时, 读写指针的更新必须
+ * 在数据访问之后才能被对端看到. 启用后使用C11内存屏障(Cortex-M上为DMB)保证
+ * 该顺序; 仅在同一上下文中使用时可以关闭.
+ */
+#ifndef RING_FIFO_USE_BARRIER
+#define RING_FIFO_USE_BARRIER 1
+#endif /* RING_FIFO_USE_BARRIER */
+
+#if (RING_FIFO_USE_BARRIER == 1)
+#include <stdatomic.h>
+
+/* 读取对端指针后使用, 保证之后对缓冲区的访问不会提前 */
+#define RING_FIFO_ACQUIRE() atomic_thread_fence(memory_order_acquire)
+/* 更新本端指针前使用, 保证之前对缓冲区的访问已经完成 */
+#define RING_FIFO_RELEASE() atomic_thread_fence(memory_order_release)
+#else /* RING_FIFO_USE_BARRIER == 1 */
+#define RING_FIFO_ACQUIRE()
+#define RING_FIFO_RELEASE()
+#endif /* RING_FIFO_USE_BARRIER == 1 */
+
+/* 判断n是否为2的幂次方, 可用于#if做编译期检查 */
+#define RING_FIFO_IS_POW2(n) (((n) != 0) && (((n) & ((n) - 1)) == 0))
+
 /* ring type */
 enum ring_fifo_type {
-    RF_TYPE_FRAME,
-    RF_TYPE_STREAM
+    RF_TYPE_FRAME, /* 帧模式, 每帧前有4字节帧长, 帧按4字节对齐存放 */
+    RF_TYPE_STREAM /* 流模式 */
 };
 
 /* 环形缓冲区结构 */
@@ -32,21 +56,43 @@ typedef struct {
 
     void *buf;           /* 缓冲区指针 */
     uint32_t is_dynamic; /* 是否使用了动态内存 */
+    uint32_t is_static;  /* 句柄是否由调用者提供 */
 
     enum ring_fifo_type type; /* fifo的类型 */
 } ring_fifo_t;
 
+/* 环形缓冲区中的一段连续内存 */
+typedef struct {
+    void *buf;    /* 起始地址 */
+    uint32_t len; /* 长度(byte) */
+} ring_fifo_span_t;
+
 /**
  * @brief    初始化环形缓冲区
- * @param[in]    buf     缓冲区指针，如果为NULL，则默认使用堆内存进行分配
+ * @param[in]    buf     缓冲区指针，如果为NULL，则默认使用堆内存进行分配.
+ *                       RF_TYPE_FRAME时必须4字节对齐
  * @param[in]    size    缓冲区长度
  * @param[in]    type    fifo类型
  * @retval   执行结果
- * -         NULL    内存分配失败，或buf非NULL时指定的size不为2的幂次方
+ * -         NULL    内存分配失败，或buf非NULL时指定的size不为2的幂次方,
+ *                   或RF_TYPE_FRAME时buf未对齐
  * -         非NULL  初始化成功
  */
 ring_fifo_t *ring_fifo_init(void *buf, uint32_t size, enum ring_fifo_type type);
 
+/**
+ * @brief    使用调用者提供的句柄和缓冲区初始化环形缓冲区(不申请堆内存)
+ * @param[in]    ring    环形缓冲区句柄
+ * @param[in]    buf     缓冲区指针. RF_TYPE_FRAME时必须4字节对齐
+ * @param[in]    size    缓冲区长度, 必须为2的幂次方
+ * @param[in]    type    fifo类型
+ * @retval   执行结果
+ * -         NULL    参数错误
+ * -         非NULL  初始化成功, 即ring
+ */
+ring_fifo_t *ring_fifo_init_static(ring_fifo_t *ring, void *buf, uint32_t size,
+                                   enum ring_fifo_type type);
+
 /**
  * @brief    销毁环形缓冲区
  * @param[in]    ring    环形缓冲区句柄
@@ -73,6 +119,50 @@ uint32_t ring_fifo_write(ring_fifo_t *ring, const void *buf, uint32_t len);
  */
 uint32_t ring_fifo_read(ring_fifo_t *ring, void *buf, uint32_t len);
 
+/**
+ * @brief    获取可直接读取的数据(零拷贝, 单消费者无锁)
+ * @param[in]    ring    环形缓冲区句柄
+ * @param[out]   span    可读数据所在的两段连续内存, span[1]为回绕部分,
+ *                       不需要回绕时span[1].len为0
+ * @retval   执行结果
+ * -         可读取的长度(byte), RF_TYPE_FRAME时为队头一帧的长度
+ * @note     读完后需调用ring_fifo_read_commit出队
+ */
+uint32_t ring_fifo_read_peek(ring_fifo_t *ring, ring_fifo_span_t span[2]);
+
+/**
+ * @brief    将ring_fifo_read_peek获取的数据出队
+ * @param[in]    ring    环形缓冲区句柄
+ * @param[in]    len     出队长度(byte), RF_TYPE_FRAME时忽略, 整帧出队
+ * @retval   执行结果
+ * -         实际出队的长度(byte)
+ */
+uint32_t ring_fifo_read_commit(ring_fifo_t *ring, uint32_t len);
+
+/**
+ * @brief    预留可直接写入的空间(零拷贝, 单生产者无锁)
+ * @param[in]    ring    环形缓冲区句柄
+ * @param[in]    len     需要预留的长度(byte)
+ * @param[out]   span    预留空间所在的两段连续内存, span[1]为回绕部分,
+ *                       不需要回绕时span[1].len为0
+ * @retval   执行结果
+ * -         成功预留的长度(byte). RF_TYPE_STREAM时可能小于len,
+ *           RF_TYPE_FRAME时整帧存不下返回0
+ * @note     写完后需调用ring_fifo_write_commit入队
+ */
+uint32_t ring_fifo_write_reserve(ring_fifo_t *ring, uint32_t len,
+                                 ring_fifo_span_t span[2]);
+
+/**
+ * @brief    将ring_fifo_write_reserve预留空间中写入的数据入队
+ * @param[in]    ring    环形缓冲区句柄
+ * @param[in]    len     入队长度(byte), 不能大于预留的长度.
+ *                       RF_TYPE_FRAME时为实际的帧长
+ * @retval   执行结果
+ * -         实际入队的长度(byte)
+ */
+uint32_t ring_fifo_write_commit(ring_fifo_t *ring, uint32_t len);
+
 /**
  * @brief    环形缓冲区是否为满
  * @param[in]    ring    环形缓冲区句柄
@@ -107,6 +197,56 @@ uint32_t ring_fifo_avail(ring_fifo_t *ring);
  */
 uint32_t ring_fifo_count(ring_fifo_t *ring);
 
+/**
+ * @brief    写入一个字节(单生产者无锁), 仅用于RF_TYPE_STREAM
+ * @param[in]    ring    环形缓冲区句柄
+ * @param[in]    byte    待写入的字节
+ * @retval   执行结果
+ * -         0   缓冲区满
+ * -         1   成功
+ * @note     内联实现, 用于中断中逐字节收发
+ */
+static inline uint32_t ring_fifo_put(ring_fifo_t *ring, uint8_t byte) {
+    uint32_t head = ring->head;
+    RING_FIFO_ACQUIRE();
+    uint32_t tail = ring->tail;
+
+    if ((tail - head) >= ring->size) {
+        return 0;
+    }
+
+    ((uint8_t *)ring->buf)[tail & ring->mask] = byte;
+    RING_FIFO_RELEASE();
+    ring->tail = tail + 1;
+
+    return 1;
+}
+
+/**
+ * @brief    读出一个字节(单消费者无锁), 仅用于RF_TYPE_STREAM
+ * @param[in]    ring    环形缓冲区句柄
+ * @param[out]   byte    读出的字节
+ * @retval   执行结果
+ * -         0   缓冲区空
+ * -         1   成功
+ * @note     内联实现, 用于中断中逐字节收发
+ */
+static inline uint32_t ring_fifo_get(ring_fifo_t *ring, uint8_t *byte) {
+    uint32_t tail = ring->tail;
+    RING_FIFO_ACQUIRE();
+    uint32_t head = ring->head;
+
+    if (tail == head) {
+        return 0;
+    }
+
+    *byte = ((uint8_t *)ring->buf)[head & ring->mask];
+    RING_FIFO_RELEASE();
+    ring->head = head + 1;
+
+    return 1;
+}
+
 #ifdef __cplusplus
 }
 #endif
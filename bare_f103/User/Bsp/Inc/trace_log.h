@@ -0,0 +1,84 @@
+/**
+ * @file    trace_log.h
+ * @author  Deadline039
+ * @brief   二进制延迟格式化日志
+ * @version 1.0
+ * @date    2026-10-18
+ *
+ * 调用处只记录格式化字符串的地址和原始参数, 不在目标板上格式化.
+ * trace_flush()将二进制记录通过stdout输出, 由上位机根据ELF中的字符串还原文本.
+ * FreeRTOS工程由低优先级任务周期调用trace_flush(), 裸机工程在主循环中调用.
+ *
+ * 记录格式(小端):
+ * | 0xA5 | 参数个数 | 序号(2字节) | 时间戳(ms, 4字节) | 格式化字符串地址 |
+ * | 参数0 | ... | 参数n-1 |
+ * 每个参数占4字节.
+ *
+ * 每条记录按uart_frame封装为 | 0x00 | COBS(记录 + CRC16) | 0x00 |.
+ * printf输出的文本中没有0x00, 上位机按0x00分段, 校验通过的段为记录,
+ * 其余为文本, 二者可以在同一个串口上混合输出.
+ */
+
+#ifndef __TRACE_LOG_H
+#define __TRACE_LOG_H
+
+#include <stdint.h>
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <e> 二进制日志
+#define TRACE_LOG_ENABLE 1
+
+// <o> 日志缓冲区大小(必须为2的幂次方)
+#define TRACE_BUF_SIZE   1024
+
+// <o> 最大参数个数 <0-8>
+#define TRACE_MAX_ARGS   6
+
+// <o> 输出周期(ms)
+// <i> FreeRTOS工程中输出任务的调用周期. 周期内写入的记录需要能放入缓冲区
+#define TRACE_FLUSH_MS   10
+
+// </e>
+
+// <<< end of configuration section >>>
+
+#define TRACE_MAGIC      0xA5U
+
+#if (TRACE_LOG_ENABLE == 1)
+
+/**
+ * @brief 记录一条日志
+ *
+ * @param fmt printf格式化字符串, 必须是字符串常量
+ * @note 参数按uint32_t保存. 不支持浮点数和64位整数;
+ *       %s的参数必须指向常量字符串, 指针需强制转换为uint32_t
+ */
+#define TRACE_LOG(fmt, ...)                                                    \
+    do {                                                                       \
+        const uint32_t trace_args_[] = {0, ##__VA_ARGS__};                     \
+        trace_log_write(fmt, &trace_args_[1],                                  \
+                        sizeof(trace_args_) / sizeof(uint32_t) - 1);           \
+    } while (0)
+
+void trace_log_init(void);
+void trace_log_write(const char *fmt, const uint32_t *args, uint32_t nargs);
+uint32_t trace_flush(void);
+uint32_t trace_get_dropped(void);
+
+#else /* TRACE_LOG_ENABLE == 1 */
+
+#define TRACE_LOG(fmt, ...)                                                    \
+    do {                                                                       \
+    } while (0)
+
+#define trace_log_init()                                                       \
+    do {                                                                       \
+    } while (0)
+
+#define trace_flush()       0U
+#define trace_get_dropped() 0U
+
+#endif /* TRACE_LOG_ENABLE == 1 */
+
+#endif /* __TRACE_LOG_H */
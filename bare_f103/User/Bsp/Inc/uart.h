@@ -9,6 +9,7 @@
 #ifndef __UART_H
 #define __UART_H
 
+#include "ring_fifo.h"
 #include "stm32f1xx_hal.h"
 
 // <<< Use Configuration Wizard in Context Menu >>>
@@ -27,7 +28,8 @@ extern UART_HandleTypeDef usart1_handle;
 
 #if (USART1_USE_DMA_TX == 1)
 
-//  <o> 发送缓冲区大小
+//  <o> 发送缓冲区大小(必须为2的幂次方)
+//  <i> 发送过程中写入的数据会在当前传输完成后自动发送
 #define USART1_TX_BUF_SIZE       256
 
 //  <o USART1_DMA_TX_PRIORITY> 串口1 DMA发送优先级
@@ -54,6 +56,10 @@ extern UART_HandleTypeDef usart1_handle;
 #define USART1_RX_BUF_SIZE       256
 //  <o> 接收fifo大小(必须为2的幂次方)
 #define USART1_RX_FIFO_SZIE      2048
+//  <q> DMA直接接收到fifo
+//  <i> 循环DMA直接以fifo存储区为目标, 不使用接收缓冲区, 接收时没有CPU拷贝.
+//  <i> 启用后接收缓冲区大小无效, fifo大小不能超过32768
+#define USART1_DMA_RX_TO_FIFO    0
 
 //  <o USART1_DMA_RX_PRIORITY> 串口1 DMA接收优先级
 //      <DMA_PRIORITY_LOW=>低
@@ -70,32 +76,69 @@ extern UART_HandleTypeDef usart1_handle;
 //  <i> 串口空闲时自动将数据拷贝到fifo中
 #define USART1_USE_IDLE_IT       1
 
+//  <o> 空闲中断合并批量(byte)
+//  <i> 空闲中断时未拷贝的数据少于此值, 则关闭空闲中断, 由定时器查询DMA计数,
+//  <i> 凑够批量或达到最大延迟后再拷贝到fifo. 为0时每次空闲中断立即拷贝
+#define USART1_RX_COALESCE_BATCH 0
+//  <o> 空闲中断合并最大延迟(us)
+#define USART1_RX_COALESCE_US    1000
+
 #endif /* USART1_USE_DMA_RX == 1 */
 
 //  </e>
 
+//  <e> 中断收发
+//  <i> 未启用DMA的方向使用RXNE/TXE中断和fifo收发, 接口与DMA收发相同
+#define USART1_USE_IT 0
+
+#if (USART1_USE_IT == 1)
+
+//  <o> 中断发送fifo大小(必须为2的幂次方)
+#define USART1_IT_TX_FIFO_SIZE 256
+//  <o> 中断接收fifo大小(必须为2的幂次方)
+#define USART1_IT_RX_FIFO_SIZE 256
+
+#endif /* USART1_USE_IT == 1 */
+
+//  </e>
+
+//  <e> 接收流控(软件RTS)
+//  <i> hw_flow_ctrl包含RTS时, RTS引脚改为GPIO输出, 由软件按接收fifo水位控制:
+//  <i> fifo数据量达到高水位时RTS置高, 暂停对端发送; 读出到低水位时重新置低.
+//  <i> 硬件RTS只反映接收数据寄存器是否为空, DMA接收时不起作用
+#define USART1_RX_FLOW_CTRL 0
+
+#if (USART1_RX_FLOW_CTRL == 1)
+
+//  <o> 高水位(fifo大小的%) <1-100>
+//  <i> 在接收中断拷贝数据后检查, 高水位以上应能容纳
+//  <i> 半个DMA接收缓冲区和对端停止发送前的数据
+#define USART1_RX_HIGH_WATER 75
+//  <o> 低水位(fifo大小的%) <0-99>
+#define USART1_RX_LOW_WATER  25
+
+#endif /* USART1_RX_FLOW_CTRL == 1 */
+
+//  </e>
+
 //  <o> 串口1中断抢占优先级
-#define USART1_IT_PREEMPT        2
+#define USART1_IT_PREEMPT    2
 //  <o> 串口1子优先级
-#define USART1_IT_SUB            3
+#define USART1_IT_SUB        3
 
 /* 串口1 发送GPIO */
-#define USART1_TX_GPIO_PORT      GPIOA
-#define USART1_TX_GPIO_ENABLE()  __HAL_RCC_GPIOA_CLK_ENABLE()
-#define USART1_TX_GPIO_PIN       GPIO_PIN_9
+#define USART1_TX_GPIO_PORT  GPIOA
+#define USART1_TX_GPIO_PIN   GPIO_PIN_9
 /* 串口1 接收GPIO */
-#define USART1_RX_GPIO_PORT      GPIOA
-#define USART1_RX_GPIO_ENABLE()  __HAL_RCC_GPIOA_CLK_ENABLE()
-#define USART1_RX_GPIO_PIN       GPIO_PIN_10
+#define USART1_RX_GPIO_PORT  GPIOA
+#define USART1_RX_GPIO_PIN   GPIO_PIN_10
 
 /* 串口1 CTS GPIO */
-#define USART1_CTS_GPIO_PORT     GPIOA
-#define USART1_CTS_GPIO_ENABLE() __HAL_RCC_GPIOA_CLK_ENABLE()
-#define USART1_CTS_GPIO_PIN      GPIO_PIN_11
+#define USART1_CTS_GPIO_PORT GPIOA
+#define USART1_CTS_GPIO_PIN  GPIO_PIN_11
 /* 串口1 RTS GPIO */
-#define USART1_RTS_GPIO_PORT     GPIOA
-#define USART1_RTS_GPIO_ENABLE() __HAL_RCC_GPIOA_CLK_ENABLE()
-#define USART1_RTS_GPIO_PIN      GPIO_PIN_12
+#define USART1_RTS_GPIO_PORT GPIOA
+#define USART1_RTS_GPIO_PIN  GPIO_PIN_12
 
 #endif /* USART1_ENABLE == 1 */
 
@@ -115,7 +158,8 @@ extern UART_HandleTypeDef usart2_handle;
 
 #if (USART2_USE_DMA_TX == 1)
 
-//  <o> 发送缓冲区大小
+//  <o> 发送缓冲区大小(必须为2的幂次方)
+//  <i> 发送过程中写入的数据会在当前传输完成后自动发送
 #define USART2_TX_BUF_SIZE       128
 
 //  <o USART2_DMA_TX_PRIORITY> 串口2 DMA发送优先级
@@ -142,6 +186,10 @@ extern UART_HandleTypeDef usart2_handle;
 #define USART2_RX_BUF_SIZE       256
 //  <o> 接收fifo大小(必须为2的幂次方)
 #define USART2_RX_FIFO_SZIE      2048
+//  <q> DMA直接接收到fifo
+//  <i> 循环DMA直接以fifo存储区为目标, 不使用接收缓冲区, 接收时没有CPU拷贝.
+//  <i> 启用后接收缓冲区大小无效, fifo大小不能超过32768
+#define USART2_DMA_RX_TO_FIFO    0
 
 //  <o USART2_DMA_RX_PRIORITY> 串口2 DMA接收优先级
 //      <DMA_PRIORITY_LOW=>低
@@ -158,32 +206,69 @@ extern UART_HandleTypeDef usart2_handle;
 //  <i> 串口空闲时自动将数据拷贝到fifo中
 #define USART2_USE_IDLE_IT       1
 
+//  <o> 空闲中断合并批量(byte)
+//  <i> 空闲中断时未拷贝的数据少于此值, 则关闭空闲中断, 由定时器查询DMA计数,
+//  <i> 凑够批量或达到最大延迟后再拷贝到fifo. 为0时每次空闲中断立即拷贝
+#define USART2_RX_COALESCE_BATCH 0
+//  <o> 空闲中断合并最大延迟(us)
+#define USART2_RX_COALESCE_US    1000
+
 #endif /* USART2_USE_DMA_RX == 1 */
 
 //  </e>
 
+//  <e> 中断收发
+//  <i> 未启用DMA的方向使用RXNE/TXE中断和fifo收发, 接口与DMA收发相同
+#define USART2_USE_IT 0
+
+#if (USART2_USE_IT == 1)
+
+//  <o> 中断发送fifo大小(必须为2的幂次方)
+#define USART2_IT_TX_FIFO_SIZE 256
+//  <o> 中断接收fifo大小(必须为2的幂次方)
+#define USART2_IT_RX_FIFO_SIZE 256
+
+#endif /* USART2_USE_IT == 1 */
+
+//  </e>
+
+//  <e> 接收流控(软件RTS)
+//  <i> hw_flow_ctrl包含RTS时, RTS引脚改为GPIO输出, 由软件按接收fifo水位控制:
+//  <i> fifo数据量达到高水位时RTS置高, 暂停对端发送; 读出到低水位时重新置低.
+//  <i> 硬件RTS只反映接收数据寄存器是否为空, DMA接收时不起作用
+#define USART2_RX_FLOW_CTRL 0
+
+#if (USART2_RX_FLOW_CTRL == 1)
+
+//  <o> 高水位(fifo大小的%) <1-100>
+//  <i> 在接收中断拷贝数据后检查, 高水位以上应能容纳
+//  <i> 半个DMA接收缓冲区和对端停止发送前的数据
+#define USART2_RX_HIGH_WATER 75
+//  <o> 低水位(fifo大小的%) <0-99>
+#define USART2_RX_LOW_WATER  25
+
+#endif /* USART2_RX_FLOW_CTRL == 1 */
+
+//  </e>
+
 //  <o> 串口2中断抢占优先级
-#define USART2_IT_PREEMPT        2
+#define USART2_IT_PREEMPT    2
 //  <o> 串口2子优先级
-#define USART2_IT_SUB            3
+#define USART2_IT_SUB        3
 
 /* 串口2 发送GPIO */
-#define USART2_TX_GPIO_PORT      GPIOA
-#define USART2_TX_GPIO_ENABLE()  __HAL_RCC_GPIOA_CLK_ENABLE()
-#define USART2_TX_GPIO_PIN       GPIO_PIN_2
+#define USART2_TX_GPIO_PORT  GPIOA
+#define USART2_TX_GPIO_PIN   GPIO_PIN_2
 /* 串口2 接收GPIO */
-#define USART2_RX_GPIO_PORT      GPIOA
-#define USART2_RX_GPIO_ENABLE()  __HAL_RCC_GPIOA_CLK_ENABLE()
-#define USART2_RX_GPIO_PIN       GPIO_PIN_3
+#define USART2_RX_GPIO_PORT  GPIOA
+#define USART2_RX_GPIO_PIN   GPIO_PIN_3
 
 /* 串口2 CTS GPIO */
-#define USART2_CTS_GPIO_PORT     GPIOA
-#define USART2_CTS_GPIO_ENABLE() __HAL_RCC_GPIOA_CLK_ENABLE()
-#define USART2_CTS_GPIO_PIN      GPIO_PIN_0
+#define USART2_CTS_GPIO_PORT GPIOA
+#define USART2_CTS_GPIO_PIN  GPIO_PIN_0
 /* 串口2 RTS GPIO */
-#define USART2_RTS_GPIO_PORT     GPIOA
-#define USART2_RTS_GPIO_ENABLE() __HAL_RCC_GPIOA_CLK_ENABLE()
-#define USART2_RTS_GPIO_PIN      GPIO_PIN_1
+#define USART2_RTS_GPIO_PORT GPIOA
+#define USART2_RTS_GPIO_PIN  GPIO_PIN_1
 
 #endif /* USART2_ENABLE == 1 */
 
@@ -203,7 +288,8 @@ extern UART_HandleTypeDef usart3_handle;
 
 #if (USART3_USE_DMA_TX == 1)
 
-//  <o> 发送缓冲区大小
+//  <o> 发送缓冲区大小(必须为2的幂次方)
+//  <i> 发送过程中写入的数据会在当前传输完成后自动发送
 #define USART3_TX_BUF_SIZE       128
 
 //  <o USART3_DMA_TX_PRIORITY> 串口3 DMA发送优先级
@@ -230,6 +316,10 @@ extern UART_HandleTypeDef usart3_handle;
 #define USART3_RX_BUF_SIZE       256
 //  <o> 接收fifo大小(必须为2的幂次方)
 #define USART3_RX_FIFO_SZIE      2048
+//  <q> DMA直接接收到fifo
+//  <i> 循环DMA直接以fifo存储区为目标, 不使用接收缓冲区, 接收时没有CPU拷贝.
+//  <i> 启用后接收缓冲区大小无效, fifo大小不能超过32768
+#define USART3_DMA_RX_TO_FIFO    0
 
 //  <o USART3_DMA_RX_PRIORITY> 串口3 DMA接收优先级
 //      <DMA_PRIORITY_LOW=>低
@@ -246,32 +336,69 @@ extern UART_HandleTypeDef usart3_handle;
 //  <i> 串口空闲时自动将数据拷贝到fifo中
 #define USART3_USE_IDLE_IT       1
 
+//  <o> 空闲中断合并批量(byte)
+//  <i> 空闲中断时未拷贝的数据少于此值, 则关闭空闲中断, 由定时器查询DMA计数,
+//  <i> 凑够批量或达到最大延迟后再拷贝到fifo. 为0时每次空闲中断立即拷贝
+#define USART3_RX_COALESCE_BATCH 0
+//  <o> 空闲中断合并最大延迟(us)
+#define USART3_RX_COALESCE_US    1000
+
 #endif /* USART3_USE_DMA_RX == 1 */
 
 //  </e>
 
+//  <e> 中断收发
+//  <i> 未启用DMA的方向使用RXNE/TXE中断和fifo收发, 接口与DMA收发相同
+#define USART3_USE_IT 0
+
+#if (USART3_USE_IT == 1)
+
+//  <o> 中断发送fifo大小(必须为2的幂次方)
+#define USART3_IT_TX_FIFO_SIZE 256
+//  <o> 中断接收fifo大小(必须为2的幂次方)
+#define USART3_IT_RX_FIFO_SIZE 256
+
+#endif /* USART3_USE_IT == 1 */
+
+//  </e>
+
+//  <e> 接收流控(软件RTS)
+//  <i> hw_flow_ctrl包含RTS时, RTS引脚改为GPIO输出, 由软件按接收fifo水位控制:
+//  <i> fifo数据量达到高水位时RTS置高, 暂停对端发送; 读出到低水位时重新置低.
+//  <i> 硬件RTS只反映接收数据寄存器是否为空, DMA接收时不起作用
+#define USART3_RX_FLOW_CTRL 0
+
+#if (USART3_RX_FLOW_CTRL == 1)
+
+//  <o> 高水位(fifo大小的%) <1-100>
+//  <i> 在接收中断拷贝数据后检查, 高水位以上应能容纳
+//  <i> 半个DMA接收缓冲区和对端停止发送前的数据
+#define USART3_RX_HIGH_WATER 75
+//  <o> 低水位(fifo大小的%) <0-99>
+#define USART3_RX_LOW_WATER  25
+
+#endif /* USART3_RX_FLOW_CTRL == 1 */
+
+//  </e>
+
 //  <o> 串口3中断抢占优先级
-#define USART3_IT_PREEMPT        2
+#define USART3_IT_PREEMPT    2
 //  <o> 串口3子优先级
-#define USART3_IT_SUB            3
+#define USART3_IT_SUB        3
 
 /* 串口3 发送GPIO */
-#define USART3_TX_GPIO_PORT      GPIOB
-#define USART3_TX_GPIO_ENABLE()  __HAL_RCC_GPIOB_CLK_ENABLE()
-#define USART3_TX_GPIO_PIN       GPIO_PIN_10
+#define USART3_TX_GPIO_PORT  GPIOB
+#define USART3_TX_GPIO_PIN   GPIO_PIN_10
 /* 串口3 接收GPIO */
-#define USART3_RX_GPIO_PORT      GPIOB
-#define USART3_RX_GPIO_ENABLE()  __HAL_RCC_GPIOB_CLK_ENABLE()
-#define USART3_RX_GPIO_PIN       GPIO_PIN_11
+#define USART3_RX_GPIO_PORT  GPIOB
+#define USART3_RX_GPIO_PIN   GPIO_PIN_11
 
 /* 串口3 CTS GPIO */
-#define USART3_CTS_GPIO_PORT     GPIOB
-#define USART3_CTS_GPIO_ENABLE() __HAL_RCC_GPIOB_CLK_ENABLE()
-#define USART3_CTS_GPIO_PIN      GPIO_PIN_13
+#define USART3_CTS_GPIO_PORT GPIOB
+#define USART3_CTS_GPIO_PIN  GPIO_PIN_13
 /* 串口3 RTS GPIO */
-#define USART3_RTS_GPIO_PORT     GPIOB
-#define USART3_RTS_GPIO_ENABLE() __HAL_RCC_GPIOB_CLK_ENABLE()
-#define USART3_RTS_GPIO_PIN      GPIO_PIN_14
+#define USART3_RTS_GPIO_PORT GPIOB
+#define USART3_RTS_GPIO_PIN  GPIO_PIN_14
 
 #endif /* USART3_ENABLE == 1 */
 
@@ -291,7 +418,8 @@ extern UART_HandleTypeDef uart4_handle;
 
 #if (UART4_USE_DMA_TX == 1)
 
-//  <o> 发送缓冲区大小
+//  <o> 发送缓冲区大小(必须为2的幂次方)
+//  <i> 发送过程中写入的数据会在当前传输完成后自动发送
 #define UART4_TX_BUF_SIZE       128
 
 //  <o UART4_DMA_TX_PRIORITY> 串口4 DMA发送优先级
@@ -318,6 +446,10 @@ extern UART_HandleTypeDef uart4_handle;
 #define UART4_RX_BUF_SIZE       256
 //  <o> 接收fifo大小(必须为2的幂次方)
 #define UART4_RX_FIFO_SZIE      2048
+//  <q> DMA直接接收到fifo
+//  <i> 循环DMA直接以fifo存储区为目标, 不使用接收缓冲区, 接收时没有CPU拷贝.
+//  <i> 启用后接收缓冲区大小无效, fifo大小不能超过32768
+#define UART4_DMA_RX_TO_FIFO    0
 
 //  <o UART4_DMA_RX_PRIORITY> 串口4 DMA接收优先级
 //      <DMA_PRIORITY_LOW=>低
@@ -334,23 +466,50 @@ extern UART_HandleTypeDef uart4_handle;
 //  <i> 串口空闲时自动将数据拷贝到fifo中
 #define UART4_USE_IDLE_IT       1
 
+//  <o> 空闲中断合并批量(byte)
+//  <i> 空闲中断时未拷贝的数据少于此值, 则关闭空闲中断, 由定时器查询DMA计数,
+//  <i> 凑够批量或达到最大延迟后再拷贝到fifo. 为0时每次空闲中断立即拷贝
+#define UART4_RX_COALESCE_BATCH 0
+//  <o> 空闲中断合并最大延迟(us)
+#define UART4_RX_COALESCE_US    1000
+
 #endif /* UART4_USE_DMA_RX == 1 */
 
 //  </e>
 
+//  <e> 中断收发
+//  <i> 未启用DMA的方向使用RXNE/TXE中断和fifo收发, 接口与DMA收发相同
+#define UART4_USE_IT 0
+
+#if (UART4_USE_IT == 1)
+
+//  <o> 中断发送fifo大小(必须为2的幂次方)
+#define UART4_IT_TX_FIFO_SIZE  256
+//  <o> 中断接收fifo大小(必须为2的幂次方)
+#define UART4_IT_RX_FIFO_SIZE  256
+
+#endif /* UART4_USE_IT == 1 */
+
+//  </e>
+
 //  <o> 串口4中断抢占优先级
-#define UART4_IT_PREEMPT       2
+#define UART4_IT_PREEMPT    2
 //  <o> 串口4子优先级
-#define UART4_IT_SUB           3
+#define UART4_IT_SUB        3
 
 /* 串口4 发送GPIO */
-#define UART4_TX_GPIO_PORT     GPIOC
-#define UART4_TX_GPIO_ENABLE() __HAL_RCC_GPIOC_CLK_ENABLE()
-#define UART4_TX_GPIO_PIN      GPIO_PIN_10
+#define UART4_TX_GPIO_PORT  GPIOC
+#define UART4_TX_GPIO_PIN   GPIO_PIN_10
 /* 串口4 接收GPIO */
-#define UART4_RX_GPIO_PORT     GPIOC
-#define UART4_RX_GPIO_ENABLE() __HAL_RCC_GPIOC_CLK_ENABLE()
-#define UART4_RX_GPIO_PIN      GPIO_PIN_11
+#define UART4_RX_GPIO_PORT  GPIOC
+#define UART4_RX_GPIO_PIN   GPIO_PIN_11
+
+/* 串口4没有CTS/RTS引脚, 不支持流控 */
+#define UART4_RX_FLOW_CTRL  0
+#define UART4_CTS_GPIO_PORT NULL
+#define UART4_CTS_GPIO_PIN  0
+#define UART4_RTS_GPIO_PORT NULL
+#define UART4_RTS_GPIO_PIN  0
 
 #endif /* UART4_ENABLE == 1 */
 
@@ -365,36 +524,182 @@ extern UART_HandleTypeDef uart4_handle;
 
 extern UART_HandleTypeDef uart5_handle;
 
+//  <e> 中断收发
+//  <i> 串口5没有DMA, 使用RXNE/TXE中断和fifo收发, 接口与DMA收发相同
+#define UART5_USE_IT 1
+
+#if (UART5_USE_IT == 1)
+
+//  <o> 中断发送fifo大小(必须为2的幂次方)
+#define UART5_IT_TX_FIFO_SIZE  256
+//  <o> 中断接收fifo大小(必须为2的幂次方)
+#define UART5_IT_RX_FIFO_SIZE  256
+
+#endif /* UART5_USE_IT == 1 */
+
+//  </e>
+
 //  <o> 串口5中断抢占优先级
-#define UART5_IT_PREEMPT       2
+#define UART5_IT_PREEMPT    2
 //  <o> 串口5子优先级
-#define UART5_IT_SUB           3
+#define UART5_IT_SUB        3
 
 /* 串口5 发送GPIO */
-#define UART5_TX_GPIO_PORT     GPIOC
-#define UART5_TX_GPIO_ENABLE() __HAL_RCC_GPIOC_CLK_ENABLE()
-#define UART5_TX_GPIO_PIN      GPIO_PIN_12
+#define UART5_TX_GPIO_PORT  GPIOC
+#define UART5_TX_GPIO_PIN   GPIO_PIN_12
 /* 串口5 接收GPIO */
-#define UART5_RX_GPIO_PORT     GPIOD
-#define UART5_RX_GPIO_ENABLE() __HAL_RCC_GPIOD_CLK_ENABLE()
-#define UART5_RX_GPIO_PIN      GPIO_PIN_2
+#define UART5_RX_GPIO_PORT  GPIOD
+#define UART5_RX_GPIO_PIN   GPIO_PIN_2
+
+/* 串口5没有DMA请求和CTS/RTS引脚 */
+#define UART5_USE_DMA_TX    0
+#define UART5_USE_DMA_RX    0
+#define UART5_RX_FLOW_CTRL  0
+#define UART5_CTS_GPIO_PORT NULL
+#define UART5_CTS_GPIO_PIN  0
+#define UART5_RTS_GPIO_PORT NULL
+#define UART5_RTS_GPIO_PIN  0
 
 #endif /* UART5_ENABLE == 1 */
 
 // </e>
 
+// <q> 使用FreeRTOS
+// <i> 开启后uart_dmarx_read_timeout等待数据时挂起任务, 由接收中断通知.
+// <i> 接收DMA中断和串口中断的抢占优先级不能高于
+// <i> configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY
+#define UART_USE_FREERTOS 0
+
+// <o> 行尾队列长度(必须为2的幂次方)
+// <i> 行模式下每个串口最多记录的未读完整行数, 队列满时相邻的行会合并读出
+#define UART_LINE_QUEUE_SIZE 16
+
+// <o> 格式化缓冲区大小(byte)
+// <i> uart_printf阻塞发送时的格式化缓冲区, 以及格式化结果跨越发送fifo末尾时
+// <i> 的临时缓冲区, 均在栈上分配. 跨越末尾且超过此长度的结果被截断
+#define UART_PRINTF_BUF_SIZE 256
+
+// <o> 写入等待时间(ms)
+// <i> FreeRTOS中多个任务写入同一串口时, 后写入的任务挂起等待前一个任务写完,
+// <i> 超时后放弃本次写入. 中断中不等待
+#define UART_TX_LOCK_TIMEOUT 100
+
+// <q> 性能测试
+// <i> 提供uart_printf_benchmark, 用DWT周期计数器测量格式化输出的耗时
+#define UART_BENCHMARK 0
+
+// <q> 统计中断耗时
+// <i> 用DWT周期计数器测量DMA回调, 合并定时器拷贝和RXNE/TXE中断处理的
+// <i> 周期数, 由uart_get_stats读出. 每次中断多读两次计数器
+#define UART_ISR_CYCLES 0
+
+// <h> 空闲中断合并定时器
+// <o> 定时器周期(us)
+// <i> 各串口的最大延迟按此周期向上取整
+#define UART_COALESCE_TICK_US    250
+// <o> 定时器中断抢占优先级
+// <i> 定时器中断中会拷贝数据到接收fifo, 应与串口中断优先级相同
+#define UART_COALESCE_IT_PREEMPT 2
+// <o> 定时器中断子优先级
+#define UART_COALESCE_IT_SUB     3
+// </h>
+
 // <<< end of configuration section >>>
 
+/* 空闲中断合并定时器 */
+#define UART_COALESCE_TIM              TIM7
+#define UART_COALESCE_TIM_CLK_ENABLE() __HAL_RCC_TIM7_CLK_ENABLE()
+#define UART_COALESCE_TIM_IRQn         TIM7_IRQn
+#define UART_COALESCE_TIM_IRQHandler   TIM7_IRQHandler
+
+/**
+ * 串口编号, 取外设地址的第10~13位, 用于按串口查表.
+ * USART1-14, USART2-1, USART3-2, UART4-3, UART5-4
+ */
+#define UART_PORT_INDEX(instance) ((((uintptr_t)(instance)) >> 10) & 0x0FU)
+#define UART_PORT_NUM             16U
+
+/**
+ * @brief 接收中断统计
+ */
+typedef struct {
+    uint32_t irqs_per_sec;  /*!< 距上次查询的平均接收中断次数(次/s) */
+    uint32_t bytes_per_irq; /*!< 距上次查询平均每次中断拷贝的字节数 */
+    uint32_t total_irqs;    /*!< 累计接收中断次数 */
+    uint32_t total_bytes;   /*!< 累计接收字节数 */
+    uint32_t deferred;      /*!< 推迟拷贝(关闭空闲中断)的次数 */
+    uint32_t flow_pauses;   /*!< 接收流控暂停对端发送的次数 */
+} uart_dmarx_irq_stats_t;
+
+/**
+ * @brief DMA发送吞吐统计
+ */
+typedef struct {
+    uint32_t bytes_per_sec; /*!< 距上次查询的平均发送速率(byte/s) */
+    uint32_t total_bytes;   /*!< 累计发送字节数 */
+    uint32_t gap_count;     /*!< 发送间隙次数(DMA空闲后重新启动传输) */
+    uint32_t gap_ms;        /*!< 累计发送间隙时长(ms) */
+} uart_dmatx_throughput_t;
+
+/**
+ * @brief 串口统计, 用于确定fifo大小和波特率
+ */
+typedef struct {
+    uint32_t rx_bytes;     /*!< 接收并写入fifo的字节数 */
+    uint32_t tx_bytes;     /*!< 发送完成的字节数 */
+    uint32_t rx_irqs;      /*!< 接收中断次数, 包括合并定时器的拷贝 */
+    uint32_t rx_dma_xfers; /*!< DMA接收半满和溢满中断次数 */
+    uint32_t tx_dma_xfers; /*!< 启动DMA发送的次数 */
+    uint32_t idle_events;  /*!< 空闲中断次数 */
+    uint32_t rx_drops;     /*!< 接收fifo满丢弃的字节数 */
+    uint32_t rx_overruns;  /*!< DMA直接接收到fifo时覆盖未读数据的次数 */
+    uint32_t tx_stalls;    /*!< 发送fifo空间不足或被占用, 写入不完整的次数 */
+    uint32_t pe_errors;    /*!< 校验错误 */
+    uint32_t ne_errors;    /*!< 噪声错误 */
+    uint32_t fe_errors;    /*!< 帧错误 */
+    uint32_t ore_errors;   /*!< 接收溢出错误 */
+    uint32_t dma_errors;   /*!< DMA传输错误 */
+    uint32_t rx_fifo_peak; /*!< 接收fifo最大数据量 */
+    uint32_t tx_fifo_peak; /*!< 发送fifo最大数据量 */
+
+    /* 以下统计需要开启UART_ISR_CYCLES, 包括被更高优先级中断打断的时间 */
+    uint32_t isr_calls;      /*!< 统计耗时的中断处理次数 */
+    uint32_t isr_cycles;     /*!< 中断处理累计周期数 */
+    uint32_t isr_cycles_max; /*!< 单次中断处理最大周期数 */
+} uart_stats_t;
+
 void uart_init(UART_HandleTypeDef *huart, uint32_t baud_rate,
                uint32_t word_length, uint32_t stop_bits, uint32_t parity,
                uint32_t hw_flow_ctrl, uint32_t mode);
 
-void uart_printf(UART_HandleTypeDef *huart, const char *__format, ...);
+uint32_t uart_printf(UART_HandleTypeDef *huart, const char *__format, ...);
 
 uint32_t uart_dmatx_write(UART_HandleTypeDef *huart, const void *data,
                           size_t len);
+uint32_t uart_dmatx_reserve(UART_HandleTypeDef *huart, uint32_t len,
+                            ring_fifo_span_t span[2]);
+uint32_t uart_dmatx_commit(UART_HandleTypeDef *huart, uint32_t len);
 uint32_t uart_dmatx_send(UART_HandleTypeDef *huart);
+uint32_t uart_dmatx_discard(UART_HandleTypeDef *huart, uint32_t len);
+uint32_t uart_tx_is_buffered(UART_HandleTypeDef *huart);
+void uart_dmatx_get_throughput(UART_HandleTypeDef *huart,
+                               uart_dmatx_throughput_t *throughput);
 
 uint32_t uart_dmarx_read(UART_HandleTypeDef *huart, void *buf, size_t len);
+uint32_t uart_dmarx_read_timeout(UART_HandleTypeDef *huart, void *buf,
+                                 size_t len, size_t min_len,
+                                 uint32_t timeout);
+void uart_dmarx_get_irq_stats(UART_HandleTypeDef *huart,
+                              uart_dmarx_irq_stats_t *stats);
+void uart_dmarx_set_delim(UART_HandleTypeDef *huart, int32_t delim);
+uint32_t uart_readline(UART_HandleTypeDef *huart, void *buf, size_t len,
+                       uint32_t timeout);
+
+void uart_get_stats(UART_HandleTypeDef *huart, uart_stats_t *stats,
+                    uint32_t reset);
+
+#if (UART_BENCHMARK == 1)
+void uart_printf_benchmark(UART_HandleTypeDef *huart);
+#endif /* UART_BENCHMARK == 1 */
 
 #endif /* __UART_H */
@@ -0,0 +1,93 @@
+/**
+ * @file    uart_frame.h
+ * @author  Deadline039
+ * @brief   串口帧封装(COBS + CRC16)
+ * @version 1.0
+ * @date    2026-10-18
+ *
+ * 帧格式: | COBS(数据 + CRC16) | 0x00 |
+ * CRC16为CRC-16/CCITT-FALSE, 高字节在前. COBS编码后数据中不含0x00,
+ * 0x00只作为帧尾, 接收端丢失数据或收到错误数据后在下一个0x00处重新同步.
+ *
+ * 发送时直接在串口发送FIFO中编码, 不需要额外的缓冲区.
+ * 接收时由uart_frame_poll从串口接收FIFO中读取数据并解码,
+ * 校验通过的帧存入帧FIFO, 由uart_frame_read逐帧读出.
+ */
+
+#ifndef __UART_FRAME_H
+#define __UART_FRAME_H
+
+#include "ring_fifo.h"
+#include "uart.h"
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <o> 最大帧长(byte)
+// <i> 不含CRC和编码开销, 超过此长度的帧被丢弃
+#define UART_FRAME_MAX_LEN   256
+
+// <o> 接收帧FIFO大小(必须为2的幂次方)
+// <i> 每帧额外占用4字节帧长, 按4字节对齐存放
+#define UART_FRAME_FIFO_SIZE 1024
+
+// <q> CRC16校验
+#define UART_FRAME_USE_CRC   1
+
+// <<< end of configuration section >>>
+
+#define UART_FRAME_DELIM     0x00U
+
+#if (UART_FRAME_USE_CRC == 1)
+#define UART_FRAME_CRC_SIZE 2U
+#else /* UART_FRAME_USE_CRC == 1 */
+#define UART_FRAME_CRC_SIZE 0U
+#endif /* UART_FRAME_USE_CRC == 1 */
+
+/**
+ * 数据长度为len时编码后的最大长度(含帧尾).
+ * COBS每254字节增加1字节开销, 另有1字节起始码和1字节帧尾
+ */
+#define UART_FRAME_ENCODED_SIZE(len)                                           \
+    ((len) + UART_FRAME_CRC_SIZE + ((len) + UART_FRAME_CRC_SIZE) / 254U + 2U)
+
+/**
+ * @brief 帧接收统计
+ */
+typedef struct {
+    uint32_t frames;        /*!< 接收成功的帧数 */
+    uint32_t crc_errors;    /*!< CRC校验失败 */
+    uint32_t decode_errors; /*!< COBS解码失败或帧长不足 */
+    uint32_t overflows;     /*!< 超过最大帧长被丢弃的帧 */
+    uint32_t dropped;       /*!< 帧FIFO满被丢弃的帧 */
+} uart_frame_stats_t;
+
+/**
+ * @brief 帧接收句柄
+ */
+typedef struct {
+    UART_HandleTypeDef *huart; /*!< 串口句柄 */
+
+    /* 接收中的编码数据, 不含帧尾 */
+    uint8_t rx_buf[UART_FRAME_ENCODED_SIZE(UART_FRAME_MAX_LEN)];
+    uint32_t rx_len;  /*!< rx_buf中的数据长度 */
+    uint32_t discard; /*!< 帧过长, 丢弃直到下一个帧尾 */
+
+    /* 校验通过的帧 */
+    uint32_t fifo_buf[UART_FRAME_FIFO_SIZE / sizeof(uint32_t)];
+    ring_fifo_t ring;
+    ring_fifo_t *frames;
+
+    uart_frame_stats_t stats;
+} uart_frame_t;
+
+uint32_t uart_frame_encode(const void *data, uint32_t len, void *buf,
+                           uint32_t size);
+int32_t uart_frame_decode(void *buf, uint32_t len);
+
+void uart_frame_init(uart_frame_t *frame, UART_HandleTypeDef *huart);
+uint32_t uart_frame_send(UART_HandleTypeDef *huart, const void *data,
+                         uint32_t len);
+uint32_t uart_frame_poll(uart_frame_t *frame);
+uint32_t uart_frame_read(uart_frame_t *frame, void *buf, uint32_t len);
+
+#endif /* __UART_FRAME_H */
@@ -0,0 +1,436 @@
+/**
+ * @file    adc.c
+ * @author  Deadline039
+ * @brief   定时器触发的多通道ADC扫描, 循环DMA双缓冲
+ * @version 1.0
+ * @date    2026-10-18
+ */
+
+#include "adc.h"
+
+#include <assert.h>
+
+#if (ADC_TRIGGER == ADC_TRIGGER_TIM3_TRGO)
+#define ADC_TRIGGER_TIM              TIM3
+#define ADC_TRIGGER_TIM_CLK_ENABLE() __HAL_RCC_TIM3_CLK_ENABLE()
+#define ADC_TRIGGER_CONV             ADC_EXTERNALTRIGCONV_T3_TRGO
+#else /* ADC_TRIGGER == ADC_TRIGGER_TIM3_TRGO */
+#define ADC_TRIGGER_TIM              TIM4
+#define ADC_TRIGGER_TIM_CLK_ENABLE() __HAL_RCC_TIM4_CLK_ENABLE()
+#define ADC_TRIGGER_CONV             ADC_EXTERNALTRIGCONV_T4_CC4
+#endif /* ADC_TRIGGER == ADC_TRIGGER_TIM3_TRGO */
+
+/* 触发定时器周期, 计数频率1MHz */
+#define ADC_TRIGGER_PERIOD (1000000U / ADC_SAMPLE_RATE)
+
+/* 每个ADC扫描的通道数 */
+#if (ADC_DUAL_MODE == 1)
+#define ADC_SCAN_NUM (ADC_CHANNEL_NUM / 2)
+#else /* ADC_DUAL_MODE == 1 */
+#define ADC_SCAN_NUM ADC_CHANNEL_NUM
+#endif /* ADC_DUAL_MODE == 1 */
+
+#if ((ADC_TRIGGER_PERIOD < 1) || (ADC_TRIGGER_PERIOD > 65536))
+#error "ADC_SAMPLE_RATE超出触发定时器范围"
+#endif /* ADC_TRIGGER_PERIOD */
+
+#if ((ADC_CHANNEL_NUM < 1) || (ADC_SCAN_NUM > 16))
+#error "ADC_CHANNEL_NUM超出扫描通道数范围"
+#endif /* ADC_CHANNEL_NUM */
+
+#if ((ADC_DUAL_MODE == 1) && (ADC_CHANNEL_NUM % 2 != 0))
+#error "双ADC同步模式下ADC_CHANNEL_NUM必须为偶数"
+#endif /* ADC_DUAL_MODE == 1 */
+
+#if ((ADC_DECIMATION < 1) || (ADC_BLOCK_FRAMES % ADC_DECIMATION != 0))
+#error "ADC_BLOCK_FRAMES必须为ADC_DECIMATION的整数倍"
+#endif /* ADC_DECIMATION */
+
+#if (((4095UL * ADC_DECIMATION) >> ADC_OVERSAMPLE_SHIFT) > 65535UL)
+#error "抽取结果超过16位, 需要增大ADC_OVERSAMPLE_SHIFT"
+#endif /* ADC_OVERSAMPLE_SHIFT */
+
+/* 单次DMA传输的数据个数, 双ADC时按字传输 */
+#define ADC_DMA_COUNT                                                          \
+    (2U * ADC_BLOCK_FRAMES * ADC_CHANNEL_NUM / (1U + ADC_DUAL_MODE))
+
+#if (ADC_DMA_COUNT > 65535)
+#error "ADC DMA缓冲区超过单次最大传输长度"
+#endif /* ADC_DMA_COUNT */
+
+static const uint32_t adc_channels[ADC_CHANNEL_NUM] = {ADC_CHANNELS};
+
+/* 两块DMA缓冲区, 双ADC时按字访问, 需要4字节对齐 */
+static uint32_t adc_dma_buf[ADC_BLOCK_FRAMES * ADC_CHANNEL_NUM];
+
+#if (ADC_DECIMATION > 1)
+static uint16_t adc_out_buf[ADC_BLOCK_OUT_FRAMES * ADC_CHANNEL_NUM];
+#endif /* ADC_DECIMATION > 1 */
+
+static ADC_HandleTypeDef adc1_handle = {.Instance = ADC1};
+#if (ADC_DUAL_MODE == 1)
+static ADC_HandleTypeDef adc2_handle = {.Instance = ADC2};
+#endif /* ADC_DUAL_MODE == 1 */
+
+static DMA_HandleTypeDef adc_dma_handle = {
+    .Instance = DMA1_Channel1,
+    .Init.Direction = DMA_PERIPH_TO_MEMORY,
+#if (ADC_DUAL_MODE == 1)
+    /* ADC1_DR高16位为ADC2的结果 */
+    .Init.MemDataAlignment = DMA_MDATAALIGN_WORD,
+    .Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD,
+#else  /* ADC_DUAL_MODE == 1 */
+    .Init.MemDataAlignment = DMA_MDATAALIGN_HALFWORD,
+    .Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD,
+#endif /* ADC_DUAL_MODE == 1 */
+    .Init.MemInc = DMA_MINC_ENABLE,
+    .Init.PeriphInc = DMA_PINC_DISABLE,
+    .Init.Mode = DMA_CIRCULAR,
+    .Init.Priority = ADC_DMA_PRIORITY};
+
+static TIM_HandleTypeDef adc_tim_handle = {.Instance = ADC_TRIGGER_TIM};
+
+static adc_block_callback_t adc_callback;
+static adc_stats_t adc_stats;
+
+/**
+ * @brief ADC DMA中断句柄
+ *
+ */
+void DMA1_Channel1_IRQHandler(void) {
+    HAL_DMA_IRQHandler(&adc_dma_handle);
+}
+
+/*****************************************************************************
+ * @defgroup 初始化
+ * @{
+ */
+
+/**
+ * @brief 通道对应的引脚设置为模拟输入
+ *
+ * @param channel ADC通道
+ */
+static void adc_channel_gpio_init(uint32_t channel) {
+    GPIO_InitTypeDef gpio_init_struct = {.Mode = GPIO_MODE_ANALOG,
+                                         .Pull = GPIO_NOPULL};
+
+    if (channel <= ADC_CHANNEL_7) {
+        __HAL_RCC_GPIOA_CLK_ENABLE();
+        gpio_init_struct.Pin = GPIO_PIN_0 << channel;
+        HAL_GPIO_Init(GPIOA, &gpio_init_struct);
+    } else if (channel <= ADC_CHANNEL_9) {
+        __HAL_RCC_GPIOB_CLK_ENABLE();
+        gpio_init_struct.Pin = GPIO_PIN_0 << (channel - ADC_CHANNEL_8);
+        HAL_GPIO_Init(GPIOB, &gpio_init_struct);
+    } else if (channel <= ADC_CHANNEL_15) {
+        __HAL_RCC_GPIOC_CLK_ENABLE();
+        gpio_init_struct.Pin = GPIO_PIN_0 << (channel - ADC_CHANNEL_10);
+        HAL_GPIO_Init(GPIOC, &gpio_init_struct);
+    }
+    /* 温度传感器和内部参考电压没有引脚 */
+}
+
+/**
+ * @brief ADC底层初始化, 由HAL_ADC_Init调用
+ *
+ * @param hadc ADC句柄
+ */
+void HAL_ADC_MspInit(ADC_HandleTypeDef *hadc) {
+    HAL_StatusTypeDef res = HAL_OK;
+
+    if (hadc->Instance == ADC1) {
+        __HAL_RCC_ADC1_CLK_ENABLE();
+        __HAL_RCC_DMA1_CLK_ENABLE();
+
+        res = HAL_DMA_Init(&adc_dma_handle);
+#ifdef DEBUG
+        assert(res == HAL_OK);
+#endif /* DEBUG */
+        UNUSED(res);
+        __HAL_LINKDMA(hadc, DMA_Handle, adc_dma_handle);
+
+        HAL_NVIC_SetPriority(DMA1_Channel1_IRQn, ADC_DMA_IT_PREEMPT,
+                             ADC_DMA_IT_SUB);
+        HAL_NVIC_EnableIRQ(DMA1_Channel1_IRQn);
+    }
+#if (ADC_DUAL_MODE == 1)
+    else if (hadc->Instance == ADC2) {
+        __HAL_RCC_ADC2_CLK_ENABLE();
+    }
+#endif /* ADC_DUAL_MODE == 1 */
+}
+
+/**
+ * @brief 初始化一个ADC并配置扫描通道
+ *
+ * @param hadc ADC句柄
+ * @param trigger 规则组触发源
+ * @param first 在adc_channels中的起始位置
+ * @param step 在adc_channels中的间隔
+ */
+static void adc_scan_init(ADC_HandleTypeDef *hadc, uint32_t trigger,
+                          uint32_t first, uint32_t step) {
+    HAL_StatusTypeDef res = HAL_OK;
+    ADC_ChannelConfTypeDef channel_conf = {.SamplingTime = ADC_SAMPLETIME};
+
+    hadc->Init.DataAlign = ADC_DATAALIGN_RIGHT;
+    hadc->Init.ScanConvMode = ADC_SCAN_ENABLE;
+    hadc->Init.ContinuousConvMode = DISABLE;
+    hadc->Init.NbrOfConversion = ADC_SCAN_NUM;
+    hadc->Init.DiscontinuousConvMode = DISABLE;
+    hadc->Init.NbrOfDiscConversion = 1;
+    hadc->Init.ExternalTrigConv = trigger;
+    res = HAL_ADC_Init(hadc);
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+
+    for (uint32_t i = 0; i < ADC_SCAN_NUM; ++i) {
+        channel_conf.Channel = adc_channels[first + i * step];
+        channel_conf.Rank = ADC_REGULAR_RANK_1 + i;
+        adc_channel_gpio_init(channel_conf.Channel);
+        res = HAL_ADC_ConfigChannel(hadc, &channel_conf);
+#ifdef DEBUG
+        assert(res == HAL_OK);
+#endif /* DEBUG */
+    }
+
+    res = HAL_ADCEx_Calibration_Start(hadc);
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+    UNUSED(res);
+}
+
+/**
+ * @brief 初始化触发定时器
+ *
+ */
+static void adc_trigger_init(void) {
+    HAL_StatusTypeDef res = HAL_OK;
+
+    /* 72MHz / 72 = 1MHz */
+    ADC_TRIGGER_TIM_CLK_ENABLE();
+    adc_tim_handle.Init.Prescaler = 72 - 1;
+    adc_tim_handle.Init.CounterMode = TIM_COUNTERMODE_UP;
+    adc_tim_handle.Init.Period = ADC_TRIGGER_PERIOD - 1;
+    adc_tim_handle.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    adc_tim_handle.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+
+#if (ADC_TRIGGER == ADC_TRIGGER_TIM3_TRGO)
+    TIM_MasterConfigTypeDef master_config = {
+        .MasterOutputTrigger = TIM_TRGO_UPDATE,
+        .MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE};
+
+    res = HAL_TIM_Base_Init(&adc_tim_handle);
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+    res = HAL_TIMEx_MasterConfigSynchronization(&adc_tim_handle,
+                                                &master_config);
+#else  /* ADC_TRIGGER == ADC_TRIGGER_TIM3_TRGO */
+    /* CC4比较事件触发, 不输出到引脚 */
+    TIM_OC_InitTypeDef oc_config = {.OCMode = TIM_OCMODE_PWM1,
+                                    .Pulse = ADC_TRIGGER_PERIOD / 2,
+                                    .OCPolarity = TIM_OCPOLARITY_HIGH,
+                                    .OCFastMode = TIM_OCFAST_DISABLE};
+
+    res = HAL_TIM_PWM_Init(&adc_tim_handle);
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+    res = HAL_TIM_PWM_ConfigChannel(&adc_tim_handle, &oc_config,
+                                    TIM_CHANNEL_4);
+#endif /* ADC_TRIGGER == ADC_TRIGGER_TIM3_TRGO */
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+    UNUSED(res);
+}
+
+/**
+ * @brief 初始化ADC, DMA和触发定时器
+ *
+ * @param callback 块处理回调
+ */
+void adc_init(adc_block_callback_t callback) {
+    adc_callback = callback;
+
+    /* PCLK2 72MHz / 6 = 12MHz, 不超过14MHz */
+    __HAL_RCC_ADC_CONFIG(RCC_ADCPCLK2_DIV6);
+
+#if (ADC_DUAL_MODE == 1)
+    HAL_StatusTypeDef res = HAL_OK;
+    ADC_MultiModeTypeDef multimode = {.Mode = ADC_DUALMODE_REGSIMULT};
+
+    /* ADC1转换偶数项, ADC2转换奇数项, 由ADC1触发ADC2 */
+    adc_scan_init(&adc1_handle, ADC_TRIGGER_CONV, 0, 2);
+    adc_scan_init(&adc2_handle, ADC_SOFTWARE_START, 1, 2);
+
+    res = HAL_ADCEx_MultiModeConfigChannel(&adc1_handle, &multimode);
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+    UNUSED(res);
+#else  /* ADC_DUAL_MODE == 1 */
+    adc_scan_init(&adc1_handle, ADC_TRIGGER_CONV, 0, 1);
+#endif /* ADC_DUAL_MODE == 1 */
+
+    adc_trigger_init();
+}
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup 采集和块处理
+ * @{
+ */
+
+/**
+ * @brief 开始采集
+ *
+ */
+void adc_start(void) {
+    HAL_StatusTypeDef res = HAL_OK;
+
+#if (ADC_DUAL_MODE == 1)
+    res = HAL_ADCEx_MultiModeStart_DMA(&adc1_handle, adc_dma_buf,
+                                       ADC_DMA_COUNT);
+#else  /* ADC_DUAL_MODE == 1 */
+    res = HAL_ADC_Start_DMA(&adc1_handle, adc_dma_buf, ADC_DMA_COUNT);
+#endif /* ADC_DUAL_MODE == 1 */
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+
+#if (ADC_TRIGGER == ADC_TRIGGER_TIM3_TRGO)
+    res = HAL_TIM_Base_Start(&adc_tim_handle);
+#else  /* ADC_TRIGGER == ADC_TRIGGER_TIM3_TRGO */
+    res = HAL_TIM_PWM_Start(&adc_tim_handle, TIM_CHANNEL_4);
+#endif /* ADC_TRIGGER == ADC_TRIGGER_TIM3_TRGO */
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+    UNUSED(res);
+}
+
+/**
+ * @brief 停止采集
+ *
+ */
+void adc_stop(void) {
+#if (ADC_TRIGGER == ADC_TRIGGER_TIM3_TRGO)
+    HAL_TIM_Base_Stop(&adc_tim_handle);
+#else  /* ADC_TRIGGER == ADC_TRIGGER_TIM3_TRGO */
+    HAL_TIM_PWM_Stop(&adc_tim_handle, TIM_CHANNEL_4);
+#endif /* ADC_TRIGGER == ADC_TRIGGER_TIM3_TRGO */
+
+#if (ADC_DUAL_MODE == 1)
+    HAL_ADCEx_MultiModeStop_DMA(&adc1_handle);
+#else  /* ADC_DUAL_MODE == 1 */
+    HAL_ADC_Stop_DMA(&adc1_handle);
+#endif /* ADC_DUAL_MODE == 1 */
+}
+
+#if (ADC_DECIMATION > 1)
+
+/**
+ * @brief 抽取: 每ADC_DECIMATION帧的同一通道求和后右移
+ *
+ * @param in 一块原始数据
+ * @param out 抽取结果
+ */
+static void adc_decimate(const uint16_t *in, uint16_t *out) {
+    uint32_t acc[ADC_CHANNEL_NUM];
+
+    for (uint32_t f = 0; f < ADC_BLOCK_OUT_FRAMES; ++f) {
+        for (uint32_t k = 0; k < ADC_CHANNEL_NUM; ++k) {
+            acc[k] = *in++;
+        }
+
+        /* 按内存顺序读取, 每次累加一整帧 */
+        for (uint32_t d = 1; d < ADC_DECIMATION; ++d) {
+            for (uint32_t k = 0; k < ADC_CHANNEL_NUM; ++k) {
+                acc[k] += *in++;
+            }
+        }
+
+        for (uint32_t k = 0; k < ADC_CHANNEL_NUM; ++k) {
+            *out++ = (uint16_t)(acc[k] >> ADC_OVERSAMPLE_SHIFT);
+        }
+    }
+}
+
+#endif /* ADC_DECIMATION > 1 */
+
+/**
+ * @brief 处理一块数据
+ *
+ * @param block 块序号, 0或1
+ */
+static void adc_block_process(uint32_t block) {
+    const uint16_t *data = (const uint16_t *)adc_dma_buf +
+                           block * (ADC_BLOCK_FRAMES * ADC_CHANNEL_NUM);
+    DMA_HandleTypeDef *hdma = &adc_dma_handle;
+    uint32_t next_flag;
+
+#if (ADC_DECIMATION > 1)
+    adc_decimate(data, adc_out_buf);
+    data = adc_out_buf;
+#endif /* ADC_DECIMATION > 1 */
+
+    if (adc_callback != NULL) {
+        adc_callback(data, ADC_BLOCK_OUT_FRAMES);
+    }
+
+    /* 处理期间DMA已经写完另一块并开始覆盖本块 */
+    next_flag = (block == 0) ? __HAL_DMA_GET_TC_FLAG_INDEX(hdma)
+                             : __HAL_DMA_GET_HT_FLAG_INDEX(hdma);
+    if (__HAL_DMA_GET_FLAG(hdma, next_flag)) {
+        ++adc_stats.overruns;
+    }
+    ++adc_stats.blocks;
+}
+
+/**
+ * @brief DMA半满回调, 第一块采集完成
+ *
+ * @param hadc ADC句柄
+ */
+void HAL_ADC_ConvHalfCpltCallback(ADC_HandleTypeDef *hadc) {
+    if (hadc == &adc1_handle) {
+        adc_block_process(0);
+    }
+}
+
+/**
+ * @brief DMA满回调, 第二块采集完成
+ *
+ * @param hadc ADC句柄
+ */
+void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc) {
+    if (hadc == &adc1_handle) {
+        adc_block_process(1);
+    }
+}
+
+/**
+ * @brief 获取采集统计
+ *
+ * @param stats 统计结果
+ */
+void adc_get_stats(adc_stats_t *stats) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    *stats = adc_stats;
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @}
+ */
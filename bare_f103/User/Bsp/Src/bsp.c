@@ -58,6 +58,8 @@ void bsp_init(void) {
               UART_PARITY_NONE, UART_HWCONTROL_NONE, UART_MODE_TX_RX);
     led_init();
     key_init();
+    trace_log_init();
+    crc32_init();
 }
 
 #ifdef USE_FULL_ASSERT
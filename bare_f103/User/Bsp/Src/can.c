@@ -0,0 +1,959 @@
+/**
+ * @file    can.c
+ * @author  Deadline039
+ * @brief   CAN收发队列和过滤器分配
+ * @version 1.0
+ * @date    2026-10-18
+ * @note    初始化和启停使用HAL库, 收发和错误中断直接读写寄存器,
+ *          每帧只需要几十个周期.
+ */
+
+#include "can.h"
+#include "ring_fifo.h"
+
+#include <assert.h>
+#include <string.h>
+
+#if !RING_FIFO_IS_POW2(CAN_RX_QUEUE_SIZE)
+#error "CAN_RX_QUEUE_SIZE必须为2的幂次方"
+#endif /* CAN_RX_QUEUE_SIZE */
+
+#if ((CAN_RX_CLASS_NUM < 1) || (CAN_RX_CLASS_NUM > 8))
+#error "CAN_RX_CLASS_NUM必须在1~8之间"
+#endif /* CAN_RX_CLASS_NUM */
+
+#if ((CAN_TX_QUEUE_SIZE < 1) || (CAN_TX_QUEUE_SIZE > 255))
+#error "CAN_TX_QUEUE_SIZE必须在1~255之间"
+#endif /* CAN_TX_QUEUE_SIZE */
+
+/* 每位的时间份额: 同步段1 + 相位段1 8 + 相位段2 3 */
+#define CAN_BIT_TQ       12U
+
+/* 发送邮箱数 */
+#define CAN_TX_MAILBOXES 3U
+
+/* 16位过滤器中的IDE位 */
+#define CAN_FILTER16_IDE 0x08U
+
+/* CAN寄存器, 主机测试时定义为模拟的寄存器 */
+#ifndef CAN_REGS
+#define CAN_REGS CAN1
+#endif /* CAN_REGS */
+
+/* 接收FIFO寄存器, FIFO0和FIFO1的位定义相同 */
+#define CAN_RFR(fifo)    ((fifo) == 0U ? &CAN_REGS->RF0R : &CAN_REGS->RF1R)
+
+/* 下面的寄存器写入会改变邮箱状态, 主机测试时由模拟器实现 */
+
+/* 请求发送邮箱, 硬件随即清除TME并更新CODE */
+#ifndef CAN_TX_REQUEST
+#define CAN_TX_REQUEST(mb)                                                     \
+    SET_BIT(CAN_REGS->sTxMailBox[mb].TIR, CAN_TI0R_TXRQ)
+#endif /* CAN_TX_REQUEST */
+
+/* 写1清除TSR中的标志 */
+#ifndef CAN_TSR_CLEAR
+#define CAN_TSR_CLEAR(bits) (CAN_REGS->TSR = (bits))
+#endif /* CAN_TSR_CLEAR */
+
+/* 写1清除RFR中的标志, 或释放输出邮箱(RFOM) */
+#ifndef CAN_RFR_CLEAR
+#define CAN_RFR_CLEAR(fifo, bits) (*CAN_RFR(fifo) = (bits))
+#endif /* CAN_RFR_CLEAR */
+
+/**
+ * @brief 过滤器类型, 决定过滤器组的位宽和模式
+ */
+typedef enum {
+    CAN_FT_STD_LIST = 0U, /*!< 16位列表, 每组4个标准帧ID */
+    CAN_FT_STD_MASK,      /*!< 16位掩码, 每组2个标准帧ID和掩码 */
+    CAN_FT_EXT_LIST,      /*!< 32位列表, 每组2个扩展帧ID */
+    CAN_FT_EXT_MASK,      /*!< 32位掩码, 每组1个扩展帧ID和掩码 */
+    CAN_FT_NUM
+} can_filter_type_t;
+
+/* 每种类型一个过滤器组能放下的过滤器数 */
+static const uint8_t can_ft_per_bank[CAN_FT_NUM] = {4U, 2U, 2U, 1U};
+
+/**
+ * @brief 登记的过滤器
+ */
+typedef struct {
+    uint32_t id;      /*!< ID */
+    uint32_t mask;    /*!< 掩码, 为1的位需要匹配 */
+    uint8_t flags;    /*!< 登记标志 */
+    uint8_t rx_class; /*!< 接收类别 */
+} can_filter_entry_t;
+
+/**
+ * @brief 接收类别的队列, 接收中断写入, 任务读出
+ */
+typedef struct {
+    can_frame_t frames[CAN_RX_QUEUE_SIZE]; /*!< 报文 */
+    __IO uint32_t in;                      /*!< 入队计数, 只由中断修改 */
+    __IO uint32_t out;                     /*!< 出队计数, 只由任务修改 */
+    can_rx_callback_t callback;            /*!< 接收回调 */
+} can_rx_queue_t;
+
+/**
+ * @brief 发送队列中的报文
+ */
+typedef struct {
+    can_frame_t frame; /*!< 报文 */
+    uint32_t key;      /*!< 仲裁优先级, 越小越优先 */
+    uint32_t seq;      /*!< 提交序号, 同优先级按提交顺序发送 */
+} can_tx_item_t;
+
+CAN_HandleTypeDef can1_handle = {.Instance = CAN1};
+
+static can_filter_entry_t can_filters[CAN_FILTER_MAX];
+static uint32_t can_filter_num;
+/* 过滤器编号(FMI)对应的接收类别, 每个FIFO单独编号 */
+static uint8_t can_fmi_class[2][CAN_FILTER_MAX];
+
+static can_rx_queue_t can_rx_queue[CAN_RX_CLASS_NUM];
+
+/* 按key和seq排列的最小堆 */
+static can_tx_item_t can_tx_heap[CAN_TX_QUEUE_SIZE];
+static uint32_t can_tx_count;
+static uint32_t can_tx_seq;
+/* 发送邮箱中报文的仲裁优先级, 邮箱非空时有效 */
+static uint32_t can_tx_mb_key[CAN_TX_MAILBOXES];
+
+static can_stats_t can_stats;
+/* 上一次错误中断时的错误被动和总线关闭标志 */
+static uint32_t can_err_last;
+
+/*****************************************************************************
+ * @defgroup 初始化和启停
+ * @{
+ */
+
+/**
+ * @brief CAN底层初始化, 由HAL_CAN_Init调用
+ *
+ * @param hcan CAN句柄
+ */
+void HAL_CAN_MspInit(CAN_HandleTypeDef *hcan) {
+    GPIO_InitTypeDef gpio_init_struct = {.Pull = GPIO_PULLUP,
+                                         .Speed = GPIO_SPEED_FREQ_HIGH};
+
+    if (hcan->Instance != CAN1) {
+        return;
+    }
+
+    __HAL_RCC_CAN1_CLK_ENABLE();
+
+#if (CAN_PIN_REMAP == 2)
+    __HAL_RCC_AFIO_CLK_ENABLE();
+    __HAL_AFIO_REMAP_CAN1_2();
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+
+    gpio_init_struct.Pin = GPIO_PIN_8;
+    gpio_init_struct.Mode = GPIO_MODE_AF_INPUT;
+    HAL_GPIO_Init(GPIOB, &gpio_init_struct);
+    gpio_init_struct.Pin = GPIO_PIN_9;
+    gpio_init_struct.Mode = GPIO_MODE_AF_PP;
+    HAL_GPIO_Init(GPIOB, &gpio_init_struct);
+#else  /* CAN_PIN_REMAP == 2 */
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+
+    gpio_init_struct.Pin = GPIO_PIN_11;
+    gpio_init_struct.Mode = GPIO_MODE_AF_INPUT;
+    HAL_GPIO_Init(GPIOA, &gpio_init_struct);
+    gpio_init_struct.Pin = GPIO_PIN_12;
+    gpio_init_struct.Mode = GPIO_MODE_AF_PP;
+    HAL_GPIO_Init(GPIOA, &gpio_init_struct);
+#endif /* CAN_PIN_REMAP == 2 */
+
+    /* 同一优先级, 队列和统计在中断之间不需要保护 */
+    HAL_NVIC_SetPriority(USB_HP_CAN1_TX_IRQn, CAN_IT_PREEMPT, CAN_IT_SUB);
+    HAL_NVIC_EnableIRQ(USB_HP_CAN1_TX_IRQn);
+    HAL_NVIC_SetPriority(USB_LP_CAN1_RX0_IRQn, CAN_IT_PREEMPT, CAN_IT_SUB);
+    HAL_NVIC_EnableIRQ(USB_LP_CAN1_RX0_IRQn);
+    HAL_NVIC_SetPriority(CAN1_RX1_IRQn, CAN_IT_PREEMPT, CAN_IT_SUB);
+    HAL_NVIC_EnableIRQ(CAN1_RX1_IRQn);
+    HAL_NVIC_SetPriority(CAN1_SCE_IRQn, CAN_IT_PREEMPT, CAN_IT_SUB);
+    HAL_NVIC_EnableIRQ(CAN1_SCE_IRQn);
+}
+
+/**
+ * @brief 初始化CAN, 之后登记过滤器并启动
+ *
+ */
+void can_init(void) {
+    HAL_StatusTypeDef res = HAL_OK;
+    uint32_t pclk1 = HAL_RCC_GetPCLK1Freq();
+
+#ifdef DEBUG
+    assert(pclk1 % (CAN_BAUDRATE * CAN_BIT_TQ) == 0);
+#endif /* DEBUG */
+
+    can1_handle.Init.Prescaler = pclk1 / (CAN_BAUDRATE * CAN_BIT_TQ);
+    can1_handle.Init.Mode = CAN_WORK_MODE;
+    can1_handle.Init.SyncJumpWidth = CAN_SJW_1TQ;
+    can1_handle.Init.TimeSeg1 = CAN_BS1_8TQ;
+    can1_handle.Init.TimeSeg2 = CAN_BS2_3TQ;
+    can1_handle.Init.TimeTriggeredMode = DISABLE;
+    /* 总线关闭后检测到128次11个连续隐性位自动恢复 */
+    can1_handle.Init.AutoBusOff = ENABLE;
+    can1_handle.Init.AutoWakeUp = DISABLE;
+    can1_handle.Init.AutoRetransmission = ENABLE;
+    /* 硬件FIFO满时覆盖最后一帧, 保留最新的报文 */
+    can1_handle.Init.ReceiveFifoLocked = DISABLE;
+    /* 发送邮箱按ID优先级发送 */
+    can1_handle.Init.TransmitFifoPriority = DISABLE;
+    res = HAL_CAN_Init(&can1_handle);
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+    UNUSED(res);
+}
+
+/**
+ * @brief 启动CAN, 开始收发
+ *
+ */
+void can_start(void) {
+    HAL_StatusTypeDef res = HAL_OK;
+
+    can_err_last = 0;
+
+    res = HAL_CAN_ActivateNotification(
+        &can1_handle,
+        CAN_IT_TX_MAILBOX_EMPTY | CAN_IT_RX_FIFO0_MSG_PENDING |
+            CAN_IT_RX_FIFO0_OVERRUN | CAN_IT_RX_FIFO1_MSG_PENDING |
+            CAN_IT_RX_FIFO1_OVERRUN | CAN_IT_ERROR_PASSIVE | CAN_IT_BUSOFF |
+            CAN_IT_LAST_ERROR_CODE | CAN_IT_ERROR);
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+
+    res = HAL_CAN_Start(&can1_handle);
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+    UNUSED(res);
+}
+
+/**
+ * @brief 停止CAN, 丢弃还未发送的报文
+ *
+ */
+void can_stop(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    /* 先清空队列, 中止邮箱后的发送完成中断不会再补充 */
+    can_tx_count = 0;
+
+    __set_PRIMASK(primask);
+
+    /* 中止的邮箱在发送完成中断中计数 */
+    (void)HAL_CAN_AbortTxRequest(
+        &can1_handle, CAN_TX_MAILBOX0 | CAN_TX_MAILBOX1 | CAN_TX_MAILBOX2);
+    (void)HAL_CAN_Stop(&can1_handle);
+}
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup 过滤器分配
+ * @{
+ */
+
+/**
+ * @brief 过滤器的类型
+ *
+ * @param entry 过滤器
+ * @return 类型. 掩码包含ID全部有效位时为列表类型
+ */
+static can_filter_type_t can_filter_type(const can_filter_entry_t *entry) {
+    if (entry->flags & CAN_FILTER_FLAG_EXT) {
+        return ((entry->mask & CAN_EXT_ID_MASK) == CAN_EXT_ID_MASK)
+                   ? CAN_FT_EXT_LIST
+                   : CAN_FT_EXT_MASK;
+    }
+
+    return ((entry->mask & CAN_STD_ID_MASK) == CAN_STD_ID_MASK)
+               ? CAN_FT_STD_LIST
+               : CAN_FT_STD_MASK;
+}
+
+/**
+ * @brief 过滤器放入的硬件FIFO
+ *
+ * @param entry 过滤器
+ * @return 0: FIFO0; 1: FIFO1
+ */
+static inline uint32_t can_filter_fifo(const can_filter_entry_t *entry) {
+    return (entry->flags & CAN_FILTER_FLAG_FIFO1) ? 1U : 0U;
+}
+
+/**
+ * @brief 计算登记的过滤器需要的过滤器组数
+ *
+ * @return 过滤器组数
+ */
+static uint32_t can_filter_banks_needed(void) {
+    uint32_t count[2][CAN_FT_NUM] = {0};
+    uint32_t banks = 0;
+    uint32_t per;
+
+    for (uint32_t i = 0; i < can_filter_num; ++i) {
+        ++count[can_filter_fifo(&can_filters[i])]
+               [can_filter_type(&can_filters[i])];
+    }
+
+    for (uint32_t fifo = 0; fifo < 2; ++fifo) {
+        for (uint32_t type = 0; type < CAN_FT_NUM; ++type) {
+            per = can_ft_per_bank[type];
+            banks += (count[fifo][type] + per - 1U) / per;
+        }
+    }
+
+    return banks;
+}
+
+/**
+ * @brief 过滤器在过滤器组中的值
+ *
+ * @param entry 过滤器
+ * @param type 类型
+ * @param[out] value 列表类型为ID; 掩码类型低16位(32位时为全部)为ID
+ * @param[out] mask 掩码类型的掩码
+ * @note 要求IDE位匹配; 列表类型的RTR位也需要匹配, 只接收数据帧
+ */
+static void can_filter_encode(const can_filter_entry_t *entry,
+                              can_filter_type_t type, uint32_t *value,
+                              uint32_t *mask) {
+    switch (type) {
+        case CAN_FT_STD_LIST: {
+            *value = entry->id << 5;
+            *mask = 0;
+        } break;
+
+        case CAN_FT_STD_MASK: {
+            *value = (entry->id & entry->mask) << 5;
+            *mask = ((entry->mask & CAN_STD_ID_MASK) << 5) | CAN_FILTER16_IDE;
+        } break;
+
+        case CAN_FT_EXT_LIST: {
+            *value = (entry->id << 3) | CAN_RI0R_IDE;
+            *mask = 0;
+        } break;
+
+        default: {
+            *value = ((entry->id & entry->mask) << 3) | CAN_RI0R_IDE;
+            *mask = ((entry->mask & CAN_EXT_ID_MASK) << 3) | CAN_RI0R_IDE;
+        } break;
+    }
+}
+
+/**
+ * @brief 写入一个过滤器组
+ *
+ * @param bank 过滤器组
+ * @param fifo 硬件FIFO
+ * @param type 类型
+ * @param entries 组内的过滤器, 不足时重复最后一个
+ * @param num 过滤器数
+ * @param fmi 该FIFO的下一个过滤器编号, 返回时增加组内过滤器数
+ */
+static void can_filter_write_bank(uint32_t bank, uint32_t fifo,
+                                  can_filter_type_t type,
+                                  const can_filter_entry_t *entries[4],
+                                  uint32_t num, uint32_t *fmi) {
+    uint32_t per = can_ft_per_bank[type];
+    uint32_t value[4];
+    uint32_t mask[4];
+    uint32_t bit = 1UL << bank;
+    uint32_t list = (type == CAN_FT_STD_LIST) || (type == CAN_FT_EXT_LIST);
+
+    for (uint32_t i = 0; i < per; ++i) {
+        const can_filter_entry_t *entry = entries[(i < num) ? i : num - 1U];
+
+        can_filter_encode(entry, type, &value[i], &mask[i]);
+        can_fmi_class[fifo][*fmi + i] = entry->rx_class;
+    }
+    *fmi += per;
+
+    /* 32位: FS1R置位; 列表: FM1R置位; FIFO1: FFA1R置位 */
+    MODIFY_REG(CAN_REGS->FS1R, bit, (type >= CAN_FT_EXT_LIST) ? bit : 0U);
+    MODIFY_REG(CAN_REGS->FM1R, bit, list ? bit : 0U);
+    MODIFY_REG(CAN_REGS->FFA1R, bit, (fifo != 0) ? bit : 0U);
+
+    /* 各模式下过滤器编号依次为FR1低半字, FR1高半字, FR2低半字, FR2高半字
+     * (16位)或FR1, FR2(32位) */
+    switch (type) {
+        case CAN_FT_STD_LIST: {
+            CAN_REGS->sFilterRegister[bank].FR1 = (value[1] << 16) | value[0];
+            CAN_REGS->sFilterRegister[bank].FR2 = (value[3] << 16) | value[2];
+        } break;
+
+        case CAN_FT_STD_MASK: {
+            CAN_REGS->sFilterRegister[bank].FR1 = (mask[0] << 16) | value[0];
+            CAN_REGS->sFilterRegister[bank].FR2 = (mask[1] << 16) | value[1];
+        } break;
+
+        case CAN_FT_EXT_LIST: {
+            CAN_REGS->sFilterRegister[bank].FR1 = value[0];
+            CAN_REGS->sFilterRegister[bank].FR2 = value[1];
+        } break;
+
+        default: {
+            CAN_REGS->sFilterRegister[bank].FR1 = value[0];
+            CAN_REGS->sFilterRegister[bank].FR2 = mask[0];
+        } break;
+    }
+
+    SET_BIT(CAN_REGS->FA1R, bit);
+}
+
+/**
+ * @brief 把登记的过滤器写入过滤器组
+ *
+ * @note FIFO0的过滤器组在前, FIFO1在后, 未使用的组在最后并关闭.
+ *       过滤器编号只受前面的组影响, 所以未使用的组不改变编号
+ */
+static void can_filter_apply(void) {
+    const can_filter_entry_t *entries[4];
+    uint32_t bank = 0;
+    uint32_t fmi;
+    uint32_t num;
+    uint32_t per;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    SET_BIT(CAN_REGS->FMR, CAN_FMR_FINIT);
+    CAN_REGS->FA1R = 0;
+
+    for (uint32_t fifo = 0; fifo < 2; ++fifo) {
+        fmi = 0;
+
+        for (uint32_t type = 0; type < CAN_FT_NUM; ++type) {
+            per = can_ft_per_bank[type];
+            num = 0;
+
+            for (uint32_t i = 0; i < can_filter_num; ++i) {
+                if ((can_filter_fifo(&can_filters[i]) != fifo) ||
+                    (can_filter_type(&can_filters[i]) != type)) {
+                    continue;
+                }
+
+                entries[num++] = &can_filters[i];
+                if (num == per) {
+                    can_filter_write_bank(bank++, fifo, type, entries, num,
+                                          &fmi);
+                    num = 0;
+                }
+            }
+
+            if (num != 0) {
+                can_filter_write_bank(bank++, fifo, type, entries, num, &fmi);
+            }
+        }
+    }
+
+    CLEAR_BIT(CAN_REGS->FMR, CAN_FMR_FINIT);
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 登记过滤器, 重新分配过滤器组
+ *
+ * @param id 报文ID
+ * @param mask 掩码, 为1的位需要与ID匹配. 包含全部有效位时为单个ID,
+ *             只接收数据帧
+ * @param flags 登记标志: CAN_FILTER_FLAG_EXT, CAN_FILTER_FLAG_FIFO1
+ * @param rx_class 匹配的报文放入的接收类别
+ * @return 1: 登记成功; 0: 参数错误或过滤器组不足
+ * @note 高频报文和其他报文放入不同的FIFO可以减少硬件FIFO溢出.
+ *       重新分配时正在硬件FIFO中的报文可能放入错误的类别,
+ *       一般在启动前登记全部过滤器
+ */
+uint32_t can_filter_add(uint32_t id, uint32_t mask, uint32_t flags,
+                        uint32_t rx_class) {
+    uint32_t id_mask =
+        (flags & CAN_FILTER_FLAG_EXT) ? CAN_EXT_ID_MASK : CAN_STD_ID_MASK;
+
+    if ((rx_class >= CAN_RX_CLASS_NUM) || (id & ~id_mask) ||
+        (can_filter_num >= CAN_FILTER_MAX)) {
+        return 0;
+    }
+
+    can_filters[can_filter_num].id = id;
+    can_filters[can_filter_num].mask = mask & id_mask;
+    can_filters[can_filter_num].flags = (uint8_t)flags;
+    can_filters[can_filter_num].rx_class = (uint8_t)rx_class;
+    ++can_filter_num;
+
+    if (can_filter_banks_needed() > CAN_FILTER_BANKS) {
+        --can_filter_num;
+        return 0;
+    }
+
+    can_filter_apply();
+    return 1;
+}
+
+/**
+ * @brief 清除全部过滤器, 之后不再接收报文
+ *
+ */
+void can_filter_reset(void) {
+    can_filter_num = 0;
+    can_filter_apply();
+}
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup 接收
+ * @{
+ */
+
+/**
+ * @brief 取出硬件FIFO中的报文, 放入对应类别的队列
+ *
+ * @param fifo 硬件FIFO
+ */
+static void can_rx_irq(uint32_t fifo) {
+    __IO uint32_t *rfr = CAN_RFR(fifo);
+    CAN_FIFOMailBox_TypeDef *mailbox = &CAN_REGS->sFIFOMailBox[fifo];
+    can_rx_queue_t *queue;
+    can_frame_t *frame;
+    uint32_t notify = 0;
+    uint32_t rir;
+    uint32_t rdtr;
+    uint32_t fmi;
+    uint32_t in;
+    uint32_t data[2];
+
+    for (uint32_t n = READ_BIT(*rfr, CAN_RF0R_FMP0); n != 0; --n) {
+        /* 等待上一帧释放后输出邮箱更新 */
+        while (READ_BIT(*rfr, CAN_RF0R_RFOM0)) {
+        }
+
+        rir = mailbox->RIR;
+        rdtr = mailbox->RDTR;
+        fmi = (rdtr & CAN_RDT0R_FMI) >> CAN_RDT0R_FMI_Pos;
+        queue = &can_rx_queue[(fmi < CAN_FILTER_MAX) ? can_fmi_class[fifo][fmi]
+                                                     : 0U];
+
+        in = queue->in;
+        if (in - queue->out >= CAN_RX_QUEUE_SIZE) {
+            ++can_stats.rx_drops;
+            CAN_RFR_CLEAR(fifo, CAN_RF0R_RFOM0);
+            continue;
+        }
+
+        frame = &queue->frames[in & (CAN_RX_QUEUE_SIZE - 1U)];
+        if (rir & CAN_RI0R_IDE) {
+            frame->id = (rir >> CAN_RI0R_EXID_Pos) & CAN_EXT_ID_MASK;
+            frame->ide = 1;
+        } else {
+            frame->id = rir >> CAN_RI0R_STID_Pos;
+            frame->ide = 0;
+        }
+        frame->rtr = (rir & CAN_RI0R_RTR) ? 1U : 0U;
+        frame->dlc = (uint8_t)(rdtr & CAN_RDT0R_DLC);
+        frame->fifo = (uint8_t)fifo;
+        data[0] = mailbox->RDLR;
+        data[1] = mailbox->RDHR;
+        memcpy(frame->data, data, sizeof(frame->data));
+
+        CAN_RFR_CLEAR(fifo, CAN_RF0R_RFOM0);
+
+        RING_FIFO_RELEASE();
+        queue->in = in + 1U;
+        ++can_stats.rx_frames;
+        notify |= 1UL << (queue - can_rx_queue);
+    }
+
+    if (READ_BIT(*rfr, CAN_RF0R_FOVR0)) {
+        ++can_stats.rx_overruns;
+        CAN_RFR_CLEAR(fifo, CAN_RF0R_FOVR0 | CAN_RF0R_FULL0);
+    }
+
+    for (uint32_t i = 0; notify != 0; ++i, notify >>= 1) {
+        if ((notify & 1U) && (can_rx_queue[i].callback != NULL)) {
+            can_rx_queue[i].callback(i);
+        }
+    }
+}
+
+/**
+ * @brief CAN接收FIFO0中断句柄
+ *
+ */
+void USB_LP_CAN1_RX0_IRQHandler(void) {
+    can_rx_irq(0);
+}
+
+/**
+ * @brief CAN接收FIFO1中断句柄
+ *
+ */
+void CAN1_RX1_IRQHandler(void) {
+    can_rx_irq(1);
+}
+
+/**
+ * @brief 设置接收回调
+ *
+ * @param rx_class 接收类别
+ * @param callback 回调, 为NULL时不回调
+ */
+void can_rx_set_callback(uint32_t rx_class, can_rx_callback_t callback) {
+#ifdef DEBUG
+    assert(rx_class < CAN_RX_CLASS_NUM);
+#endif /* DEBUG */
+
+    can_rx_queue[rx_class].callback = callback;
+}
+
+/**
+ * @brief 从接收类别的队列中读出一帧
+ *
+ * @param rx_class 接收类别
+ * @param[out] frame 报文
+ * @return 1: 读出一帧; 0: 队列为空
+ * @note 同一类别只能由一个任务读取
+ */
+uint32_t can_receive(uint32_t rx_class, can_frame_t *frame) {
+    can_rx_queue_t *queue;
+    uint32_t out;
+
+    if (rx_class >= CAN_RX_CLASS_NUM) {
+        return 0;
+    }
+
+    queue = &can_rx_queue[rx_class];
+    out = queue->out;
+    if (queue->in == out) {
+        return 0;
+    }
+
+    RING_FIFO_ACQUIRE();
+    *frame = queue->frames[out & (CAN_RX_QUEUE_SIZE - 1U)];
+    RING_FIFO_RELEASE();
+    queue->out = out + 1U;
+
+    return 1;
+}
+
+/**
+ * @brief 接收类别的队列中的报文数
+ *
+ * @param rx_class 接收类别
+ * @return 报文数
+ */
+uint32_t can_rx_count(uint32_t rx_class) {
+    if (rx_class >= CAN_RX_CLASS_NUM) {
+        return 0;
+    }
+
+    return can_rx_queue[rx_class].in - can_rx_queue[rx_class].out;
+}
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup 发送
+ * @{
+ */
+
+/**
+ * @brief 计算报文的仲裁优先级
+ *
+ * @param frame 报文
+ * @return 按总线上的位顺序排列的仲裁段, 越小越优先
+ * @note 基本ID相同时, 标准数据帧 < 标准远程帧 < 扩展帧
+ */
+static uint32_t can_tx_key(const can_frame_t *frame) {
+    if (frame->ide == 0) {
+        /* 基本ID[31:21], RTR[20] */
+        return ((frame->id & CAN_STD_ID_MASK) << 21) |
+               ((frame->rtr != 0) ? (1UL << 20) : 0U);
+    }
+
+    /* 基本ID[31:21], SRR[20], IDE[19], 扩展ID[18:1], RTR[0] */
+    return (((frame->id >> 18) & CAN_STD_ID_MASK) << 21) | (1UL << 20) |
+           (1UL << 19) | ((frame->id & 0x3FFFFU) << 1) |
+           ((frame->rtr != 0) ? 1U : 0U);
+}
+
+/**
+ * @brief 发送队列中a是否先于b发送
+ *
+ * @param a 报文
+ * @param b 报文
+ * @return 1: a先发送
+ */
+static inline uint32_t can_tx_before(const can_tx_item_t *a,
+                                     const can_tx_item_t *b) {
+    if (a->key != b->key) {
+        return a->key < b->key;
+    }
+
+    return (int32_t)(a->seq - b->seq) < 0;
+}
+
+/**
+ * @brief 报文放入发送队列
+ *
+ * @param frame 报文
+ * @return 1: 成功; 0: 队列满
+ * @note 需要在关中断时调用
+ */
+static uint32_t can_tx_push(const can_frame_t *frame) {
+    uint32_t i = can_tx_count;
+    uint32_t parent;
+    can_tx_item_t item;
+
+    if (i >= CAN_TX_QUEUE_SIZE) {
+        return 0;
+    }
+
+    item.frame = *frame;
+    item.key = can_tx_key(frame);
+    item.seq = can_tx_seq++;
+
+    /* 上浮 */
+    while (i != 0) {
+        parent = (i - 1U) / 2U;
+        if (!can_tx_before(&item, &can_tx_heap[parent])) {
+            break;
+        }
+        can_tx_heap[i] = can_tx_heap[parent];
+        i = parent;
+    }
+    can_tx_heap[i] = item;
+
+    if (++can_tx_count > can_stats.tx_queue_peak) {
+        can_stats.tx_queue_peak = can_tx_count;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief 移除发送队列中最先发送的报文
+ *
+ * @note 需要在关中断时调用, 队列不能为空
+ */
+static void can_tx_pop(void) {
+    can_tx_item_t *last = &can_tx_heap[--can_tx_count];
+    uint32_t i = 0;
+    uint32_t child;
+
+    /* 最后一个报文从堆顶下沉 */
+    while ((child = 2U * i + 1U) < can_tx_count) {
+        if ((child + 1U < can_tx_count) &&
+            can_tx_before(&can_tx_heap[child + 1U], &can_tx_heap[child])) {
+            ++child;
+        }
+        if (!can_tx_before(&can_tx_heap[child], last)) {
+            break;
+        }
+        can_tx_heap[i] = can_tx_heap[child];
+        i = child;
+    }
+    can_tx_heap[i] = *last;
+}
+
+/**
+ * @brief 从发送队列补充空闲的发送邮箱
+ *
+ * @note 需要在关中断时调用.
+ *       与邮箱中报文优先级相同的报文等待该邮箱发送完成, 否则硬件按邮箱号
+ *       发送会打乱同ID报文的顺序
+ */
+static void can_tx_refill(void) {
+    CAN_TxMailBox_TypeDef *mailbox;
+    const can_frame_t *frame;
+    uint32_t tsr;
+    uint32_t mb;
+    uint32_t data[2];
+
+    while (can_tx_count != 0) {
+        tsr = CAN_REGS->TSR;
+        if ((tsr & (CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2)) == 0) {
+            return;
+        }
+
+        for (mb = 0; mb < CAN_TX_MAILBOXES; ++mb) {
+            if (((tsr & (CAN_TSR_TME0 << mb)) == 0) &&
+                (can_tx_mb_key[mb] == can_tx_heap[0].key)) {
+                return;
+            }
+        }
+
+        mb = (tsr & CAN_TSR_CODE) >> CAN_TSR_CODE_Pos;
+        mailbox = &CAN_REGS->sTxMailBox[mb];
+        frame = &can_tx_heap[0].frame;
+
+        if (frame->ide == 0) {
+            mailbox->TIR = (frame->id & CAN_STD_ID_MASK) << CAN_TI0R_STID_Pos;
+        } else {
+            mailbox->TIR =
+                ((frame->id & CAN_EXT_ID_MASK) << CAN_TI0R_EXID_Pos) |
+                CAN_TI0R_IDE;
+        }
+        if (frame->rtr != 0) {
+            SET_BIT(mailbox->TIR, CAN_TI0R_RTR);
+        }
+        mailbox->TDTR = frame->dlc & CAN_TDT0R_DLC;
+        memcpy(data, frame->data, sizeof(data));
+        mailbox->TDLR = data[0];
+        mailbox->TDHR = data[1];
+
+        can_tx_mb_key[mb] = can_tx_heap[0].key;
+        CAN_TX_REQUEST(mb);
+
+        can_tx_pop();
+    }
+}
+
+/**
+ * @brief CAN发送完成中断句柄
+ *
+ */
+void USB_HP_CAN1_TX_IRQHandler(void) {
+    static const uint32_t rqcp[CAN_TX_MAILBOXES] = {
+        CAN_TSR_RQCP0, CAN_TSR_RQCP1, CAN_TSR_RQCP2};
+    static const uint32_t txok[CAN_TX_MAILBOXES] = {
+        CAN_TSR_TXOK0, CAN_TSR_TXOK1, CAN_TSR_TXOK2};
+    uint32_t tsr = CAN_REGS->TSR;
+    uint32_t sent = 0;
+    uint32_t primask;
+
+    for (uint32_t mb = 0; mb < CAN_TX_MAILBOXES; ++mb) {
+        if ((tsr & rqcp[mb]) == 0) {
+            continue;
+        }
+
+        if (tsr & txok[mb]) {
+            ++can_stats.tx_frames;
+            sent = 1;
+        } else {
+            ++can_stats.tx_aborts;
+        }
+
+        /* 写1清除RQCP, 同时清除TXOK, ALST和TERR */
+        CAN_TSR_CLEAR(rqcp[mb]);
+    }
+
+    /* 发送成功说明已经退出总线关闭, 下次进入时重新计数 */
+    if (sent) {
+        can_err_last = CAN_REGS->ESR & (CAN_ESR_EPVF | CAN_ESR_BOFF);
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+    can_tx_refill();
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 发送报文
+ *
+ * @param frame 报文
+ * @return 1: 已放入发送邮箱或发送队列; 0: 队列满或CAN未启动
+ * @note 可以在中断中调用. 优先级高的报文先放入发送邮箱
+ */
+uint32_t can_send(const can_frame_t *frame) {
+    uint32_t primask;
+
+    if ((frame == NULL) || (can1_handle.State != HAL_CAN_STATE_LISTENING)) {
+        return 0;
+    }
+
+#ifdef DEBUG
+    assert(frame->dlc <= 8);
+#endif /* DEBUG */
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (can_tx_push(frame) == 0) {
+        ++can_stats.tx_drops;
+        __set_PRIMASK(primask);
+        return 0;
+    }
+
+    can_tx_refill();
+
+    __set_PRIMASK(primask);
+    return 1;
+}
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup 错误和统计
+ * @{
+ */
+
+/**
+ * @brief CAN错误中断句柄
+ *
+ */
+void CAN1_SCE_IRQHandler(void) {
+    uint32_t esr = CAN_REGS->ESR;
+    uint32_t flags = esr & (CAN_ESR_EPVF | CAN_ESR_BOFF);
+
+    if (esr & CAN_ESR_LEC) {
+        ++can_stats.bus_errors;
+        CLEAR_BIT(CAN_REGS->ESR, CAN_ESR_LEC);
+    }
+
+    if ((flags & CAN_ESR_EPVF) && !(can_err_last & CAN_ESR_EPVF)) {
+        ++can_stats.error_passive;
+    }
+
+    /* 总线关闭后硬件自动恢复, 邮箱中的报文恢复后继续发送 */
+    if ((flags & CAN_ESR_BOFF) && !(can_err_last & CAN_ESR_BOFF)) {
+        ++can_stats.bus_off;
+    }
+
+    can_err_last = flags;
+    CAN_REGS->MSR = CAN_MSR_ERRI;
+}
+
+/**
+ * @brief 获取统计
+ *
+ * @param[out] stats 统计
+ * @param reset 1: 读取后清零
+ */
+void can_get_stats(can_stats_t *stats, uint32_t reset) {
+    uint32_t esr;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    *stats = can_stats;
+    if (reset) {
+        memset(&can_stats, 0, sizeof(can_stats));
+    }
+    esr = CAN_REGS->ESR;
+
+    __set_PRIMASK(primask);
+
+    stats->tec = (esr & CAN_ESR_TEC) >> CAN_ESR_TEC_Pos;
+    stats->rec = (esr & CAN_ESR_REC) >> CAN_ESR_REC_Pos;
+}
+
+/**
+ * @}
+ */
@@ -13,6 +13,227 @@
 #include "retarget_io.h"
 #include <stdio.h>
 
+#define STDOUT_USE_UART_DMA ((RETARGET_STDOUT == 1) && (RE_STDOUT_TARGET == 2))
+#define STDERR_USE_UART_DMA ((RETARGET_STDERR == 1) && (RE_STDERR_TARGET == 2))
+
+#if (STDOUT_USE_UART_DMA || STDERR_USE_UART_DMA)
+#include "uart.h"
+
+#if (UART_USE_FREERTOS == 1)
+#include "FreeRTOS.h"
+#include "task.h"
+#endif /* UART_USE_FREERTOS == 1 */
+
+#include <string.h>
+#endif /* STDOUT_USE_UART_DMA || STDERR_USE_UART_DMA */
+
+/**
+ * @defgroup 串口DMA缓冲输出
+ * @{
+ */
+
+/* 串口DMA发送缓冲区满时的处理方式 */
+#define OVERFLOW_DROP      0 /* 丢弃新数据 */
+#define OVERFLOW_BLOCK     1 /* 阻塞等待 */
+#define OVERFLOW_OVERWRITE 2 /* 丢弃最早的未发送数据 */
+
+static uint32_t stdout_dropped; /* stdout丢弃的字节数 */
+static uint32_t stderr_dropped; /* stderr丢弃的字节数 */
+
+#if (STDOUT_USE_UART_DMA || STDERR_USE_UART_DMA)
+
+/**
+ * @brief 累加丢弃的字节数
+ *
+ * @param counter 丢弃计数
+ * @param dropped 本次丢弃的字节数
+ * @note 任务和中断都会输出, 读改写在临界区中完成
+ */
+static inline void retarget_count_dropped(uint32_t *counter,
+                                          uint32_t dropped) {
+    if (dropped == 0) {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    *counter += dropped;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 等待DMA发送出空间
+ *
+ * @note FreeRTOS调度器运行时挂起当前任务, 让出CPU
+ */
+static inline void uart_dma_wait_space(void) {
+#if (UART_USE_FREERTOS == 1)
+    if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) {
+        vTaskDelay(1);
+        return;
+    }
+#endif /* UART_USE_FREERTOS == 1 */
+
+    HAL_Delay(1);
+}
+
+/**
+ * @brief 写入串口DMA发送缓冲区, 由DMA在后台发送
+ *
+ * @param huart 串口句柄
+ * @param ptr 数据
+ * @param len 数据长度
+ * @param overflow 缓冲区满时的处理方式
+ * @return 丢弃的字节数
+ */
+static uint32_t uart_dma_buffered_write(UART_HandleTypeDef *huart,
+                                        const char *ptr, uint32_t len,
+                                        uint32_t overflow) {
+    uint32_t written = 0;
+    uint32_t dropped = 0;
+
+    if (!uart_tx_is_buffered(huart)) {
+        /* 未启用发送DMA或中断发送, 阻塞发送 */
+        HAL_UART_Transmit(huart, (uint8_t *)ptr, (uint16_t)len,
+                          HAL_MAX_DELAY);
+        return 0;
+    }
+
+    while (1) {
+        written += uart_dmatx_write(huart, ptr + written, len - written);
+        uart_dmatx_send(huart);
+
+        if (written == len) {
+            break;
+        }
+
+        if ((overflow == OVERFLOW_BLOCK) && (__get_IPSR() == 0U)) {
+            uart_dma_wait_space();
+            continue;
+        }
+
+        if (overflow == OVERFLOW_OVERWRITE) {
+            /* 只腾出写入剩余数据所需的空间 */
+            uint32_t discarded = uart_dmatx_discard(huart, len - written);
+            if (discarded != 0) {
+                dropped += discarded;
+                continue;
+            }
+        }
+
+        dropped += len - written;
+        break;
+    }
+
+    return dropped;
+}
+
+#if defined(__ARMCC_VERSION)
+
+/**
+ * @brief fputc行缓冲
+ */
+typedef struct {
+    char buf[RETARGET_LINE_BUF_SIZE]; /*!< 缓冲的字符 */
+    uint32_t len;                     /*!< 缓冲的长度 */
+} retarget_line_t;
+
+#if (STDOUT_USE_UART_DMA)
+static retarget_line_t stdout_line;
+#endif /* STDOUT_USE_UART_DMA */
+
+#if (STDERR_USE_UART_DMA)
+static retarget_line_t stderr_line;
+#endif /* STDERR_USE_UART_DMA */
+
+/**
+ * @brief 字符存入行缓冲, 遇到'\n', '\0'或缓冲满时写入串口DMA发送缓冲区
+ *
+ * @param line 行缓冲
+ * @param huart 串口句柄
+ * @param ch 字符, 小于0时只写出已缓冲的字符
+ * @param overflow 发送缓冲区满时的处理方式
+ * @param dropped 丢弃计数
+ * @note 存入和取出在临界区中完成, 写入发送缓冲区(可能阻塞)在临界区外,
+ *       多个任务同时输出时按行交错. '\0'是trace_log帧的分隔符,
+ *       不超过行缓冲大小的帧一次写入, 不会与其他输出交错
+ */
+static void retarget_line_put(retarget_line_t *line, UART_HandleTypeDef *huart,
+                              int ch, uint32_t overflow, uint32_t *dropped) {
+    char out[RETARGET_LINE_BUF_SIZE];
+    uint32_t len = 0;
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (ch >= 0) {
+        line->buf[line->len++] = (char)ch;
+    }
+    if ((ch < 0) || (ch == '\n') || (ch == '\0') ||
+        (line->len == sizeof(line->buf))) {
+        len = line->len;
+        memcpy(out, line->buf, len);
+        line->len = 0;
+    }
+
+    __set_PRIMASK(primask);
+
+    if (len != 0) {
+        retarget_count_dropped(
+            dropped, uart_dma_buffered_write(huart, out, len, overflow));
+    }
+}
+
+#endif /* __ARMCC_VERSION */
+
+#endif /* STDOUT_USE_UART_DMA || STDERR_USE_UART_DMA */
+
+/**
+ * @brief 获取输出到串口DMA缓冲时丢弃的字节数
+ *
+ * @param file `stdout`或`stderr`
+ * @return 丢弃的字节数
+ */
+uint32_t retarget_get_dropped(FILE *file) {
+    if (file == stdout) {
+        return stdout_dropped;
+    } else if (file == stderr) {
+        return stderr_dropped;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief 写出行缓冲中不以'\n'结尾的输出, 如命令行提示符
+ *
+ * @param file `stdout`或`stderr`
+ * @note 只有AC6/AC5下输出到串口DMA缓冲时使用行缓冲, 其他情况不需要调用
+ */
+void retarget_flush(FILE *file) {
+#if defined(__ARMCC_VERSION)
+#if (STDOUT_USE_UART_DMA)
+    if (file == stdout) {
+        retarget_line_put(&stdout_line, &STDOUT_UART_HANDLE, -1,
+                          STDOUT_OVERFLOW, &stdout_dropped);
+    }
+#endif /* STDOUT_USE_UART_DMA */
+
+#if (STDERR_USE_UART_DMA)
+    if (file == stderr) {
+        retarget_line_put(&stderr_line, &STDERR_UART_HANDLE, -1,
+                          STDERR_OVERFLOW, &stderr_dropped);
+    }
+#endif /* STDERR_USE_UART_DMA */
+#endif /* __ARMCC_VERSION */
+
+    UNUSED(file);
+}
+
+/**
+ * @}
+ */
+
 /**
  * @defgroup 重定向stdout, stderr
  * @{
@@ -110,6 +331,11 @@ int fputc(int ch, FILE *file) {
 
         ITM_SendChar(ch);
 
+#elif (RE_STDOUT_TARGET == 2) /* 使用串口DMA缓冲 */
+
+        retarget_line_put(&stdout_line, &STDOUT_UART_HANDLE, (uint8_t)ch,
+                          STDOUT_OVERFLOW, &stdout_dropped);
+
 #endif /* RE_STDOUT_TARGET */
 
 #endif /* RETARGET_STDOUT == 1 */
@@ -128,6 +354,11 @@ int fputc(int ch, FILE *file) {
 
         ITM_SendChar(ch);
 
+#elif (RE_STDERR_TARGET == 2) /* 使用串口DMA缓冲 */
+
+        retarget_line_put(&stderr_line, &STDERR_UART_HANDLE, (uint8_t)ch,
+                          STDERR_OVERFLOW, &stderr_dropped);
+
 #endif /* RE_STDERR_TARGET */
 
 #endif /* RETARGET_STDERR == 1 */
@@ -174,6 +405,13 @@ int _write(int file, char *ptr, int len) {
             ITM_SendChar(ptr[i]);
         }
 
+#elif (RE_STDOUT_TARGET == 2) /* 使用串口DMA缓冲 */
+
+        retarget_count_dropped(
+            &stdout_dropped,
+            uart_dma_buffered_write(&STDOUT_UART_HANDLE, ptr, (uint32_t)len,
+                                    STDOUT_OVERFLOW));
+
 #endif /* RE_STDOUT_TARGET */
 
 #endif /* RETARGET_STDOUT == 1 */
@@ -199,6 +437,13 @@ int _write(int file, char *ptr, int len) {
             ITM_SendChar(ptr[i]);
         }
 
+#elif (RE_STDERR_TARGET == 2) /* 使用串口DMA缓冲 */
+
+        retarget_count_dropped(
+            &stderr_dropped,
+            uart_dma_buffered_write(&STDERR_UART_HANDLE, ptr, (uint32_t)len,
+                                    STDERR_OVERFLOW));
+
 #endif /* RE_STDERR_TARGET */
 
 #endif /* RETARGET_STDERR == 1 */
@@ -0,0 +1,137 @@
+/**
+ * @file    trace_log.c
+ * @author  Deadline039
+ * @brief   二进制延迟格式化日志
+ * @version 1.0
+ * @date    2026-10-18
+ */
+
+#include "trace_log.h"
+
+#if (TRACE_LOG_ENABLE == 1)
+
+#include "ring_fifo.h"
+#include "stm32f1xx_hal.h"
+#include "uart_frame.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#if ((TRACE_BUF_SIZE & (TRACE_BUF_SIZE - 1)) != 0)
+#error "TRACE_BUF_SIZE must be power of 2. "
+#endif /* TRACE_BUF_SIZE */
+
+/* 记录头: 标志, 参数个数, 序号, 时间戳, 格式化字符串地址 */
+#define TRACE_HDR_WORDS 3
+
+/* 最长记录的字节数 */
+#define TRACE_RECORD_MAX ((TRACE_HDR_WORDS + TRACE_MAX_ARGS) * sizeof(uint32_t))
+
+static uint32_t trace_buf[TRACE_BUF_SIZE / sizeof(uint32_t)];
+static ring_fifo_t trace_ring;
+static ring_fifo_t *trace_fifo;
+static uint16_t trace_seq;
+static uint32_t trace_dropped;
+
+/**
+ * @brief 初始化日志缓冲区
+ *
+ */
+void trace_log_init(void) {
+    trace_fifo = ring_fifo_init_static(&trace_ring, trace_buf, TRACE_BUF_SIZE,
+                                       RF_TYPE_FRAME);
+#ifdef DEBUG
+    assert(trace_fifo != NULL);
+#endif /* DEBUG */
+}
+
+/**
+ * @brief 写入一条日志记录, 由TRACE_LOG调用
+ *
+ * @param fmt 格式化字符串
+ * @param args 参数
+ * @param nargs 参数个数
+ * @note 可在任务和中断中调用, 缓冲区满时丢弃该条记录
+ */
+void trace_log_write(const char *fmt, const uint32_t *args, uint32_t nargs) {
+    uint32_t record[TRACE_HDR_WORDS + TRACE_MAX_ARGS];
+
+    if (trace_fifo == NULL) {
+        return;
+    }
+
+#ifdef DEBUG
+    assert(nargs <= TRACE_MAX_ARGS);
+#endif /* DEBUG */
+    if (nargs > TRACE_MAX_ARGS) {
+        nargs = TRACE_MAX_ARGS;
+    }
+
+    record[1] = HAL_GetTick();
+    record[2] = (uint32_t)(uintptr_t)fmt;
+    for (uint32_t i = 0; i < nargs; ++i) {
+        record[TRACE_HDR_WORDS + i] = args[i];
+    }
+
+    /* 多个任务和中断共用一个缓冲区, 入队需要互斥 */
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    record[0] = TRACE_MAGIC | (nargs << 8) | ((uint32_t)trace_seq << 16);
+    if (ring_fifo_write(trace_fifo, record,
+                        (TRACE_HDR_WORDS + nargs) * sizeof(uint32_t)) == 0) {
+        ++trace_dropped;
+    }
+    /* 序号在丢弃时也递增, 上位机据此发现丢失的记录 */
+    ++trace_seq;
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 将缓冲区中的日志记录封装成帧, 通过stdout输出
+ *
+ * @return 输出的字节数
+ * @note 只能在一个上下文中调用, 建议放在低优先级任务或主循环中.
+ *       stdout配置为串口DMA缓冲时由DMA在后台发送.
+ *       帧前也加一个0x00, 与之前输出的文本分开
+ */
+uint32_t trace_flush(void) {
+    uint8_t record[TRACE_RECORD_MAX];
+    uint8_t frame[1 + UART_FRAME_ENCODED_SIZE(TRACE_RECORD_MAX)];
+    ring_fifo_span_t span[2];
+    uint32_t len;
+    uint32_t total = 0;
+
+    if (trace_fifo == NULL) {
+        return 0;
+    }
+
+    frame[0] = UART_FRAME_DELIM;
+    while ((len = ring_fifo_read_peek(trace_fifo, span)) != 0) {
+        memcpy(record, span[0].buf, span[0].len);
+        if (span[1].len != 0) {
+            memcpy(record + span[0].len, span[1].buf, span[1].len);
+        }
+        ring_fifo_read_commit(trace_fifo, len);
+
+        len = uart_frame_encode(record, len, frame + 1, sizeof(frame) - 1);
+        fwrite(frame, 1, len + 1, stdout);
+        total += len + 1;
+    }
+    fflush(stdout);
+
+    return total;
+}
+
+/**
+ * @brief 获取因缓冲区满而丢弃的记录条数
+ *
+ * @return 丢弃的条数
+ */
+uint32_t trace_get_dropped(void) {
+    return trace_dropped;
+}
+
+#endif /* TRACE_LOG_ENABLE == 1 */
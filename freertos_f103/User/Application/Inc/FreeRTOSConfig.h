@@ -34,7 +34,7 @@ extern uint32_t SystemCoreClock;
 //  <i> 如果启用tickless模式, 当在Idle时停止tick周期中断.
 //  <i> 如果禁用, 将会一直产生tick周期中断
 //  <i> 默认: 0
-#define configUSE_TICKLESS_IDLE                   0
+#define configUSE_TICKLESS_IDLE                   1
 
 //  <o>系统时钟节拍频率 [Hz] <0-0xFFFFFFFF>
 #define configTICK_RATE_HZ                        ((TickType_t)1000)
@@ -113,10 +113,13 @@ extern uint32_t SystemCoreClock;
 
 //  <q>支持静态申请内存
 //  <i> 默认: 0
-#define configSUPPORT_STATIC_ALLOCATION           0
+//  <i> 启用后模板中的任务, 队列均使用静态内存, 空闲任务和定时器任务的
+//  <i> 内存在rtos_tasks.c中提供
+#define configSUPPORT_STATIC_ALLOCATION           1
 
 //  <q>支持动态申请内存
 //  <i> 默认: 1
+//  <i> 关闭后需要将heap_4.c移出工程, 此时不再占用configTOTAL_HEAP_SIZE
 #define configSUPPORT_DYNAMIC_ALLOCATION          1
 
 //  <o>堆内存总大小 [byte] <0-65535>
@@ -167,13 +170,12 @@ extern uint32_t SystemCoreClock;
 
 //  <q>启用任务运行时间统计功能
 //  <i> 默认: 0
-#define configGENERATE_RUN_TIME_STATS             0
+#define configGENERATE_RUN_TIME_STATS             1
 
 #if (configGENERATE_RUN_TIME_STATS == 1)
-#include "./BSP/TIMER/btim.h"
-#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() ConfigureTimeForRunTimeStats()
-extern uint32_t FreeRTOSRunTimeTicks;
-#define portGET_RUN_TIME_COUNTER_VALUE() FreeRTOSRunTimeTicks
+#include "run_time_stats.h"
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() run_time_stats_timer_init()
+#define portGET_RUN_TIME_COUNTER_VALUE()         run_time_stats_counter()
 #endif /* configGENERATE_RUN_TIME_STATS == 1 */
 
 //  <q>使用可视化跟踪调试
@@ -259,6 +261,15 @@ extern uint32_t FreeRTOSRunTimeTicks;
     if ((x) == 0)                                                              \
     vAssertCalled(__FILE__, __LINE__)
 
+/* tickless低功耗, 见low_power.c */
+#if (configUSE_TICKLESS_IDLE == 1)
+#include "low_power.h"
+#define portSUPPRESS_TICKS_AND_SLEEP(xExpectedIdleTime)                        \
+    low_power_suppress_ticks_and_sleep(xExpectedIdleTime)
+#define traceINCREASE_TICK_COUNT(xTicksToJump)                                 \
+    low_power_step_tick(xTicksToJump)
+#endif /* configUSE_TICKLESS_IDLE == 1 */
+
 /* 重定向FreeRTOS中断服务相关函数到系统中断 */
 #define xPortPendSVHandler  PendSV_Handler
 #define vPortSVCHandler     SVC_Handler
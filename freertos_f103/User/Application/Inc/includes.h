@@ -14,6 +14,9 @@
 #include "FreeRTOS.h"
 #include "task.h"
 
+#include "low_power.h"
+#include "run_time_stats.h"
+
 void freertos_start(void);
 
 #endif /* __INCLUDES_H */
@@ -12,5 +12,6 @@
 int main(void) {
     HAL_NVIC_SetPriorityGrouping(NVIC_PRIORITYGROUP_4);
     bsp_init();
+    low_power_init();
     freertos_start();
 }
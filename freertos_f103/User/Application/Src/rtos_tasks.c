@@ -20,14 +20,91 @@ void task2(void *pvParameters);
 static TaskHandle_t task3_handle;
 void task3(void *pvParameters);
 
+#if (TRACE_LOG_ENABLE == 1)
+static TaskHandle_t trace_task_handle;
+void trace_task(void *pvParameters);
+#endif /* TRACE_LOG_ENABLE == 1 */
+
+#define START_TASK_STACK_SIZE 128
+#define TASK1_STACK_SIZE      128
+#define TASK2_STACK_SIZE      128
+#define TASK3_STACK_SIZE      128
+#define TRACE_TASK_STACK_SIZE 256
+
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+static StaticTask_t start_task_tcb;
+static StackType_t start_task_stack[START_TASK_STACK_SIZE];
+static StaticTask_t task1_tcb;
+static StackType_t task1_stack[TASK1_STACK_SIZE];
+static StaticTask_t task2_tcb;
+static StackType_t task2_stack[TASK2_STACK_SIZE];
+static StaticTask_t task3_tcb;
+static StackType_t task3_stack[TASK3_STACK_SIZE];
+#if (TRACE_LOG_ENABLE == 1)
+static StaticTask_t trace_task_tcb;
+static StackType_t trace_task_stack[TRACE_TASK_STACK_SIZE];
+#endif /* TRACE_LOG_ENABLE == 1 */
+#endif /* configSUPPORT_STATIC_ALLOCATION == 1 */
+
 /*****************************************************************************/
 
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+
+/**
+ * @brief 提供空闲任务的内存
+ *
+ * @param[out] ppxIdleTaskTCBBuffer 任务控制块
+ * @param[out] ppxIdleTaskStackBuffer 任务堆栈
+ * @param[out] pulIdleTaskStackSize 任务堆栈大小
+ */
+void vApplicationGetIdleTaskMemory(StaticTask_t **ppxIdleTaskTCBBuffer,
+                                   StackType_t **ppxIdleTaskStackBuffer,
+                                   uint32_t *pulIdleTaskStackSize) {
+    static StaticTask_t idle_task_tcb;
+    static StackType_t idle_task_stack[configMINIMAL_STACK_SIZE];
+
+    *ppxIdleTaskTCBBuffer = &idle_task_tcb;
+    *ppxIdleTaskStackBuffer = idle_task_stack;
+    *pulIdleTaskStackSize = configMINIMAL_STACK_SIZE;
+}
+
+#if (configUSE_TIMERS == 1)
+
+/**
+ * @brief 提供定时器任务的内存
+ *
+ * @param[out] ppxTimerTaskTCBBuffer 任务控制块
+ * @param[out] ppxTimerTaskStackBuffer 任务堆栈
+ * @param[out] pulTimerTaskStackSize 任务堆栈大小
+ */
+void vApplicationGetTimerTaskMemory(StaticTask_t **ppxTimerTaskTCBBuffer,
+                                    StackType_t **ppxTimerTaskStackBuffer,
+                                    uint32_t *pulTimerTaskStackSize) {
+    static StaticTask_t timer_task_tcb;
+    static StackType_t timer_task_stack[configTIMER_TASK_STACK_DEPTH];
+
+    *ppxTimerTaskTCBBuffer = &timer_task_tcb;
+    *ppxTimerTaskStackBuffer = timer_task_stack;
+    *pulTimerTaskStackSize = configTIMER_TASK_STACK_DEPTH;
+}
+
+#endif /* configUSE_TIMERS == 1 */
+
+#endif /* configSUPPORT_STATIC_ALLOCATION == 1 */
+
 /**
  * @brief FreeRTOS启动函数
  *
  */
 void freertos_start(void) {
-    xTaskCreate(start_task, "start_task", 128, NULL, 2, &start_task_handle);
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+    start_task_handle =
+        xTaskCreateStatic(start_task, "start_task", START_TASK_STACK_SIZE, NULL,
+                          2, start_task_stack, &start_task_tcb);
+#else  /* configSUPPORT_STATIC_ALLOCATION == 1 */
+    xTaskCreate(start_task, "start_task", START_TASK_STACK_SIZE, NULL, 2,
+                &start_task_handle);
+#endif /* configSUPPORT_STATIC_ALLOCATION == 1 */
     vTaskStartScheduler();
 }
 
@@ -40,9 +117,30 @@ void start_task(void *pvParameters) {
     UNUSED(pvParameters);
     taskENTER_CRITICAL();
 
-    xTaskCreate(task1, "task1", 128, NULL, 2, &task1_handle);
-    xTaskCreate(task2, "task2", 128, NULL, 2, &task2_handle);
-    xTaskCreate(task3, "task3", 128, NULL, 2, &task3_handle);
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+    task1_handle = xTaskCreateStatic(task1, "task1", TASK1_STACK_SIZE, NULL, 2,
+                                     task1_stack, &task1_tcb);
+    task2_handle = xTaskCreateStatic(task2, "task2", TASK2_STACK_SIZE, NULL, 2,
+                                     task2_stack, &task2_tcb);
+    task3_handle = xTaskCreateStatic(task3, "task3", TASK3_STACK_SIZE, NULL, 2,
+                                     task3_stack, &task3_tcb);
+#if (TRACE_LOG_ENABLE == 1)
+    trace_task_handle =
+        xTaskCreateStatic(trace_task, "trace", TRACE_TASK_STACK_SIZE, NULL, 1,
+                          trace_task_stack, &trace_task_tcb);
+#endif /* TRACE_LOG_ENABLE == 1 */
+#else  /* configSUPPORT_STATIC_ALLOCATION == 1 */
+    xTaskCreate(task1, "task1", TASK1_STACK_SIZE, NULL, 2, &task1_handle);
+    xTaskCreate(task2, "task2", TASK2_STACK_SIZE, NULL, 2, &task2_handle);
+    xTaskCreate(task3, "task3", TASK3_STACK_SIZE, NULL, 2, &task3_handle);
+#if (TRACE_LOG_ENABLE == 1)
+    xTaskCreate(trace_task, "trace", TRACE_TASK_STACK_SIZE, NULL, 1,
+                &trace_task_handle);
+#endif /* TRACE_LOG_ENABLE == 1 */
+#endif /* configSUPPORT_STATIC_ALLOCATION == 1 */
+#if (configGENERATE_RUN_TIME_STATS == 1)
+    run_time_stats_reporter_start();
+#endif /* configGENERATE_RUN_TIME_STATS == 1 */
 
     vTaskDelete(start_task_handle);
     taskEXIT_CRITICAL();
@@ -81,34 +179,43 @@ void task2(void *pvParameters) {
 }
 
 /**
- * @brief 任务3, 按键扫描
+ * @brief 任务3, 按键事件处理
  *
  * @param pvParameters 传入参数(未用到)
  */
 void task3(void *pvParameters) {
     UNUSED(pvParameters);
 
-    key_press_t key = KEY_NO_PRESS;
+    static const char *const key_name[] = {"", "KEY0", "KEY1", "Wake Up"};
+    static const char *const event_name[] = {"Pressed", "Released",
+                                             "Long Pressed", "Double Clicked"};
+    key_event_t event;
 
     while (1) {
-        key = key_scan(0);
-        switch (key) {
-            case WKUP_PRESS: {
-                printf("Wake Up Pressed. \r\n");
-            } break;
-
-            case KEY0_PRESS: {
-                printf("KEY0 Pressed. \r\n");
-            } break;
-
-            case KEY1_PRESS: {
-                printf("KEY1 Pressed. \r\n");
-            } break;
-
-            default: {
-            } break;
+        /* 阻塞直到有按键事件 */
+        if (key_get_event(&event, portMAX_DELAY)) {
+            printf("%s %s. \r\n", key_name[event.key],
+                   event_name[event.type]);
         }
+    }
+}
+
+#if (TRACE_LOG_ENABLE == 1)
 
-        vTaskDelay(10);
+/**
+ * @brief 日志输出任务, 最低优先级, 周期把二进制日志写入stdout
+ *
+ * @param pvParameters 传入参数(未用到)
+ */
+void trace_task(void *pvParameters) {
+    UNUSED(pvParameters);
+
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (1) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(TRACE_FLUSH_MS));
+        trace_flush();
     }
 }
+
+#endif /* TRACE_LOG_ENABLE == 1 */
@@ -11,20 +11,59 @@
 
 #include "stm32f1xx_hal.h"
 
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <h> 按键事件
+
+// <o> 扫描周期(ms) <1-50>
+// <i> 有按键动作时由定时器周期扫描, 无按键动作时定时器停止
+#define KEY_SCAN_PERIOD_MS   5
+// <o> 消抖时间(ms)
+#define KEY_DEBOUNCE_MS      20
+// <o> 长按时间(ms)
+#define KEY_LONG_PRESS_MS    1000
+// <o> 双击间隔(ms)
+// <i> 松开后在该时间内再次按下产生双击事件
+#define KEY_DOUBLE_CLICK_MS  300
+// <o> 事件队列长度
+#define KEY_EVENT_QUEUE_LEN  8
+
+// <o> 按键中断抢占优先级 <5-15>
+// <i> 中断中会调用FreeRTOS API, 不能高于configMAX_SYSCALL_INTERRUPT_PRIORITY
+#define KEY_IT_PREEMPT       6
+// <o> 按键中断子优先级
+#define KEY_IT_SUB           0
+
+// </h>
+
+// <<< end of configuration section >>>
+
+/* 扫描定时器 */
+#define KEY_TIM              TIM6
+#define KEY_TIM_CLK_ENABLE() __HAL_RCC_TIM6_CLK_ENABLE()
+#define KEY_TIM_IRQn         TIM6_IRQn
+#define KEY_TIM_IRQHandler   TIM6_IRQHandler
+
 /* KEY0定义 */
 #define KEY0_GPIO_PORT     GPIOC
 #define KEY0_GPIO_ENABLE() __HAL_RCC_GPIOC_CLK_ENABLE()
 #define KEY0_GPIO_PIN      GPIO_PIN_5
+#define KEY0_IRQn          EXTI9_5_IRQn
+#define KEY0_IRQHandler    EXTI9_5_IRQHandler
 
 /* KEY1定义 */
 #define KEY1_GPIO_PORT     GPIOA
 #define KEY1_GPIO_ENABLE() __HAL_RCC_GPIOA_CLK_ENABLE()
 #define KEY1_GPIO_PIN      GPIO_PIN_15
+#define KEY1_IRQn          EXTI15_10_IRQn
+#define KEY1_IRQHandler    EXTI15_10_IRQHandler
 
 /* WK_UP定义 */
 #define WKUP_GPIO_PORT     GPIOA
 #define WKUP_GPIO_ENABLE() __HAL_RCC_GPIOA_CLK_ENABLE()
 #define WKUP_GPIO_PIN      GPIO_PIN_0
+#define WKUP_IRQn          EXTI0_IRQn
+#define WKUP_IRQHandler    EXTI0_IRQHandler
 
 /**
  * @brief 按下的按键
@@ -36,7 +75,25 @@ typedef enum {
     WKUP_PRESS         /* WK_UP按下 */
 } key_press_t;
 
+/**
+ * @brief 按键事件类型
+ */
+typedef enum {
+    KEY_EVENT_PRESS = 0U,  /* 按下 */
+    KEY_EVENT_RELEASE,     /* 松开 */
+    KEY_EVENT_LONG_PRESS,  /* 长按 */
+    KEY_EVENT_DOUBLE_CLICK /* 双击, 在第二次按下时产生 */
+} key_event_type_t;
+
+/**
+ * @brief 按键事件
+ */
+typedef struct {
+    uint8_t key;  /* 按键, 见`key_press_t` */
+    uint8_t type; /* 事件类型, 见`key_event_type_t` */
+} key_event_t;
+
 void key_init(void);
-uint8_t key_scan(uint8_t mode);
+uint8_t key_get_event(key_event_t *event, uint32_t timeout);
 
 #endif /* __KEY_H */
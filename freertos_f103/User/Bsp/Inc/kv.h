@@ -0,0 +1,101 @@
+/**
+ * @file    kv.h
+ * @author  Deadline039
+ * @brief   内部Flash键值存储
+ * @version 1.0
+ * @date    2026-10-18
+ *
+ * 在保留的若干个2KB Flash页上以日志方式追加记录, 修改一个键只追加一条新记录,
+ * 不擦除原有数据. 所有页轮流写入, 擦除次数平均分布在各页上.
+ *
+ * 页头: 魔数, 状态和序号. 序号越大的页越新, 同一个键以最新的记录为准.
+ * 记录: 键, 长度, 数据, CRC和提交标志. 提交标志在其他内容写入后最后写入,
+ * 掉电时没有写完的记录不会被当作有效记录.
+ *
+ * 启动时扫描一次全部记录, 在RAM中建立键到记录位置的哈希索引, 之后读取
+ * 不需要扫描Flash.
+ *
+ * 垃圾回收: 始终保留一个空白页. 写满后把最旧一页中仍然有效的记录复制到
+ * 空白页, 复制完成并标记新页有效后再擦除旧页. 复制过程中掉电时旧页仍然
+ * 完整, 启动时擦除没有完成的新页.
+ *
+ * 擦除和写入Flash期间CPU无法从Flash取指, 全部中断都会被推迟,
+ * 擦除一页约20ms.
+ */
+
+#ifndef __KV_H
+#define __KV_H
+
+#include <stdint.h>
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <o> 存储区起始地址 <0x08000000-0x0807F800:0x800>
+// <i> 必须按页对齐. 需要同时把工程的IROM大小减去存储区大小,
+// <i> 以免程序被链接到存储区. 默认为256KB Flash的最后4页
+#define KV_FLASH_BASE   0x0803E000
+
+// <o> 存储区页数 <2-64>
+// <i> 其中一页始终保留为空白页
+#define KV_PAGE_NUM     4
+
+// <o> 索引表大小(必须为2的幂次方)
+// <i> 最多能保存的键数, 建议为实际键数的2倍以上
+#define KV_INDEX_SIZE   128
+
+// <o> 值的最大长度(byte) <1-1024>
+#define KV_VALUE_MAX    256
+
+// <q> 使用FreeRTOS
+// <i> 开启后读写期间挂起调度器, 多个任务可以同时访问
+#define KV_USE_FREERTOS 1
+
+// <q> 性能测试
+// <i> 提供kv_benchmark, 用DWT周期计数器测量启动建立索引和读取的耗时
+#define KV_BENCHMARK    0
+
+// <<< end of configuration section >>>
+
+/* Flash页大小 */
+#define KV_PAGE_SIZE    2048U
+
+/* 无效的键, 与擦除后的Flash相同 */
+#define KV_KEY_INVALID  0xFFFFU
+
+/**
+ * @brief 操作结果
+ */
+typedef enum {
+    KV_OK = 0U,       /*!< 成功 */
+    KV_ERR_NOT_FOUND, /*!< 键不存在 */
+    KV_ERR_PARAM,     /*!< 参数错误 */
+    KV_ERR_FULL,      /*!< 存储区已满 */
+    KV_ERR_INDEX,     /*!< 索引表已满 */
+    KV_ERR_FLASH      /*!< Flash擦除或写入失败 */
+} kv_status_t;
+
+/**
+ * @brief 存储统计
+ */
+typedef struct {
+    uint32_t keys;       /*!< 有效的键数 */
+    uint32_t live_bytes; /*!< 有效记录占用的字节数 */
+    uint32_t free_bytes; /*!< 当前页剩余的字节数 */
+    uint32_t gc_count;   /*!< 本次启动后垃圾回收的次数 */
+    uint32_t erases;     /*!< 本次启动后擦除的页数 */
+} kv_stats_t;
+
+kv_status_t kv_init(void);
+kv_status_t kv_format(void);
+
+kv_status_t kv_get(uint16_t key, void *buf, uint16_t size, uint16_t *len);
+kv_status_t kv_set(uint16_t key, const void *data, uint16_t len);
+kv_status_t kv_delete(uint16_t key);
+
+void kv_get_stats(kv_stats_t *stats);
+
+#if (KV_BENCHMARK == 1)
+void kv_benchmark(void);
+#endif /* KV_BENCHMARK == 1 */
+
+#endif /* __KV_H */
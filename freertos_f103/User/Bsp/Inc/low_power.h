@@ -0,0 +1,61 @@
+/**
+ * @file    low_power.h
+ * @author  Deadline039
+ * @brief   FreeRTOS tickless低功耗
+ * @version 1.0
+ * @date    2026-10-18
+ * @note    本文件会被FreeRTOSConfig.h包含, 不能包含FreeRTOS头文件
+ */
+
+#ifndef __LOW_POWER_H
+#define __LOW_POWER_H
+
+#include <stdint.h>
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <e> 空闲时进入STOP模式
+// <i> 预计空闲时间较长时进入STOP模式, 由RTC闹钟唤醒, 否则进入睡眠模式.
+// <i> STOP模式下只有EXTI线(按键, RTC闹钟等)可以唤醒, 串口接收无法唤醒
+#define LOW_POWER_USE_STOP       0
+
+// <o> 进入STOP模式的最短空闲时间(tick)
+#define LOW_POWER_STOP_MIN_TICKS 20
+
+// <o> 提前唤醒时间(tick)
+// <i> 唤醒后恢复HSE和PLL需要时间, RTC闹钟提前这么多tick唤醒
+#define LOW_POWER_WAKEUP_TICKS   2
+
+// </e>
+
+// <q> 统计睡眠时间
+// <i> 统计以tick为单位, 不足一个tick的睡眠不计入
+#define LOW_POWER_STATS          1
+
+// <<< end of configuration section >>>
+
+/* RTC计数频率, 使用LSE时分频系数为LSE_VALUE / LOW_POWER_RTC_HZ */
+#define LOW_POWER_RTC_HZ         1024U
+
+/**
+ * @brief 低功耗统计
+ */
+typedef struct {
+    uint32_t total_ticks; /* 统计的总时间 */
+    uint32_t sleep_ticks; /* 睡眠模式时间 */
+    uint32_t stop_ticks;  /* STOP模式时间 */
+    uint32_t sleep_count; /* 进入睡眠模式次数 */
+    uint32_t stop_count;  /* 进入STOP模式次数 */
+} low_power_stats_t;
+
+void low_power_init(void);
+void low_power_suppress_ticks_and_sleep(uint32_t expected_idle_ticks);
+void low_power_step_tick(uint32_t ticks);
+
+#if (LOW_POWER_STATS == 1)
+void low_power_get_stats(low_power_stats_t *stats);
+void low_power_reset_stats(void);
+void low_power_print_stats(void);
+#endif /* LOW_POWER_STATS == 1 */
+
+#endif /* __LOW_POWER_H */
@@ -11,6 +11,8 @@
 
 #include "stm32f1xx_hal.h"
 
+#include <stdio.h>
+
 // <<< Use Configuration Wizard in Context Menu >>>
 
 // <e> 重定向stdout
@@ -19,7 +21,8 @@
 #if (RETARGET_STDOUT == 1)
 
 // <o RE_STDOUT_TARGET> 重定向stdout位置
-//  <0=>串口 <1=>ITM
+//  <0=>串口 <1=>ITM <2=>串口DMA缓冲
+//  <i> 串口DMA缓冲: 数据写入串口发送缓冲区后立即返回, 由DMA在后台发送
 #define RE_STDOUT_TARGET 0
 
 #if (RE_STDOUT_TARGET == 0)
@@ -34,6 +37,25 @@
 
 #endif /* RE_STDOUT_TARGET == 0 */
 
+#if (RE_STDOUT_TARGET == 2)
+
+// <o STDOUT_UART_HANDLE> stdout的串口
+//  <usart1_handle=> 串口1
+//  <usart2_handle=> 串口2
+//  <usart3_handle=> 串口3
+//  <uart4_handle=> 串口4
+//  <uart5_handle=> 串口5
+// <i> 需要在uart.h中启用该串口的发送DMA或中断收发, 否则阻塞发送
+#define STDOUT_UART_HANDLE usart1_handle
+
+// <o STDOUT_OVERFLOW> 发送缓冲区满时
+//  <0=>丢弃新数据 <1=>阻塞等待 <2=>丢弃最早的未发送数据
+// <i> 中断中不会阻塞等待, 按丢弃新数据处理
+// <i> 丢弃旧数据时只丢弃放下新数据所需的长度, 正在发送的数据不受影响
+#define STDOUT_OVERFLOW    0
+
+#endif /* RE_STDOUT_TARGET == 2 */
+
 #endif /* RETARGET_STDOUT == 1 */
 
 // </e>
@@ -44,7 +66,8 @@
 #if (RETARGET_STDERR == 1)
 
 // <o RE_STDERR_TARGET> 重定向stderr位置
-//  <0=>串口 <1=>ITM
+//  <0=>串口 <1=>ITM <2=>串口DMA缓冲
+//  <i> 串口DMA缓冲: 数据写入串口发送缓冲区后立即返回, 由DMA在后台发送
 #define RE_STDERR_TARGET 0
 
 #if (RE_STDERR_TARGET == 0)
@@ -59,10 +82,38 @@
 
 #endif /* RE_STDERR_TARGET == 0 */
 
+#if (RE_STDERR_TARGET == 2)
+
+// <o STDERR_UART_HANDLE> stderr的串口
+//  <usart1_handle=> 串口1
+//  <usart2_handle=> 串口2
+//  <usart3_handle=> 串口3
+//  <uart4_handle=> 串口4
+//  <uart5_handle=> 串口5
+// <i> 需要在uart.h中启用该串口的发送DMA或中断收发, 否则阻塞发送
+#define STDERR_UART_HANDLE usart1_handle
+
+// <o STDERR_OVERFLOW> 发送缓冲区满时
+//  <0=>丢弃新数据 <1=>阻塞等待 <2=>丢弃最早的未发送数据
+// <i> 中断中不会阻塞等待, 按丢弃新数据处理
+// <i> 丢弃旧数据时只丢弃放下新数据所需的长度, 正在发送的数据不受影响
+#define STDERR_OVERFLOW    0
+
+#endif /* RE_STDERR_TARGET == 2 */
+
 #endif /* RETARGET_STDOUT == 1 */
 
 // </e>
 
+// <o> 串口DMA缓冲的行缓冲大小(byte) <8-256>
+// <i> AC6/AC5的printf逐个字符调用fputc, 字符先存入行缓冲,
+// <i> 遇到'\n', '\0'(trace_log帧分隔符)或缓冲满时一次写入串口发送缓冲区.
+// <i> GCC整段写入, 不使用行缓冲. 不以'\n'结尾的输出需要调用retarget_flush
+#define RETARGET_LINE_BUF_SIZE 64
+
 // <<< end of configuration section >>>
 
+uint32_t retarget_get_dropped(FILE *file);
+void retarget_flush(FILE *file);
+
 #endif /* __RETARGET_IO_H */
@@ -0,0 +1,53 @@
+/**
+ * @file    run_time_stats.h
+ * @author  Deadline039
+ * @brief   FreeRTOS运行时间统计
+ * @version 1.0
+ * @date    2026-10-18
+ * @note    本文件会被FreeRTOSConfig.h包含, 不能包含FreeRTOS头文件
+ */
+
+#ifndef __RUN_TIME_STATS_H
+#define __RUN_TIME_STATS_H
+
+#include <stdint.h>
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <o> 运行时间计数频率(Hz)
+// <i> TIM2和TIM3级联为32位计数器, 无需中断. 1MHz时约71分钟溢出一次
+#define RUN_TIME_STATS_HZ         1000000U
+
+// <q> 统计中断时间
+// <i> 将中断向量表复制到RAM, 用DWT周期计数器统计每个中断的执行时间.
+// <i> 嵌套的中断只计入内层中断. 向量表占用RAM, 且每个中断都多经过一层
+// <i> 统计入口, 会改变被测的中断延迟, 所以默认关闭, 关闭时报告中只有任务
+#define RUN_TIME_STATS_ISR        0
+
+// <o> 负载报告周期(ms)
+// <i> 最低优先级的报告任务周期打印各任务(和中断)的CPU占用.
+// <i> 为0时不创建报告任务, 可手动调用run_time_stats_report
+#define RUN_TIME_STATS_REPORT_MS  10000
+
+// <o> 报告支持的最大任务数
+#define RUN_TIME_STATS_MAX_TASKS  16
+
+// <<< end of configuration section >>>
+
+/* 计数器 */
+#define RUN_TIME_STATS_TIM_LOW    TIM2
+#define RUN_TIME_STATS_TIM_HIGH   TIM3
+#define RUN_TIME_STATS_TIM_ITR    TIM_TS_ITR1 /* TIM3的ITR1为TIM2 */
+#define RUN_TIME_STATS_CLK_ENABLE()                                            \
+    do {                                                                       \
+        __HAL_RCC_TIM2_CLK_ENABLE();                                           \
+        __HAL_RCC_TIM3_CLK_ENABLE();                                           \
+    } while (0)
+
+void run_time_stats_timer_init(void);
+uint32_t run_time_stats_counter(void);
+
+void run_time_stats_report(void);
+void run_time_stats_reporter_start(void);
+
+#endif /* __RUN_TIME_STATS_H */
@@ -0,0 +1,165 @@
+/**
+ * @file    spi.h
+ * @author  Deadline039
+ * @brief   SPI DMA传输队列
+ * @version 1.0
+ * @date    2026-10-18
+ *
+ * 每条SPI总线一个传输队列, 挂在同一总线上的设备各自有片选, 模式和速度.
+ * 一次传输可以由多段组成(如命令 + 数据), 各段之间保持片选.
+ * 传输完成后在DMA中断中直接启动队列中的下一次传输, 传输之间没有任务切换.
+ *
+ * 完成方式:
+ * - `spi_transfer`: 等待传输完成. FreeRTOS中挂起任务, 由DMA中断直接唤醒
+ * - `spi_submit`: 只入队, 完成后在DMA中断中调用回调函数, 裸机中使用
+ */
+
+#ifndef __SPI_H
+#define __SPI_H
+
+#include "stm32f1xx_hal.h"
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <e> 启用SPI1
+// <i> 使用DMA1通道2(接收)和通道3(发送), 与串口3的DMA冲突
+// ==================
+
+#define SPI1_ENABLE 0
+
+#if (SPI1_ENABLE == 1)
+
+//  <o SPI1_DMA_PRIORITY> SPI1 DMA优先级
+//      <DMA_PRIORITY_LOW=>低
+//      <DMA_PRIORITY_MEDIUM=>中
+//      <DMA_PRIORITY_HIGH=>高
+//      <DMA_PRIORITY_VERY_HIGH=>非常高
+#define SPI1_DMA_PRIORITY       DMA_PRIORITY_HIGH
+//  <o> SPI1 DMA中断抢占优先级
+#define SPI1_DMA_IT_PREEMPT     5
+//  <o> SPI1 DMA中断子优先级
+#define SPI1_DMA_IT_SUB         1
+
+/* SPI1 SCK GPIO */
+#define SPI1_SCK_GPIO_PORT      GPIOA
+#define SPI1_SCK_GPIO_ENABLE()  __HAL_RCC_GPIOA_CLK_ENABLE()
+#define SPI1_SCK_GPIO_PIN       GPIO_PIN_5
+/* SPI1 MISO GPIO */
+#define SPI1_MISO_GPIO_PORT     GPIOA
+#define SPI1_MISO_GPIO_ENABLE() __HAL_RCC_GPIOA_CLK_ENABLE()
+#define SPI1_MISO_GPIO_PIN      GPIO_PIN_6
+/* SPI1 MOSI GPIO */
+#define SPI1_MOSI_GPIO_PORT     GPIOA
+#define SPI1_MOSI_GPIO_ENABLE() __HAL_RCC_GPIOA_CLK_ENABLE()
+#define SPI1_MOSI_GPIO_PIN      GPIO_PIN_7
+
+#endif /* SPI1_ENABLE == 1 */
+
+// </e>
+
+// <e> 启用SPI2
+// <i> 使用DMA1通道4(接收)和通道5(发送), 与串口1的DMA冲突
+// ==================
+
+#define SPI2_ENABLE 0
+
+#if (SPI2_ENABLE == 1)
+
+//  <o SPI2_DMA_PRIORITY> SPI2 DMA优先级
+//      <DMA_PRIORITY_LOW=>低
+//      <DMA_PRIORITY_MEDIUM=>中
+//      <DMA_PRIORITY_HIGH=>高
+//      <DMA_PRIORITY_VERY_HIGH=>非常高
+#define SPI2_DMA_PRIORITY       DMA_PRIORITY_HIGH
+//  <o> SPI2 DMA中断抢占优先级
+#define SPI2_DMA_IT_PREEMPT     5
+//  <o> SPI2 DMA中断子优先级
+#define SPI2_DMA_IT_SUB         1
+
+/* SPI2 SCK GPIO */
+#define SPI2_SCK_GPIO_PORT      GPIOB
+#define SPI2_SCK_GPIO_ENABLE()  __HAL_RCC_GPIOB_CLK_ENABLE()
+#define SPI2_SCK_GPIO_PIN       GPIO_PIN_13
+/* SPI2 MISO GPIO */
+#define SPI2_MISO_GPIO_PORT     GPIOB
+#define SPI2_MISO_GPIO_ENABLE() __HAL_RCC_GPIOB_CLK_ENABLE()
+#define SPI2_MISO_GPIO_PIN      GPIO_PIN_14
+/* SPI2 MOSI GPIO */
+#define SPI2_MOSI_GPIO_PORT     GPIOB
+#define SPI2_MOSI_GPIO_ENABLE() __HAL_RCC_GPIOB_CLK_ENABLE()
+#define SPI2_MOSI_GPIO_PIN      GPIO_PIN_15
+
+#endif /* SPI2_ENABLE == 1 */
+
+// </e>
+
+// <o> 传输队列长度(必须为2的幂次方)
+// <i> 每条总线最多排队的传输数, 不含正在进行的传输
+#define SPI_QUEUE_SIZE   8
+
+// <q> 使用FreeRTOS
+// <i> 开启后spi_transfer挂起任务等待, 由DMA中断通知.
+// <i> DMA中断的抢占优先级不能高于configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY
+#define SPI_USE_FREERTOS 1
+
+// <<< end of configuration section >>>
+
+/**
+ * @brief 传输状态
+ */
+typedef enum {
+    SPI_XFER_IDLE = 0U, /*!< 未提交 */
+    SPI_XFER_QUEUED,    /*!< 在队列中等待 */
+    SPI_XFER_ACTIVE,    /*!< 正在传输 */
+    SPI_XFER_DONE,      /*!< 传输完成 */
+    SPI_XFER_ERROR,     /*!< DMA传输错误 */
+    SPI_XFER_CANCELLED  /*!< 等待超时, 未开始传输就被取消 */
+} spi_xfer_status_t;
+
+/**
+ * @brief SPI设备
+ */
+typedef struct {
+    SPI_TypeDef *spi;      /*!< 所在总线 */
+    GPIO_TypeDef *cs_port; /*!< 片选GPIO端口, NULL时不控制片选 */
+    uint16_t cs_pin;       /*!< 片选GPIO引脚 */
+    uint16_t cr1;          /*!< 模式和分频, 切换设备时写入SPI_CR1 */
+} spi_device_t;
+
+typedef struct spi_xfer spi_xfer_t;
+
+/**
+ * @brief 传输完成回调, 在DMA中断中调用
+ *
+ * @param xfer 完成的传输, 可以在回调中重新提交
+ */
+typedef void (*spi_callback_t)(spi_xfer_t *xfer);
+
+/**
+ * @brief SPI传输, 提交后到完成前不能修改或释放
+ */
+struct spi_xfer {
+    spi_device_t *dev;       /*!< 设备, 只使用第一段的设置 */
+    const void *tx_buf;      /*!< 发送数据, NULL时发送0xFF */
+    void *rx_buf;            /*!< 接收缓冲区, NULL时丢弃接收的数据 */
+    uint16_t len;            /*!< 本段长度, 不能为0 */
+    spi_xfer_t *next;        /*!< 下一段, 各段之间保持片选. NULL为最后一段 */
+    spi_callback_t callback; /*!< 完成回调, 只使用第一段的设置, 可以为NULL */
+    void *arg;               /*!< 回调参数 */
+
+    __IO spi_xfer_status_t status; /*!< 传输状态, 由第一段记录 */
+    void *__IO waiter;             /*!< 等待完成的任务 */
+};
+
+void spi_bus_init(SPI_TypeDef *spi);
+void spi_device_init(spi_device_t *dev, SPI_TypeDef *spi,
+                     GPIO_TypeDef *cs_port, uint16_t cs_pin, uint32_t mode,
+                     uint32_t max_hz);
+
+uint32_t spi_submit(spi_xfer_t *xfer);
+spi_xfer_status_t spi_transfer(spi_xfer_t *xfer, uint32_t timeout);
+spi_xfer_status_t spi_write_read(spi_device_t *dev, const void *tx_buf,
+                                 void *rx_buf, uint16_t len,
+                                 uint32_t timeout);
+
+#endif /* __SPI_H */
@@ -0,0 +1,62 @@
+/**
+ * @file    uart_port.h
+ * @author  Deadline039
+ * @brief   串口列表, 按uart.h中的配置展开各串口的定义
+ * @version 1.0
+ * @date    2026-10-18
+ *
+ * uart.c和dma_uart.c用UART_PORT_LIST展开每个串口的句柄, 中断处理函数,
+ * 缓冲区和描述表项, 驱动代码按描述表处理所有串口.
+ * 添加串口时在列表中增加一项, 并在uart.h中添加同一前缀的配置.
+ */
+
+#ifndef __UART_PORT_H
+#define __UART_PORT_H
+
+#include "uart.h"
+
+/**
+ * 串口列表, 每项依次为:
+ *  名称: 变量名前缀, 如usart1_handle
+ *  配置前缀: uart.h中配置的前缀, 外设地址, 中断号和中断处理函数也由它拼接,
+ *           如USART1_ENABLE, USART1_BASE, USART1_IRQn, USART1_IRQHandler
+ *  发送DMA通道, 发送DMA中断前缀: 如DMA1_Channel4_IRQn, DMA1_Channel4_IRQHandler
+ *  接收DMA通道, 接收DMA中断前缀
+ * 没有DMA的串口通道填NULL, 配置中USE_DMA_TX和USE_DMA_RX固定为0.
+ * 用于选择展开的配置(ENABLE, USE_DMA_TX, USE_DMA_RX, USE_IT, DMA_RX_TO_FIFO,
+ * RX_FLOW_CTRL)必须是字面量0或1
+ */
+#define UART_PORT_LIST(X)                                                      \
+    X(usart1, USART1_, DMA1_Channel4, DMA1_Channel4_, DMA1_Channel5,           \
+      DMA1_Channel5_)                                                          \
+    X(usart2, USART2_, DMA1_Channel7, DMA1_Channel7_, DMA1_Channel6,           \
+      DMA1_Channel6_)                                                          \
+    X(usart3, USART3_, DMA1_Channel2, DMA1_Channel2_, DMA1_Channel3,           \
+      DMA1_Channel3_)                                                          \
+    X(uart4, UART4_, DMA2_Channel5, DMA2_Channel4_5_, DMA2_Channel3,           \
+      DMA2_Channel3_)                                                          \
+    X(uart5, UART5_, NULL, NONE_, NULL, NONE_)
+
+/* 拼接两个记号, 参数先展开 */
+#define UART_CAT_(a, b) a##b
+#define UART_CAT(a, b)  UART_CAT_(a, b)
+
+/* 按配置选择是否展开: UART_IF(cond)(...), cond为字面量0或1 */
+#define UART_IF(cond)   UART_CAT(UART_IF_, cond)
+#define UART_IF_0(...)
+#define UART_IF_1(...)  __VA_ARGS__
+
+/* 配置取反和或运算, 参数为字面量0或1 */
+#define UART_NOT(a)     UART_CAT(UART_NOT_, a)
+#define UART_NOT_0      1
+#define UART_NOT_1      0
+#define UART_OR(a, b)   UART_CAT(UART_OR_, UART_CAT(a, b))
+#define UART_OR_00      0
+#define UART_OR_01      1
+#define UART_OR_10      1
+#define UART_OR_11      1
+
+/* 编译期检查, 不满足时数组大小为负, 编译报错中的类型名说明原因 */
+#define UART_STATIC_ASSERT(cond, msg) typedef char msg[(cond) ? 1 : -1]
+
+#endif /* __UART_PORT_H */
@@ -0,0 +1,524 @@
+/**
+ * @file    crc32.c
+ * @author  Deadline039
+ * @brief   CRC32计算, 使用硬件CRC单元, 软件查表兜底
+ * @version 1.0
+ * @date    2026-10-18
+ */
+
+#include "crc32.h"
+
+#include <string.h>
+
+#if ((CRC32_USE_HW == 1) || (CRC32_BENCHMARK == 1))
+#include "stm32f1xx_hal.h"
+
+#include <assert.h>
+#include <stdio.h>
+#endif /* CRC32_USE_HW == 1 || CRC32_BENCHMARK == 1 */
+
+/* CRC单元复位后的初值 */
+#define CRC32_WORD_INIT 0xFFFFFFFFU
+
+#if (CRC32_USE_HW == 1)
+
+/* CRC单元寄存器, 主机测试时定义为模拟的寄存器 */
+#ifndef CRC32_REGS
+#define CRC32_REGS CRC
+#endif /* CRC32_REGS */
+
+/* 写入数据寄存器时CRC单元随即计算, 主机测试时由模拟器实现 */
+#ifndef CRC32_HW_WRITE
+#define CRC32_HW_WRITE(word) (CRC32_REGS->DR = (word))
+#endif /* CRC32_HW_WRITE */
+
+/* 复位后数据寄存器为CRC32_WORD_INIT */
+#ifndef CRC32_HW_RESET
+#define CRC32_HW_RESET() (CRC32_REGS->CR = CRC_CR_RESET)
+#endif /* CRC32_HW_RESET */
+
+#endif /* CRC32_USE_HW == 1 */
+
+/* 标准CRC-32, 反射多项式0xEDB88320 */
+static const uint32_t crc32_table[256] = {
+    0x00000000U, 0x77073096U, 0xEE0E612CU, 0x990951BAU, 0x076DC419U,
+    0x706AF48FU, 0xE963A535U, 0x9E6495A3U, 0x0EDB8832U, 0x79DCB8A4U,
+    0xE0D5E91EU, 0x97D2D988U, 0x09B64C2BU, 0x7EB17CBDU, 0xE7B82D07U,
+    0x90BF1D91U, 0x1DB71064U, 0x6AB020F2U, 0xF3B97148U, 0x84BE41DEU,
+    0x1ADAD47DU, 0x6DDDE4EBU, 0xF4D4B551U, 0x83D385C7U, 0x136C9856U,
+    0x646BA8C0U, 0xFD62F97AU, 0x8A65C9ECU, 0x14015C4FU, 0x63066CD9U,
+    0xFA0F3D63U, 0x8D080DF5U, 0x3B6E20C8U, 0x4C69105EU, 0xD56041E4U,
+    0xA2677172U, 0x3C03E4D1U, 0x4B04D447U, 0xD20D85FDU, 0xA50AB56BU,
+    0x35B5A8FAU, 0x42B2986CU, 0xDBBBC9D6U, 0xACBCF940U, 0x32D86CE3U,
+    0x45DF5C75U, 0xDCD60DCFU, 0xABD13D59U, 0x26D930ACU, 0x51DE003AU,
+    0xC8D75180U, 0xBFD06116U, 0x21B4F4B5U, 0x56B3C423U, 0xCFBA9599U,
+    0xB8BDA50FU, 0x2802B89EU, 0x5F058808U, 0xC60CD9B2U, 0xB10BE924U,
+    0x2F6F7C87U, 0x58684C11U, 0xC1611DABU, 0xB6662D3DU, 0x76DC4190U,
+    0x01DB7106U, 0x98D220BCU, 0xEFD5102AU, 0x71B18589U, 0x06B6B51FU,
+    0x9FBFE4A5U, 0xE8B8D433U, 0x7807C9A2U, 0x0F00F934U, 0x9609A88EU,
+    0xE10E9818U, 0x7F6A0DBBU, 0x086D3D2DU, 0x91646C97U, 0xE6635C01U,
+    0x6B6B51F4U, 0x1C6C6162U, 0x856530D8U, 0xF262004EU, 0x6C0695EDU,
+    0x1B01A57BU, 0x8208F4C1U, 0xF50FC457U, 0x65B0D9C6U, 0x12B7E950U,
+    0x8BBEB8EAU, 0xFCB9887CU, 0x62DD1DDFU, 0x15DA2D49U, 0x8CD37CF3U,
+    0xFBD44C65U, 0x4DB26158U, 0x3AB551CEU, 0xA3BC0074U, 0xD4BB30E2U,
+    0x4ADFA541U, 0x3DD895D7U, 0xA4D1C46DU, 0xD3D6F4FBU, 0x4369E96AU,
+    0x346ED9FCU, 0xAD678846U, 0xDA60B8D0U, 0x44042D73U, 0x33031DE5U,
+    0xAA0A4C5FU, 0xDD0D7CC9U, 0x5005713CU, 0x270241AAU, 0xBE0B1010U,
+    0xC90C2086U, 0x5768B525U, 0x206F85B3U, 0xB966D409U, 0xCE61E49FU,
+    0x5EDEF90EU, 0x29D9C998U, 0xB0D09822U, 0xC7D7A8B4U, 0x59B33D17U,
+    0x2EB40D81U, 0xB7BD5C3BU, 0xC0BA6CADU, 0xEDB88320U, 0x9ABFB3B6U,
+    0x03B6E20CU, 0x74B1D29AU, 0xEAD54739U, 0x9DD277AFU, 0x04DB2615U,
+    0x73DC1683U, 0xE3630B12U, 0x94643B84U, 0x0D6D6A3EU, 0x7A6A5AA8U,
+    0xE40ECF0BU, 0x9309FF9DU, 0x0A00AE27U, 0x7D079EB1U, 0xF00F9344U,
+    0x8708A3D2U, 0x1E01F268U, 0x6906C2FEU, 0xF762575DU, 0x806567CBU,
+    0x196C3671U, 0x6E6B06E7U, 0xFED41B76U, 0x89D32BE0U, 0x10DA7A5AU,
+    0x67DD4ACCU, 0xF9B9DF6FU, 0x8EBEEFF9U, 0x17B7BE43U, 0x60B08ED5U,
+    0xD6D6A3E8U, 0xA1D1937EU, 0x38D8C2C4U, 0x4FDFF252U, 0xD1BB67F1U,
+    0xA6BC5767U, 0x3FB506DDU, 0x48B2364BU, 0xD80D2BDAU, 0xAF0A1B4CU,
+    0x36034AF6U, 0x41047A60U, 0xDF60EFC3U, 0xA867DF55U, 0x316E8EEFU,
+    0x4669BE79U, 0xCB61B38CU, 0xBC66831AU, 0x256FD2A0U, 0x5268E236U,
+    0xCC0C7795U, 0xBB0B4703U, 0x220216B9U, 0x5505262FU, 0xC5BA3BBEU,
+    0xB2BD0B28U, 0x2BB45A92U, 0x5CB36A04U, 0xC2D7FFA7U, 0xB5D0CF31U,
+    0x2CD99E8BU, 0x5BDEAE1DU, 0x9B64C2B0U, 0xEC63F226U, 0x756AA39CU,
+    0x026D930AU, 0x9C0906A9U, 0xEB0E363FU, 0x72076785U, 0x05005713U,
+    0x95BF4A82U, 0xE2B87A14U, 0x7BB12BAEU, 0x0CB61B38U, 0x92D28E9BU,
+    0xE5D5BE0DU, 0x7CDCEFB7U, 0x0BDBDF21U, 0x86D3D2D4U, 0xF1D4E242U,
+    0x68DDB3F8U, 0x1FDA836EU, 0x81BE16CDU, 0xF6B9265BU, 0x6FB077E1U,
+    0x18B74777U, 0x88085AE6U, 0xFF0F6A70U, 0x66063BCAU, 0x11010B5CU,
+    0x8F659EFFU, 0xF862AE69U, 0x616BFFD3U, 0x166CCF45U, 0xA00AE278U,
+    0xD70DD2EEU, 0x4E048354U, 0x3903B3C2U, 0xA7672661U, 0xD06016F7U,
+    0x4969474DU, 0x3E6E77DBU, 0xAED16A4AU, 0xD9D65ADCU, 0x40DF0B66U,
+    0x37D83BF0U, 0xA9BCAE53U, 0xDEBB9EC5U, 0x47B2CF7FU, 0x30B5FFE9U,
+    0xBDBDF21CU, 0xCABAC28AU, 0x53B39330U, 0x24B4A3A6U, 0xBAD03605U,
+    0xCDD70693U, 0x54DE5729U, 0x23D967BFU, 0xB3667A2EU, 0xC4614AB8U,
+    0x5D681B02U, 0x2A6F2B94U, 0xB40BBE37U, 0xC30C8EA1U, 0x5A05DF1BU,
+    0x2D02EF8DU,
+};
+
+/* CRC单元, 多项式0x04C11DB7, 高位在前 */
+static const uint32_t crc32_word_table[256] = {
+    0x00000000U, 0x04C11DB7U, 0x09823B6EU, 0x0D4326D9U, 0x130476DCU,
+    0x17C56B6BU, 0x1A864DB2U, 0x1E475005U, 0x2608EDB8U, 0x22C9F00FU,
+    0x2F8AD6D6U, 0x2B4BCB61U, 0x350C9B64U, 0x31CD86D3U, 0x3C8EA00AU,
+    0x384FBDBDU, 0x4C11DB70U, 0x48D0C6C7U, 0x4593E01EU, 0x4152FDA9U,
+    0x5F15ADACU, 0x5BD4B01BU, 0x569796C2U, 0x52568B75U, 0x6A1936C8U,
+    0x6ED82B7FU, 0x639B0DA6U, 0x675A1011U, 0x791D4014U, 0x7DDC5DA3U,
+    0x709F7B7AU, 0x745E66CDU, 0x9823B6E0U, 0x9CE2AB57U, 0x91A18D8EU,
+    0x95609039U, 0x8B27C03CU, 0x8FE6DD8BU, 0x82A5FB52U, 0x8664E6E5U,
+    0xBE2B5B58U, 0xBAEA46EFU, 0xB7A96036U, 0xB3687D81U, 0xAD2F2D84U,
+    0xA9EE3033U, 0xA4AD16EAU, 0xA06C0B5DU, 0xD4326D90U, 0xD0F37027U,
+    0xDDB056FEU, 0xD9714B49U, 0xC7361B4CU, 0xC3F706FBU, 0xCEB42022U,
+    0xCA753D95U, 0xF23A8028U, 0xF6FB9D9FU, 0xFBB8BB46U, 0xFF79A6F1U,
+    0xE13EF6F4U, 0xE5FFEB43U, 0xE8BCCD9AU, 0xEC7DD02DU, 0x34867077U,
+    0x30476DC0U, 0x3D044B19U, 0x39C556AEU, 0x278206ABU, 0x23431B1CU,
+    0x2E003DC5U, 0x2AC12072U, 0x128E9DCFU, 0x164F8078U, 0x1B0CA6A1U,
+    0x1FCDBB16U, 0x018AEB13U, 0x054BF6A4U, 0x0808D07DU, 0x0CC9CDCAU,
+    0x7897AB07U, 0x7C56B6B0U, 0x71159069U, 0x75D48DDEU, 0x6B93DDDBU,
+    0x6F52C06CU, 0x6211E6B5U, 0x66D0FB02U, 0x5E9F46BFU, 0x5A5E5B08U,
+    0x571D7DD1U, 0x53DC6066U, 0x4D9B3063U, 0x495A2DD4U, 0x44190B0DU,
+    0x40D816BAU, 0xACA5C697U, 0xA864DB20U, 0xA527FDF9U, 0xA1E6E04EU,
+    0xBFA1B04BU, 0xBB60ADFCU, 0xB6238B25U, 0xB2E29692U, 0x8AAD2B2FU,
+    0x8E6C3698U, 0x832F1041U, 0x87EE0DF6U, 0x99A95DF3U, 0x9D684044U,
+    0x902B669DU, 0x94EA7B2AU, 0xE0B41DE7U, 0xE4750050U, 0xE9362689U,
+    0xEDF73B3EU, 0xF3B06B3BU, 0xF771768CU, 0xFA325055U, 0xFEF34DE2U,
+    0xC6BCF05FU, 0xC27DEDE8U, 0xCF3ECB31U, 0xCBFFD686U, 0xD5B88683U,
+    0xD1799B34U, 0xDC3ABDEDU, 0xD8FBA05AU, 0x690CE0EEU, 0x6DCDFD59U,
+    0x608EDB80U, 0x644FC637U, 0x7A089632U, 0x7EC98B85U, 0x738AAD5CU,
+    0x774BB0EBU, 0x4F040D56U, 0x4BC510E1U, 0x46863638U, 0x42472B8FU,
+    0x5C007B8AU, 0x58C1663DU, 0x558240E4U, 0x51435D53U, 0x251D3B9EU,
+    0x21DC2629U, 0x2C9F00F0U, 0x285E1D47U, 0x36194D42U, 0x32D850F5U,
+    0x3F9B762CU, 0x3B5A6B9BU, 0x0315D626U, 0x07D4CB91U, 0x0A97ED48U,
+    0x0E56F0FFU, 0x1011A0FAU, 0x14D0BD4DU, 0x19939B94U, 0x1D528623U,
+    0xF12F560EU, 0xF5EE4BB9U, 0xF8AD6D60U, 0xFC6C70D7U, 0xE22B20D2U,
+    0xE6EA3D65U, 0xEBA91BBCU, 0xEF68060BU, 0xD727BBB6U, 0xD3E6A601U,
+    0xDEA580D8U, 0xDA649D6FU, 0xC423CD6AU, 0xC0E2D0DDU, 0xCDA1F604U,
+    0xC960EBB3U, 0xBD3E8D7EU, 0xB9FF90C9U, 0xB4BCB610U, 0xB07DABA7U,
+    0xAE3AFBA2U, 0xAAFBE615U, 0xA7B8C0CCU, 0xA379DD7BU, 0x9B3660C6U,
+    0x9FF77D71U, 0x92B45BA8U, 0x9675461FU, 0x8832161AU, 0x8CF30BADU,
+    0x81B02D74U, 0x857130C3U, 0x5D8A9099U, 0x594B8D2EU, 0x5408ABF7U,
+    0x50C9B640U, 0x4E8EE645U, 0x4A4FFBF2U, 0x470CDD2BU, 0x43CDC09CU,
+    0x7B827D21U, 0x7F436096U, 0x7200464FU, 0x76C15BF8U, 0x68860BFDU,
+    0x6C47164AU, 0x61043093U, 0x65C52D24U, 0x119B4BE9U, 0x155A565EU,
+    0x18197087U, 0x1CD86D30U, 0x029F3D35U, 0x065E2082U, 0x0B1D065BU,
+    0x0FDC1BECU, 0x3793A651U, 0x3352BBE6U, 0x3E119D3FU, 0x3AD08088U,
+    0x2497D08DU, 0x2056CD3AU, 0x2D15EBE3U, 0x29D4F654U, 0xC5A92679U,
+    0xC1683BCEU, 0xCC2B1D17U, 0xC8EA00A0U, 0xD6AD50A5U, 0xD26C4D12U,
+    0xDF2F6BCBU, 0xDBEE767CU, 0xE3A1CBC1U, 0xE760D676U, 0xEA23F0AFU,
+    0xEEE2ED18U, 0xF0A5BD1DU, 0xF464A0AAU, 0xF9278673U, 0xFDE69BC4U,
+    0x89B8FD09U, 0x8D79E0BEU, 0x803AC667U, 0x84FBDBD0U, 0x9ABC8BD5U,
+    0x9E7D9662U, 0x933EB0BBU, 0x97FFAD0CU, 0xAFB010B1U, 0xAB710D06U,
+    0xA6322BDFU, 0xA2F33668U, 0xBCB4666DU, 0xB8757BDAU, 0xB5365D03U,
+    0xB1F740B4U,
+};
+
+/*****************************************************************************
+ * @defgroup 软件计算
+ * @{
+ */
+
+/**
+ * @brief 标准CRC-32查表计算, 不做初值和结果取反
+ *
+ * @param crc 余数寄存器
+ * @param data 数据
+ * @param len 数据长度
+ * @return 余数寄存器
+ */
+static uint32_t crc32_soft_raw(uint32_t crc, const uint8_t *data,
+                               uint32_t len) {
+    while (len--) {
+        crc = (crc >> 8) ^ crc32_table[(crc ^ *data++) & 0xFFU];
+    }
+
+    return crc;
+}
+
+/**
+ * @brief 软件计算标准CRC-32
+ *
+ * @param crc 上一段数据的CRC, 第一段为0
+ * @param data 数据
+ * @param len 数据长度
+ * @return CRC值
+ * @note 可以分段计算, 结果与整段计算相同
+ */
+uint32_t crc32_soft_update(uint32_t crc, const void *data, uint32_t len) {
+    return ~crc32_soft_raw(~crc, data, len);
+}
+
+/**
+ * @brief 软件计算与CRC单元相同的CRC
+ *
+ * @param data 数据, 按32位字读取
+ * @param nwords 字数
+ * @return CRC值
+ */
+uint32_t crc32_word_soft(const uint32_t *data, uint32_t nwords) {
+    uint32_t crc = CRC32_WORD_INIT;
+
+    while (nwords--) {
+        uint32_t word = *data++;
+
+        /* CRC单元从字的最高字节开始计算 */
+        for (uint32_t i = 0; i < sizeof(word); ++i) {
+            crc = (crc << 8) ^ crc32_word_table[(crc >> 24) ^ (word >> 24)];
+            word <<= 8;
+        }
+    }
+
+    return crc;
+}
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup 硬件计算
+ * @{
+ */
+
+#if (CRC32_USE_HW == 1)
+
+static uint32_t crc32_hw_ready;
+static volatile uint32_t crc32_hw_busy;
+
+#if (CRC32_USE_DMA == 1)
+static DMA_HandleTypeDef crc32_dma_handle;
+#endif /* CRC32_USE_DMA == 1 */
+
+/**
+ * @brief 初始化CRC单元和DMA
+ *
+ */
+void crc32_init(void) {
+    __HAL_RCC_CRC_CLK_ENABLE();
+
+#if (CRC32_USE_DMA == 1)
+    HAL_StatusTypeDef res = HAL_OK;
+
+    __HAL_RCC_DMA2_CLK_ENABLE();
+
+    /* 存储器到存储器: 源地址(外设端)递增, 目的地址CRC->DR固定 */
+    crc32_dma_handle.Instance = CRC32_DMA_CHANNEL;
+    crc32_dma_handle.Init.Direction = DMA_MEMORY_TO_MEMORY;
+    crc32_dma_handle.Init.PeriphInc = DMA_PINC_ENABLE;
+    crc32_dma_handle.Init.MemInc = DMA_MINC_DISABLE;
+    crc32_dma_handle.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+    crc32_dma_handle.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+    crc32_dma_handle.Init.Mode = DMA_NORMAL;
+    crc32_dma_handle.Init.Priority = DMA_PRIORITY_LOW;
+    res = HAL_DMA_Init(&crc32_dma_handle);
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+    UNUSED(res);
+#endif /* CRC32_USE_DMA == 1 */
+
+    crc32_hw_ready = 1;
+}
+
+/**
+ * @brief 占用CRC单元并复位
+ *
+ * @return 1: 成功; 0: 未初始化或正在被使用
+ */
+static uint32_t crc32_hw_acquire(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if ((crc32_hw_ready == 0) || (crc32_hw_busy != 0)) {
+        __set_PRIMASK(primask);
+        return 0;
+    }
+    crc32_hw_busy = 1;
+
+    __set_PRIMASK(primask);
+
+    CRC32_HW_RESET();
+    return 1;
+}
+
+/**
+ * @brief 释放CRC单元
+ *
+ */
+static inline void crc32_hw_release(void) {
+    crc32_hw_busy = 0;
+}
+
+/**
+ * @brief CPU将字节流按小端字位反转后写入CRC单元
+ *
+ * @param data 数据, 不要求对齐
+ * @param nwords 字数
+ * @note 字内位反转后, CRC单元高位在前的计算等价于标准CRC-32的低位在前
+ */
+static void crc32_hw_feed_rbit(const uint8_t *data, uint32_t nwords) {
+    uint32_t word;
+
+    while (nwords--) {
+        memcpy(&word, data, sizeof(word));
+        CRC32_HW_WRITE(__RBIT(word));
+        data += sizeof(word);
+    }
+}
+
+/**
+ * @brief CPU将字写入CRC单元
+ *
+ * @param data 数据
+ * @param nwords 字数
+ */
+static void crc32_hw_feed_cpu(const uint32_t *data, uint32_t nwords) {
+    while (nwords--) {
+        CRC32_HW_WRITE(*data++);
+    }
+}
+
+#if (CRC32_USE_DMA == 1)
+
+/**
+ * @brief DMA将字写入CRC单元, 等待传输完成
+ *
+ * @param data 数据
+ * @param nwords 字数
+ */
+static void crc32_hw_feed_dma(const uint32_t *data, uint32_t nwords) {
+    HAL_StatusTypeDef res = HAL_OK;
+    uint32_t n;
+
+    while (nwords != 0) {
+        /* 单次传输最多65535个数据 */
+        n = (nwords > 0xFFFFU) ? 0xFFFFU : nwords;
+
+        res = HAL_DMA_Start(&crc32_dma_handle, (uint32_t)data,
+                            (uint32_t)&CRC32_REGS->DR, n);
+#ifdef DEBUG
+        assert(res == HAL_OK);
+#endif /* DEBUG */
+        res = HAL_DMA_PollForTransfer(&crc32_dma_handle, HAL_DMA_FULL_TRANSFER,
+                                      HAL_MAX_DELAY);
+#ifdef DEBUG
+        assert(res == HAL_OK);
+#endif /* DEBUG */
+
+        data += n;
+        nwords -= n;
+    }
+
+    UNUSED(res);
+}
+
+#endif /* CRC32_USE_DMA == 1 */
+
+#else /* CRC32_USE_HW == 1 */
+
+/**
+ * @brief 不使用硬件CRC单元, 无需初始化
+ *
+ */
+void crc32_init(void) {
+}
+
+#endif /* CRC32_USE_HW == 1 */
+
+/**
+ * @brief 计算标准CRC-32
+ *
+ * @param data 数据, 不要求对齐
+ * @param len 数据长度
+ * @return CRC值, 与crc32_soft_update(0, data, len)相同
+ * @note 整4字节部分由CRC单元计算, 剩余部分用软件接着计算.
+ *       CRC单元被占用时全部用软件计算
+ */
+uint32_t crc32_calc(const void *data, uint32_t len) {
+#if (CRC32_USE_HW == 1)
+    const uint8_t *p = data;
+    uint32_t crc;
+
+    if ((len >= sizeof(uint32_t)) && crc32_hw_acquire()) {
+        crc32_hw_feed_rbit(p, len / sizeof(uint32_t));
+        /* 结果位反转后即为软件算法的余数寄存器 */
+        crc = __RBIT(CRC32_REGS->DR);
+        crc32_hw_release();
+
+        return ~crc32_soft_raw(crc, p + (len & ~0x03U), len & 0x03U);
+    }
+#endif /* CRC32_USE_HW == 1 */
+
+    return crc32_soft_update(0, data, len);
+}
+
+/**
+ * @brief 按CRC单元的原生方式计算CRC
+ *
+ * @param data 数据, 4字节对齐
+ * @param nwords 字数
+ * @return CRC值, 与crc32_word_soft相同
+ * @note 数据较长时由DMA写入, 调用者等待DMA完成
+ */
+uint32_t crc32_word_calc(const uint32_t *data, uint32_t nwords) {
+#if (CRC32_USE_HW == 1)
+    uint32_t crc;
+
+    if ((nwords != 0) && crc32_hw_acquire()) {
+#if (CRC32_USE_DMA == 1)
+        if (nwords * sizeof(uint32_t) >= CRC32_DMA_MIN_LEN) {
+            crc32_hw_feed_dma(data, nwords);
+        } else
+#endif /* CRC32_USE_DMA == 1 */
+        {
+            crc32_hw_feed_cpu(data, nwords);
+        }
+
+        crc = CRC32_REGS->DR;
+        crc32_hw_release();
+
+        return crc;
+    }
+#endif /* CRC32_USE_HW == 1 */
+
+    return crc32_word_soft(data, nwords);
+}
+
+/**
+ * @}
+ */
+
+#if (CRC32_BENCHMARK == 1)
+
+#define CRC32_BENCH_LEN 1024U
+
+static uint32_t crc32_bench_buf[CRC32_BENCH_LEN / sizeof(uint32_t)];
+
+/**
+ * @brief 打印一项测试结果
+ *
+ * @param name 测试项
+ * @param cycles 耗费的周期数
+ */
+static void crc32_bench_print(const char *name, uint32_t cycles) {
+    printf("%-10s %5u.%02u cycles/byte\r\n", name,
+           (unsigned int)(cycles / CRC32_BENCH_LEN),
+           (unsigned int)(cycles % CRC32_BENCH_LEN * 100 / CRC32_BENCH_LEN));
+}
+
+/**
+ * @brief 测量各种计算方式每字节耗费的周期数, 并校验结果
+ *
+ * @note 测量时关闭中断
+ */
+void crc32_benchmark(void) {
+    uint32_t primask;
+    uint32_t start;
+    uint32_t cycles;
+    uint32_t pass;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    for (uint32_t i = 0; i < CRC32_BENCH_LEN / sizeof(uint32_t); ++i) {
+        crc32_bench_buf[i] = i * 0x9E3779B9U;
+    }
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    start = DWT->CYCCNT;
+    crc32_soft_update(0, crc32_bench_buf, CRC32_BENCH_LEN);
+    cycles = DWT->CYCCNT - start;
+    crc32_bench_print("soft", cycles);
+
+    start = DWT->CYCCNT;
+    crc32_word_soft(crc32_bench_buf, CRC32_BENCH_LEN / sizeof(uint32_t));
+    cycles = DWT->CYCCNT - start;
+    crc32_bench_print("word soft", cycles);
+
+#if (CRC32_USE_HW == 1)
+    if (crc32_hw_acquire()) {
+        start = DWT->CYCCNT;
+        crc32_hw_feed_rbit((const uint8_t *)crc32_bench_buf,
+                           CRC32_BENCH_LEN / sizeof(uint32_t));
+        (void)CRC32_REGS->DR;
+        cycles = DWT->CYCCNT - start;
+        crc32_bench_print("hw rbit", cycles);
+
+        CRC32_HW_RESET();
+        start = DWT->CYCCNT;
+        crc32_hw_feed_cpu(crc32_bench_buf, CRC32_BENCH_LEN / sizeof(uint32_t));
+        (void)CRC32_REGS->DR;
+        cycles = DWT->CYCCNT - start;
+        crc32_bench_print("hw cpu", cycles);
+
+#if (CRC32_USE_DMA == 1)
+        CRC32_HW_RESET();
+        start = DWT->CYCCNT;
+        crc32_hw_feed_dma(crc32_bench_buf, CRC32_BENCH_LEN / sizeof(uint32_t));
+        (void)CRC32_REGS->DR;
+        cycles = DWT->CYCCNT - start;
+        crc32_bench_print("hw dma", cycles);
+#endif /* CRC32_USE_DMA == 1 */
+
+        crc32_hw_release();
+    } else {
+        printf("CRC unit not available. \r\n");
+    }
+#endif /* CRC32_USE_HW == 1 */
+
+    __set_PRIMASK(primask);
+
+    /* 硬件与软件结果一致, 且标准CRC-32的校验值正确 */
+    pass = (crc32_calc("123456789", 9) == 0xCBF43926U);
+    for (uint32_t len = CRC32_BENCH_LEN - 3; len <= CRC32_BENCH_LEN; ++len) {
+        pass &= (crc32_calc(crc32_bench_buf, len) ==
+                 crc32_soft_update(0, crc32_bench_buf, len));
+    }
+    pass &= (crc32_word_calc(crc32_bench_buf,
+                             CRC32_BENCH_LEN / sizeof(uint32_t)) ==
+             crc32_word_soft(crc32_bench_buf,
+                             CRC32_BENCH_LEN / sizeof(uint32_t)));
+    printf("CRC32 check: %s \r\n", pass ? "pass" : "FAIL");
+}
+
+#endif /* CRC32_BENCHMARK == 1 */
@@ -1,7 +1,8 @@
 /**
  * @file    dma_uart.c
  * @author  Deadline039
- * @brief   使用DMA+半满中断+满中断+空闲中断实现高可靠串口数据收发
+ * @brief   使用DMA+半满中断+满中断+空闲中断实现高可靠串口数据收发,
+ *          没有使用DMA的串口使用RXNE/TXE中断收发
  * @version 1.1
  * @date    2024-01-18
  * @note    stm32f103串口DMA配置文件
@@ -12,22 +13,111 @@
 #include "bsp.h"
 #include "ring_fifo.h"
 #include "uart.h"
+#include "uart_port.h"
 
+#include <stdarg.h>
+#include <stdio.h>
 #include <string.h>
 
+#if (UART_USE_FREERTOS == 1)
+#include "FreeRTOS.h"
+#include "semphr.h"
+#include "task.h"
+
+/* 接收中断中会通知等待数据的任务, 需要允许调用FreeRTOS API */
+#define UART_RTOS_PRIO_OK(preempt)                                             \
+    ((preempt) >= configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY)
+#else /* UART_USE_FREERTOS == 1 */
+#define UART_RTOS_PRIO_OK(preempt) 1
+#endif /* UART_USE_FREERTOS == 1 */
+
+#if !RING_FIFO_IS_POW2(UART_LINE_QUEUE_SIZE)
+#error "UART_LINE_QUEUE_SIZE必须为2的幂次方"
+#endif /* UART_LINE_QUEUE_SIZE */
+
+/* 有串口启用空闲中断合并时才使用合并定时器, 未启用DMA接收的串口按0计算 */
+#define UART_COALESCE_BATCH_SUM(name, p, ...) p##RX_COALESCE_BATCH +
+#if ((UART_PORT_LIST(UART_COALESCE_BATCH_SUM) 0) > 0)
+#define UART_RX_COALESCE 1
+#else /* RX_COALESCE_BATCH */
+#define UART_RX_COALESCE 0
+#endif /* RX_COALESCE_BATCH */
+
+/* 最大延迟(us)换算为合并定时器周期数, 至少为1 */
+#define UART_COALESCE_TICKS(us)                                                \
+    (((us) + UART_COALESCE_TICK_US - 1) / UART_COALESCE_TICK_US + ((us) == 0))
+
+#if ((UART_RX_COALESCE == 1) && !UART_RTOS_PRIO_OK(UART_COALESCE_IT_PREEMPT))
+#error "UART_COALESCE_IT_PREEMPT高于configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY"
+#endif /* UART_RTOS_PRIO_OK */
+
+/* 会拷贝DMA接收数据的中断(DMA接收, 串口和合并定时器)中最高的抢占优先级 */
+#define UART_PRIO_MIN(a, b) (((a) < (b)) ? (a) : (b))
+#if (UART_RX_COALESCE == 1)
+#define UART_RX_LOCK_PREEMPT(p)                                                \
+    UART_PRIO_MIN(UART_PRIO_MIN(p##DMA_RX_IT_PREEMPT, p##IT_PREEMPT),          \
+                  UART_COALESCE_IT_PREEMPT)
+#else /* UART_RX_COALESCE == 1 */
+#define UART_RX_LOCK_PREEMPT(p)                                                \
+    UART_PRIO_MIN(p##DMA_RX_IT_PREEMPT, p##IT_PREEMPT)
+#endif /* UART_RX_COALESCE == 1 */
+
+/* 抢占优先级换算为BASEPRI, 按HAL_Init设置的NVIC_PRIORITYGROUP_4 */
+#define UART_BASEPRI(preempt) ((uint32_t)(preempt) << (8U - __NVIC_PRIO_BITS))
+
+#if (UART_ISR_CYCLES == 1)
+/* 记录中断处理开始时的周期计数 */
+#define UART_ISR_ENTER()     uint32_t uart_isr_start = DWT->CYCCNT
+/* 累计本次中断处理的周期数 */
+#define UART_ISR_EXIT(stats) uart_isr_cycles((stats), uart_isr_start)
+#else /* UART_ISR_CYCLES == 1 */
+#define UART_ISR_ENTER()                                                       \
+    do {                                                                       \
+    } while (0)
+#define UART_ISR_EXIT(stats)                                                   \
+    do {                                                                       \
+    } while (0)
+#endif /* UART_ISR_CYCLES == 1 */
+
 void uart_dmatx_clear_tc_flag(UART_HandleTypeDef *huart);
 
 void uart_dmarx_halfdone_callback(UART_HandleTypeDef *huart);
 void uart_dmarx_done_callback(UART_HandleTypeDef *huart);
 
+#if (UART_RX_COALESCE == 1)
+static void uart_coalesce_init(void);
+#endif /* UART_RX_COALESCE == 1 */
+
 /**
  * @brief 串口发送缓冲区
  */
 typedef struct {
-    uint8_t *send_buf;     /*!< 发送数据缓冲区 */
-    uint32_t head_ptr;     /*!< 位置指针, 用来控制DMA传输的长度 */
-    size_t send_buf_size;  /*!< 缓冲区大小, 避免溢出 */
+    DMA_HandleTypeDef *hdma; /*!< 发送DMA句柄, NULL时使用TXE中断发送 */
+    IRQn_Type dma_irqn;      /*!< DMA中断号 */
+    uint8_t it_preempt;      /*!< DMA中断抢占优先级 */
+    uint8_t it_sub;          /*!< DMA中断子优先级 */
+    uint8_t *tx_fifo_buf;    /*!< FIFO数据存储区 */
+    uint32_t tx_fifo_size;   /*!< FIFO数据存储区大小 */
+
+    ring_fifo_t ring;      /*!< FIFO句柄存储区 */
+    ring_fifo_t *tx_fifo;  /*!< 发送FIFO */
+    uart_stats_t *stats;   /*!< 串口统计 */
+    uint32_t xfer_len;     /*!< 当前DMA传输的长度 */
     __IO uint32_t tc_flag; /*!< 是否发送完成, 0-未完成; 1-完成 */
+    __IO uint32_t lock;    /*!< 写入锁, 保证同一时刻只有一个写入者 */
+#if (UART_USE_FREERTOS == 1)
+    SemaphoreHandle_t mutex; /*!< 写入互斥量, 多个任务写入时排队等待 */
+    uint32_t mutex_held;     /*!< 写入锁的持有者是否同时持有互斥量 */
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+    StaticSemaphore_t mutex_buf; /*!< 互斥量存储区 */
+#endif /* configSUPPORT_STATIC_ALLOCATION == 1 */
+#endif /* UART_USE_FREERTOS == 1 */
+
+    uint32_t gap_count;    /*!< 发送间隙次数 */
+    uint32_t gap_ms;       /*!< 累计发送间隙时长 */
+    uint32_t idle_tick;    /*!< DMA进入空闲的时刻 */
+    uint32_t stat_bytes;   /*!< 上次查询吞吐时的累计发送字节数 */
+    uint32_t stat_tick;    /*!< 上次查询吞吐的时刻 */
 } uart_tx_buf_t;
 
 /**
@@ -35,203 +125,305 @@ typedef struct {
  *
  */
 typedef struct {
-    ring_fifo_t *rx_fifo; /*!< 接收FIFO */
-    uint8_t *rx_fifo_buf; /*!< FIFO数据存储区 */
-    uint8_t *recv_buf;    /*!< DMA接收数据缓冲区 */
-    uint32_t head_ptr;    /*!< 位置指针, 用来控制半满和溢出 */
+    DMA_HandleTypeDef *hdma; /*!< 接收DMA句柄, NULL时使用RXNE中断接收 */
+    IRQn_Type dma_irqn;      /*!< DMA中断号 */
+    uint8_t it_preempt;      /*!< DMA中断抢占优先级 */
+    uint8_t it_sub;          /*!< DMA中断子优先级 */
+    uint8_t lock_preempt;    /*!< 拷贝时屏蔽的抢占优先级 */
+    uint8_t use_idle_it;     /*!< 是否启用空闲中断 */
+    uint8_t dma_to_fifo;     /*!< DMA是否直接写入FIFO数据存储区 */
+    uint16_t coalesce_batch; /*!< 空闲中断合并批量, 0为立即拷贝 */
+    uint16_t coalesce_ticks; /*!< 空闲中断合并最大延迟(定时器周期数) */
+    uint8_t *rx_fifo_buf;    /*!< FIFO数据存储区 */
+    uint32_t rx_fifo_size;   /*!< FIFO数据存储区大小 */
+    uint8_t *recv_buf;       /*!< DMA接收数据缓冲区 */
+    uint16_t recv_buf_size;  /*!< DMA接收数据缓冲区大小 */
+
+    ring_fifo_t ring;        /*!< FIFO句柄存储区 */
+    ring_fifo_t *rx_fifo;    /*!< 接收FIFO */
+    uart_stats_t *stats;     /*!< 串口统计 */
+    __IO uint8_t overrun;    /*!< FIFO溢出标志, 仅在DMA直接写入FIFO时使用 */
+    uint32_t head_ptr;       /*!< 位置指针, 用来控制半满和溢出 */
+
+    __IO uint32_t coalesce_left; /*!< 推迟拷贝剩余的定时器周期数, 0为未推迟 */
+    uint32_t deferred;           /*!< 推迟拷贝的次数 */
+    uint32_t stat_irqs;          /*!< 上次查询时的累计接收中断次数 */
+    uint32_t stat_bytes;         /*!< 上次查询时的累计接收字节数 */
+    uint32_t stat_tick;          /*!< 上次查询的时刻 */
+
+    uint8_t line_mode;       /*!< 是否记录行尾位置 */
+    uint8_t line_delim;      /*!< 行结束符 */
+    __IO uint32_t line_in;   /*!< 行尾队列写入计数 */
+    __IO uint32_t line_out;  /*!< 行尾队列读出计数 */
+    uint32_t line_scan;      /*!< 已查找行结束符的FIFO位置 */
+    __IO uint8_t line_busy;  /*!< 正在查找行结束符 */
+    uint32_t line_end[UART_LINE_QUEUE_SIZE]; /*!< 行尾在FIFO中的位置(不含) */
+
+    GPIO_TypeDef *rts_port; /*!< 软件RTS引脚, NULL时不使用接收流控 */
+    uint16_t rts_pin;       /*!< 软件RTS引脚号 */
+    uint8_t rts_high_pct;   /*!< 高水位(FIFO大小的%) */
+    uint8_t rts_low_pct;    /*!< 低水位(FIFO大小的%) */
+    uint8_t flow_ctrl;      /*!< 是否启用接收流控 */
+    __IO uint8_t rts_off;   /*!< RTS已置高, 对端暂停发送 */
+    uint32_t rts_high;      /*!< 高水位(byte) */
+    uint32_t rts_low;       /*!< 低水位(byte) */
+    uint32_t flow_pauses;   /*!< 暂停对端发送的次数 */
+
+#if (UART_USE_FREERTOS == 1)
+    __IO TaskHandle_t waiter; /*!< 等待数据的任务 */
+    uint32_t wait_len;        /*!< 唤醒等待任务所需的数据量, 0表示等待一行 */
+#endif /* UART_USE_FREERTOS == 1 */
 } uart_rx_fifo_t;
 
-#if (USART1_ENABLE == 1)
-
-#if (USART1_USE_DMA_TX == 1)
-static DMA_HandleTypeDef usart1_dmatx_handle = {
-    .Instance = DMA1_Channel4,
-    .Init.Direction = DMA_MEMORY_TO_PERIPH,       /* 发送, 内存到外设 */
-    .Init.MemDataAlignment = DMA_MDATAALIGN_BYTE, /* 内存以字节对齐 */
-    .Init.MemInc = DMA_MINC_ENABLE,               /* 启用内存地址自增 */
-    .Init.Mode = DMA_NORMAL,                      /* 正常模式 */
-    .Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE, /* 外设以字节对齐 */
-    .Init.PeriphInc = DMA_PINC_DISABLE,     /* 关闭外设地址自增 */
-    .Init.Priority = USART1_DMA_TX_PRIORITY /* DMA优先级 */
-};
-static uart_tx_buf_t usart1_tx_buf;
+/* DMA句柄初始值, 内存和外设以字节对齐, 内存地址自增 */
+#define UART_DMA_HANDLE(channel, direction, mode, priority)                    \
+    {                                                                          \
+        .Instance = (channel),                                                 \
+        .Init.Direction = (direction),                                         \
+        .Init.MemDataAlignment = DMA_MDATAALIGN_BYTE,                          \
+        .Init.MemInc = DMA_MINC_ENABLE,                                        \
+        .Init.Mode = (mode),                                                   \
+        .Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE,                       \
+        .Init.PeriphInc = DMA_PINC_DISABLE,                                    \
+        .Init.Priority = (priority),                                           \
+    }
 
 /**
- * @brief 串口1发送中断句柄
- *
+ * 发送缓冲区, 按USE_DMA_TX和USE_IT选择DMA发送(同时启用时使用DMA),
+ * 中断发送或不使用发送缓冲区. DMA发送时同时定义DMA句柄和DMA中断处理函数
  */
-void DMA1_Channel4_IRQHandler(void) {
-    HAL_DMA_IRQHandler(&usart1_dmatx_handle);
-}
-#endif /* USART1_USE_DMA_TX == 1 */
+#define UART_TX_DEFINE(name, p, ch, irq)                                       \
+    UART_CAT(UART_TX_DEFINE_, UART_CAT(p##USE_DMA_TX, p##USE_IT))             \
+    (name, p, ch, irq)
+#define UART_TX_DEFINE_00(name, p, ch, irq)
+#define UART_TX_DEFINE_01(name, p, ch, irq)                                    \
+    static uint8_t name##_tx_fifo_buf[p##IT_TX_FIFO_SIZE];                     \
+    static uart_tx_buf_t name##_tx_buf = {                                     \
+        .tx_fifo_buf = name##_tx_fifo_buf,                                     \
+        .tx_fifo_size = sizeof(name##_tx_fifo_buf),                            \
+    };                                                                         \
+    UART_STATIC_ASSERT(RING_FIFO_IS_POW2(p##IT_TX_FIFO_SIZE),                  \
+                       name##_it_tx_fifo_size_must_be_pow2);
+#define UART_TX_DEFINE_10(name, p, ch, irq)                                    \
+    static DMA_HandleTypeDef name##_dmatx_handle = UART_DMA_HANDLE(            \
+        ch, DMA_MEMORY_TO_PERIPH, DMA_NORMAL, p##DMA_TX_PRIORITY);             \
+    static uint8_t name##_tx_fifo_buf[p##TX_BUF_SIZE];                         \
+    static uart_tx_buf_t name##_tx_buf = {                                     \
+        .hdma = &name##_dmatx_handle,                                          \
+        .dma_irqn = irq##IRQn,                                                 \
+        .it_preempt = p##DMA_TX_IT_PREEMPT,                                    \
+        .it_sub = p##DMA_TX_IT_SUB,                                            \
+        .tx_fifo_buf = name##_tx_fifo_buf,                                     \
+        .tx_fifo_size = sizeof(name##_tx_fifo_buf),                            \
+    };                                                                         \
+    UART_STATIC_ASSERT(RING_FIFO_IS_POW2(p##TX_BUF_SIZE),                      \
+                       name##_tx_buf_size_must_be_pow2);                       \
+    void irq##IRQHandler(void) {                                               \
+        HAL_DMA_IRQHandler(&name##_dmatx_handle);                              \
+    }
+#define UART_TX_DEFINE_11 UART_TX_DEFINE_10
 
-#if (USART1_USE_DMA_RX == 1)
-static DMA_HandleTypeDef usart1_dmarx_handle = {
-    .Instance = DMA1_Channel5,
-    .Init.Direction = DMA_PERIPH_TO_MEMORY,       /* 接收, 外设到内存 */
-    .Init.MemDataAlignment = DMA_MDATAALIGN_BYTE, /* 内存以字节对齐 */
-    .Init.MemInc = DMA_MINC_ENABLE,               /* 启用内存地址自增 */
-    .Init.Mode = DMA_CIRCULAR,                    /* 正常模式 */
-    .Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE, /* 外设以字节对齐 */
-    .Init.PeriphInc = DMA_PINC_DISABLE,     /* 关闭外设地址自增 */
-    .Init.Priority = USART1_DMA_RX_PRIORITY /* DMA优先级 */
-};
-static uart_rx_fifo_t usart1_rx_fifo;
+/* 软件RTS引脚和水位 */
+#define UART_RX_RTS(p)                                                         \
+    .rts_port = p##RTS_GPIO_PORT, .rts_pin = p##RTS_GPIO_PIN,                  \
+    .rts_high_pct = p##RX_HIGH_WATER, .rts_low_pct = p##RX_LOW_WATER,
+
+/* DMA直接写入FIFO时以FIFO数据存储区为DMA接收缓冲区, 否则单独定义 */
+#define UART_RECV_BUF(name, p) UART_CAT(UART_RECV_BUF_, p##DMA_RX_TO_FIFO)(name)
+#define UART_RECV_BUF_0(name)  name##_recv_buf
+#define UART_RECV_BUF_1(name)  name##_rx_fifo_buf
 
 /**
- * @brief 串口1接收中断句柄
- *
+ * 接收缓冲区, 按USE_DMA_RX和USE_IT选择DMA接收(同时启用时使用DMA),
+ * 中断接收或不使用接收缓冲区. DMA接收时同时定义DMA句柄和DMA中断处理函数
  */
-void DMA1_Channel5_IRQHandler(void) {
-    HAL_DMA_IRQHandler(&usart1_dmarx_handle);
-}
-#endif /* USART1_USE_DMA_RX == 1 */
-
-#endif /* USART1_ENABLE == 1 */
+#define UART_RX_DEFINE(name, p, ch, irq)                                       \
+    UART_CAT(UART_RX_DEFINE_, UART_CAT(p##USE_DMA_RX, p##USE_IT))             \
+    (name, p, ch, irq)
+#define UART_RX_DEFINE_00(name, p, ch, irq)
+#define UART_RX_DEFINE_01(name, p, ch, irq)                                    \
+    static uint8_t name##_rx_fifo_buf[p##IT_RX_FIFO_SIZE];                     \
+    static uart_rx_fifo_t name##_rx_fifo = {                                   \
+        .rx_fifo_buf = name##_rx_fifo_buf,                                     \
+        .rx_fifo_size = sizeof(name##_rx_fifo_buf),                            \
+        UART_IF(p##RX_FLOW_CTRL)(UART_RX_RTS(p))};                             \
+    UART_STATIC_ASSERT(RING_FIFO_IS_POW2(p##IT_RX_FIFO_SIZE),                  \
+                       name##_it_rx_fifo_size_must_be_pow2);                   \
+    UART_STATIC_ASSERT(UART_RTOS_PRIO_OK(p##IT_PREEMPT),                       \
+                       name##_it_preempt_above_max_syscall_priority);
+#define UART_RX_DEFINE_10(name, p, ch, irq)                                    \
+    static DMA_HandleTypeDef name##_dmarx_handle = UART_DMA_HANDLE(            \
+        ch, DMA_PERIPH_TO_MEMORY, DMA_CIRCULAR, p##DMA_RX_PRIORITY);           \
+    static uint8_t name##_rx_fifo_buf[p##RX_FIFO_SZIE];                        \
+    UART_IF(UART_NOT(p##DMA_RX_TO_FIFO))(                                      \
+        static uint8_t name##_recv_buf[p##RX_BUF_SIZE];)                       \
+    static uart_rx_fifo_t name##_rx_fifo = {                                   \
+        .hdma = &name##_dmarx_handle,                                          \
+        .dma_irqn = irq##IRQn,                                                 \
+        .it_preempt = p##DMA_RX_IT_PREEMPT,                                    \
+        .it_sub = p##DMA_RX_IT_SUB,                                            \
+        .lock_preempt = UART_RX_LOCK_PREEMPT(p),                               \
+        .use_idle_it = p##USE_IDLE_IT,                                         \
+        .coalesce_batch = p##RX_COALESCE_BATCH,                                \
+        .coalesce_ticks = UART_COALESCE_TICKS(p##RX_COALESCE_US),              \
+        .rx_fifo_buf = name##_rx_fifo_buf,                                     \
+        .rx_fifo_size = sizeof(name##_rx_fifo_buf),                            \
+        .dma_to_fifo = p##DMA_RX_TO_FIFO,                                      \
+        .recv_buf = UART_RECV_BUF(name, p),                                    \
+        .recv_buf_size = sizeof(UART_RECV_BUF(name, p)),                       \
+        UART_IF(p##RX_FLOW_CTRL)(UART_RX_RTS(p))};                             \
+    UART_STATIC_ASSERT(RING_FIFO_IS_POW2(p##RX_FIFO_SZIE),                     \
+                       name##_rx_fifo_size_must_be_pow2);                      \
+    UART_STATIC_ASSERT(UART_RTOS_PRIO_OK(p##DMA_RX_IT_PREEMPT) &&              \
+                           UART_RTOS_PRIO_OK(p##IT_PREEMPT),                   \
+                       name##_rx_preempt_above_max_syscall_priority);          \
+    /* DMA直接写入FIFO时FIFO大小不能超过DMA单次最大传输长度 */                 \
+    UART_STATIC_ASSERT(!p##DMA_RX_TO_FIFO || (p##RX_FIFO_SZIE <= 32768),       \
+                       name##_rx_fifo_size_exceeds_dma_length);                \
+    void irq##IRQHandler(void) {                                               \
+        HAL_DMA_IRQHandler(&name##_dmarx_handle);                              \
+    }
+#define UART_RX_DEFINE_11 UART_RX_DEFINE_10
+
+/* 一个串口的统计, 发送和接收缓冲区 */
+#define UART_PORT_DEFINE(name, p, tx_ch, tx_irq, rx_ch, rx_irq)                \
+    UART_IF(p##ENABLE)(                                                        \
+        static uart_stats_t name##_stats;                                      \
+        UART_TX_DEFINE(name, p, tx_ch, tx_irq)                                 \
+        UART_RX_DEFINE(name, p, rx_ch, rx_irq)                                 \
+        UART_IF(p##RX_FLOW_CTRL)(UART_STATIC_ASSERT(                           \
+            p##RX_LOW_WATER < p##RX_HIGH_WATER,                                \
+            name##_rx_low_water_must_be_below_high_water);))
+
+UART_PORT_LIST(UART_PORT_DEFINE)
+
+/* 查表的表项, 未启用的串口为NULL */
+#define UART_TX_ENTRY(name, p, ...)                                            \
+    UART_IF(p##ENABLE)(UART_IF(UART_OR(p##USE_DMA_TX, p##USE_IT))(             \
+        [UART_PORT_INDEX(p##BASE)] = &name##_tx_buf, ))
+#define UART_RX_ENTRY(name, p, ...)                                            \
+    UART_IF(p##ENABLE)(UART_IF(UART_OR(p##USE_DMA_RX, p##USE_IT))(             \
+        [UART_PORT_INDEX(p##BASE)] = &name##_rx_fifo, ))
+#define UART_STATS_ENTRY(name, p, ...)                                         \
+    UART_IF(p##ENABLE)([UART_PORT_INDEX(p##BASE)] = &name##_stats, )
+
+/* 按串口编号索引的发送缓冲区, 未启用DMA或中断发送的串口为NULL.
+   编号0不对应串口, 保证没有启用串口时初始化列表不为空 */
+static uart_tx_buf_t *const uart_tx_table[UART_PORT_NUM] = {
+    [0] = NULL,
+    UART_PORT_LIST(UART_TX_ENTRY)
+};
 
-#if (USART2_ENABLE == 1)
+/* 按串口编号索引的接收缓冲区, 未启用DMA或中断接收的串口为NULL */
+static uart_rx_fifo_t *const uart_rx_table[UART_PORT_NUM] = {
+    [0] = NULL,
+    UART_PORT_LIST(UART_RX_ENTRY)
+};
 
-#if (USART2_USE_DMA_TX == 1)
-static DMA_HandleTypeDef usart2_dmatx_handle = {
-    .Instance = DMA1_Channel7,
-    .Init.Direction = DMA_MEMORY_TO_PERIPH,       /* 发送, 内存到外设 */
-    .Init.MemDataAlignment = DMA_MDATAALIGN_BYTE, /* 内存以字节对齐 */
-    .Init.MemInc = DMA_MINC_ENABLE,               /* 启用内存地址自增 */
-    .Init.Mode = DMA_NORMAL,                      /* 正常模式 */
-    .Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE, /* 外设以字节对齐 */
-    .Init.PeriphInc = DMA_PINC_DISABLE,     /* 关闭外设地址自增 */
-    .Init.Priority = USART2_DMA_TX_PRIORITY /* DMA优先级 */
+/* 按串口编号索引的统计, 未启用的串口为NULL */
+static uart_stats_t *const uart_stats_table[UART_PORT_NUM] = {
+    [0] = NULL,
+    UART_PORT_LIST(UART_STATS_ENTRY)
 };
-static uart_tx_buf_t usart2_tx_buf;
 
 /**
- * @brief 串口2发送中断句柄
+ * @brief 根据串口句柄, 判断是哪个发送缓冲区指针
  *
+ * @param huart 串口句柄
+ * @return 发送缓冲区指针
  */
-void DMA1_Channel7_IRQHandler(void) {
-    HAL_DMA_IRQHandler(&usart2_dmatx_handle);
+static inline uart_tx_buf_t *uart_tx_identify(UART_HandleTypeDef *huart) {
+    return uart_tx_table[UART_PORT_INDEX(huart->Instance)];
 }
-#endif /* USART2_USE_DMA_TX == 1 */
-
-#if (USART2_USE_DMA_RX == 1)
-static DMA_HandleTypeDef usart2_dmarx_handle = {
-    .Instance = DMA1_Channel6,
-    .Init.Direction = DMA_PERIPH_TO_MEMORY,       /* 接收, 外设到内存 */
-    .Init.MemDataAlignment = DMA_MDATAALIGN_BYTE, /* 内存以字节对齐 */
-    .Init.MemInc = DMA_MINC_ENABLE,               /* 启用内存地址自增 */
-    .Init.Mode = DMA_CIRCULAR,                    /* 正常模式 */
-    .Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE, /* 外设以字节对齐 */
-    .Init.PeriphInc = DMA_PINC_DISABLE,     /* 关闭外设地址自增 */
-    .Init.Priority = USART2_DMA_RX_PRIORITY /* DMA优先级 */
-};
-static uart_rx_fifo_t usart2_rx_fifo;
 
 /**
- * @brief 串口2接收中断句柄
+ * @brief 根据串口句柄, 判断是哪个接收缓冲区指针
  *
+ * @param huart 串口句柄
+ * @return 接收缓冲区指针
  */
-void DMA1_Channel6_IRQHandler(void) {
-    HAL_DMA_IRQHandler(&usart2_dmarx_handle);
+static inline uart_rx_fifo_t *uart_rx_identify(UART_HandleTypeDef *huart) {
+    return uart_rx_table[UART_PORT_INDEX(huart->Instance)];
 }
-#endif /* USART2_USE_DMA_RX == 1 */
 
-#endif /* USART2_ENABLE == 1 */
+/**
+ * @brief 根据串口句柄, 判断是哪个统计指针
+ *
+ * @param huart 串口句柄
+ * @return 统计指针
+ */
+static inline uart_stats_t *uart_stats_identify(UART_HandleTypeDef *huart) {
+    return uart_stats_table[UART_PORT_INDEX(huart->Instance)];
+}
 
-#if (USART3_ENABLE == 1)
+/**
+ * @brief 更新FIFO最大数据量
+ *
+ * @param peak 最大数据量
+ * @param fifo FIFO句柄
+ */
+static inline void uart_stats_peak(uint32_t *peak, ring_fifo_t *fifo) {
+    uint32_t count = ring_fifo_count(fifo);
 
-#if (USART3_USE_DMA_TX == 1)
-static DMA_HandleTypeDef usart3_dmatx_handle = {
-    .Instance = DMA1_Channel2,
-    .Init.Direction = DMA_MEMORY_TO_PERIPH,       /* 发送, 内存到外设 */
-    .Init.MemDataAlignment = DMA_MDATAALIGN_BYTE, /* 内存以字节对齐 */
-    .Init.MemInc = DMA_MINC_ENABLE,               /* 启用内存地址自增 */
-    .Init.Mode = DMA_NORMAL,                      /* 正常模式 */
-    .Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE, /* 外设以字节对齐 */
-    .Init.PeriphInc = DMA_PINC_DISABLE,     /* 关闭外设地址自增 */
-    .Init.Priority = USART3_DMA_TX_PRIORITY /* DMA优先级 */
-};
-static uart_tx_buf_t usart3_tx_buf;
+    if (count > *peak) {
+        *peak = count;
+    }
+}
 
 /**
- * @brief 串口3发送中断句柄
+ * @brief 计数加1
  *
+ * @param counter 计数
+ * @note 用于任务和中断都会更新的计数, 读改写在临界区中完成
  */
-void DMA1_Channel2_IRQHandler(void) {
-    HAL_DMA_IRQHandler(&usart3_dmatx_handle);
+static inline void uart_stats_inc(uint32_t *counter) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    ++*counter;
+    __set_PRIMASK(primask);
 }
-#endif /* USART3_USE_DMA_TX == 1 */
 
-#if (USART3_USE_DMA_RX == 1)
-static DMA_HandleTypeDef usart3_dmarx_handle = {
-    .Instance = DMA1_Channel3,
-    .Init.Direction = DMA_PERIPH_TO_MEMORY,       /* 接收, 外设到内存 */
-    .Init.MemDataAlignment = DMA_MDATAALIGN_BYTE, /* 内存以字节对齐 */
-    .Init.MemInc = DMA_MINC_ENABLE,               /* 启用内存地址自增 */
-    .Init.Mode = DMA_CIRCULAR,                    /* 正常模式 */
-    .Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE, /* 外设以字节对齐 */
-    .Init.PeriphInc = DMA_PINC_DISABLE,     /* 关闭外设地址自增 */
-    .Init.Priority = USART3_DMA_RX_PRIORITY /* DMA优先级 */
-};
-static uart_rx_fifo_t usart3_rx_fifo;
+#if (UART_ISR_CYCLES == 1)
 
 /**
- * @brief 串口3接收中断句柄
+ * @brief 启用DWT周期计数器
  *
  */
-void DMA1_Channel3_IRQHandler(void) {
-    HAL_DMA_IRQHandler(&usart3_dmarx_handle);
+static void uart_isr_cycles_init(void) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 }
-#endif /* USART3_USE_DMA_RX == 1 */
-
-#endif /* USART3_ENABLE == 1 */
-
-#if (UART4_ENABLE == 1)
-
-#if (UART4_USE_DMA_TX == 1)
-static DMA_HandleTypeDef uart4_dmatx_handle = {
-    .Instance = DMA2_Channel5,
-    .Init.Direction = DMA_MEMORY_TO_PERIPH,       /* 发送, 内存到外设 */
-    .Init.MemDataAlignment = DMA_MDATAALIGN_BYTE, /* 内存以字节对齐 */
-    .Init.MemInc = DMA_MINC_ENABLE,               /* 启用内存地址自增 */
-    .Init.Mode = DMA_NORMAL,                      /* 正常模式 */
-    .Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE, /* 外设以字节对齐 */
-    .Init.PeriphInc = DMA_PINC_DISABLE,    /* 关闭外设地址自增 */
-    .Init.Priority = UART4_DMA_TX_PRIORITY /* DMA优先级 */
-};
-static uart_tx_buf_t uart4_tx_buf;
 
 /**
- * @brief 串口4发送中断句柄
+ * @brief 累计一次中断处理的周期数
  *
+ * @param stats 串口统计
+ * @param start 中断处理开始时的周期计数
  */
-void DMA2_Channel4_5_IRQHandler(void) {
-    HAL_DMA_IRQHandler(&uart4_dmatx_handle);
+static inline void uart_isr_cycles(uart_stats_t *stats, uint32_t start) {
+    uint32_t cycles = DWT->CYCCNT - start;
+
+    ++stats->isr_calls;
+    stats->isr_cycles += cycles;
+    if (cycles > stats->isr_cycles_max) {
+        stats->isr_cycles_max = cycles;
+    }
 }
-#endif /* UART4_USE_DMA_TX == 1 */
 
-#if (UART4_USE_DMA_RX == 1)
-static DMA_HandleTypeDef uart4_dmarx_handle = {
-    .Instance = DMA2_Channel3,
-    .Init.Direction = DMA_PERIPH_TO_MEMORY,       /* 接收, 外设到内存 */
-    .Init.MemDataAlignment = DMA_MDATAALIGN_BYTE, /* 内存以字节对齐 */
-    .Init.MemInc = DMA_MINC_ENABLE,               /* 启用内存地址自增 */
-    .Init.Mode = DMA_CIRCULAR,                    /* 正常模式 */
-    .Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE, /* 外设以字节对齐 */
-    .Init.PeriphInc = DMA_PINC_DISABLE,    /* 关闭外设地址自增 */
-    .Init.Priority = UART4_DMA_RX_PRIORITY /* DMA优先级 */
-};
-static uart_rx_fifo_t uart4_rx_fifo;
+#endif /* UART_ISR_CYCLES == 1 */
 
 /**
- * @brief 串口4接收中断句柄
+ * @brief 打开DMA通道所在控制器的时钟
  *
+ * @param hdma DMA句柄
  */
-void DMA2_Channel3_IRQHandler(void) {
-    HAL_DMA_IRQHandler(&uart4_dmarx_handle);
+static void uart_dma_clk_enable(DMA_HandleTypeDef *hdma) {
+    if ((uintptr_t)hdma->Instance >= DMA2_BASE) {
+        __HAL_RCC_DMA2_CLK_ENABLE();
+    } else {
+        __HAL_RCC_DMA1_CLK_ENABLE();
+    }
 }
-#endif /* UART4_USE_DMA_RX == 1 */
-
-#endif /* UART4_ENABLE == 1 */
 
 /**
  * @brief DMA发送初始化
@@ -240,114 +432,63 @@ void DMA2_Channel3_IRQHandler(void) {
  */
 void uart_dmatx_init(UART_HandleTypeDef *huart) {
     HAL_StatusTypeDef res = HAL_OK;
+    uart_tx_buf_t *uart_tx_buf = uart_tx_identify(huart);
 
-    if (huart->Instance == USART1) {
-
-#if USART1_USE_DMA_TX
-        usart1_tx_buf.send_buf =
-            (uint8_t *)malloc(sizeof(uint8_t) * USART1_TX_BUF_SIZE);
-        usart1_tx_buf.send_buf_size = USART1_TX_BUF_SIZE;
-#ifdef DEBUG
-        assert(usart1_tx_buf.send_buf != NULL);
-#endif /* DEBUG */
-
-        usart1_tx_buf.tc_flag = 1;
-
-        __HAL_RCC_DMA1_CLK_ENABLE();
-        res = HAL_DMA_Init(&usart1_dmatx_handle);
-#ifdef DEBUG
-        assert(res == HAL_OK);
-#endif /* DEBUG */
-
-        __HAL_LINKDMA(&usart1_handle, hdmatx, usart1_dmatx_handle);
-
-        HAL_NVIC_SetPriority(DMA1_Channel4_IRQn, USART1_DMA_TX_IT_PREEMPT,
-                             USART1_DMA_TX_IT_SUB);
-        HAL_NVIC_EnableIRQ(DMA1_Channel4_IRQn);
-#endif /* USART1_USE_DMA_TX */
-
-    } else if (huart->Instance == USART2) {
-
-#if USART2_USE_DMA_TX
-        usart2_tx_buf.send_buf =
-            (uint8_t *)malloc(sizeof(uint8_t) * USART2_TX_BUF_SIZE);
-        usart2_tx_buf.send_buf_size = USART2_TX_BUF_SIZE;
-#ifdef DEBUG
-        assert(usart2_tx_buf.send_buf != NULL);
-#endif /* DEBUG */
-
-        usart2_tx_buf.tc_flag = 1;
-
-        __HAL_RCC_DMA1_CLK_ENABLE();
-        res = HAL_DMA_Init(&usart2_dmatx_handle);
-#ifdef DEBUG
-        assert(res == HAL_OK);
-#endif /* DEBUG */
-
-        __HAL_LINKDMA(&usart2_handle, hdmatx, usart2_dmatx_handle);
-
-        HAL_NVIC_SetPriority(DMA1_Channel7_IRQn, USART2_DMA_TX_IT_PREEMPT,
-                             USART2_DMA_TX_IT_SUB);
-        HAL_NVIC_EnableIRQ(DMA1_Channel7_IRQn);
-#endif /* USART2_USE_DMA_TX */
-
-    } else if (huart->Instance == USART3) {
-
-#if USART3_USE_DMA_TX
-        usart3_tx_buf.send_buf =
-            (uint8_t *)malloc(sizeof(uint8_t) * USART3_TX_BUF_SIZE);
-        usart3_tx_buf.send_buf_size = USART3_TX_BUF_SIZE;
-#ifdef DEBUG
-        assert(usart3_tx_buf.send_buf != NULL);
-#endif /* DEBUG */
-
-        usart3_tx_buf.tc_flag = 1;
+    if (uart_tx_buf == NULL) {
+        return;
+    }
 
-        __HAL_RCC_DMA1_CLK_ENABLE();
-        res = HAL_DMA_Init(&usart3_dmatx_handle);
+    uart_tx_buf->tx_fifo =
+        ring_fifo_init_static(&uart_tx_buf->ring, uart_tx_buf->tx_fifo_buf,
+                              uart_tx_buf->tx_fifo_size, RF_TYPE_STREAM);
 #ifdef DEBUG
-        assert(res == HAL_OK);
+    assert(uart_tx_buf->tx_fifo != NULL);
 #endif /* DEBUG */
 
-        __HAL_LINKDMA(&usart3_handle, hdmatx, usart3_dmatx_handle);
-
-        HAL_NVIC_SetPriority(DMA1_Channel2_IRQn, USART3_DMA_TX_IT_PREEMPT,
-                             USART3_DMA_TX_IT_SUB);
-        HAL_NVIC_EnableIRQ(DMA1_Channel2_IRQn);
-#endif /* USART3_USE_DMA_TX */
-
-    } else if (huart->Instance == UART4) {
-
-#if UART4_USE_DMA_TX
-        uart4_tx_buf.send_buf =
-            (uint8_t *)malloc(sizeof(uint8_t) * UART4_TX_BUF_SIZE);
-        uart4_tx_buf.send_buf_size = UART4_TX_BUF_SIZE;
+    uart_tx_buf->stats = uart_stats_identify(huart);
+#if (UART_ISR_CYCLES == 1)
+    uart_isr_cycles_init();
+#endif /* UART_ISR_CYCLES == 1 */
+    uart_tx_buf->tc_flag = 1;
+    uart_tx_buf->idle_tick = HAL_GetTick();
+    uart_tx_buf->stat_tick = uart_tx_buf->idle_tick;
+
+#if (UART_USE_FREERTOS == 1)
+    if (uart_tx_buf->mutex == NULL) {
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+        uart_tx_buf->mutex =
+            xSemaphoreCreateMutexStatic(&uart_tx_buf->mutex_buf);
+#else  /* configSUPPORT_STATIC_ALLOCATION == 1 */
+        uart_tx_buf->mutex = xSemaphoreCreateMutex();
+#endif /* configSUPPORT_STATIC_ALLOCATION == 1 */
 #ifdef DEBUG
-        assert(uart4_tx_buf.send_buf != NULL);
+        assert(uart_tx_buf->mutex != NULL);
 #endif /* DEBUG */
+    }
+#endif /* UART_USE_FREERTOS == 1 */
 
-        uart4_tx_buf.tc_flag = 1;
+    if (uart_tx_buf->hdma == NULL) {
+        /* 中断发送, 在uart_dmatx_send中打开TXE中断 */
+        return;
+    }
 
-        __HAL_RCC_DMA2_CLK_ENABLE();
-        res = HAL_DMA_Init(&uart4_dmatx_handle);
+    uart_dma_clk_enable(uart_tx_buf->hdma);
+    res = HAL_DMA_Init(uart_tx_buf->hdma);
 #ifdef DEBUG
-        assert(res == HAL_OK);
+    assert(res == HAL_OK);
 #endif /* DEBUG */
+    UNUSED(res);
 
-        __HAL_LINKDMA(&uart4_handle, hdmatx, uart4_dmatx_handle);
+    __HAL_LINKDMA(huart, hdmatx, *uart_tx_buf->hdma);
 
-        HAL_NVIC_SetPriority(DMA2_Channel4_5_IRQn, UART4_DMA_TX_IT_PREEMPT,
-                             UART4_DMA_TX_IT_SUB);
-        HAL_NVIC_EnableIRQ(DMA2_Channel4_5_IRQn);
-#endif /* UART4_USE_DMA_TX */
-    }
+    HAL_NVIC_SetPriority(uart_tx_buf->dma_irqn, uart_tx_buf->it_preempt,
+                         uart_tx_buf->it_sub);
+    HAL_NVIC_EnableIRQ(uart_tx_buf->dma_irqn);
 
 #if (USE_HAL_UART_REGISTER_CALLBACKS == 1)
-    if (huart->hdmatx != NULL) {
-        /* 注册发送完成回调函数 */
-        HAL_UART_RegisterCallback(huart, HAL_UART_TX_COMPLETE_CB_ID,
-                                  uart_dmatx_clear_tc_flag);
-    }
+    /* 注册发送完成回调函数 */
+    HAL_UART_RegisterCallback(huart, HAL_UART_TX_COMPLETE_CB_ID,
+                              uart_dmatx_clear_tc_flag);
 #endif /* USE_HAL_UART_REGISTER_CALLBACKS == 1 */
 }
 
@@ -358,261 +499,227 @@ void uart_dmatx_init(UART_HandleTypeDef *huart) {
  */
 void uart_dmarx_init(UART_HandleTypeDef *huart) {
     HAL_StatusTypeDef res = HAL_OK;
+    uart_rx_fifo_t *uart_rx_fifo = uart_rx_identify(huart);
 
-    if (huart->Instance == USART1) {
-
-#if USART1_USE_DMA_RX
-        usart1_rx_fifo.head_ptr = 0;
-        usart1_rx_fifo.recv_buf =
-            (uint8_t *)malloc(sizeof(uint8_t) * USART1_RX_BUF_SIZE);
-#ifdef DEBUG
-        assert(usart1_rx_fifo.recv_buf != NULL);
-#endif /* DEBUG */
-        usart1_rx_fifo.rx_fifo_buf =
-            (uint8_t *)malloc(sizeof(uint8_t) * USART1_RX_FIFO_SZIE);
-#ifdef DEBUG
-        assert(usart1_rx_fifo.rx_fifo_buf != NULL);
-#endif /* DEBUG */
-
-        usart1_rx_fifo.rx_fifo = ring_fifo_init(
-            usart1_rx_fifo.rx_fifo_buf, sizeof(uint8_t) * USART1_RX_FIFO_SZIE,
-            RF_TYPE_STREAM);
-#ifdef DEBUG
-        assert(usart1_rx_fifo.rx_fifo != NULL);
-#endif /* DEBUG */
-
-        __HAL_RCC_DMA1_CLK_ENABLE();
-        res = HAL_DMA_Init(&usart1_dmarx_handle);
-#ifdef DEBUG
-        assert(res == HAL_OK);
-#endif /* DEBUG */
-
-        __HAL_LINKDMA(&usart1_handle, hdmarx, usart1_dmarx_handle);
-
-        HAL_NVIC_SetPriority(DMA1_Channel5_IRQn, USART1_DMA_RX_IT_PREEMPT,
-                             USART1_DMA_RX_IT_SUB);
-        HAL_NVIC_EnableIRQ(DMA1_Channel5_IRQn);
-
-#if USART1_USE_IDLE_IT
-        __HAL_UART_ENABLE_IT(&usart1_handle, UART_IT_IDLE);
-        __HAL_UART_CLEAR_IDLEFLAG(&usart1_handle);
-#endif /* USART1_USE_IDLE_IT */
-        HAL_UART_Receive_DMA(&usart1_handle, (uint8_t *)usart1_rx_fifo.recv_buf,
-                             USART1_RX_BUF_SIZE);
-#endif /* USART1_USE_DMA_RX */
-
-    } else if (huart->Instance == USART2) {
-
-#if USART2_USE_DMA_RX
-        usart2_rx_fifo.head_ptr = 0;
-        usart2_rx_fifo.recv_buf =
-            (uint8_t *)malloc(sizeof(uint8_t) * USART2_RX_BUF_SIZE);
-#ifdef DEBUG
-        assert(usart2_rx_fifo.recv_buf != NULL);
-#endif /* DEBUG */
-
-        usart2_rx_fifo.rx_fifo_buf =
-            (uint8_t *)malloc(sizeof(uint8_t) * USART2_RX_FIFO_SZIE);
-#ifdef DEBUG
-        assert(usart2_rx_fifo.rx_fifo_buf != NULL);
-#endif /* DEBUG */
-
-        usart2_rx_fifo.rx_fifo = ring_fifo_init(
-            usart2_rx_fifo.rx_fifo_buf, sizeof(uint8_t) * USART2_RX_FIFO_SZIE,
-            RF_TYPE_STREAM);
-#ifdef DEBUG
-        assert(usart2_rx_fifo.rx_fifo != NULL);
-#endif /* DEBUG */
-
-        __HAL_RCC_DMA1_CLK_ENABLE();
-        res = HAL_DMA_Init(&usart2_dmarx_handle);
-#ifdef DEBUG
-        assert(res == HAL_OK);
-#endif /* DEBUG */
-
-        __HAL_LINKDMA(&usart2_handle, hdmarx, usart2_dmarx_handle);
-
-        HAL_NVIC_SetPriority(DMA1_Channel6_IRQn, USART2_DMA_RX_IT_PREEMPT,
-                             USART2_DMA_RX_IT_SUB);
-        HAL_NVIC_EnableIRQ(DMA1_Channel6_IRQn);
-
-#if USART2_USE_IDLE_IT
-        __HAL_UART_ENABLE_IT(&usart2_handle, UART_IT_IDLE);
-        __HAL_UART_CLEAR_IDLEFLAG(&usart2_handle);
-#endif /* USART2_USE_IDLE_IT */
-        HAL_UART_Receive_DMA(&usart2_handle, (uint8_t *)usart2_rx_fifo.recv_buf,
-                             USART2_RX_BUF_SIZE);
-#endif /* USART2_USE_DMA_RX */
-
-    } else if (huart->Instance == USART3) {
-
-#if USART3_USE_DMA_RX
-        usart3_rx_fifo.head_ptr = 0;
-        usart3_rx_fifo.recv_buf =
-            (uint8_t *)malloc(sizeof(uint8_t) * USART3_RX_BUF_SIZE);
-#ifdef DEBUG
-        assert(usart3_rx_fifo.recv_buf != NULL);
-#endif /* DEBUG */
+    if (uart_rx_fifo == NULL) {
+        return;
+    }
 
-        usart3_rx_fifo.rx_fifo_buf =
-            (uint8_t *)malloc(sizeof(uint8_t) * USART3_RX_FIFO_SZIE);
+    uart_rx_fifo->stats = uart_stats_identify(huart);
+#if (UART_ISR_CYCLES == 1)
+    uart_isr_cycles_init();
+#endif /* UART_ISR_CYCLES == 1 */
+    uart_rx_fifo->head_ptr = 0;
+    uart_rx_fifo->overrun = 0;
+    uart_rx_fifo->line_scan = 0;
+    uart_rx_fifo->rx_fifo =
+        ring_fifo_init_static(&uart_rx_fifo->ring, uart_rx_fifo->rx_fifo_buf,
+                              uart_rx_fifo->rx_fifo_size, RF_TYPE_STREAM);
 #ifdef DEBUG
-        assert(usart3_rx_fifo.rx_fifo_buf != NULL);
+    assert(uart_rx_fifo->rx_fifo != NULL);
 #endif /* DEBUG */
 
-        usart3_rx_fifo.rx_fifo = ring_fifo_init(
-            usart3_rx_fifo.rx_fifo_buf, sizeof(uint8_t) * USART3_RX_FIFO_SZIE,
-            RF_TYPE_STREAM);
-#ifdef DEBUG
-        assert(usart3_rx_fifo.rx_fifo != NULL);
-#endif /* DEBUG */
+    /* hw_flow_ctrl包含RTS时启用接收流控, RTS引脚已在HAL_UART_MspInit中配置 */
+    uart_rx_fifo->flow_ctrl = (uart_rx_fifo->rts_port != NULL) &&
+                              (huart->Init.HwFlowCtl & UART_HWCONTROL_RTS);
+    uart_rx_fifo->rts_off = 0;
+    uart_rx_fifo->rts_high =
+        uart_rx_fifo->rx_fifo->size * uart_rx_fifo->rts_high_pct / 100U;
+    uart_rx_fifo->rts_low =
+        uart_rx_fifo->rx_fifo->size * uart_rx_fifo->rts_low_pct / 100U;
+
+    if (uart_rx_fifo->hdma == NULL) {
+        /* 中断接收, 每收到一个字节写入FIFO */
+        __HAL_UART_ENABLE_IT(huart, UART_IT_RXNE);
+        return;
+    }
 
-        __HAL_RCC_DMA1_CLK_ENABLE();
-        res = HAL_DMA_Init(&usart3_dmarx_handle);
+    uart_dma_clk_enable(uart_rx_fifo->hdma);
+    res = HAL_DMA_Init(uart_rx_fifo->hdma);
 #ifdef DEBUG
-        assert(res == HAL_OK);
+    assert(res == HAL_OK);
 #endif /* DEBUG */
+    UNUSED(res);
 
-        __HAL_LINKDMA(&usart3_handle, hdmarx, usart3_dmarx_handle);
+    __HAL_LINKDMA(huart, hdmarx, *uart_rx_fifo->hdma);
 
-        HAL_NVIC_SetPriority(DMA1_Channel3_IRQn, USART3_DMA_RX_IT_PREEMPT,
-                             USART3_DMA_RX_IT_SUB);
-        HAL_NVIC_EnableIRQ(DMA1_Channel3_IRQn);
+    HAL_NVIC_SetPriority(uart_rx_fifo->dma_irqn, uart_rx_fifo->it_preempt,
+                         uart_rx_fifo->it_sub);
+    HAL_NVIC_EnableIRQ(uart_rx_fifo->dma_irqn);
 
-#if USART3_USE_IDLE_IT
-        __HAL_UART_ENABLE_IT(&usart3_handle, UART_IT_IDLE);
-        __HAL_UART_CLEAR_IDLEFLAG(&usart3_handle);
-#endif /* USART3_USE_IDLE_IT */
-        HAL_UART_Receive_DMA(&usart3_handle, (uint8_t *)usart3_rx_fifo.recv_buf,
-                             USART3_RX_BUF_SIZE);
-#endif /* USART3_USE_DMA_RX */
+#if (USE_HAL_UART_REGISTER_CALLBACKS == 1)
+    /* 注册半满, 全满回调函数 */
+    HAL_UART_RegisterCallback(huart, HAL_UART_RX_HALFCOMPLETE_CB_ID,
+                              uart_dmarx_halfdone_callback);
+    HAL_UART_RegisterCallback(huart, HAL_UART_RX_COMPLETE_CB_ID,
+                              uart_dmarx_done_callback);
+#endif /* USE_HAL_UART_REGISTER_CALLBACKS == 1 */
 
-    } else if (huart->Instance == UART4) {
+    if (uart_rx_fifo->use_idle_it) {
+        __HAL_UART_ENABLE_IT(huart, UART_IT_IDLE);
+        __HAL_UART_CLEAR_IDLEFLAG(huart);
+    }
 
-#if UART4_USE_DMA_RX
-        uart4_rx_fifo.head_ptr = 0;
-        uart4_rx_fifo.recv_buf =
-            (uint8_t *)malloc(sizeof(uint8_t) * UART4_RX_BUF_SIZE);
-#ifdef DEBUG
-        assert(uart4_rx_fifo.recv_buf != NULL);
-#endif /* DEBUG */
+#if (UART_RX_COALESCE == 1)
+    if (uart_rx_fifo->coalesce_batch != 0) {
+        uart_coalesce_init();
+    }
+#endif /* UART_RX_COALESCE == 1 */
+    HAL_UART_Receive_DMA(huart, uart_rx_fifo->recv_buf,
+                         uart_rx_fifo->recv_buf_size);
+}
 
-        uart4_rx_fifo.rx_fifo_buf =
-            (uint8_t *)malloc(sizeof(uint8_t) * UART4_RX_FIFO_SZIE);
-#ifdef DEBUG
-        assert(uart4_rx_fifo.rx_fifo_buf != NULL);
-#endif /* DEBUG */
+/*****************************************************************************
+ * @defgroup 发送函数部分
+ * @{
+ */
 
-        uart4_rx_fifo.rx_fifo = ring_fifo_init(
-            uart4_rx_fifo.rx_fifo_buf, sizeof(uint8_t) * UART4_RX_FIFO_SZIE,
-            RF_TYPE_STREAM);
-#ifdef DEBUG
-        assert(uart4_rx_fifo.rx_fifo != NULL);
-#endif /* DEBUG */
+/**
+ * @brief 获取发送FIFO的写入权
+ *
+ * @param uart_tx_buf 串口发送缓冲区
+ * @return 是否获取成功, 0-已被其他任务或中断占用; 1-成功
+ * @note FreeRTOS任务中先获取互斥量, 其他任务正在写入时挂起等待,
+ *       最多等待`UART_TX_LOCK_TIMEOUT`. 中断中, 关中断时和调度器未运行时
+ *       不等待
+ */
+static uint32_t uart_tx_lock(uart_tx_buf_t *uart_tx_buf) {
+    uint32_t locked;
+    uint32_t primask;
+
+#if (UART_USE_FREERTOS == 1)
+    uint32_t mutex_held = 0;
+
+    if ((uart_tx_buf->mutex != NULL) && (__get_IPSR() == 0U) &&
+        (__get_PRIMASK() == 0U) &&
+        (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING)) {
+        if (xSemaphoreTake(uart_tx_buf->mutex,
+                           pdMS_TO_TICKS(UART_TX_LOCK_TIMEOUT)) != pdTRUE) {
+            return 0;
+        }
+        mutex_held = 1;
+    }
+#endif /* UART_USE_FREERTOS == 1 */
 
-        __HAL_RCC_DMA2_CLK_ENABLE();
-        res = HAL_DMA_Init(&uart4_dmarx_handle);
-#ifdef DEBUG
-        assert(res == HAL_OK);
-#endif /* DEBUG */
+    /**
+     * 持有互斥量后只有中断可能持有写入锁, 中断返回前会释放,
+     * 因此任务中只在中断预留空间后没有提交时才会失败
+     */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    locked = uart_tx_buf->lock;
+    uart_tx_buf->lock = 1;
+    __set_PRIMASK(primask);
+
+    if (locked) {
+#if (UART_USE_FREERTOS == 1)
+        if (mutex_held) {
+            xSemaphoreGive(uart_tx_buf->mutex);
+        }
+#endif /* UART_USE_FREERTOS == 1 */
+        return 0;
+    }
 
-        __HAL_LINKDMA(&uart4_handle, hdmarx, uart4_dmarx_handle);
+#if (UART_USE_FREERTOS == 1)
+    uart_tx_buf->mutex_held = mutex_held;
+#endif /* UART_USE_FREERTOS == 1 */
+    return 1;
+}
 
-        HAL_NVIC_SetPriority(DMA2_Channel3_IRQn, UART4_DMA_RX_IT_PREEMPT,
-                             UART4_DMA_RX_IT_SUB);
-        HAL_NVIC_EnableIRQ(DMA2_Channel3_IRQn);
+/**
+ * @brief 释放发送FIFO的写入权
+ *
+ * @param uart_tx_buf 串口发送缓冲区
+ */
+static void uart_tx_unlock(uart_tx_buf_t *uart_tx_buf) {
+#if (UART_USE_FREERTOS == 1)
+    uint32_t mutex_held = uart_tx_buf->mutex_held;
+    uart_tx_buf->mutex_held = 0;
+#endif /* UART_USE_FREERTOS == 1 */
 
-#if UART4_USE_IDLE_IT
-        __HAL_UART_ENABLE_IT(&uart4_handle, UART_IT_IDLE);
-        __HAL_UART_CLEAR_IDLEFLAG(&uart4_handle);
-#endif /* UART4_USE_IDLE_IT */
-        HAL_UART_Receive_DMA(&uart4_handle, (uint8_t *)uart4_rx_fifo.recv_buf,
-                             UART4_RX_BUF_SIZE);
-#endif /* UART4_USE_DMA_RX */
-    }
+    uart_tx_buf->lock = 0;
 
-#if (USE_HAL_UART_REGISTER_CALLBACKS == 1)
-    if (huart->hdmarx != NULL) {
-        /* 注册半满, 全满回调函数 */
-        HAL_UART_RegisterCallback(huart, HAL_UART_RX_HALFCOMPLETE_CB_ID,
-                                  uart_dmarx_halfdone_callback);
-        HAL_UART_RegisterCallback(huart, HAL_UART_RX_COMPLETE_CB_ID,
-                                  uart_dmarx_done_callback);
+#if (UART_USE_FREERTOS == 1)
+    if (mutex_held) {
+        xSemaphoreGive(uart_tx_buf->mutex);
     }
-#endif /* USE_HAL_UART_REGISTER_CALLBACKS == 1 */
+#endif /* UART_USE_FREERTOS == 1 */
 }
 
 /**
- * @brief 根据串口句柄, 判断是哪个发送缓冲区指针
+ * @brief 启动一次DMA发送, 发送FIFO中连续的一段数据
  *
  * @param huart 串口句柄
- * @return 发送缓冲区指针
+ * @param uart_tx_buf 串口发送缓冲区
+ * @return 本次DMA传输的长度, 0表示FIFO为空或者无法启动
+ * @note 需要在中断中或者关闭中断时调用
  */
-static inline uart_tx_buf_t *uart_tx_identify(UART_HandleTypeDef *huart) {
-    if (huart->Instance == USART1) {
-#if USART1_USE_DMA_TX
-        return &usart1_tx_buf;
-#endif /* USART1_USE_DMA_TX */
-    } else if (huart->Instance == USART2) {
-#if USART2_USE_DMA_TX
-        return &usart2_tx_buf;
-#endif /* USART2_USE_DMA_TX */
-    } else if (huart->Instance == USART3) {
-#if USART3_USE_DMA_TX
-        return &usart3_tx_buf;
-#endif /* USART3_USE_DMA_TX */
-    } else if (huart->Instance == UART4) {
-#if UART4_USE_DMA_TX
-        return &uart4_tx_buf;
-#endif /* UART4_USE_DMA_TX */
-    }
-    return NULL;
+static uint32_t uart_dmatx_start(UART_HandleTypeDef *huart,
+                                 uart_tx_buf_t *uart_tx_buf) {
+    ring_fifo_span_t span[2];
+
+    if (ring_fifo_read_peek(uart_tx_buf->tx_fifo, span) == 0) {
+        return 0;
+    }
+
+    /* 回绕部分在下一次传输中发送 */
+    uint32_t len = span[0].len;
+    if (len > UINT16_MAX) {
+        len = UINT16_MAX;
+    }
+
+    if (HAL_UART_Transmit_DMA(huart, (uint8_t *)span[0].buf, (uint16_t)len) !=
+        HAL_OK) {
+        return 0;
+    }
+
+    uart_tx_buf->xfer_len = len;
+    ++uart_tx_buf->stats->tx_dma_xfers;
+    return len;
 }
 
 /**
- * @brief 根据串口句柄, 判断是哪个接收缓冲区指针
+ * @brief 打开TXE中断, 由中断发送FIFO中的全部数据
  *
  * @param huart 串口句柄
- * @return 接收缓冲区指针
+ * @param uart_tx_buf 串口发送缓冲区
+ * @return FIFO中待发送的长度, 0表示FIFO为空
+ * @note 需要在中断中或者关闭中断时调用
  */
-static inline uart_rx_fifo_t *uart_rx_identify(UART_HandleTypeDef *huart) {
-    if (huart->Instance == USART1) {
-#if USART1_USE_DMA_RX
-        return &usart1_rx_fifo;
-#endif /* USART1_USE_DMA_RX */
-    } else if (huart->Instance == USART2) {
-#if USART2_USE_DMA_RX
-        return &usart2_rx_fifo;
-#endif /* USART2_USE_DMA_RX */
-    } else if (huart->Instance == USART3) {
-#if USART3_USE_DMA_RX
-        return &usart3_rx_fifo;
-#endif /* USART3_USE_DMA_RX */
-    } else if (huart->Instance == UART4) {
-#if UART4_USE_DMA_RX
-        return &uart4_rx_fifo;
-#endif /* UART4_USE_DMA_RX */
-    }
-    return NULL;
-}
+static uint32_t uart_ittx_start(UART_HandleTypeDef *huart,
+                                uart_tx_buf_t *uart_tx_buf) {
+    uint32_t len = ring_fifo_count(uart_tx_buf->tx_fifo);
 
-/*****************************************************************************
- * @defgroup 发送函数部分
- * @{
- */
+    if (len != 0) {
+        __HAL_UART_ENABLE_IT(huart, UART_IT_TXE);
+    }
+
+    return len;
+}
 
 /**
- * @brief 清楚串口发送完成标志位
+ * @brief 串口DMA发送完成回调, 自动发送FIFO中剩余的数据
  *
  * @param huart 串口句柄
  */
 void uart_dmatx_clear_tc_flag(UART_HandleTypeDef *huart) {
+    UART_ISR_ENTER();
     uart_tx_buf_t *uart_tx_buf = uart_tx_identify(huart);
-    if (uart_tx_buf == NULL) {
+    if ((uart_tx_buf == NULL) || (uart_tx_buf->hdma == NULL)) {
         return;
     }
 
-    uart_tx_buf->tc_flag = 1;
+    ring_fifo_read_commit(uart_tx_buf->tx_fifo, uart_tx_buf->xfer_len);
+    uart_tx_buf->stats->tx_bytes += uart_tx_buf->xfer_len;
+    uart_tx_buf->xfer_len = 0;
+
+    /* 紧接着发送写入的数据, 避免两次传输之间的空闲 */
+    if (uart_dmatx_start(huart, uart_tx_buf) == 0) {
+        uart_tx_buf->idle_tick = HAL_GetTick();
+        uart_tx_buf->tc_flag = 1;
+    }
+
+    UART_ISR_EXIT(uart_tx_buf->stats);
 }
 
 /**
@@ -621,7 +728,9 @@ void uart_dmatx_clear_tc_flag(UART_HandleTypeDef *huart) {
  * @param huart 串口句柄
  * @param data 数据
  * @param len 数据长度
- * @return 成功写入的长度
+ * @return 成功写入的长度, 缓冲区满时小于`len`.
+ *         中断中同一串口正被写入, 或者任务等待写入超时时返回0
+ * @note 发送过程中也可以写入, 当前传输完成后会自动发送
  */
 uint32_t uart_dmatx_write(UART_HandleTypeDef *huart, const void *data,
                           size_t len) {
@@ -630,103 +739,658 @@ uint32_t uart_dmatx_write(UART_HandleTypeDef *huart, const void *data,
     }
 
     uart_tx_buf_t *send_tx_buf = uart_tx_identify(huart);
-    if (send_tx_buf == NULL) {
+    if ((send_tx_buf == NULL) || (send_tx_buf->tx_fifo == NULL)) {
         return 0;
     }
 
-    /* 计算当前缓冲区剩余长度 */
-    uint32_t buf_remain = send_tx_buf->send_buf_size - send_tx_buf->head_ptr;
+    if (!uart_tx_lock(send_tx_buf)) {
+        uart_stats_inc(&send_tx_buf->stats->tx_stalls);
+        return 0;
+    }
 
-    /* 如果要写入的长度大于剩余长度, 为避免溢出, 只写入剩余的长度 */
-    if (buf_remain < len) {
-        memcpy(send_tx_buf->send_buf + send_tx_buf->head_ptr, data, buf_remain);
-        send_tx_buf->head_ptr += buf_remain;
-        return buf_remain;
-    } else {
-        memcpy(send_tx_buf->send_buf + send_tx_buf->head_ptr, data, len);
-        send_tx_buf->head_ptr += len;
-        return len;
+    uint32_t written = ring_fifo_write(send_tx_buf->tx_fifo, data, len);
+    if (written != len) {
+        uart_stats_inc(&send_tx_buf->stats->tx_stalls);
     }
+    uart_stats_peak(&send_tx_buf->stats->tx_fifo_peak, send_tx_buf->tx_fifo);
+    uart_tx_unlock(send_tx_buf);
+
+    return written;
 }
 
 /**
- * @brief 把FIFO中的数据通过DMA发送
+ * @brief 在串口发送缓冲区中预留一段空间, 直接在缓冲区中组包
  *
  * @param huart 串口句柄
- * @return 成功发送的长度
- * @note 先使用`uart_dmatx_write`写入数据
+ * @param len 预留长度
+ * @param[out] span 预留的空间, 跨越FIFO末尾时分为两段
+ * @return 成功时返回`len`; 空间不足, 中断中同一串口正被写入,
+ *         或者任务等待写入超时时返回0, 此时不需要调用`uart_dmatx_commit`
+ * @note 预留成功后持有写入锁, 必须调用`uart_dmatx_commit`释放
  */
-uint32_t uart_dmatx_send(UART_HandleTypeDef *huart) {
-    uart_tx_buf_t *send_tx_buf = uart_tx_identify(huart);
-    if (send_tx_buf == NULL) {
+uint32_t uart_dmatx_reserve(UART_HandleTypeDef *huart, uint32_t len,
+                            ring_fifo_span_t span[2]) {
+    if ((span == NULL) || (len == 0)) {
         return 0;
     }
 
-    /* 未启用DMA */
-    if (huart->hdmatx == NULL) {
+    uart_tx_buf_t *send_tx_buf = uart_tx_identify(huart);
+    if ((send_tx_buf == NULL) || (send_tx_buf->tx_fifo == NULL)) {
         return 0;
     }
 
-    /* 未发送完毕 */
-    if (!send_tx_buf->tc_flag) {
+    if (!uart_tx_lock(send_tx_buf)) {
+        uart_stats_inc(&send_tx_buf->stats->tx_stalls);
         return 0;
     }
 
-    uint32_t len = send_tx_buf->head_ptr;
-    /* 缓冲区为空 */
-    if (!len) {
+    if (ring_fifo_write_reserve(send_tx_buf->tx_fifo, len, span) < len) {
+        uart_stats_inc(&send_tx_buf->stats->tx_stalls);
+        uart_tx_unlock(send_tx_buf);
         return 0;
     }
 
-    send_tx_buf->tc_flag = 0;
-    HAL_UART_Transmit_DMA(huart, send_tx_buf->send_buf, (uint16_t)len);
-    send_tx_buf->head_ptr = 0;
     return len;
 }
 
 /**
- * @}
+ * @brief 将`uart_dmatx_reserve`预留空间中写入的数据入队
+ *
+ * @param huart 串口句柄
+ * @param len 实际写入的长度, 不能超过预留长度. 为0时放弃本次预留
+ * @return 入队的长度
+ * @note 只入队不启动发送, 需要时调用`uart_dmatx_send`
  */
+uint32_t uart_dmatx_commit(UART_HandleTypeDef *huart, uint32_t len) {
+    uart_tx_buf_t *send_tx_buf = uart_tx_identify(huart);
+    if (send_tx_buf == NULL) {
+        return 0;
+    }
 
-/*****************************************************************************
- * @defgroup 接收函数部分
- * @{
- */
+    len = ring_fifo_write_commit(send_tx_buf->tx_fifo, len);
+    uart_stats_peak(&send_tx_buf->stats->tx_fifo_peak, send_tx_buf->tx_fifo);
+    uart_tx_unlock(send_tx_buf);
+
+    return len;
+}
 
 /**
- * @brief 向接收FIFO写数据
+ * @brief 丢弃发送缓冲区中最早写入且尚未开始发送的数据
  *
- * @param uart_rx_fifo 串口接收缓冲区
- * @param data 要写入的数据
- * @param len 数据长度
+ * @param huart 串口句柄
+ * @param len 丢弃的长度, 超过未发送的数据量时全部丢弃
+ * @return 丢弃的长度. 中断中同一串口正被写入, 或者任务等待写入超时时
+ *         返回0
+ * @note 正在进行的DMA传输不受影响, 之后写入的数据前移到它后面.
+ *       不启动发送, 需要时调用`uart_dmatx_send`
  */
-static inline void uart_write_rx_fifo(uart_rx_fifo_t *uart_rx_fifo,
-                                      const void *data, uint32_t len) {
-    if ((data == NULL) || (len == 0)) {
-        return;
+uint32_t uart_dmatx_discard(UART_HandleTypeDef *huart, uint32_t len) {
+    uart_tx_buf_t *send_tx_buf = uart_tx_identify(huart);
+    if (send_tx_buf == NULL) {
+        return 0;
+    }
+
+    if (!uart_tx_lock(send_tx_buf)) {
+        return 0;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    /* 正在发送的数据位于FIFO头部, 保留这一段. 剩余的数据暂时从FIFO中
+     * 移出, 前移时不会被发送, 也不用关中断 */
+    ring_fifo_t *tx_fifo = send_tx_buf->tx_fifo;
+    uint32_t keep = tx_fifo->head + send_tx_buf->xfer_len;
+    uint32_t pending = tx_fifo->tail - keep;
+    tx_fifo->tail = keep;
+
+    __set_PRIMASK(primask);
+
+    if (len > pending) {
+        len = pending;
     }
 
-    uint32_t copied = ring_fifo_write(uart_rx_fifo->rx_fifo, data, len);
-    if (copied != len) {
-        // printf("%s is full. \r\n", __FUNCTION__);
+    /* 目的地址在源地址之前, 从前往后复制不会覆盖未复制的数据 */
+    uint8_t *buf = tx_fifo->buf;
+    for (uint32_t i = 0; i < pending - len; ++i) {
+        buf[(keep + i) & tx_fifo->mask] =
+            buf[(keep + len + i) & tx_fifo->mask];
     }
+    tx_fifo->tail = keep + pending - len;
+
+    uart_tx_unlock(send_tx_buf);
+
+    return len;
 }
 
 /**
- * @brief DMA接收空闲回调
+ * @brief 把跨越FIFO末尾的格式化结果写入预留的两段空间
  *
- * @param huart 串口句柄
+ * @param span 预留的空间, span[0]中已有截断的格式化结果
+ * @param n 格式化结果的长度, 不小于span[0].len
+ * @param format 格式字符串
+ * @param ap 参数列表
+ * @return 写入的长度. 超过预留空间, 或者超过回绕部分和临时缓冲区时截断
+ * @note 回绕部分能放下时直接格式化到回绕部分, 再把前半段移到末尾;
+ *       否则格式化到栈上的临时缓冲区, 再分两段拷贝
  */
-void uart_dmarx_idle_callback(UART_HandleTypeDef *huart) {
-    uart_rx_fifo_t *uart_rx_fifo = uart_rx_identify(huart);
-    if (uart_rx_fifo == NULL) {
-        return;
+static uint32_t uart_vprintf_wrap(ring_fifo_span_t span[2], uint32_t n,
+                                  const char *format, va_list ap) {
+    uint32_t head = span[0].len;
+    uint32_t len = head + span[1].len;
+    uint32_t limit = (span[1].len > UART_PRINTF_BUF_SIZE)
+                         ? span[1].len - 1
+                         : UART_PRINTF_BUF_SIZE - 1;
+
+    len = (n < len) ? n : len;
+    len = (len < limit) ? len : limit;
+
+    if (len < head) {
+        /* span[0]中已有的结果更长, 最后一个字节是结束符 */
+        return head - 1;
     }
 
-    uint32_t tail_ptr;
-    uint32_t copy, offset;
+    if (len < span[1].len) {
+        vsnprintf((char *)span[1].buf, len + 1, format, ap);
+        memcpy(span[0].buf, span[1].buf, head);
+        memmove(span[1].buf, (uint8_t *)span[1].buf + head, len - head);
+    } else {
+        char buf[UART_PRINTF_BUF_SIZE];
 
-    /**
+        vsnprintf(buf, len + 1, format, ap);
+        memcpy(span[0].buf, buf, head);
+        memcpy(span[1].buf, buf + head, len - head);
+    }
+
+    return len;
+}
+
+/**
+ * @brief 格式化输出直接写入串口发送缓冲区
+ *
+ * @param huart 串口句柄
+ * @param format 格式字符串
+ * @param ap 参数列表
+ * @return 写入的长度. 缓冲区空间不足时截断; 中断中同一串口正被写入,
+ *         或者任务等待写入超时时返回0
+ * @note 格式化结果直接写入发送FIFO, 只有结果跨越FIFO末尾时才需要移动一次.
+ *       跨越末尾的结果超过回绕部分时经过`UART_PRINTF_BUF_SIZE`大小的
+ *       临时缓冲区, 更长的结果被截断
+ */
+uint32_t uart_dmatx_vprintf(UART_HandleTypeDef *huart, const char *format,
+                            va_list ap) {
+    uart_tx_buf_t *send_tx_buf = uart_tx_identify(huart);
+    if ((send_tx_buf == NULL) || (send_tx_buf->tx_fifo == NULL)) {
+        return 0;
+    }
+
+    if (!uart_tx_lock(send_tx_buf)) {
+        uart_stats_inc(&send_tx_buf->stats->tx_stalls);
+        return 0;
+    }
+
+    ring_fifo_span_t span[2];
+    uint32_t len = 0;
+    uint32_t avail = ring_fifo_write_reserve(send_tx_buf->tx_fifo,
+                                             send_tx_buf->tx_fifo->size, span);
+
+    if (avail != 0) {
+        va_list ap_copy;
+        va_copy(ap_copy, ap);
+
+        int n = vsnprintf((char *)span[0].buf, span[0].len, format, ap);
+        if (n < 0) {
+            len = 0;
+        } else if ((uint32_t)n < span[0].len) {
+            len = (uint32_t)n;
+        } else {
+            len = uart_vprintf_wrap(span, (uint32_t)n, format, ap_copy);
+        }
+
+        va_end(ap_copy);
+
+        if ((n > 0) && (len < (uint32_t)n)) {
+            uart_stats_inc(&send_tx_buf->stats->tx_stalls);
+        }
+    } else {
+        uart_stats_inc(&send_tx_buf->stats->tx_stalls);
+    }
+
+    len = ring_fifo_write_commit(send_tx_buf->tx_fifo, len);
+    uart_stats_peak(&send_tx_buf->stats->tx_fifo_peak, send_tx_buf->tx_fifo);
+    uart_tx_unlock(send_tx_buf);
+
+    return len;
+}
+
+/**
+ * @brief 把FIFO中的数据通过DMA发送
+ *
+ * @param huart 串口句柄
+ * @return 本次启动DMA传输的长度, 正在发送或者FIFO为空时返回0
+ * @note 先使用`uart_dmatx_write`写入数据. 只有DMA空闲时需要调用,
+ *       发送过程中写入的数据会在当前传输完成后自动发送
+ */
+uint32_t uart_dmatx_send(UART_HandleTypeDef *huart) {
+    uart_tx_buf_t *send_tx_buf = uart_tx_identify(huart);
+    if (send_tx_buf == NULL) {
+        return 0;
+    }
+
+    /* 未初始化 */
+    if (send_tx_buf->tx_fifo == NULL) {
+        return 0;
+    }
+
+    uint32_t len = 0;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    /* 未发送完毕时, 由发送完成回调或TXE中断继续发送 */
+    if (send_tx_buf->tc_flag) {
+        if (send_tx_buf->hdma == NULL) {
+            len = uart_ittx_start(huart, send_tx_buf);
+        } else {
+            len = uart_dmatx_start(huart, send_tx_buf);
+        }
+        if (len) {
+            send_tx_buf->tc_flag = 0;
+            send_tx_buf->gap_ms += HAL_GetTick() - send_tx_buf->idle_tick;
+            ++send_tx_buf->gap_count;
+        }
+    }
+
+    __set_PRIMASK(primask);
+    return len;
+}
+
+/**
+ * @brief 串口是否使用发送缓冲区(DMA发送或中断发送)
+ *
+ * @param huart 串口句柄
+ * @return 0-未使用, 需要阻塞发送; 1-使用, 可以调用`uart_dmatx_write`
+ */
+uint32_t uart_tx_is_buffered(UART_HandleTypeDef *huart) {
+    uart_tx_buf_t *send_tx_buf = uart_tx_identify(huart);
+
+    return (send_tx_buf != NULL) && (send_tx_buf->tx_fifo != NULL);
+}
+
+/**
+ * @brief 获取DMA发送吞吐统计
+ *
+ * @param huart 串口句柄
+ * @param throughput 吞吐统计
+ * @note 发送速率为距上次调用此函数的平均值.
+ *       发送间隙为DMA空闲到下一次启动传输的时间
+ */
+void uart_dmatx_get_throughput(UART_HandleTypeDef *huart,
+                               uart_dmatx_throughput_t *throughput) {
+    if (throughput == NULL) {
+        return;
+    }
+
+    memset(throughput, 0, sizeof(uart_dmatx_throughput_t));
+
+    uart_tx_buf_t *send_tx_buf = uart_tx_identify(huart);
+    if ((send_tx_buf == NULL) || (send_tx_buf->stats == NULL)) {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    throughput->total_bytes = send_tx_buf->stats->tx_bytes;
+    throughput->gap_count = send_tx_buf->gap_count;
+    throughput->gap_ms = send_tx_buf->gap_ms;
+    __set_PRIMASK(primask);
+
+    uint32_t now = HAL_GetTick();
+    uint32_t elapsed = now - send_tx_buf->stat_tick;
+    if (elapsed != 0) {
+        throughput->bytes_per_sec =
+            (uint32_t)((uint64_t)(throughput->total_bytes -
+                                  send_tx_buf->stat_bytes) *
+                       1000U / elapsed);
+    }
+    send_tx_buf->stat_tick = now;
+    send_tx_buf->stat_bytes = throughput->total_bytes;
+}
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup 接收函数部分
+ * @{
+ */
+
+/**
+ * @brief 判断等待的数据是否已经到达
+ *
+ * @param uart_rx_fifo 串口接收缓冲区
+ * @param min_len 等待的数据长度, 为0时等待一行
+ * @return 1: 已到达; 0: 未到达
+ * @note 行模式下FIFO已满或接收流控已暂停对端发送, 但没有完整的行时
+ *       同样返回1, 以免一直等待
+ */
+static inline uint32_t uart_rx_ready(uart_rx_fifo_t *uart_rx_fifo,
+                                     uint32_t min_len) {
+    if (min_len == 0) {
+        return (uart_rx_fifo->line_in != uart_rx_fifo->line_out) ||
+               ring_fifo_is_full(uart_rx_fifo->rx_fifo) ||
+               uart_rx_fifo->rts_off;
+    }
+
+    return ring_fifo_count(uart_rx_fifo->rx_fifo) >= min_len;
+}
+
+/**
+ * @brief 记录一个行尾位置, 在接收中断中调用
+ *
+ * @param uart_rx_fifo 串口接收缓冲区
+ * @param end 行尾在FIFO中的位置(行结束符之后)
+ */
+static inline void uart_line_push(uart_rx_fifo_t *uart_rx_fifo, uint32_t end) {
+    uint32_t line_in = uart_rx_fifo->line_in;
+
+    if (line_in - uart_rx_fifo->line_out >= UART_LINE_QUEUE_SIZE) {
+        /* 队列满, 这一行与下一行合并 */
+        return;
+    }
+
+    uart_rx_fifo->line_end[line_in & (UART_LINE_QUEUE_SIZE - 1)] = end;
+    RING_FIFO_RELEASE();
+    uart_rx_fifo->line_in = line_in + 1;
+}
+
+/**
+ * @brief 查找新写入FIFO的数据中的行结束符, 在接收中断中调用
+ *
+ * @param uart_rx_fifo 串口接收缓冲区
+ * @param data 新写入的数据
+ * @param len 数据长度
+ * @param pos 数据在FIFO中的起始位置
+ * @note 对齐后每次检查4字节, 没有行结束符的字只需一次判断
+ */
+static void uart_line_scan(uart_rx_fifo_t *uart_rx_fifo, const uint8_t *data,
+                           uint32_t len, uint32_t pos) {
+    uint8_t delim = uart_rx_fifo->line_delim;
+    uint32_t pattern = delim * 0x01010101U;
+    uint32_t word;
+    uint32_t i = 0;
+
+    while (i < len) {
+        if (((uintptr_t)(data + i) & 0x03U) == 0) {
+            /* 与结束符异或后, 含有0字节的字才需要逐字节检查 */
+            for (; i + sizeof(word) <= len; i += sizeof(word)) {
+                memcpy(&word, data + i, sizeof(word));
+                word ^= pattern;
+                if (((word - 0x01010101U) & ~word & 0x80808080U) != 0) {
+                    break;
+                }
+            }
+
+            if (i == len) {
+                break;
+            }
+        }
+
+        if (data[i] == delim) {
+            uart_line_push(uart_rx_fifo, pos + i + 1);
+        }
+        ++i;
+    }
+}
+
+/**
+ * @brief 等待的数据到达时唤醒等待的任务, 在接收中断中调用
+ *
+ * @param uart_rx_fifo 串口接收缓冲区
+ */
+static inline void uart_rx_notify(uart_rx_fifo_t *uart_rx_fifo) {
+#if (UART_USE_FREERTOS == 1)
+    TaskHandle_t waiter = uart_rx_fifo->waiter;
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    if ((waiter == NULL) ||
+        (!uart_rx_fifo->overrun &&
+         !uart_rx_ready(uart_rx_fifo, uart_rx_fifo->wait_len))) {
+        /* 溢出时也唤醒, 由等待的任务重新同步 */
+        return;
+    }
+
+    /* 只通知一次, 清空后等待的任务知道通知已经发出 */
+    uart_rx_fifo->waiter = NULL;
+    vTaskNotifyGiveFromISR(waiter, &higher_priority_task_woken);
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+#else  /* UART_USE_FREERTOS == 1 */
+    UNUSED(uart_rx_fifo);
+#endif /* UART_USE_FREERTOS == 1 */
+}
+
+/**
+ * @brief 接收FIFO达到高水位时置高RTS, 暂停对端发送, 在接收中断中调用
+ *
+ * @param uart_rx_fifo 串口接收缓冲区
+ */
+static inline void uart_rx_flow_pause(uart_rx_fifo_t *uart_rx_fifo) {
+    if (!uart_rx_fifo->flow_ctrl || uart_rx_fifo->rts_off ||
+        (ring_fifo_count(uart_rx_fifo->rx_fifo) < uart_rx_fifo->rts_high)) {
+        return;
+    }
+
+    uart_rx_fifo->rts_port->BSRR = uart_rx_fifo->rts_pin;
+    uart_rx_fifo->rts_off = 1;
+    ++uart_rx_fifo->flow_pauses;
+}
+
+/**
+ * @brief 读出数据后FIFO降到低水位时置低RTS, 恢复对端发送
+ *
+ * @param uart_rx_fifo 串口接收缓冲区
+ */
+static inline void uart_rx_flow_resume(uart_rx_fifo_t *uart_rx_fifo) {
+    if (!uart_rx_fifo->rts_off) {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (ring_fifo_count(uart_rx_fifo->rx_fifo) <= uart_rx_fifo->rts_low) {
+        uart_rx_fifo->rts_port->BRR = uart_rx_fifo->rts_pin;
+        uart_rx_fifo->rts_off = 0;
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 屏蔽会拷贝DMA接收数据的中断, 在接收中断中调用
+ *
+ * @param uart_rx_fifo 串口接收缓冲区
+ * @return 原来的BASEPRI(或PRIMASK), 传给`uart_rx_unlock`
+ * @note 用BASEPRI屏蔽DMA接收, 串口和合并定时器中断,
+ *       抢占优先级更高的中断不受影响. 其中有抢占优先级为0的中断时
+ *       BASEPRI无法屏蔽, 改为关中断
+ */
+static inline uint32_t uart_rx_lock(const uart_rx_fifo_t *uart_rx_fifo) {
+    uint32_t basepri = UART_BASEPRI(uart_rx_fifo->lock_preempt);
+    uint32_t saved;
+
+    if (basepri == 0) {
+        saved = __get_PRIMASK();
+        __disable_irq();
+        return saved;
+    }
+
+    saved = __get_BASEPRI();
+    if ((saved == 0) || (saved > basepri)) {
+        /* 只提高屏蔽的优先级, 不放开调用者已经屏蔽的中断 */
+        __set_BASEPRI(basepri);
+        __ISB();
+    }
+
+    return saved;
+}
+
+/**
+ * @brief 恢复`uart_rx_lock`屏蔽的中断
+ *
+ * @param uart_rx_fifo 串口接收缓冲区
+ * @param saved `uart_rx_lock`的返回值
+ */
+static inline void uart_rx_unlock(const uart_rx_fifo_t *uart_rx_fifo,
+                                  uint32_t saved) {
+    if (UART_BASEPRI(uart_rx_fifo->lock_preempt) == 0) {
+        __set_PRIMASK(saved);
+    } else {
+        __set_BASEPRI(saved);
+    }
+}
+
+/**
+ * @brief 向接收FIFO写数据
+ *
+ * @param uart_rx_fifo 串口接收缓冲区
+ * @param data 要写入的数据
+ * @param len 数据长度
+ * @note DMA直接写入FIFO时数据已经在FIFO中, 只更新FIFO写指针.
+ *       FIFO放不下时DMA已经覆盖了未读出的数据, 整段丢弃并置位溢出标志;
+ *       溢出标志清除前不再更新写指针, 由读取时重新同步.
+ *       写入后调用`uart_rx_post`查找行尾并唤醒等待的任务
+ */
+static inline void uart_write_rx_fifo(uart_rx_fifo_t *uart_rx_fifo,
+                                      const void *data, uint32_t len) {
+    if ((data == NULL) || (len == 0)) {
+        return;
+    }
+
+    uart_stats_t *stats = uart_rx_fifo->stats;
+
+    if (uart_rx_fifo->dma_to_fifo) {
+        if (uart_rx_fifo->overrun ||
+            (ring_fifo_avail(uart_rx_fifo->rx_fifo) < len)) {
+            /* FIFO写指针与DMA不再同步, 不能只提交一部分 */
+            if (!uart_rx_fifo->overrun) {
+                uart_rx_fifo->overrun = 1;
+                ++stats->rx_overruns;
+            }
+            stats->rx_drops += len;
+            return;
+        }
+
+        ring_fifo_write_commit(uart_rx_fifo->rx_fifo, len);
+    } else {
+        uint32_t copied = ring_fifo_write(uart_rx_fifo->rx_fifo, data, len);
+        if (copied != len) {
+            /* FIFO满, 丢弃放不下的部分 */
+            stats->rx_drops += len - copied;
+            len = copied;
+        }
+    }
+
+    stats->rx_bytes += len;
+    uart_stats_peak(&stats->rx_fifo_peak, uart_rx_fifo->rx_fifo);
+    uart_rx_flow_pause(uart_rx_fifo);
+}
+
+/**
+ * @brief 查找新写入FIFO的行结束符并唤醒等待的任务, 在接收中断中调用
+ *
+ * @param uart_rx_fifo 串口接收缓冲区
+ * @note 在`uart_write_rx_fifo`之后, `uart_rx_lock`屏蔽的范围之外调用.
+ *       从上次查找到的位置查找到FIFO写指针. 查找中被其他接收中断抢占时,
+ *       抢占方不查找, 由被抢占的一方继续查找它写入的数据, 行尾按顺序记录
+ */
+static void uart_rx_post(uart_rx_fifo_t *uart_rx_fifo) {
+    ring_fifo_t *ring = uart_rx_fifo->rx_fifo;
+    uint32_t pos, tail, len;
+
+    while (uart_rx_fifo->line_mode && !uart_rx_fifo->line_busy &&
+           (ring->tail != uart_rx_fifo->line_scan)) {
+        uart_rx_fifo->line_busy = 1;
+
+        while ((pos = uart_rx_fifo->line_scan) != (tail = ring->tail)) {
+            RING_FIFO_ACQUIRE();
+            len = tail - pos;
+            if (len > ring->size - (pos & ring->mask)) {
+                /* 先查找到存储区末尾 */
+                len = ring->size - (pos & ring->mask);
+            }
+
+            uart_line_scan(uart_rx_fifo,
+                           (const uint8_t *)ring->buf + (pos & ring->mask), len,
+                           pos);
+            uart_rx_fifo->line_scan = pos + len;
+        }
+
+        /* 清除标志前被抢占时, 抢占方写入的数据由外层循环查找 */
+        uart_rx_fifo->line_busy = 0;
+    }
+
+    uart_rx_notify(uart_rx_fifo);
+}
+
+#if (UART_RX_COALESCE == 1)
+
+static TIM_HandleTypeDef uart_coalesce_tim_handle = {
+    .Instance = UART_COALESCE_TIM};
+static uint8_t uart_coalesce_running;
+
+/**
+ * @brief 初始化空闲中断合并定时器, 多个串口共用
+ *
+ */
+static void uart_coalesce_init(void) {
+    if (uart_coalesce_tim_handle.State != HAL_TIM_STATE_RESET) {
+        return;
+    }
+
+    /* 72MHz / 72 = 1MHz */
+    UART_COALESCE_TIM_CLK_ENABLE();
+    uart_coalesce_tim_handle.Init.Prescaler = 72 - 1;
+    uart_coalesce_tim_handle.Init.CounterMode = TIM_COUNTERMODE_UP;
+    uart_coalesce_tim_handle.Init.Period = UART_COALESCE_TICK_US - 1;
+    uart_coalesce_tim_handle.Init.AutoReloadPreload =
+        TIM_AUTORELOAD_PRELOAD_DISABLE;
+    HAL_TIM_Base_Init(&uart_coalesce_tim_handle);
+    __HAL_TIM_CLEAR_FLAG(&uart_coalesce_tim_handle, TIM_FLAG_UPDATE);
+
+    HAL_NVIC_SetPriority(UART_COALESCE_TIM_IRQn, UART_COALESCE_IT_PREEMPT,
+                         UART_COALESCE_IT_SUB);
+    HAL_NVIC_EnableIRQ(UART_COALESCE_TIM_IRQn);
+}
+
+/**
+ * @brief 启动合并定时器, 没有推迟拷贝的串口时由定时器中断停止
+ *
+ */
+static inline void uart_coalesce_start(void) {
+    if (!uart_coalesce_running) {
+        uart_coalesce_running = 1;
+        __HAL_TIM_SET_COUNTER(&uart_coalesce_tim_handle, 0);
+        HAL_TIM_Base_Start_IT(&uart_coalesce_tim_handle);
+    }
+}
+
+#endif /* UART_RX_COALESCE == 1 */
+
+/**
+ * @brief DMA接收缓冲区中尚未拷贝到FIFO的长度
+ *
+ * @param uart_rx_fifo 串口接收缓冲区
+ * @param huart 串口句柄
+ * @return 未拷贝的长度. DMA已经回绕但溢满中断还未处理时返回0,
+ *         由溢满中断拷贝
+ */
+static inline uint32_t uart_dmarx_pending(uart_rx_fifo_t *uart_rx_fifo,
+                                          UART_HandleTypeDef *huart) {
+    uint32_t tail_ptr;
+    uint32_t offset;
+
+    /**
      * +~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+
      * |     head_ptr          tail_ptr         |
      * |         |                 |            |
@@ -737,12 +1401,70 @@ void uart_dmarx_idle_callback(UART_HandleTypeDef *huart) {
 
     /* 已接收 */
     tail_ptr = huart->RxXferSize - __HAL_DMA_GET_COUNTER(huart->hdmarx);
-
     offset = (uart_rx_fifo->head_ptr) % (uint32_t)(huart->RxXferSize);
-    copy = tail_ptr - offset;
-    uart_rx_fifo->head_ptr += copy;
 
+    return (tail_ptr > offset) ? (tail_ptr - offset) : 0;
+}
+
+/**
+ * @brief 把DMA接收缓冲区中尚未拷贝的数据拷贝到FIFO
+ *
+ * @param uart_rx_fifo 串口接收缓冲区
+ * @param huart 串口句柄
+ * @note 在串口中断和合并定时器中断中调用, 这两个中断的优先级可能与
+ *       DMA接收中断不同. 读取和更新head_ptr并拷贝的过程中用`uart_rx_lock`
+ *       屏蔽这些中断, 避免半满或溢满回调在中途拷贝同一段数据;
+ *       查找行尾和唤醒任务在屏蔽之外进行
+ */
+static void uart_dmarx_flush(uart_rx_fifo_t *uart_rx_fifo,
+                             UART_HandleTypeDef *huart) {
+    uint32_t saved = uart_rx_lock(uart_rx_fifo);
+
+    uint32_t offset = (uart_rx_fifo->head_ptr) % (uint32_t)(huart->RxXferSize);
+    uint32_t copy = uart_dmarx_pending(uart_rx_fifo, huart);
+
+    uart_rx_fifo->head_ptr += copy;
     uart_write_rx_fifo(uart_rx_fifo, huart->pRxBuffPtr + offset, copy);
+
+    uart_rx_unlock(uart_rx_fifo, saved);
+    uart_rx_post(uart_rx_fifo);
+}
+
+/**
+ * @brief DMA接收空闲回调
+ *
+ * @param huart 串口句柄
+ */
+void uart_dmarx_idle_callback(UART_HandleTypeDef *huart) {
+    UART_ISR_ENTER();
+    uart_rx_fifo_t *uart_rx_fifo = uart_rx_identify(huart);
+    if ((uart_rx_fifo == NULL) || (uart_rx_fifo->hdma == NULL)) {
+        return;
+    }
+
+    ++uart_rx_fifo->stats->rx_irqs;
+    ++uart_rx_fifo->stats->idle_events;
+
+#if (UART_RX_COALESCE == 1)
+    if (uart_rx_fifo->coalesce_batch != 0) {
+        uint32_t pending = uart_dmarx_pending(uart_rx_fifo, huart);
+
+        if ((pending != 0) && (pending < uart_rx_fifo->coalesce_batch)) {
+            /* 数据较少, 关闭空闲中断, 由定时器凑够批量或超时后拷贝 */
+            __HAL_UART_DISABLE_IT(huart, UART_IT_IDLE);
+            if (uart_rx_fifo->coalesce_left == 0) {
+                uart_rx_fifo->coalesce_left = uart_rx_fifo->coalesce_ticks;
+                ++uart_rx_fifo->deferred;
+                uart_coalesce_start();
+            }
+            UART_ISR_EXIT(uart_rx_fifo->stats);
+            return;
+        }
+    }
+#endif /* UART_RX_COALESCE == 1 */
+
+    uart_dmarx_flush(uart_rx_fifo, huart);
+    UART_ISR_EXIT(uart_rx_fifo->stats);
 }
 
 /**
@@ -751,13 +1473,18 @@ void uart_dmarx_idle_callback(UART_HandleTypeDef *huart) {
  * @param huart 串口句柄
  */
 void uart_dmarx_halfdone_callback(UART_HandleTypeDef *huart) {
+    UART_ISR_ENTER();
     uart_rx_fifo_t *uart_rx_fifo = uart_rx_identify(huart);
-    if (uart_rx_fifo == NULL) {
+    if ((uart_rx_fifo == NULL) || (uart_rx_fifo->hdma == NULL)) {
         return;
     }
 
+    ++uart_rx_fifo->stats->rx_irqs;
+    ++uart_rx_fifo->stats->rx_dma_xfers;
+
     uint32_t tail_ptr;
     uint32_t offset, copy;
+    uint32_t saved;
 
     /**
      * +~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+
@@ -771,11 +1498,15 @@ void uart_dmarx_halfdone_callback(UART_HandleTypeDef *huart) {
 
     tail_ptr = (huart->RxXferSize >> 1) + (huart->RxXferSize & 1);
 
+    saved = uart_rx_lock(uart_rx_fifo);
     offset = (uart_rx_fifo->head_ptr) % (uint32_t)(huart->RxXferSize);
     copy = tail_ptr - offset;
     uart_rx_fifo->head_ptr += copy;
 
     uart_write_rx_fifo(uart_rx_fifo, huart->pRxBuffPtr + offset, copy);
+    uart_rx_unlock(uart_rx_fifo, saved);
+    uart_rx_post(uart_rx_fifo);
+    UART_ISR_EXIT(uart_rx_fifo->stats);
 }
 
 /**
@@ -784,13 +1515,18 @@ void uart_dmarx_halfdone_callback(UART_HandleTypeDef *huart) {
  * @param huart 串口句柄
  */
 void uart_dmarx_done_callback(UART_HandleTypeDef *huart) {
+    UART_ISR_ENTER();
     uart_rx_fifo_t *uart_rx_fifo = uart_rx_identify(huart);
-    if (uart_rx_fifo == NULL) {
+    if ((uart_rx_fifo == NULL) || (uart_rx_fifo->hdma == NULL)) {
         return;
     }
 
+    ++uart_rx_fifo->stats->rx_irqs;
+    ++uart_rx_fifo->stats->rx_dma_xfers;
+
     uint32_t tail_ptr;
     uint32_t offset, copy;
+    uint32_t saved;
 
     /**
      * +~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~+
@@ -804,11 +1540,14 @@ void uart_dmarx_done_callback(UART_HandleTypeDef *huart) {
 
     tail_ptr = huart->RxXferSize;
 
+    saved = uart_rx_lock(uart_rx_fifo);
     offset = (uart_rx_fifo->head_ptr) % (uint32_t)(huart->RxXferSize);
     copy = tail_ptr - offset;
     uart_rx_fifo->head_ptr += copy;
 
     uart_write_rx_fifo(uart_rx_fifo, huart->pRxBuffPtr + offset, copy);
+    uart_rx_unlock(uart_rx_fifo, saved);
+    uart_rx_post(uart_rx_fifo);
 
     if (huart->hdmarx->Init.Mode != DMA_CIRCULAR) {
         /* 非循环DMA, 重新打开DMA接收 */
@@ -817,6 +1556,80 @@ void uart_dmarx_done_callback(UART_HandleTypeDef *huart) {
             __HAL_UNLOCK(huart);
         }
     }
+
+    UART_ISR_EXIT(uart_rx_fifo->stats);
+}
+
+#if (UART_RX_COALESCE == 1)
+
+/**
+ * @brief 空闲中断合并定时器中断服务函数
+ *
+ * @note 查询推迟拷贝的串口的DMA计数, 凑够批量或达到最大延迟时拷贝到FIFO,
+ *       并重新打开空闲中断
+ */
+void UART_COALESCE_TIM_IRQHandler(void) {
+    uart_rx_fifo_t *uart_rx_fifo;
+    UART_HandleTypeDef *huart;
+    uint32_t running = 0;
+
+    __HAL_TIM_CLEAR_FLAG(&uart_coalesce_tim_handle, TIM_FLAG_UPDATE);
+
+    for (uint32_t i = 0; i < UART_PORT_NUM; ++i) {
+        uart_rx_fifo = uart_rx_table[i];
+        if ((uart_rx_fifo == NULL) || (uart_rx_fifo->coalesce_left == 0)) {
+            continue;
+        }
+
+        huart = (UART_HandleTypeDef *)uart_rx_fifo->hdma->Parent;
+        if ((uart_dmarx_pending(uart_rx_fifo, huart) <
+             uart_rx_fifo->coalesce_batch) &&
+            (--uart_rx_fifo->coalesce_left != 0)) {
+            running = 1;
+            continue;
+        }
+
+        UART_ISR_ENTER();
+        uart_rx_fifo->coalesce_left = 0;
+        ++uart_rx_fifo->stats->rx_irqs;
+        uart_dmarx_flush(uart_rx_fifo, huart);
+
+        /* 线路空闲时才会置位IDLE, 此时读DR不会取走DMA的数据 */
+        if (__HAL_UART_GET_FLAG(huart, UART_FLAG_IDLE)) {
+            __HAL_UART_CLEAR_IDLEFLAG(huart);
+        }
+        __HAL_UART_ENABLE_IT(huart, UART_IT_IDLE);
+        UART_ISR_EXIT(uart_rx_fifo->stats);
+    }
+
+    if (!running) {
+        HAL_TIM_Base_Stop_IT(&uart_coalesce_tim_handle);
+        uart_coalesce_running = 0;
+    }
+}
+
+#endif /* UART_RX_COALESCE == 1 */
+
+/**
+ * @brief DMA直接写入FIFO溢出后, 丢弃FIFO中的数据并与DMA位置重新同步
+ *
+ * @param uart_rx_fifo 串口接收缓冲区
+ * @note 读写指针都移到最近一次接收中断处理到的DMA位置`head_ptr`,
+ *       之前的数据(包括溢出后接收中断跳过的部分)全部丢弃,
+ *       之后的数据由下一次接收中断从这里开始提交
+ */
+static void uart_dmarx_resync(uart_rx_fifo_t *uart_rx_fifo) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uart_rx_fifo->rx_fifo->head = uart_rx_fifo->head_ptr;
+    uart_rx_fifo->rx_fifo->tail = uart_rx_fifo->head_ptr;
+    uart_rx_fifo->line_scan = uart_rx_fifo->head_ptr;
+    uart_rx_fifo->line_out = uart_rx_fifo->line_in;
+    uart_rx_fifo->overrun = 0;
+
+    __set_PRIMASK(primask);
+    uart_rx_flow_resume(uart_rx_fifo);
 }
 
 /**
@@ -837,9 +1650,538 @@ uint32_t uart_dmarx_read(UART_HandleTypeDef *huart, void *buf, size_t len) {
         return 0;
     }
 
-    return ring_fifo_read(uart_rx_fifo->rx_fifo, buf, len);
+    if (uart_rx_fifo->overrun) {
+        uart_dmarx_resync(uart_rx_fifo);
+    }
+
+    len = ring_fifo_read(uart_rx_fifo->rx_fifo, buf, len);
+    uart_rx_flow_resume(uart_rx_fifo);
+
+    return len;
+}
+
+/**
+ * @brief 等待数据到达
+ *
+ * @param uart_rx_fifo 串口接收缓冲区
+ * @param min_len 等待的数据长度, 为0时等待一行
+ * @param timeout 超时时间, FreeRTOS中为tick(portMAX_DELAY为一直等待),
+ *                裸机中为ms
+ * @note FreeRTOS中挂起当前任务, 由接收中断在数据到达时直接唤醒.
+ *       调度器未运行时与裸机相同, 忙等直到数据到达或超时
+ */
+static void uart_rx_wait(uart_rx_fifo_t *uart_rx_fifo, uint32_t min_len,
+                         uint32_t timeout) {
+#if (UART_USE_FREERTOS == 1)
+    if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) {
+        TickType_t start = xTaskGetTickCount();
+        TickType_t elapsed = 0;
+        uint32_t primask;
+        uint32_t taken;
+        uint32_t notified;
+
+        while (!uart_rx_ready(uart_rx_fifo, min_len) && (elapsed < timeout)) {
+            if (uart_rx_fifo->overrun) {
+                /* 溢出唤醒, 同步后继续等待 */
+                uart_dmarx_resync(uart_rx_fifo);
+                continue;
+            }
+
+            primask = __get_PRIMASK();
+            __disable_irq();
+            uart_rx_fifo->wait_len = min_len;
+            uart_rx_fifo->waiter = xTaskGetCurrentTaskHandle();
+            __set_PRIMASK(primask);
+
+            /* 登记前数据可能已经到达, 此时不会再有通知 */
+            taken = 0;
+            if (!uart_rx_ready(uart_rx_fifo, min_len)) {
+                taken = ulTaskNotifyTake(pdTRUE, (timeout == portMAX_DELAY)
+                                                     ? portMAX_DELAY
+                                                     : timeout - elapsed);
+            }
+
+            primask = __get_PRIMASK();
+            __disable_irq();
+            notified = (uart_rx_fifo->waiter == NULL);
+            uart_rx_fifo->waiter = NULL;
+            __set_PRIMASK(primask);
+
+            if (notified && (taken == 0)) {
+                /* 中断已发出通知但没有被取走, 清除以免影响下次等待 */
+                ulTaskNotifyTake(pdTRUE, 0);
+            }
+
+            if (timeout != portMAX_DELAY) {
+                elapsed = xTaskGetTickCount() - start;
+            }
+        }
+
+        return;
+    }
+#endif /* UART_USE_FREERTOS == 1 */
+
+    uint32_t start = HAL_GetTick();
+
+    while (!uart_rx_ready(uart_rx_fifo, min_len) &&
+           (HAL_GetTick() - start < timeout)) {
+        /* 空闲中断和DMA中断会把数据拷贝到FIFO */
+        if (uart_rx_fifo->overrun) {
+            uart_dmarx_resync(uart_rx_fifo);
+        }
+    }
+}
+
+/**
+ * @brief 从接收FIFO读数据, 数据不足时等待
+ *
+ * @param huart 串口句柄
+ * @param buf 接收缓冲数组
+ * @param len `buf`长度
+ * @param min_len 至少等待的数据长度, 超过`len`, FIFO大小或接收流控高水位时
+ *                按其中较小者. 为0时不等待
+ * @param timeout 超时时间, FreeRTOS中为tick(portMAX_DELAY为一直等待),
+ *                裸机中为ms. 为0时不等待
+ * @return 接收到的长度, 超时时可能小于`min_len`
+ * @note FreeRTOS中挂起当前任务, 由接收中断在数据足够时直接唤醒,
+ *       不需要用`vTaskDelay`轮询. 同一串口同时只能有一个任务等待
+ */
+uint32_t uart_dmarx_read_timeout(UART_HandleTypeDef *huart, void *buf,
+                                 size_t len, size_t min_len,
+                                 uint32_t timeout) {
+    if ((buf == NULL) || (len == 0)) {
+        return 0;
+    }
+    uart_rx_fifo_t *uart_rx_fifo = uart_rx_identify(huart);
+
+    if ((uart_rx_fifo == NULL) || (uart_rx_fifo->rx_fifo == NULL)) {
+        return 0;
+    }
+
+    if (min_len > len) {
+        min_len = len;
+    }
+    if (min_len > uart_rx_fifo->rx_fifo->size) {
+        min_len = uart_rx_fifo->rx_fifo->size;
+    }
+    if (uart_rx_fifo->flow_ctrl && (min_len > uart_rx_fifo->rts_high)) {
+        /* 达到高水位后对端暂停发送, 等不到更多数据 */
+        min_len = uart_rx_fifo->rts_high;
+    }
+
+    if (uart_rx_fifo->overrun) {
+        uart_dmarx_resync(uart_rx_fifo);
+    }
+
+    if (min_len != 0) {
+        uart_rx_wait(uart_rx_fifo, min_len, timeout);
+    }
+
+    len = ring_fifo_read(uart_rx_fifo->rx_fifo, buf, len);
+    uart_rx_flow_resume(uart_rx_fifo);
+
+    return len;
+}
+
+/**
+ * @brief 设置行结束符, 开启行模式
+ *
+ * @param huart 串口句柄
+ * @param delim 行结束符(0~255), 小于0时关闭行模式
+ * @note 接收中断把数据写入FIFO时记录行尾位置, `uart_readline`直接按行读出,
+ *       不需要再查找结束符. 开启前已在FIFO中的数据不记录行尾
+ */
+void uart_dmarx_set_delim(UART_HandleTypeDef *huart, int32_t delim) {
+    uart_rx_fifo_t *uart_rx_fifo = uart_rx_identify(huart);
+    if ((uart_rx_fifo == NULL) || (uart_rx_fifo->rx_fifo == NULL)) {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    uart_rx_fifo->line_mode = (delim >= 0);
+    uart_rx_fifo->line_delim = (uint8_t)delim;
+    uart_rx_fifo->line_scan = uart_rx_fifo->rx_fifo->tail;
+    uart_rx_fifo->line_out = uart_rx_fifo->line_in;
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 丢弃已经被读走的行尾
+ *
+ * @param uart_rx_fifo 串口接收缓冲区
+ * @note 使用`uart_dmarx_read`读走数据后, 队列中的行尾可能已经过期
+ */
+static void uart_line_drop_stale(uart_rx_fifo_t *uart_rx_fifo) {
+    uint32_t head = uart_rx_fifo->rx_fifo->head;
+
+    while (uart_rx_fifo->line_out != uart_rx_fifo->line_in) {
+        RING_FIFO_ACQUIRE();
+        uint32_t end = uart_rx_fifo->line_end[uart_rx_fifo->line_out &
+                                              (UART_LINE_QUEUE_SIZE - 1)];
+        if ((int32_t)(end - head) > 0) {
+            break;
+        }
+        ++uart_rx_fifo->line_out;
+    }
+}
+
+/**
+ * @brief 按行读数据, 没有完整的行时等待
+ *
+ * @param huart 串口句柄
+ * @param buf 接收缓冲数组
+ * @param len `buf`长度
+ * @param timeout 超时时间, FreeRTOS中为tick(portMAX_DELAY为一直等待),
+ *                裸机中为ms. 为0时不等待
+ * @return 读出的长度, 包含行结束符, 不添加'\0'. 超时或未开启行模式时返回0
+ * @note 先用`uart_dmarx_set_delim`开启行模式.
+ *       行长超过`len`时只读出前`len`字节, 剩余部分下次读出;
+ *       FIFO已满或接收流控已暂停对端发送, 但没有完整的行时
+ *       读出FIFO中的数据, 以免一直等待
+ */
+uint32_t uart_readline(UART_HandleTypeDef *huart, void *buf, size_t len,
+                       uint32_t timeout) {
+    if ((buf == NULL) || (len == 0)) {
+        return 0;
+    }
+    uart_rx_fifo_t *uart_rx_fifo = uart_rx_identify(huart);
+
+    if ((uart_rx_fifo == NULL) || (uart_rx_fifo->rx_fifo == NULL) ||
+        !uart_rx_fifo->line_mode) {
+        return 0;
+    }
+
+    if (uart_rx_fifo->overrun) {
+        uart_dmarx_resync(uart_rx_fifo);
+    }
+
+    uart_line_drop_stale(uart_rx_fifo);
+    uart_rx_wait(uart_rx_fifo, 0, timeout);
+    uart_line_drop_stale(uart_rx_fifo);
+
+    uint32_t line_len;
+    if (uart_rx_fifo->line_out != uart_rx_fifo->line_in) {
+        line_len = uart_rx_fifo->line_end[uart_rx_fifo->line_out &
+                                          (UART_LINE_QUEUE_SIZE - 1)] -
+                   uart_rx_fifo->rx_fifo->head;
+    } else if (ring_fifo_is_full(uart_rx_fifo->rx_fifo) ||
+               uart_rx_fifo->rts_off) {
+        line_len = uart_rx_fifo->rx_fifo->size;
+    } else {
+        return 0;
+    }
+
+    if (line_len > len) {
+        line_len = len;
+    }
+
+    line_len = ring_fifo_read(uart_rx_fifo->rx_fifo, buf, line_len);
+    uart_line_drop_stale(uart_rx_fifo);
+    uart_rx_flow_resume(uart_rx_fifo);
+
+    return line_len;
+}
+
+/**
+ * @brief 获取接收中断统计
+ *
+ * @param huart 串口句柄
+ * @param[out] stats 统计结果, 平均值为距上次查询的平均值
+ * @note 接收中断包括空闲中断, DMA半满和溢满中断, 合并定时器的拷贝
+ *       以及中断收发时的RXNE中断
+ */
+void uart_dmarx_get_irq_stats(UART_HandleTypeDef *huart,
+                              uart_dmarx_irq_stats_t *stats) {
+    if (stats == NULL) {
+        return;
+    }
+
+    memset(stats, 0, sizeof(uart_dmarx_irq_stats_t));
+
+    uart_rx_fifo_t *uart_rx_fifo = uart_rx_identify(huart);
+    if ((uart_rx_fifo == NULL) || (uart_rx_fifo->stats == NULL)) {
+        return;
+    }
+
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    stats->total_irqs = uart_rx_fifo->stats->rx_irqs;
+    stats->total_bytes = uart_rx_fifo->stats->rx_bytes;
+    stats->deferred = uart_rx_fifo->deferred;
+    stats->flow_pauses = uart_rx_fifo->flow_pauses;
+    __set_PRIMASK(primask);
+
+    uint32_t now = HAL_GetTick();
+    uint32_t elapsed = now - uart_rx_fifo->stat_tick;
+    uint32_t irqs = stats->total_irqs - uart_rx_fifo->stat_irqs;
+    if (elapsed != 0) {
+        stats->irqs_per_sec = (uint32_t)((uint64_t)irqs * 1000U / elapsed);
+    }
+    if (irqs != 0) {
+        stats->bytes_per_irq =
+            (stats->total_bytes - uart_rx_fifo->stat_bytes) / irqs;
+    }
+    uart_rx_fifo->stat_tick = now;
+    uart_rx_fifo->stat_irqs = stats->total_irqs;
+    uart_rx_fifo->stat_bytes = stats->total_bytes;
 }
 
 /**
  * @}
  */
+
+/*****************************************************************************
+ * @defgroup 统计部分
+ * @{
+ */
+
+/**
+ * @brief 统计串口错误, 在串口错误回调中调用
+ *
+ * @param huart 串口句柄
+ * @param error_code HAL库错误码, `HAL_UART_ERROR_xx`按位组合
+ */
+void uart_stats_error(UART_HandleTypeDef *huart, uint32_t error_code) {
+    uart_stats_t *stats = uart_stats_identify(huart);
+    if (stats == NULL) {
+        return;
+    }
+
+    stats->pe_errors += ((error_code & HAL_UART_ERROR_PE) != 0);
+    stats->ne_errors += ((error_code & HAL_UART_ERROR_NE) != 0);
+    stats->fe_errors += ((error_code & HAL_UART_ERROR_FE) != 0);
+    stats->ore_errors += ((error_code & HAL_UART_ERROR_ORE) != 0);
+    stats->dma_errors += ((error_code & HAL_UART_ERROR_DMA) != 0);
+}
+
+/**
+ * @brief 记录一次不完整的发送, 供阻塞发送使用
+ *
+ * @param huart 串口句柄
+ */
+void uart_stats_tx_stall(UART_HandleTypeDef *huart) {
+    uart_stats_t *stats = uart_stats_identify(huart);
+    if (stats == NULL) {
+        return;
+    }
+
+    uart_stats_inc(&stats->tx_stalls);
+}
+
+/**
+ * @brief 获取串口统计
+ *
+ * @param huart 串口句柄
+ * @param[out] stats 统计结果, 为NULL时只清零
+ * @param reset 是否同时清零. 读取和清零在同一临界区中完成, 不会漏掉计数
+ * @note 清零后fifo最大数据量从当前数据量开始重新统计.
+ *       `uart_dmarx_get_irq_stats`和`uart_dmatx_get_throughput`的累计值
+ *       同样被清零
+ */
+void uart_get_stats(UART_HandleTypeDef *huart, uart_stats_t *stats,
+                    uint32_t reset) {
+    if (stats != NULL) {
+        memset(stats, 0, sizeof(uart_stats_t));
+    }
+
+    uart_stats_t *port_stats = uart_stats_identify(huart);
+    if (port_stats == NULL) {
+        return;
+    }
+
+    uart_tx_buf_t *uart_tx_buf = uart_tx_identify(huart);
+    uart_rx_fifo_t *uart_rx_fifo = uart_rx_identify(huart);
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (stats != NULL) {
+        *stats = *port_stats;
+    }
+
+    if (reset) {
+        memset(port_stats, 0, sizeof(uart_stats_t));
+
+        /* 平均值按与上次查询时累计值的差计算, 一起清零 */
+        if ((uart_rx_fifo != NULL) && (uart_rx_fifo->rx_fifo != NULL)) {
+            uart_rx_fifo->stat_irqs = 0;
+            uart_rx_fifo->stat_bytes = 0;
+            port_stats->rx_fifo_peak = ring_fifo_count(uart_rx_fifo->rx_fifo);
+        }
+        if ((uart_tx_buf != NULL) && (uart_tx_buf->tx_fifo != NULL)) {
+            uart_tx_buf->stat_bytes = 0;
+            port_stats->tx_fifo_peak = ring_fifo_count(uart_tx_buf->tx_fifo);
+        }
+    }
+
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup 中断收发部分
+ * @{
+ */
+
+/**
+ * @brief 串口RXNE/TXE中断收发, 在串口中断服务函数中调用
+ *
+ * @param huart 串口句柄
+ * @note 直接读写寄存器, 每个字节只有一次FIFO读写.
+ *       读DR的同时清除ORE, NE, FE, PE标志
+ */
+void uart_it_irq_handler(UART_HandleTypeDef *huart) {
+    UART_ISR_ENTER();
+    USART_TypeDef *uart = huart->Instance;
+    uint32_t sr = uart->SR;
+    uint32_t cr1 = uart->CR1;
+    uint8_t data;
+
+    if ((sr & USART_SR_RXNE) && (cr1 & USART_CR1_RXNEIE)) {
+        uart_rx_fifo_t *uart_rx_fifo = uart_rx_table[UART_PORT_INDEX(uart)];
+        uart_stats_t *stats = uart_rx_fifo->stats;
+
+        data = (uint8_t)uart->DR;
+        ++stats->rx_irqs;
+        if (sr & (USART_SR_PE | USART_SR_NE | USART_SR_FE | USART_SR_ORE)) {
+            /* 不经过HAL库, 错误标志已被读DR清除, 在这里统计 */
+            stats->pe_errors += ((sr & USART_SR_PE) != 0);
+            stats->ne_errors += ((sr & USART_SR_NE) != 0);
+            stats->fe_errors += ((sr & USART_SR_FE) != 0);
+            stats->ore_errors += ((sr & USART_SR_ORE) != 0);
+        }
+
+        /* FIFO满时丢弃 */
+        if (ring_fifo_put(uart_rx_fifo->rx_fifo, data)) {
+            ++stats->rx_bytes;
+            uart_stats_peak(&stats->rx_fifo_peak, uart_rx_fifo->rx_fifo);
+            uart_rx_flow_pause(uart_rx_fifo);
+            if (uart_rx_fifo->line_mode &&
+                (data == uart_rx_fifo->line_delim)) {
+                uart_line_push(uart_rx_fifo, uart_rx_fifo->rx_fifo->tail);
+            }
+        } else {
+            ++stats->rx_drops;
+        }
+        uart_rx_notify(uart_rx_fifo);
+    }
+
+    if ((sr & USART_SR_TXE) && (cr1 & USART_CR1_TXEIE)) {
+        uart_tx_buf_t *uart_tx_buf = uart_tx_table[UART_PORT_INDEX(uart)];
+
+        if (ring_fifo_get(uart_tx_buf->tx_fifo, &data)) {
+            uart->DR = data;
+            ++uart_tx_buf->stats->tx_bytes;
+        } else {
+            /* 发送完毕, 关闭TXE中断 */
+            CLEAR_BIT(uart->CR1, USART_CR1_TXEIE);
+            uart_tx_buf->idle_tick = HAL_GetTick();
+            uart_tx_buf->tc_flag = 1;
+        }
+    }
+
+    UART_ISR_EXIT(uart_stats_table[UART_PORT_INDEX(uart)]);
+}
+
+/**
+ * @}
+ */
+
+#if (UART_BENCHMARK == 1)
+
+/* 测量的调用次数 */
+#define UART_BENCH_CALLS 64U
+
+/**
+ * @brief 以可变参数调用`uart_dmatx_vprintf`
+ *
+ * @param huart 串口句柄
+ * @param format 格式字符串
+ * @return 写入的长度
+ */
+static uint32_t uart_bench_printf(UART_HandleTypeDef *huart,
+                                  const char *format, ...) {
+    uint32_t len;
+    va_list ap;
+
+    va_start(ap, format);
+    len = uart_dmatx_vprintf(huart, format, ap);
+    va_end(ap);
+
+    return len;
+}
+
+/**
+ * @brief 测量格式化输出每次调用的周期数,
+ *        并计算115200和2M波特率下每秒最多能输出的行数
+ *
+ * @param huart 串口句柄, 需要使用DMA或中断发送
+ * @note 测量时关闭中断. 每次输出后丢弃, 不实际发送
+ */
+void uart_printf_benchmark(UART_HandleTypeDef *huart) {
+    static const uint32_t baud_rates[] = {115200U, 2000000U};
+    uint32_t primask;
+    uint32_t start;
+    uint32_t cycles;
+    uint32_t len = 0;
+    uint32_t total = 0;
+    uint32_t max = 0;
+
+    if (!uart_tx_is_buffered(huart)) {
+        printf("uart_printf_benchmark: port is not buffered \r\n");
+        return;
+    }
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    uart_dmatx_discard(huart, UINT32_MAX);
+    for (uint32_t i = 0; i < UART_BENCH_CALLS; ++i) {
+        start = DWT->CYCCNT;
+        len = uart_bench_printf(huart, "t=%8u adc=%4u,%4u temp=%d.%02d\r\n",
+                                (unsigned int)(i * 1000U),
+                                (unsigned int)(2048U + i),
+                                (unsigned int)(4095U - i), 25, (int)i);
+        cycles = DWT->CYCCNT - start;
+        uart_dmatx_discard(huart, UINT32_MAX);
+
+        total += cycles;
+        max = (cycles > max) ? cycles : max;
+    }
+
+    __set_PRIMASK(primask);
+
+    if (len == 0) {
+        printf("uart_printf_benchmark: write failed \r\n");
+        return;
+    }
+
+    uint32_t avg = total / UART_BENCH_CALLS;
+    uint32_t cpu_rate = SystemCoreClock / avg;
+    printf("uart_printf: %u bytes, avg %u cycles, max %u cycles, "
+           "%u calls/s at 100%% CPU \r\n",
+           (unsigned int)len, (unsigned int)avg, (unsigned int)max,
+           (unsigned int)cpu_rate);
+
+    for (uint32_t i = 0; i < sizeof(baud_rates) / sizeof(baud_rates[0]);
+         ++i) {
+        /* 8N1每字节10位 */
+        uint32_t rate = baud_rates[i] / 10U / len;
+        rate = (rate < cpu_rate) ? rate : cpu_rate;
+        uint32_t load = (uint32_t)((uint64_t)rate * avg * 10000U /
+                                   SystemCoreClock);
+        printf("%7u baud: max %u lines/s, CPU %u.%02u%% \r\n",
+               (unsigned int)baud_rates[i], (unsigned int)rate,
+               (unsigned int)(load / 100U), (unsigned int)(load % 100U));
+    }
+}
+
+#endif /* UART_BENCHMARK == 1 */
@@ -0,0 +1,960 @@
+/**
+ * @file    i2c.c
+ * @author  Deadline039
+ * @brief   I2C DMA传输队列
+ * @version 1.0
+ * @date    2026-10-18
+ * @note    使用HAL库的顺序传输接口(Seq), 起始条件和地址在中断中发送,
+ *          不会像HAL_I2C_Mem_Read_DMA那样轮询等待地址阶段.
+ *          传输的各阶段和下一次传输都在HAL库的完成回调中启动.
+ */
+
+#include "i2c.h"
+#include "delay.h"
+#include "ring_fifo.h"
+#include "spi.h"
+#include "uart.h"
+
+#include <assert.h>
+
+#if (I2C_USE_FREERTOS == 1)
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* 中断中会通知等待传输的任务, 需要允许调用FreeRTOS API */
+#define I2C_RTOS_PRIO_OK(preempt)                                              \
+    ((preempt) >= configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY)
+#else /* I2C_USE_FREERTOS == 1 */
+#define I2C_RTOS_PRIO_OK(preempt) 1
+#endif /* I2C_USE_FREERTOS == 1 */
+
+#if !RING_FIFO_IS_POW2(I2C_QUEUE_SIZE)
+#error "I2C_QUEUE_SIZE必须为2的幂次方"
+#endif /* I2C_QUEUE_SIZE */
+
+#if ((I2C1_ENABLE == 1) && (USART2_ENABLE == 1) &&                             \
+     ((USART2_USE_DMA_TX == 1) || (USART2_USE_DMA_RX == 1)))
+#error "I2C1与串口2使用相同的DMA通道"
+#endif /* I2C1_ENABLE == 1 */
+
+#if ((I2C2_ENABLE == 1) &&                                                     \
+     (((USART1_ENABLE == 1) &&                                                 \
+       ((USART1_USE_DMA_TX == 1) || (USART1_USE_DMA_RX == 1))) ||              \
+      (SPI2_ENABLE == 1)))
+#error "I2C2与串口1或SPI2使用相同的DMA通道"
+#endif /* I2C2_ENABLE == 1 */
+
+/* 恢复总线时SCL半周期(us), 按标准模式 */
+#define I2C_RECOVER_HALF_US 5U
+
+/* 启动传输前等待上一次STOP发出的最大查询次数 */
+#define I2C_STOP_WAIT_LOOPS 1000U
+
+/**
+ * @brief 传输阶段
+ */
+typedef enum {
+    I2C_PHASE_REG = 0U, /*!< 发送寄存器地址 */
+    I2C_PHASE_DATA      /*!< 收发数据 */
+} i2c_phase_t;
+
+/**
+ * @brief I2C总线
+ */
+typedef struct {
+    I2C_HandleTypeDef *hi2c;    /*!< I2C句柄 */
+    DMA_HandleTypeDef *hdma_tx; /*!< 发送DMA句柄 */
+    DMA_HandleTypeDef *hdma_rx; /*!< 接收DMA句柄 */
+    uint32_t speed;             /*!< 时钟频率 */
+    uint32_t duty_cycle;        /*!< 快速模式占空比 */
+    GPIO_TypeDef *scl_port;     /*!< SCL端口 */
+    GPIO_TypeDef *sda_port;     /*!< SDA端口 */
+    uint16_t scl_pin;           /*!< SCL引脚 */
+    uint16_t sda_pin;           /*!< SDA引脚 */
+    IRQn_Type irqn[4];          /*!< 事件, 错误, 发送DMA, 接收DMA中断号 */
+    uint8_t it_preempt;         /*!< 中断抢占优先级 */
+    uint8_t it_sub;             /*!< 中断子优先级 */
+
+    i2c_xfer_t *queue[I2C_QUEUE_SIZE]; /*!< 等待的传输, 取消后置为NULL */
+    uint32_t queue_in;                 /*!< 入队计数 */
+    uint32_t queue_out;                /*!< 出队计数 */
+
+    i2c_xfer_t *active; /*!< 正在进行的传输, NULL时总线空闲 */
+    i2c_phase_t phase;  /*!< 正在进行的传输所处阶段 */
+    uint8_t reg_buf[2]; /*!< 寄存器地址, 高字节在前 */
+} i2c_bus_t;
+
+#if (I2C1_ENABLE == 1)
+
+I2C_HandleTypeDef i2c1_handle = {.Instance = I2C1};
+
+static DMA_HandleTypeDef i2c1_dmatx_handle = {
+    .Instance = DMA1_Channel6,
+    .Init.Direction = DMA_MEMORY_TO_PERIPH,
+    .Init.MemDataAlignment = DMA_MDATAALIGN_BYTE,
+    .Init.MemInc = DMA_MINC_ENABLE,
+    .Init.Mode = DMA_NORMAL,
+    .Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE,
+    .Init.PeriphInc = DMA_PINC_DISABLE,
+    .Init.Priority = I2C1_DMA_PRIORITY};
+static DMA_HandleTypeDef i2c1_dmarx_handle = {
+    .Instance = DMA1_Channel7,
+    .Init.Direction = DMA_PERIPH_TO_MEMORY,
+    .Init.MemDataAlignment = DMA_MDATAALIGN_BYTE,
+    .Init.MemInc = DMA_MINC_ENABLE,
+    .Init.Mode = DMA_NORMAL,
+    .Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE,
+    .Init.PeriphInc = DMA_PINC_DISABLE,
+    .Init.Priority = I2C1_DMA_PRIORITY};
+static i2c_bus_t i2c1_bus = {
+    .hi2c = &i2c1_handle,
+    .hdma_tx = &i2c1_dmatx_handle,
+    .hdma_rx = &i2c1_dmarx_handle,
+    .speed = I2C1_SPEED,
+    .duty_cycle = I2C1_DUTY_CYCLE,
+    .scl_port = I2C1_SCL_GPIO_PORT,
+    .sda_port = I2C1_SDA_GPIO_PORT,
+    .scl_pin = I2C1_SCL_GPIO_PIN,
+    .sda_pin = I2C1_SDA_GPIO_PIN,
+    .irqn = {I2C1_EV_IRQn, I2C1_ER_IRQn, DMA1_Channel6_IRQn,
+             DMA1_Channel7_IRQn},
+    .it_preempt = I2C1_IT_PREEMPT,
+    .it_sub = I2C1_IT_SUB,
+};
+
+#if !I2C_RTOS_PRIO_OK(I2C1_IT_PREEMPT)
+#error "I2C1中断优先级高于configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY"
+#endif /* I2C_RTOS_PRIO_OK */
+
+/**
+ * @brief I2C1事件中断句柄
+ *
+ */
+void I2C1_EV_IRQHandler(void) {
+    HAL_I2C_EV_IRQHandler(&i2c1_handle);
+}
+
+/**
+ * @brief I2C1错误中断句柄
+ *
+ */
+void I2C1_ER_IRQHandler(void) {
+    HAL_I2C_ER_IRQHandler(&i2c1_handle);
+}
+
+/**
+ * @brief I2C1发送DMA中断句柄
+ *
+ */
+void DMA1_Channel6_IRQHandler(void) {
+    HAL_DMA_IRQHandler(&i2c1_dmatx_handle);
+}
+
+/**
+ * @brief I2C1接收DMA中断句柄
+ *
+ */
+void DMA1_Channel7_IRQHandler(void) {
+    HAL_DMA_IRQHandler(&i2c1_dmarx_handle);
+}
+
+#endif /* I2C1_ENABLE == 1 */
+
+#if (I2C2_ENABLE == 1)
+
+I2C_HandleTypeDef i2c2_handle = {.Instance = I2C2};
+
+static DMA_HandleTypeDef i2c2_dmatx_handle = {
+    .Instance = DMA1_Channel4,
+    .Init.Direction = DMA_MEMORY_TO_PERIPH,
+    .Init.MemDataAlignment = DMA_MDATAALIGN_BYTE,
+    .Init.MemInc = DMA_MINC_ENABLE,
+    .Init.Mode = DMA_NORMAL,
+    .Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE,
+    .Init.PeriphInc = DMA_PINC_DISABLE,
+    .Init.Priority = I2C2_DMA_PRIORITY};
+static DMA_HandleTypeDef i2c2_dmarx_handle = {
+    .Instance = DMA1_Channel5,
+    .Init.Direction = DMA_PERIPH_TO_MEMORY,
+    .Init.MemDataAlignment = DMA_MDATAALIGN_BYTE,
+    .Init.MemInc = DMA_MINC_ENABLE,
+    .Init.Mode = DMA_NORMAL,
+    .Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE,
+    .Init.PeriphInc = DMA_PINC_DISABLE,
+    .Init.Priority = I2C2_DMA_PRIORITY};
+static i2c_bus_t i2c2_bus = {
+    .hi2c = &i2c2_handle,
+    .hdma_tx = &i2c2_dmatx_handle,
+    .hdma_rx = &i2c2_dmarx_handle,
+    .speed = I2C2_SPEED,
+    .duty_cycle = I2C2_DUTY_CYCLE,
+    .scl_port = I2C2_SCL_GPIO_PORT,
+    .sda_port = I2C2_SDA_GPIO_PORT,
+    .scl_pin = I2C2_SCL_GPIO_PIN,
+    .sda_pin = I2C2_SDA_GPIO_PIN,
+    .irqn = {I2C2_EV_IRQn, I2C2_ER_IRQn, DMA1_Channel4_IRQn,
+             DMA1_Channel5_IRQn},
+    .it_preempt = I2C2_IT_PREEMPT,
+    .it_sub = I2C2_IT_SUB,
+};
+
+#if !I2C_RTOS_PRIO_OK(I2C2_IT_PREEMPT)
+#error "I2C2中断优先级高于configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY"
+#endif /* I2C_RTOS_PRIO_OK */
+
+/**
+ * @brief I2C2事件中断句柄
+ *
+ */
+void I2C2_EV_IRQHandler(void) {
+    HAL_I2C_EV_IRQHandler(&i2c2_handle);
+}
+
+/**
+ * @brief I2C2错误中断句柄
+ *
+ */
+void I2C2_ER_IRQHandler(void) {
+    HAL_I2C_ER_IRQHandler(&i2c2_handle);
+}
+
+/**
+ * @brief I2C2发送DMA中断句柄
+ *
+ */
+void DMA1_Channel4_IRQHandler(void) {
+    HAL_DMA_IRQHandler(&i2c2_dmatx_handle);
+}
+
+/**
+ * @brief I2C2接收DMA中断句柄
+ *
+ */
+void DMA1_Channel5_IRQHandler(void) {
+    HAL_DMA_IRQHandler(&i2c2_dmarx_handle);
+}
+
+#endif /* I2C2_ENABLE == 1 */
+
+/**
+ * @brief 根据I2C句柄找到总线
+ *
+ * @param hi2c I2C句柄
+ * @return 总线, 未启用时返回NULL
+ */
+static i2c_bus_t *i2c_bus_identify(I2C_HandleTypeDef *hi2c) {
+#if (I2C1_ENABLE == 1)
+    if (hi2c == &i2c1_handle) {
+        return &i2c1_bus;
+    }
+#endif /* I2C1_ENABLE == 1 */
+
+#if (I2C2_ENABLE == 1)
+    if (hi2c == &i2c2_handle) {
+        return &i2c2_bus;
+    }
+#endif /* I2C2_ENABLE == 1 */
+
+    UNUSED(hi2c);
+    return NULL;
+}
+
+/*****************************************************************************
+ * @defgroup 初始化和总线恢复
+ * @{
+ */
+
+/**
+ * @brief I2C底层初始化, 由HAL_I2C_Init调用
+ *
+ * @param hi2c I2C句柄
+ */
+void HAL_I2C_MspInit(I2C_HandleTypeDef *hi2c) {
+    HAL_StatusTypeDef res = HAL_OK;
+    GPIO_InitTypeDef gpio_init_struct = {.Mode = GPIO_MODE_AF_OD,
+                                         .Pull = GPIO_NOPULL,
+                                         .Speed = GPIO_SPEED_FREQ_HIGH};
+    i2c_bus_t *bus = i2c_bus_identify(hi2c);
+
+    if (bus == NULL) {
+        return;
+    }
+
+#if (I2C1_ENABLE == 1)
+    if (hi2c->Instance == I2C1) {
+        I2C1_SCL_GPIO_ENABLE();
+        I2C1_SDA_GPIO_ENABLE();
+        __HAL_RCC_I2C1_CLK_ENABLE();
+    }
+#endif /* I2C1_ENABLE == 1 */
+
+#if (I2C2_ENABLE == 1)
+    if (hi2c->Instance == I2C2) {
+        I2C2_SCL_GPIO_ENABLE();
+        I2C2_SDA_GPIO_ENABLE();
+        __HAL_RCC_I2C2_CLK_ENABLE();
+    }
+#endif /* I2C2_ENABLE == 1 */
+
+    gpio_init_struct.Pin = bus->scl_pin;
+    HAL_GPIO_Init(bus->scl_port, &gpio_init_struct);
+    gpio_init_struct.Pin = bus->sda_pin;
+    HAL_GPIO_Init(bus->sda_port, &gpio_init_struct);
+
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    res = HAL_DMA_Init(bus->hdma_tx);
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+    __HAL_LINKDMA(hi2c, hdmatx, *bus->hdma_tx);
+
+    res = HAL_DMA_Init(bus->hdma_rx);
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+    __HAL_LINKDMA(hi2c, hdmarx, *bus->hdma_rx);
+    UNUSED(res);
+
+    /* 同一优先级, HAL库的I2C中断处理不会重入 */
+    for (uint32_t i = 0; i < 4; ++i) {
+        HAL_NVIC_SetPriority(bus->irqn[i], bus->it_preempt, bus->it_sub);
+        HAL_NVIC_EnableIRQ(bus->irqn[i]);
+    }
+}
+
+/**
+ * @brief 恢复总线并复位I2C外设
+ *
+ * @param bus 总线
+ * @note 从机在传输中途被打断时会一直拉低SDA, 需要主机补足时钟.
+ *       最多耗时约100us, 在中断中调用时会阻塞同优先级的中断
+ */
+static void i2c_bus_recover(i2c_bus_t *bus) {
+    HAL_StatusTypeDef res = HAL_OK;
+    GPIO_InitTypeDef gpio_init_struct = {.Mode = GPIO_MODE_OUTPUT_OD,
+                                         .Pull = GPIO_NOPULL,
+                                         .Speed = GPIO_SPEED_FREQ_HIGH};
+
+    __HAL_I2C_DISABLE(bus->hi2c);
+
+    /* 引脚切换为开漏输出, 由软件产生时钟 */
+    bus->scl_port->BSRR = bus->scl_pin;
+    bus->sda_port->BSRR = bus->sda_pin;
+    gpio_init_struct.Pin = bus->scl_pin;
+    HAL_GPIO_Init(bus->scl_port, &gpio_init_struct);
+    gpio_init_struct.Pin = bus->sda_pin;
+    HAL_GPIO_Init(bus->sda_port, &gpio_init_struct);
+    delay_us(I2C_RECOVER_HALF_US);
+
+    /* 从机最多再发送8位数据和1位应答就会释放SDA */
+    for (uint32_t i = 0; i < 9; ++i) {
+        if (READ_BIT(bus->sda_port->IDR, bus->sda_pin)) {
+            break;
+        }
+        bus->scl_port->BRR = bus->scl_pin;
+        delay_us(I2C_RECOVER_HALF_US);
+        bus->scl_port->BSRR = bus->scl_pin;
+        delay_us(I2C_RECOVER_HALF_US);
+    }
+
+    /* SCL为高时SDA由低变高, 产生STOP */
+    bus->scl_port->BRR = bus->scl_pin;
+    delay_us(I2C_RECOVER_HALF_US);
+    bus->sda_port->BRR = bus->sda_pin;
+    delay_us(I2C_RECOVER_HALF_US);
+    bus->scl_port->BSRR = bus->scl_pin;
+    delay_us(I2C_RECOVER_HALF_US);
+    bus->sda_port->BSRR = bus->sda_pin;
+    delay_us(I2C_RECOVER_HALF_US);
+
+    gpio_init_struct.Mode = GPIO_MODE_AF_OD;
+    gpio_init_struct.Pin = bus->scl_pin;
+    HAL_GPIO_Init(bus->scl_port, &gpio_init_struct);
+    gpio_init_struct.Pin = bus->sda_pin;
+    HAL_GPIO_Init(bus->sda_port, &gpio_init_struct);
+
+    /* HAL_I2C_Init会软件复位I2C外设, 清除卡住的BUSY标志和HAL状态 */
+    res = HAL_I2C_Init(bus->hi2c);
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+    UNUSED(res);
+}
+
+/**
+ * @brief 初始化I2C总线
+ *
+ * @param hi2c I2C句柄
+ */
+void i2c_bus_init(I2C_HandleTypeDef *hi2c) {
+    HAL_StatusTypeDef res = HAL_OK;
+    i2c_bus_t *bus = i2c_bus_identify(hi2c);
+
+#ifdef DEBUG
+    assert(bus != NULL);
+#endif /* DEBUG */
+
+    if (bus == NULL) {
+        return;
+    }
+
+    hi2c->Init.ClockSpeed = bus->speed;
+    hi2c->Init.DutyCycle = bus->duty_cycle;
+    hi2c->Init.OwnAddress1 = 0;
+    hi2c->Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
+    hi2c->Init.DualAddressMode = I2C_DUALADDRESS_DISABLE;
+    hi2c->Init.OwnAddress2 = 0;
+    hi2c->Init.GeneralCallMode = I2C_GENERALCALL_DISABLE;
+    hi2c->Init.NoStretchMode = I2C_NOSTRETCH_DISABLE;
+    res = HAL_I2C_Init(hi2c);
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+    UNUSED(res);
+
+    /* 上电或复位时从机可能停在传输中途 */
+    if (!READ_BIT(bus->sda_port->IDR, bus->sda_pin) ||
+        __HAL_I2C_GET_FLAG(hi2c, I2C_FLAG_BUSY)) {
+        i2c_bus_recover(bus);
+    }
+}
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup 传输调度
+ * @{
+ */
+
+/**
+ * @brief 取出下一次传输并占用总线
+ *
+ * @param bus 总线
+ * @return 下一次传输, 总线忙或队列空时返回NULL
+ * @note 需要在关中断时调用
+ */
+static i2c_xfer_t *i2c_bus_claim_next(i2c_bus_t *bus) {
+    i2c_xfer_t *xfer;
+
+    if (bus->active != NULL) {
+        return NULL;
+    }
+
+    while (bus->queue_out != bus->queue_in) {
+        xfer = bus->queue[bus->queue_out & (I2C_QUEUE_SIZE - 1U)];
+        ++bus->queue_out;
+
+        if (xfer == NULL) {
+            /* 已被取消 */
+            continue;
+        }
+
+        xfer->status = I2C_XFER_ACTIVE;
+        bus->active = xfer;
+        return xfer;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief 启动数据阶段
+ *
+ * @param bus 总线
+ * @param xfer 传输
+ * @param options HAL顺序传输选项
+ * @return HAL状态
+ */
+static HAL_StatusTypeDef i2c_data_start(i2c_bus_t *bus, i2c_xfer_t *xfer,
+                                        uint32_t options) {
+    uint16_t addr = (uint16_t)(xfer->dev_addr << 1);
+
+    bus->phase = I2C_PHASE_DATA;
+
+    if (xfer->read == 0) {
+        return HAL_I2C_Master_Seq_Transmit_DMA(bus->hi2c, addr, xfer->buf,
+                                               xfer->len, options);
+    }
+
+    /* 只接收1字节时DMA无法及时产生NACK, 使用中断接收 */
+    if (xfer->len == 1) {
+        return HAL_I2C_Master_Seq_Receive_IT(bus->hi2c, addr, xfer->buf, 1,
+                                             options);
+    }
+
+    return HAL_I2C_Master_Seq_Receive_DMA(bus->hi2c, addr, xfer->buf,
+                                          xfer->len, options);
+}
+
+/**
+ * @brief 启动传输
+ *
+ * @param bus 总线
+ * @param xfer 传输
+ * @return HAL状态
+ */
+static HAL_StatusTypeDef i2c_xfer_start(i2c_bus_t *bus, i2c_xfer_t *xfer) {
+    I2C_TypeDef *i2c = bus->hi2c->Instance;
+    uint32_t options;
+
+    /* 上一次传输的STOP可能还没有发出 */
+    for (uint32_t n = I2C_STOP_WAIT_LOOPS;
+         (n != 0) && READ_BIT(i2c->CR1, I2C_CR1_STOP); --n) {
+    }
+    if (READ_BIT(i2c->SR2, I2C_SR2_BUSY)) {
+        i2c_bus_recover(bus);
+    }
+
+    if (xfer->reg_size == 0) {
+        return i2c_data_start(bus, xfer, I2C_FIRST_AND_LAST_FRAME);
+    }
+
+    if (xfer->reg_size == 2) {
+        bus->reg_buf[0] = (uint8_t)(xfer->reg >> 8);
+        bus->reg_buf[1] = (uint8_t)xfer->reg;
+    } else {
+        bus->reg_buf[0] = (uint8_t)xfer->reg;
+    }
+
+    /* 没有数据时只写寄存器地址 */
+    options = ((xfer->read == 0) && (xfer->len == 0)) ? I2C_FIRST_AND_LAST_FRAME
+                                                       : I2C_FIRST_FRAME;
+    bus->phase = I2C_PHASE_REG;
+    return HAL_I2C_Master_Seq_Transmit_IT(
+        bus->hi2c, (uint16_t)(xfer->dev_addr << 1), bus->reg_buf,
+        xfer->reg_size, options);
+}
+
+/**
+ * @brief 传输结束, 调用回调并唤醒等待的任务
+ *
+ * @param xfer 传输
+ * @param status 结果
+ * @param error HAL错误码
+ */
+static void i2c_xfer_finish(i2c_xfer_t *xfer, i2c_xfer_status_t status,
+                            uint32_t error) {
+    void *waiter = xfer->waiter;
+
+    xfer->waiter = NULL;
+    xfer->error = error;
+    xfer->status = status;
+
+    if (xfer->callback != NULL) {
+        xfer->callback(xfer);
+    }
+
+#if (I2C_USE_FREERTOS == 1)
+    if (waiter != NULL) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR((TaskHandle_t)waiter, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+#else  /* I2C_USE_FREERTOS == 1 */
+    UNUSED(waiter);
+#endif /* I2C_USE_FREERTOS == 1 */
+}
+
+static void i2c_bus_run(i2c_bus_t *bus, i2c_xfer_t *xfer);
+
+/**
+ * @brief 当前传输结束, 启动下一次传输
+ *
+ * @param bus 总线
+ * @param status 结果
+ * @param error HAL错误码
+ */
+static void i2c_bus_done(i2c_bus_t *bus, i2c_xfer_status_t status,
+                         uint32_t error) {
+    i2c_xfer_t *xfer = bus->active;
+    i2c_xfer_t *next;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    bus->active = NULL;
+    next = i2c_bus_claim_next(bus);
+
+    __set_PRIMASK(primask);
+
+    /* 先启动下一次传输, 再处理完成的传输, 缩短总线空闲时间 */
+    if (next != NULL) {
+        i2c_bus_run(bus, next);
+    }
+
+    i2c_xfer_finish(xfer, status, error);
+}
+
+/**
+ * @brief 启动已占用总线的传输, 失败时恢复总线并结束该传输
+ *
+ * @param bus 总线
+ * @param xfer 传输
+ */
+static void i2c_bus_run(i2c_bus_t *bus, i2c_xfer_t *xfer) {
+    uint32_t error;
+
+    if (i2c_xfer_start(bus, xfer) == HAL_OK) {
+        return;
+    }
+
+    error = bus->hi2c->ErrorCode;
+    i2c_bus_recover(bus);
+    i2c_bus_done(bus, I2C_XFER_ERROR, error);
+}
+
+/**
+ * @brief 主机发送完成回调: 寄存器地址或写数据发送完成
+ *
+ * @param hi2c I2C句柄
+ */
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c) {
+    i2c_bus_t *bus = i2c_bus_identify(hi2c);
+    i2c_xfer_t *xfer;
+    uint32_t error;
+
+    if ((bus == NULL) || (bus->active == NULL)) {
+        return;
+    }
+
+    xfer = bus->active;
+    if ((bus->phase == I2C_PHASE_REG) && (xfer->len != 0)) {
+        /* 读时方向改变, 产生重复起始; 写时不产生起始, 直接继续发送数据 */
+        if (i2c_data_start(bus, xfer, I2C_LAST_FRAME) == HAL_OK) {
+            return;
+        }
+
+        error = hi2c->ErrorCode;
+        i2c_bus_recover(bus);
+        i2c_bus_done(bus, I2C_XFER_ERROR, error);
+        return;
+    }
+
+    i2c_bus_done(bus, I2C_XFER_DONE, HAL_I2C_ERROR_NONE);
+}
+
+/**
+ * @brief 主机接收完成回调
+ *
+ * @param hi2c I2C句柄
+ */
+void HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c) {
+    i2c_bus_t *bus = i2c_bus_identify(hi2c);
+
+    if ((bus == NULL) || (bus->active == NULL)) {
+        return;
+    }
+
+    i2c_bus_done(bus, I2C_XFER_DONE, HAL_I2C_ERROR_NONE);
+}
+
+/**
+ * @brief I2C错误回调
+ *
+ * @param hi2c I2C句柄
+ * @note 从机无应答时HAL库已经产生STOP, 其他错误需要恢复总线
+ */
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c) {
+    i2c_bus_t *bus = i2c_bus_identify(hi2c);
+    uint32_t error = hi2c->ErrorCode;
+
+    if ((bus == NULL) || (bus->active == NULL)) {
+        return;
+    }
+
+    if (error == HAL_I2C_ERROR_AF) {
+        i2c_bus_done(bus, I2C_XFER_NACK, error);
+        return;
+    }
+
+    i2c_bus_recover(bus);
+    i2c_bus_done(bus, I2C_XFER_ERROR, error);
+}
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup 提交和等待
+ * @{
+ */
+
+/**
+ * @brief 提交传输, 总线空闲时立即开始
+ *
+ * @param xfer 传输
+ * @return 1: 已入队; 0: 队列满或总线未初始化
+ * @note 完成后一般在中断中调用回调, 可以在中断和回调中调用
+ */
+uint32_t i2c_submit(i2c_xfer_t *xfer) {
+    i2c_bus_t *bus;
+    i2c_xfer_t *next;
+    uint32_t primask;
+
+    if (xfer == NULL) {
+        return 0;
+    }
+
+    bus = i2c_bus_identify(xfer->hi2c);
+    if ((bus == NULL) || (xfer->hi2c->State == HAL_I2C_STATE_RESET)) {
+        return 0;
+    }
+
+#ifdef DEBUG
+    assert(xfer->reg_size <= 2);
+    assert((xfer->len != 0) || ((xfer->read == 0) && (xfer->reg_size != 0)));
+#endif /* DEBUG */
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (bus->queue_in - bus->queue_out >= I2C_QUEUE_SIZE) {
+        __set_PRIMASK(primask);
+        return 0;
+    }
+
+    xfer->status = I2C_XFER_QUEUED;
+    bus->queue[bus->queue_in & (I2C_QUEUE_SIZE - 1U)] = xfer;
+    ++bus->queue_in;
+    next = i2c_bus_claim_next(bus);
+
+    __set_PRIMASK(primask);
+
+    /* 已经占用总线, 总线中断不会在此时到来, 开中断启动 */
+    if (next != NULL) {
+        i2c_bus_run(bus, next);
+    }
+
+    return 1;
+}
+
+/**
+ * @brief 取消还未开始的传输
+ *
+ * @param bus 总线
+ * @param xfer 传输
+ * @return 1: 已取消; 0: 已经开始或已经结束
+ */
+static uint32_t i2c_xfer_cancel(i2c_bus_t *bus, i2c_xfer_t *xfer) {
+    uint32_t cancelled = 0;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (xfer->status == I2C_XFER_QUEUED) {
+        /* 从队列中移除, 调用者返回后传输可能已经失效 */
+        for (uint32_t i = bus->queue_out; i != bus->queue_in; ++i) {
+            if (bus->queue[i & (I2C_QUEUE_SIZE - 1U)] == xfer) {
+                bus->queue[i & (I2C_QUEUE_SIZE - 1U)] = NULL;
+            }
+        }
+        xfer->status = I2C_XFER_CANCELLED;
+        xfer->waiter = NULL;
+        cancelled = 1;
+    }
+
+    __set_PRIMASK(primask);
+    return cancelled;
+}
+
+/**
+ * @brief 中止正在进行的传输并恢复总线
+ *
+ * @param bus 总线
+ * @param xfer 传输
+ * @return 1: 已中止; 0: 传输已经结束
+ */
+static uint32_t i2c_xfer_abort(i2c_bus_t *bus, i2c_xfer_t *xfer) {
+    for (uint32_t i = 0; i < 4; ++i) {
+        HAL_NVIC_DisableIRQ(bus->irqn[i]);
+    }
+
+    if (bus->active != xfer) {
+        for (uint32_t i = 0; i < 4; ++i) {
+            HAL_NVIC_EnableIRQ(bus->irqn[i]);
+        }
+        return 0;
+    }
+
+    /* 由等待的任务自己中止, 不需要通知 */
+    xfer->waiter = NULL;
+
+    (void)HAL_DMA_Abort(bus->hdma_tx);
+    (void)HAL_DMA_Abort(bus->hdma_rx);
+    i2c_bus_recover(bus);
+
+    for (uint32_t i = 0; i < 4; ++i) {
+        HAL_NVIC_ClearPendingIRQ(bus->irqn[i]);
+    }
+
+    i2c_bus_done(bus, I2C_XFER_TIMEOUT, HAL_I2C_ERROR_TIMEOUT);
+
+    for (uint32_t i = 0; i < 4; ++i) {
+        HAL_NVIC_EnableIRQ(bus->irqn[i]);
+    }
+
+    return 1;
+}
+
+/**
+ * @brief 传输是否还未结束
+ *
+ * @param xfer 传输
+ * @return 1: 在队列中或正在传输
+ */
+static inline uint32_t i2c_xfer_pending(i2c_xfer_t *xfer) {
+    i2c_xfer_status_t status = xfer->status;
+
+    return (status == I2C_XFER_QUEUED) || (status == I2C_XFER_ACTIVE);
+}
+
+/**
+ * @brief 超时处理: 取消未开始的传输或中止正在进行的传输
+ *
+ * @param bus 总线
+ * @param xfer 传输
+ * @return 1: 由本函数结束了传输; 0: 传输已经结束
+ */
+static uint32_t i2c_xfer_expire(i2c_bus_t *bus, i2c_xfer_t *xfer) {
+    if (i2c_xfer_cancel(bus, xfer)) {
+        return 1;
+    }
+
+    return i2c_xfer_abort(bus, xfer);
+}
+
+/**
+ * @brief 提交传输并等待完成
+ *
+ * @param xfer 传输
+ * @param timeout 超时时间. FreeRTOS中单位为tick, 裸机中单位为ms
+ * @return 传输结果. 队列满时返回I2C_XFER_IDLE;
+ *         超时时未开始的传输被取消, 正在进行的传输被中止并恢复总线
+ * @note 不能在中断中调用. FreeRTOS调度器运行时挂起任务等待,
+ *       由中断通知唤醒; 否则轮询等待
+ */
+i2c_xfer_status_t i2c_transfer(i2c_xfer_t *xfer, uint32_t timeout) {
+    i2c_bus_t *bus = i2c_bus_identify(xfer->hi2c);
+    uint32_t expired = 0;
+
+#if (I2C_USE_FREERTOS == 1)
+    if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) {
+        TickType_t start = xTaskGetTickCount();
+        TickType_t elapsed;
+        uint32_t taken = 0;
+        uint32_t notified;
+        uint32_t primask;
+
+        xfer->waiter = xTaskGetCurrentTaskHandle();
+        if (i2c_submit(xfer) == 0) {
+            xfer->waiter = NULL;
+            return I2C_XFER_IDLE;
+        }
+
+        while (i2c_xfer_pending(xfer)) {
+            elapsed = xTaskGetTickCount() - start;
+            if ((timeout != portMAX_DELAY) && (elapsed >= timeout)) {
+                expired = i2c_xfer_expire(bus, xfer);
+                break;
+            }
+            taken = ulTaskNotifyTake(pdTRUE, (timeout == portMAX_DELAY)
+                                                 ? portMAX_DELAY
+                                                 : timeout - elapsed);
+        }
+
+        /* 中断已通知但没有被取走时清除, 以免影响下一次等待 */
+        primask = __get_PRIMASK();
+        __disable_irq();
+        notified = (xfer->waiter == NULL) && (expired == 0);
+        xfer->waiter = NULL;
+        __set_PRIMASK(primask);
+
+        if (notified && (taken == 0)) {
+            ulTaskNotifyTake(pdTRUE, 0);
+        }
+
+        return xfer->status;
+    }
+#endif /* I2C_USE_FREERTOS == 1 */
+
+    uint32_t tick_start;
+
+    xfer->waiter = NULL;
+    if (i2c_submit(xfer) == 0) {
+        return I2C_XFER_IDLE;
+    }
+
+    tick_start = HAL_GetTick();
+    while (i2c_xfer_pending(xfer)) {
+        if (HAL_GetTick() - tick_start >= timeout) {
+            expired = i2c_xfer_expire(bus, xfer);
+            break;
+        }
+    }
+    UNUSED(expired);
+
+    return xfer->status;
+}
+
+/**
+ * @brief 读寄存器
+ *
+ * @param hi2c I2C句柄
+ * @param dev_addr 7位从机地址
+ * @param reg 寄存器地址
+ * @param reg_size 寄存器地址长度: 0, 1或2
+ * @param buf 接收缓冲区
+ * @param len 长度, 不能为0
+ * @param timeout 超时时间, 同i2c_transfer
+ * @return 传输结果, 同i2c_transfer
+ */
+i2c_xfer_status_t i2c_mem_read(I2C_HandleTypeDef *hi2c, uint16_t dev_addr,
+                               uint16_t reg, uint8_t reg_size, void *buf,
+                               uint16_t len, uint32_t timeout) {
+    i2c_xfer_t xfer = {
+        .hi2c = hi2c,
+        .dev_addr = dev_addr,
+        .reg = reg,
+        .reg_size = reg_size,
+        .read = 1,
+        .len = len,
+        .buf = buf,
+    };
+
+    return i2c_transfer(&xfer, timeout);
+}
+
+/**
+ * @brief 写寄存器
+ *
+ * @param hi2c I2C句柄
+ * @param dev_addr 7位从机地址
+ * @param reg 寄存器地址
+ * @param reg_size 寄存器地址长度: 0, 1或2
+ * @param buf 数据
+ * @param len 长度, 为0时只写寄存器地址
+ * @param timeout 超时时间, 同i2c_transfer
+ * @return 传输结果, 同i2c_transfer
+ */
+i2c_xfer_status_t i2c_mem_write(I2C_HandleTypeDef *hi2c, uint16_t dev_addr,
+                                uint16_t reg, uint8_t reg_size,
+                                const void *buf, uint16_t len,
+                                uint32_t timeout) {
+    i2c_xfer_t xfer = {
+        .hi2c = hi2c,
+        .dev_addr = dev_addr,
+        .reg = reg,
+        .reg_size = reg_size,
+        .read = 0,
+        .len = len,
+        .buf = (void *)buf,
+    };
+
+    return i2c_transfer(&xfer, timeout);
+}
+
+/**
+ * @}
+ */
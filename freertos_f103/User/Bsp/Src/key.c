@@ -8,6 +8,56 @@
 
 #include "key.h"
 
+#include "FreeRTOS.h"
+#include "queue.h"
+
+#include <assert.h>
+
+#define KEY_NUM              3U
+
+/* 以扫描周期为单位的时间 */
+#define KEY_DEBOUNCE_TICKS   (KEY_DEBOUNCE_MS / KEY_SCAN_PERIOD_MS)
+#define KEY_LONG_PRESS_TICKS (KEY_LONG_PRESS_MS / KEY_SCAN_PERIOD_MS)
+#define KEY_DOUBLE_TICKS     (KEY_DOUBLE_CLICK_MS / KEY_SCAN_PERIOD_MS)
+
+/**
+ * @brief 按键引脚
+ */
+typedef struct {
+    GPIO_TypeDef *port;   /* 端口 */
+    uint16_t pin;         /* 引脚 */
+    GPIO_PinState active; /* 按下时的电平 */
+} key_gpio_t;
+
+/**
+ * @brief 按键状态
+ */
+typedef struct {
+    uint8_t pressed;   /* 消抖后的状态 */
+    uint8_t debounce;  /* 电平与消抖后状态不同的持续时间 */
+    uint8_t is_double; /* 本次按下已产生双击事件 */
+    uint16_t hold;     /* 按下持续时间 */
+    uint16_t idle;     /* 松开持续时间, 最大为KEY_DOUBLE_TICKS */
+} key_state_t;
+
+/* 顺序与key_press_t一致 */
+static const key_gpio_t key_gpio[KEY_NUM] = {
+    {KEY0_GPIO_PORT, KEY0_GPIO_PIN, GPIO_PIN_RESET},
+    {KEY1_GPIO_PORT, KEY1_GPIO_PIN, GPIO_PIN_RESET},
+    {WKUP_GPIO_PORT, WKUP_GPIO_PIN, GPIO_PIN_SET  },
+};
+
+static key_state_t key_state[KEY_NUM];
+static TIM_HandleTypeDef key_tim_handle = {.Instance = KEY_TIM};
+static uint8_t key_tim_running;
+static QueueHandle_t key_event_queue;
+
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+static StaticQueue_t key_event_queue_tcb;
+static uint8_t
+    key_event_queue_storage[KEY_EVENT_QUEUE_LEN * sizeof(key_event_t)];
+#endif /* configSUPPORT_STATIC_ALLOCATION == 1 */
+
 /**
  * @brief 按键初始化函数
  *
@@ -20,56 +70,197 @@ void key_init(void) {
     WKUP_GPIO_ENABLE();
 
     gpio_initure.Pin = KEY0_GPIO_PIN;
-    gpio_initure.Mode = GPIO_MODE_INPUT;
+    gpio_initure.Mode = GPIO_MODE_IT_RISING_FALLING;
     gpio_initure.Pull = GPIO_PULLUP;
     gpio_initure.Speed = GPIO_SPEED_FREQ_HIGH;
     HAL_GPIO_Init(KEY0_GPIO_PORT, &gpio_initure);
 
     gpio_initure.Pin = KEY1_GPIO_PIN;
-    gpio_initure.Mode = GPIO_MODE_INPUT;
+    gpio_initure.Mode = GPIO_MODE_IT_RISING_FALLING;
     gpio_initure.Pull = GPIO_PULLUP;
     gpio_initure.Speed = GPIO_SPEED_FREQ_HIGH;
     HAL_GPIO_Init(KEY1_GPIO_PORT, &gpio_initure);
 
     gpio_initure.Pin = WKUP_GPIO_PIN;
-    gpio_initure.Mode = GPIO_MODE_INPUT;
+    gpio_initure.Mode = GPIO_MODE_IT_RISING_FALLING;
     gpio_initure.Pull = GPIO_PULLDOWN;
     gpio_initure.Speed = GPIO_SPEED_FREQ_HIGH;
     HAL_GPIO_Init(WKUP_GPIO_PORT, &gpio_initure);
+
+    for (uint32_t i = 0; i < KEY_NUM; ++i) {
+        key_state[i].idle = KEY_DOUBLE_TICKS;
+    }
+
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+    key_event_queue =
+        xQueueCreateStatic(KEY_EVENT_QUEUE_LEN, sizeof(key_event_t),
+                           key_event_queue_storage, &key_event_queue_tcb);
+#else  /* configSUPPORT_STATIC_ALLOCATION == 1 */
+    key_event_queue = xQueueCreate(KEY_EVENT_QUEUE_LEN, sizeof(key_event_t));
+#endif /* configSUPPORT_STATIC_ALLOCATION == 1 */
+#ifdef DEBUG
+    assert(key_event_queue != NULL);
+#endif /* DEBUG */
+
+    /* 扫描定时器: 72MHz / 7200 = 10kHz */
+    KEY_TIM_CLK_ENABLE();
+    key_tim_handle.Init.Prescaler = 7200 - 1;
+    key_tim_handle.Init.CounterMode = TIM_COUNTERMODE_UP;
+    key_tim_handle.Init.Period = KEY_SCAN_PERIOD_MS * 10 - 1;
+    key_tim_handle.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+    HAL_TIM_Base_Init(&key_tim_handle);
+    __HAL_TIM_CLEAR_FLAG(&key_tim_handle, TIM_FLAG_UPDATE);
+
+    /* 定时器和外部中断使用相同优先级, 互不抢占 */
+    HAL_NVIC_SetPriority(KEY_TIM_IRQn, KEY_IT_PREEMPT, KEY_IT_SUB);
+    HAL_NVIC_EnableIRQ(KEY_TIM_IRQn);
+    HAL_NVIC_SetPriority(KEY0_IRQn, KEY_IT_PREEMPT, KEY_IT_SUB);
+    HAL_NVIC_EnableIRQ(KEY0_IRQn);
+    HAL_NVIC_SetPriority(KEY1_IRQn, KEY_IT_PREEMPT, KEY_IT_SUB);
+    HAL_NVIC_EnableIRQ(KEY1_IRQn);
+    HAL_NVIC_SetPriority(WKUP_IRQn, KEY_IT_PREEMPT, KEY_IT_SUB);
+    HAL_NVIC_EnableIRQ(WKUP_IRQn);
 }
 
-/* 检测按键按下 */
-#define KEY0  HAL_GPIO_ReadPin(KEY0_GPIO_PORT, KEY0_GPIO_PIN)
-#define KEY1  HAL_GPIO_ReadPin(KEY1_GPIO_PORT, KEY1_GPIO_PIN)
-#define WK_UP HAL_GPIO_ReadPin(WKUP_GPIO_PORT, WKUP_GPIO_PIN)
+/**
+ * @brief 获取按键事件
+ *
+ * @param[out] event 按键事件
+ * @param timeout 等待时间(tick), `portMAX_DELAY`为一直等待
+ * @return 是否获取到事件
+ *  @retval 1: 获取到事件
+ *  @retval 0: 超时
+ */
+uint8_t key_get_event(key_event_t *event, uint32_t timeout) {
+    return (xQueueReceive(key_event_queue, event, timeout) == pdTRUE);
+}
 
 /**
- * @brief 按键扫描
+ * @brief 发送按键事件
  *
- * @param mode 是否支持连按
- *  0-不支持连按, 1-支持连按
- * @return 按下的按键
- *  @retval 按下:`KEY0_GPIO_PRES ~ WKUP_GPIO_PRES`
- *  @retval 未按下:`0`
- * @note 注意此函数有响应优先级,`KEY0 > KEY1 > WK_UP`
+ * @param key 按键
+ * @param type 事件类型
+ * @param[out] woken 是否需要切换任务
  */
-uint8_t key_scan(uint8_t mode) {
-    static uint8_t key_up = 1; /* 按键松开标志 */
-    if (mode == 1) {
-        key_up = 1; /* 支持连按 */
-    }
-    if (key_up && (KEY0 == 0 || KEY1 == 0 || WK_UP == 1)) {
-        HAL_Delay(10);
-        key_up = 0;
-        if (KEY0 == 0) {
-            return KEY0_PRESS;
-        } else if (KEY1 == 0) {
-            return KEY1_PRESS;
-        } else if (WK_UP == 1) {
-            return WKUP_PRESS;
+static void key_post_event(uint32_t key, key_event_type_t type,
+                           BaseType_t *woken) {
+    key_event_t event = {.key = (uint8_t)key, .type = (uint8_t)type};
+
+    /* 队列满时丢弃 */
+    xQueueSendFromISR(key_event_queue, &event, woken);
+}
+
+/**
+ * @brief 按键状态机, 每个扫描周期调用一次
+ *
+ * @param[out] woken 是否需要切换任务
+ * @return 是否还需要继续扫描
+ */
+static uint8_t key_tick(BaseType_t *woken) {
+    uint8_t busy = 0;
+
+    for (uint32_t i = 0; i < KEY_NUM; ++i) {
+        key_state_t *state = &key_state[i];
+        uint8_t level = (HAL_GPIO_ReadPin(key_gpio[i].port, key_gpio[i].pin) ==
+                         key_gpio[i].active);
+
+        if (level != state->pressed) {
+            if (++state->debounce >= KEY_DEBOUNCE_TICKS) {
+                state->debounce = 0;
+                state->pressed = level;
+
+                if (level) {
+                    key_post_event(i + 1, KEY_EVENT_PRESS, woken);
+                    state->is_double = (state->idle < KEY_DOUBLE_TICKS);
+                    if (state->is_double) {
+                        key_post_event(i + 1, KEY_EVENT_DOUBLE_CLICK, woken);
+                    }
+                    state->hold = 0;
+                } else {
+                    key_post_event(i + 1, KEY_EVENT_RELEASE, woken);
+                    /* 双击后的松开不再作为下一次双击的开始 */
+                    state->idle = state->is_double ? KEY_DOUBLE_TICKS : 0;
+                }
+            }
+        } else {
+            state->debounce = 0;
+        }
+
+        if (state->pressed) {
+            if (state->hold < KEY_LONG_PRESS_TICKS) {
+                if (++state->hold == KEY_LONG_PRESS_TICKS) {
+                    key_post_event(i + 1, KEY_EVENT_LONG_PRESS, woken);
+                }
+            }
+        } else if (state->idle < KEY_DOUBLE_TICKS) {
+            ++state->idle;
+        }
+
+        /* 长按已产生或双击等待结束后, 只需等待下一次边沿 */
+        if ((state->debounce != 0) ||
+            (state->pressed && (state->hold < KEY_LONG_PRESS_TICKS)) ||
+            (!state->pressed && (state->idle < KEY_DOUBLE_TICKS))) {
+            busy = 1;
         }
-    } else if (KEY0 == 1 && KEY1 == 1 && WK_UP == 0) {
-        key_up = 1;
     }
-    return KEY_NO_PRESS; /* 无按键按下 */
+
+    return busy;
+}
+
+/**
+ * @brief 按键引脚外部中断回调, 启动扫描定时器
+ *
+ * @param GPIO_Pin 引脚
+ */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin) {
+    if ((GPIO_Pin & (KEY0_GPIO_PIN | KEY1_GPIO_PIN | WKUP_GPIO_PIN)) == 0) {
+        return;
+    }
+
+    if (!key_tim_running) {
+        key_tim_running = 1;
+        __HAL_TIM_SET_COUNTER(&key_tim_handle, 0);
+        HAL_TIM_Base_Start_IT(&key_tim_handle);
+    }
+}
+
+/**
+ * @brief KEY0外部中断服务函数
+ */
+void KEY0_IRQHandler(void) {
+    HAL_GPIO_EXTI_IRQHandler(KEY0_GPIO_PIN);
+}
+
+/**
+ * @brief KEY1外部中断服务函数
+ */
+void KEY1_IRQHandler(void) {
+    HAL_GPIO_EXTI_IRQHandler(KEY1_GPIO_PIN);
+}
+
+/**
+ * @brief WK_UP外部中断服务函数
+ */
+void WKUP_IRQHandler(void) {
+    HAL_GPIO_EXTI_IRQHandler(WKUP_GPIO_PIN);
+}
+
+/**
+ * @brief 按键扫描定时器中断服务函数
+ */
+void KEY_TIM_IRQHandler(void) {
+    BaseType_t woken = pdFALSE;
+
+    if (__HAL_TIM_GET_FLAG(&key_tim_handle, TIM_FLAG_UPDATE) == RESET) {
+        return;
+    }
+    __HAL_TIM_CLEAR_FLAG(&key_tim_handle, TIM_FLAG_UPDATE);
+
+    if (!key_tick(&woken)) {
+        /* 所有按键都已稳定, 停止扫描直到下一次外部中断 */
+        HAL_TIM_Base_Stop_IT(&key_tim_handle);
+        key_tim_running = 0;
+    }
+
+    portYIELD_FROM_ISR(woken);
 }
@@ -0,0 +1,1014 @@
+/**
+ * @file    kv.c
+ * @author  Deadline039
+ * @brief   内部Flash键值存储
+ * @version 1.0
+ * @date    2026-10-18
+ * @note    Flash只能按半字写入, 且只能写入已擦除(0xFFFF)的半字;
+ *          例外是任何半字都可以写为0x0000, 页状态和提交标志利用这一点,
+ *          不需要擦除就能改变状态.
+ *
+ * 页布局:
+ *   0: 魔数(半字) 2: 状态(半字) 4: 序号(字) 8: 记录...
+ * 记录布局, 按4字节对齐:
+ *   0: 键(半字) 2: 长度(半字) 4: 数据, 补齐到4字节
+ *   n: CRC(字, 覆盖键, 长度和数据) n+4: 提交标志(半字) n+6: 保留(半字)
+ */
+
+#include "kv.h"
+#include "crc32.h"
+
+#include "stm32f1xx_hal.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#if (KV_USE_FREERTOS == 1)
+#include "FreeRTOS.h"
+#include "task.h"
+#endif /* KV_USE_FREERTOS == 1 */
+
+#if ((KV_FLASH_BASE % KV_PAGE_SIZE) != 0)
+#error "KV_FLASH_BASE必须按页对齐"
+#endif /* KV_FLASH_BASE */
+
+#if ((KV_PAGE_NUM < 2) || (KV_PAGE_NUM > 64))
+#error "KV_PAGE_NUM必须在2~64之间"
+#endif /* KV_PAGE_NUM */
+
+#if (((KV_INDEX_SIZE) & ((KV_INDEX_SIZE) - 1)) != 0)
+#error "KV_INDEX_SIZE必须为2的幂次方"
+#endif /* KV_INDEX_SIZE */
+
+#if ((KV_VALUE_MAX < 1) || (KV_VALUE_MAX > 1024))
+#error "KV_VALUE_MAX必须在1~1024之间"
+#endif /* KV_VALUE_MAX */
+
+/* 页头 */
+#define KV_PAGE_MAGIC     0x564BU /* "KV" */
+#define KV_PAGE_VALID     0x0000U /* 状态: 有效. 为0xFFFF时正在复制 */
+#define KV_HEADER_SIZE    8U
+
+/* 记录 */
+#define KV_COMMIT         0x0000U /* 提交标志 */
+#define KV_LEN_DELETED    0x8000U /* 长度的最高位: 删除标记 */
+#define KV_ALIGN4(n)      (((n) + 3U) & ~3U)
+#define KV_REC_SIZE(len)  (4U + KV_ALIGN4(len) + 8U)
+
+/* 记录位置: 页号[14:9], 页内偏移/4[8:0] */
+#define KV_LOC(page, off) ((uint16_t)(((page) << 9) | ((off) >> 2)))
+#define KV_LOC_PAGE(loc)  ((uint32_t)(loc) >> 9)
+#define KV_LOC_OFF(loc)   (((uint32_t)(loc) & 0x1FFU) << 2)
+#define KV_LOC_NONE       0xFFFFU
+
+/* 没有当前页 */
+#define KV_HEAD_NONE      KV_PAGE_NUM
+
+/* 定义KV_FLASH_SIM时, 存储区KV_FLASH_MEM和擦写操作kv_hw_erase,
+ * kv_hw_program由主机测试的模拟Flash提供 */
+#ifndef KV_FLASH_SIM
+#define KV_FLASH_MEM      ((const uint8_t *)KV_FLASH_BASE)
+#endif /* KV_FLASH_SIM */
+
+/**
+ * @brief 页头
+ */
+typedef struct {
+    uint16_t magic; /*!< KV_PAGE_MAGIC */
+    uint16_t state; /*!< 页状态 */
+    uint32_t seq;   /*!< 序号, 越大越新 */
+} kv_page_header_t;
+
+/**
+ * @brief 记录解析结果
+ */
+typedef enum {
+    KV_REC_VALID = 0U, /*!< 已提交且校验正确 */
+    KV_REC_FREE,       /*!< 空白区域, 之后没有记录 */
+    KV_REC_BAD         /*!< 掉电时没有写完, 之后不再写入该页 */
+} kv_rec_result_t;
+
+/**
+ * @brief 记录信息
+ */
+typedef struct {
+    uint16_t key;  /*!< 键 */
+    uint16_t len;  /*!< 数据长度 */
+    uint8_t del;   /*!< 1: 删除标记 */
+    uint32_t size; /*!< 记录占用的字节数 */
+} kv_rec_t;
+
+/**
+ * @brief 索引表项
+ */
+typedef struct {
+    uint16_t key; /*!< 键, KV_KEY_INVALID为空 */
+    uint16_t loc; /*!< 最新记录的位置, 已回收的删除标记为KV_LOC_NONE */
+} kv_index_entry_t;
+
+static kv_index_entry_t kv_index[KV_INDEX_SIZE];
+
+static uint8_t kv_page_used[KV_PAGE_NUM];
+static uint32_t kv_page_seq[KV_PAGE_NUM];
+static uint32_t kv_seq_max;
+static uint32_t kv_head = KV_HEAD_NONE;
+static uint32_t kv_head_off;
+static uint32_t kv_ready;
+
+static uint32_t kv_keys;
+static uint32_t kv_live_bytes;
+static uint32_t kv_gc_count;
+static uint32_t kv_erases;
+
+/* 待写入的记录 */
+static uint32_t kv_rec_buf[KV_REC_SIZE(KV_VALUE_MAX) / sizeof(uint32_t)];
+
+/**
+ * @brief 页的起始地址
+ *
+ * @param page 页号
+ * @return 起始地址
+ */
+static inline const uint8_t *kv_page_ptr(uint32_t page) {
+    return KV_FLASH_MEM + page * KV_PAGE_SIZE;
+}
+
+/**
+ * @brief 独占访问
+ *
+ * @note Flash擦写期间CPU本来就无法运行, 挂起调度器不会增加其他任务的延迟
+ */
+static inline void kv_lock(void) {
+#if (KV_USE_FREERTOS == 1)
+    if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) {
+        vTaskSuspendAll();
+    }
+#endif /* KV_USE_FREERTOS == 1 */
+}
+
+/**
+ * @brief 结束独占访问
+ *
+ */
+static inline void kv_unlock(void) {
+#if (KV_USE_FREERTOS == 1)
+    if (xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED) {
+        (void)xTaskResumeAll();
+    }
+#endif /* KV_USE_FREERTOS == 1 */
+}
+
+/*****************************************************************************
+ * @defgroup Flash操作
+ * @{
+ */
+
+#ifndef KV_FLASH_SIM
+
+/**
+ * @brief 擦除Flash页
+ *
+ * @param p 页起始地址
+ * @return HAL_OK或错误
+ */
+static HAL_StatusTypeDef kv_hw_erase(const uint8_t *p) {
+    FLASH_EraseInitTypeDef erase_init = {
+        .TypeErase = FLASH_TYPEERASE_PAGES,
+        .Banks = FLASH_BANK_1,
+        .PageAddress = (uint32_t)p,
+        .NbPages = 1};
+    uint32_t page_error = 0;
+
+    return HAL_FLASHEx_Erase(&erase_init, &page_error);
+}
+
+/**
+ * @brief 写入一个半字
+ *
+ * @param p 地址, 2字节对齐
+ * @param data 数据
+ * @return HAL_OK或错误
+ */
+static HAL_StatusTypeDef kv_hw_program(const uint8_t *p, uint16_t data) {
+    return HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, (uint32_t)p, data);
+}
+
+#endif /* KV_FLASH_SIM */
+
+/**
+ * @brief 按半字写入并校验
+ *
+ * @param dst 地址, 2字节对齐
+ * @param data 数据, 可以位于Flash中
+ * @param num 半字数
+ * @return KV_OK或KV_ERR_FLASH
+ * @note 跳过0xFFFF, 擦除后的Flash已经是该值
+ */
+static kv_status_t kv_flash_program(const uint8_t *dst, const uint16_t *data,
+                                    uint32_t num) {
+    kv_status_t res = KV_OK;
+
+    (void)HAL_FLASH_Unlock();
+
+    for (uint32_t i = 0; i < num; ++i, dst += 2U) {
+        if (data[i] == 0xFFFFU) {
+            continue;
+        }
+        if ((kv_hw_program(dst, data[i]) != HAL_OK) ||
+            (*(const __IO uint16_t *)dst != data[i])) {
+            res = KV_ERR_FLASH;
+            break;
+        }
+    }
+
+    (void)HAL_FLASH_Lock();
+    return res;
+}
+
+/**
+ * @brief 擦除一页
+ *
+ * @param page 页号
+ * @return KV_OK或KV_ERR_FLASH
+ * @note 擦除中掉电时页头可能只擦除了一部分, 序号变大后旧页会被当作最新的页.
+ *       所以先把魔数写为0, 没有擦除完的页在启动时一定无效
+ */
+static kv_status_t kv_flash_erase(uint32_t page) {
+    const kv_page_header_t *header =
+        (const kv_page_header_t *)kv_page_ptr(page);
+    const uint16_t magic = 0x0000U;
+    HAL_StatusTypeDef res;
+
+    if (header->magic == KV_PAGE_MAGIC) {
+        (void)kv_flash_program((const uint8_t *)&header->magic, &magic, 1);
+    }
+
+    (void)HAL_FLASH_Unlock();
+    res = kv_hw_erase(kv_page_ptr(page));
+    (void)HAL_FLASH_Lock();
+
+    ++kv_erases;
+    return (res == HAL_OK) ? KV_OK : KV_ERR_FLASH;
+}
+
+/**
+ * @brief 页是否全部为擦除状态
+ *
+ * @param page 页号
+ * @return 1: 空白
+ */
+static uint32_t kv_page_blank(uint32_t page) {
+    const uint32_t *p = (const uint32_t *)kv_page_ptr(page);
+
+    for (uint32_t i = 0; i < KV_PAGE_SIZE / sizeof(uint32_t); ++i) {
+        if (p[i] != 0xFFFFFFFFU) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * @brief 写入页头, 开始使用空白页
+ *
+ * @param page 页号
+ * @param valid 1: 直接标记为有效; 0: 保持复制状态, 之后调用kv_page_commit
+ * @return KV_OK或KV_ERR_FLASH
+ * @note 先写序号再写魔数, 魔数有效时序号一定完整
+ */
+static kv_status_t kv_page_open(uint32_t page, uint32_t valid) {
+    kv_page_header_t header = {.magic = KV_PAGE_MAGIC,
+                               .state = valid ? KV_PAGE_VALID : 0xFFFFU,
+                               .seq = kv_seq_max + 1U};
+    const uint8_t *p = kv_page_ptr(page);
+    kv_status_t res;
+
+    res = kv_flash_program(p + offsetof(kv_page_header_t, seq),
+                           (const uint16_t *)&header.seq, 2);
+    if (res == KV_OK) {
+        res = kv_flash_program(p, (const uint16_t *)&header, 2);
+    }
+    if (res != KV_OK) {
+        (void)kv_flash_erase(page);
+        return res;
+    }
+
+    ++kv_seq_max;
+    kv_page_seq[page] = kv_seq_max;
+    kv_page_used[page] = 1;
+    return KV_OK;
+}
+
+/**
+ * @brief 把正在复制的页标记为有效
+ *
+ * @param page 页号
+ * @return KV_OK或KV_ERR_FLASH
+ */
+static kv_status_t kv_page_commit(uint32_t page) {
+    const uint16_t state = KV_PAGE_VALID;
+
+    return kv_flash_program(kv_page_ptr(page) +
+                                offsetof(kv_page_header_t, state),
+                            &state, 1);
+}
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup 记录和索引
+ * @{
+ */
+
+/**
+ * @brief 解析一条记录
+ *
+ * @param page 页号
+ * @param off 页内偏移
+ * @param[out] rec 记录信息
+ * @return 解析结果
+ */
+static kv_rec_result_t kv_rec_parse(uint32_t page, uint32_t off,
+                                    kv_rec_t *rec) {
+    const uint8_t *p = kv_page_ptr(page) + off;
+    uint32_t head;
+    uint32_t crc;
+
+    if (off + KV_REC_SIZE(0) > KV_PAGE_SIZE) {
+        return KV_REC_FREE;
+    }
+
+    head = *(const uint32_t *)p;
+    if (head == 0xFFFFFFFFU) {
+        return KV_REC_FREE;
+    }
+
+    rec->key = (uint16_t)head;
+    rec->del = ((head >> 16) & KV_LEN_DELETED) ? 1U : 0U;
+    rec->len = (uint16_t)((head >> 16) & ~KV_LEN_DELETED);
+    rec->size = KV_REC_SIZE(rec->len);
+
+    if ((rec->key == KV_KEY_INVALID) || (rec->len > KV_VALUE_MAX) ||
+        (rec->del && (rec->len != 0)) || (off + rec->size > KV_PAGE_SIZE)) {
+        return KV_REC_BAD;
+    }
+
+    if (*(const uint16_t *)(p + rec->size - 4U) != KV_COMMIT) {
+        return KV_REC_BAD;
+    }
+
+    crc = crc32_word_calc((const uint32_t *)p,
+                          (4U + KV_ALIGN4(rec->len)) / sizeof(uint32_t));
+    if (crc != *(const uint32_t *)(p + rec->size - 8U)) {
+        return KV_REC_BAD;
+    }
+
+    return KV_REC_VALID;
+}
+
+/**
+ * @brief 查找键的索引表项
+ *
+ * @param key 键
+ * @param create 1: 不存在时返回空表项
+ * @return 表项, 不存在或表已满时返回NULL
+ */
+static kv_index_entry_t *kv_index_find(uint16_t key, uint32_t create) {
+    uint32_t i = (((uint32_t)key * 0x9E3779B1U) >> 16) & (KV_INDEX_SIZE - 1U);
+
+    for (uint32_t n = 0; n < KV_INDEX_SIZE; ++n) {
+        if (kv_index[i].key == key) {
+            return &kv_index[i];
+        }
+        if (kv_index[i].key == KV_KEY_INVALID) {
+            return create ? &kv_index[i] : NULL;
+        }
+        i = (i + 1U) & (KV_INDEX_SIZE - 1U);
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief 表项指向新的记录, 更新有效数据统计
+ *
+ * @param entry 表项
+ * @param key 键
+ * @param loc 新记录的位置, KV_LOC_NONE为移除
+ * @param rec 新记录, loc为KV_LOC_NONE时忽略
+ */
+static void kv_index_set(kv_index_entry_t *entry, uint16_t key, uint16_t loc,
+                         const kv_rec_t *rec) {
+    kv_rec_t old;
+
+    if (entry->loc != KV_LOC_NONE) {
+        (void)kv_rec_parse(KV_LOC_PAGE(entry->loc), KV_LOC_OFF(entry->loc),
+                           &old);
+        kv_live_bytes -= old.size;
+        kv_keys -= old.del ? 0U : 1U;
+    }
+
+    entry->key = key;
+    entry->loc = loc;
+
+    if (loc != KV_LOC_NONE) {
+        kv_live_bytes += rec->size;
+        kv_keys += rec->del ? 0U : 1U;
+    }
+}
+
+/**
+ * @brief 序号大于seq的页中最旧的一页
+ *
+ * @param seq 序号
+ * @return 页号, 没有时返回KV_HEAD_NONE
+ */
+static uint32_t kv_page_after(uint32_t seq) {
+    uint32_t found = KV_HEAD_NONE;
+
+    for (uint32_t page = 0; page < KV_PAGE_NUM; ++page) {
+        if (kv_page_used[page] && (kv_page_seq[page] > seq) &&
+            ((found == KV_HEAD_NONE) ||
+             (kv_page_seq[page] < kv_page_seq[found]))) {
+            found = page;
+        }
+    }
+
+    return found;
+}
+
+/**
+ * @brief 按从旧到新的顺序扫描全部页, 建立索引
+ *
+ * @return KV_OK或KV_ERR_INDEX
+ * @note 最新的一页为当前页, 写入位置为第一个空白处.
+ *       遇到没有写完的记录时该页不再写入
+ */
+static kv_status_t kv_index_build(void) {
+    kv_index_entry_t *entry;
+    kv_rec_result_t result = KV_REC_FREE;
+    kv_rec_t rec;
+    uint32_t off = KV_HEADER_SIZE;
+
+    memset(kv_index, 0xFF, sizeof(kv_index));
+    kv_keys = 0;
+    kv_live_bytes = 0;
+    kv_head = KV_HEAD_NONE;
+
+    for (uint32_t page = kv_page_after(0); page != KV_HEAD_NONE;
+         page = kv_page_after(kv_page_seq[page])) {
+        for (off = KV_HEADER_SIZE;
+             (result = kv_rec_parse(page, off, &rec)) == KV_REC_VALID;
+             off += rec.size) {
+            entry = kv_index_find(rec.key, 1);
+            if (entry == NULL) {
+                return KV_ERR_INDEX;
+            }
+            kv_index_set(entry, rec.key, KV_LOC(page, off), &rec);
+        }
+        kv_head = page;
+    }
+
+    kv_head_off = (result == KV_REC_FREE) ? off : KV_PAGE_SIZE;
+    return KV_OK;
+}
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup 空间分配和垃圾回收
+ * @{
+ */
+
+/**
+ * @brief 空白页数
+ *
+ * @return 空白页数
+ */
+static uint32_t kv_erased_count(void) {
+    uint32_t count = 0;
+
+    for (uint32_t page = 0; page < KV_PAGE_NUM; ++page) {
+        count += kv_page_used[page] ? 0U : 1U;
+    }
+
+    return count;
+}
+
+/**
+ * @brief 选择下一个使用的空白页
+ *
+ * @return 当前页之后的第一个空白页, 各页轮流使用
+ */
+static uint32_t kv_erased_next(void) {
+    uint32_t page = (kv_head == KV_HEAD_NONE) ? 0U : kv_head;
+
+    for (uint32_t n = 0; n < KV_PAGE_NUM; ++n) {
+        page = (page + 1U) % KV_PAGE_NUM;
+        if (!kv_page_used[page]) {
+            return page;
+        }
+    }
+
+    return KV_HEAD_NONE;
+}
+
+/**
+ * @brief 记录是否为对应键的最新记录
+ *
+ * @param page 页号
+ * @param off 页内偏移
+ * @param rec 记录
+ * @return 索引表项, 不是最新记录时返回NULL
+ */
+static kv_index_entry_t *kv_rec_live(uint32_t page, uint32_t off,
+                                     const kv_rec_t *rec) {
+    kv_index_entry_t *entry = kv_index_find(rec->key, 0);
+
+    if ((entry == NULL) || (entry->loc != KV_LOC(page, off))) {
+        return NULL;
+    }
+
+    return entry;
+}
+
+/**
+ * @brief 回收最旧的一页
+ *
+ * @return KV_OK, KV_ERR_FULL(没有空白页)或KV_ERR_FLASH
+ * @note 有效记录复制到空白页, 新页标记有效后再擦除旧页.
+ *       最旧一页中的删除标记之前不会再有该键的记录, 直接丢弃.
+ *       复制出的新页成为当前页
+ */
+static kv_status_t kv_gc(void) {
+    uint32_t victim = kv_page_after(0);
+    uint32_t dest = KV_HEAD_NONE;
+    uint32_t dest_off = KV_HEADER_SIZE;
+    uint32_t copies = 0;
+    uint32_t off;
+    kv_index_entry_t *entry;
+    kv_status_t res;
+    kv_rec_t rec;
+
+    if (victim == KV_HEAD_NONE) {
+        return KV_ERR_FULL;
+    }
+
+    for (off = KV_HEADER_SIZE;
+         kv_rec_parse(victim, off, &rec) == KV_REC_VALID; off += rec.size) {
+        if (!rec.del && (kv_rec_live(victim, off, &rec) != NULL)) {
+            ++copies;
+        }
+    }
+
+    if (copies != 0) {
+        dest = kv_erased_next();
+        if (dest == KV_HEAD_NONE) {
+            return KV_ERR_FULL;
+        }
+
+        res = kv_page_open(dest, 0);
+        for (off = KV_HEADER_SIZE;
+             (res == KV_OK) &&
+             (kv_rec_parse(victim, off, &rec) == KV_REC_VALID);
+             off += rec.size) {
+            if (rec.del || (kv_rec_live(victim, off, &rec) == NULL)) {
+                continue;
+            }
+            res = kv_flash_program(
+                kv_page_ptr(dest) + dest_off,
+                (const uint16_t *)(kv_page_ptr(victim) + off), rec.size / 2U);
+            dest_off += rec.size;
+        }
+        if (res == KV_OK) {
+            res = kv_page_commit(dest);
+        }
+        if (res != KV_OK) {
+            /* 旧页仍然完整, 放弃复制 */
+            if (kv_page_used[dest]) {
+                kv_page_used[dest] = 0;
+                (void)kv_flash_erase(dest);
+            }
+            return res;
+        }
+    }
+
+    /* 新页已经有效, 索引指向新页, 删除标记移出索引 */
+    dest_off = KV_HEADER_SIZE;
+    for (off = KV_HEADER_SIZE;
+         kv_rec_parse(victim, off, &rec) == KV_REC_VALID; off += rec.size) {
+        entry = kv_rec_live(victim, off, &rec);
+        if (entry == NULL) {
+            continue;
+        }
+        if (rec.del) {
+            kv_index_set(entry, rec.key, KV_LOC_NONE, NULL);
+            continue;
+        }
+        entry->loc = KV_LOC(dest, dest_off);
+        dest_off += rec.size;
+    }
+
+    kv_page_used[victim] = 0;
+    if (victim == kv_head) {
+        kv_head = KV_HEAD_NONE;
+    }
+    if (copies != 0) {
+        kv_head = dest;
+        kv_head_off = dest_off;
+    }
+    ++kv_gc_count;
+
+    return kv_flash_erase(victim);
+}
+
+/**
+ * @brief 保证当前页有足够的空间
+ *
+ * @param size 记录大小
+ * @return KV_OK, KV_ERR_FULL或KV_ERR_FLASH
+ * @note 保留一个空白页用于垃圾回收
+ */
+static kv_status_t kv_reserve(uint32_t size) {
+    kv_status_t res;
+    uint32_t page;
+
+    /* 有效数据加上新记录超过除空白页外的容量时, 回收也无法腾出空间 */
+    if (kv_live_bytes + size >
+        (KV_PAGE_NUM - 1U) * (KV_PAGE_SIZE - KV_HEADER_SIZE)) {
+        return KV_ERR_FULL;
+    }
+
+    for (uint32_t n = 0; n <= KV_PAGE_NUM; ++n) {
+        if ((kv_head != KV_HEAD_NONE) && (kv_head_off + size <= KV_PAGE_SIZE)) {
+            return KV_OK;
+        }
+
+        if (kv_erased_count() >= 2U) {
+            page = kv_erased_next();
+            res = kv_page_open(page, 1);
+            if (res != KV_OK) {
+                return res;
+            }
+            kv_head = page;
+            kv_head_off = KV_HEADER_SIZE;
+            continue;
+        }
+
+        res = kv_gc();
+        if (res != KV_OK) {
+            return res;
+        }
+    }
+
+    return KV_ERR_FULL;
+}
+
+/**
+ * @brief 在当前页追加一条记录
+ *
+ * @param key 键
+ * @param len_field 长度字段, 删除标记为KV_LEN_DELETED
+ * @param data 数据
+ * @param[out] rec 写入的记录
+ * @param[out] loc 写入的位置
+ * @return KV_OK, KV_ERR_FULL或KV_ERR_FLASH
+ * @note 写入失败时当前页不再写入
+ */
+static kv_status_t kv_append(uint16_t key, uint16_t len_field,
+                             const void *data, kv_rec_t *rec, uint16_t *loc) {
+    uint16_t len = len_field & (uint16_t)~KV_LEN_DELETED;
+    uint32_t data_words = KV_ALIGN4(len) / sizeof(uint32_t);
+    const uint8_t *dst;
+    kv_status_t res;
+
+    rec->key = key;
+    rec->len = len;
+    rec->del = (len_field & KV_LEN_DELETED) ? 1U : 0U;
+    rec->size = KV_REC_SIZE(len);
+
+    res = kv_reserve(rec->size);
+    if (res != KV_OK) {
+        return res;
+    }
+
+    /* 数据补齐的字节保持0xFF, 不需要写入 */
+    kv_rec_buf[data_words] = 0xFFFFFFFFU;
+    kv_rec_buf[0] = key | ((uint32_t)len_field << 16);
+    if (len != 0) {
+        memcpy(&kv_rec_buf[1], data, len);
+    }
+    kv_rec_buf[1U + data_words] = crc32_word_calc(kv_rec_buf, 1U + data_words);
+    kv_rec_buf[2U + data_words] = 0xFFFF0000U | KV_COMMIT;
+
+    /* 先写入除提交标志外的内容, 最后写入提交标志 */
+    dst = kv_page_ptr(kv_head) + kv_head_off;
+    res = kv_flash_program(dst, (const uint16_t *)kv_rec_buf,
+                           (rec->size - 4U) / 2U);
+    if (res == KV_OK) {
+        res = kv_flash_program(dst + rec->size - 4U,
+                               (const uint16_t *)&kv_rec_buf[2U + data_words],
+                               1);
+    }
+    if (res != KV_OK) {
+        kv_head_off = KV_PAGE_SIZE;
+        return res;
+    }
+
+    *loc = KV_LOC(kv_head, kv_head_off);
+    kv_head_off += rec->size;
+    return KV_OK;
+}
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup 接口
+ * @{
+ */
+
+/**
+ * @brief 初始化, 扫描存储区并建立索引
+ *
+ * @return KV_OK; KV_ERR_INDEX: 索引表太小; KV_ERR_FLASH: 擦除失败
+ * @note 需要在crc32_init之后调用. 擦除掉电时没有完成的页
+ */
+kv_status_t kv_init(void) {
+    const kv_page_header_t *header;
+    kv_status_t res = KV_OK;
+
+    kv_lock();
+
+    kv_ready = 0;
+    kv_seq_max = 0;
+
+    for (uint32_t page = 0; page < KV_PAGE_NUM; ++page) {
+        header = (const kv_page_header_t *)kv_page_ptr(page);
+        kv_page_used[page] = 0;
+
+        if ((header->magic == KV_PAGE_MAGIC) &&
+            (header->state == KV_PAGE_VALID) && (header->seq != 0) &&
+            (header->seq != 0xFFFFFFFFU)) {
+            kv_page_used[page] = 1;
+            kv_page_seq[page] = header->seq;
+            if (header->seq > kv_seq_max) {
+                kv_seq_max = header->seq;
+            }
+            continue;
+        }
+
+        /* 复制没有完成, 擦除没有完成或页头损坏 */
+        if (!kv_page_blank(page) && (kv_flash_erase(page) != KV_OK)) {
+            res = KV_ERR_FLASH;
+        }
+    }
+
+    if (res == KV_OK) {
+        res = kv_index_build();
+    }
+
+    /* 回收完成但旧页还没有擦除时, 旧页中已经没有有效记录, 直接擦除 */
+    while ((res == KV_OK) && (kv_erased_count() == 0)) {
+        res = kv_gc();
+    }
+
+    kv_ready = (res == KV_OK);
+
+    kv_unlock();
+    return res;
+}
+
+/**
+ * @brief 擦除全部数据
+ *
+ * @return KV_OK或KV_ERR_FLASH
+ */
+kv_status_t kv_format(void) {
+    kv_status_t res = KV_OK;
+
+    kv_lock();
+
+    for (uint32_t page = 0; page < KV_PAGE_NUM; ++page) {
+        kv_page_used[page] = 0;
+        if (!kv_page_blank(page) && (kv_flash_erase(page) != KV_OK)) {
+            res = KV_ERR_FLASH;
+        }
+    }
+
+    memset(kv_index, 0xFF, sizeof(kv_index));
+    kv_keys = 0;
+    kv_live_bytes = 0;
+    kv_seq_max = 0;
+    kv_head = KV_HEAD_NONE;
+    kv_ready = (res == KV_OK);
+
+    kv_unlock();
+    return res;
+}
+
+/**
+ * @brief 读取键的值
+ *
+ * @param key 键
+ * @param[out] buf 缓冲区
+ * @param size 缓冲区大小, 值较长时只读取前size字节
+ * @param[out] len 值的长度, 可以为NULL
+ * @return KV_OK或KV_ERR_NOT_FOUND
+ */
+kv_status_t kv_get(uint16_t key, void *buf, uint16_t size, uint16_t *len) {
+    kv_index_entry_t *entry;
+    kv_status_t res = KV_ERR_NOT_FOUND;
+    const uint8_t *p;
+    uint16_t rec_len;
+
+    kv_lock();
+
+    entry = kv_ready ? kv_index_find(key, 0) : NULL;
+    if ((entry != NULL) && (entry->loc != KV_LOC_NONE)) {
+        p = kv_page_ptr(KV_LOC_PAGE(entry->loc)) + KV_LOC_OFF(entry->loc);
+        rec_len = *(const uint16_t *)(p + 2U);
+
+        if ((rec_len & KV_LEN_DELETED) == 0) {
+            memcpy(buf, p + 4U, (rec_len < size) ? rec_len : size);
+            if (len != NULL) {
+                *len = rec_len;
+            }
+            res = KV_OK;
+        }
+    }
+
+    kv_unlock();
+    return res;
+}
+
+/**
+ * @brief 写入键的值
+ *
+ * @param key 键, 不能为KV_KEY_INVALID
+ * @param data 值
+ * @param len 值的长度, 不超过KV_VALUE_MAX
+ * @return KV_OK, KV_ERR_PARAM, KV_ERR_FULL, KV_ERR_INDEX或KV_ERR_FLASH
+ * @note 值与已保存的相同时不写入. 可能触发垃圾回收, 最长耗时约为擦除一页
+ *       加写满一页的时间
+ */
+kv_status_t kv_set(uint16_t key, const void *data, uint16_t len) {
+    kv_index_entry_t *entry;
+    kv_status_t res;
+    kv_rec_t rec;
+    uint16_t loc;
+    const uint8_t *p;
+
+    if ((key == KV_KEY_INVALID) || (len > KV_VALUE_MAX) ||
+        ((data == NULL) && (len != 0))) {
+        return KV_ERR_PARAM;
+    }
+
+    kv_lock();
+
+    if (!kv_ready) {
+        kv_unlock();
+        return KV_ERR_PARAM;
+    }
+
+    entry = kv_index_find(key, 1);
+    if (entry == NULL) {
+        kv_unlock();
+        return KV_ERR_INDEX;
+    }
+
+    if ((entry->key == key) && (entry->loc != KV_LOC_NONE)) {
+        p = kv_page_ptr(KV_LOC_PAGE(entry->loc)) + KV_LOC_OFF(entry->loc);
+        if ((*(const uint16_t *)(p + 2U) == len) &&
+            (memcmp(p + 4U, data, len) == 0)) {
+            kv_unlock();
+            return KV_OK;
+        }
+    }
+
+    res = kv_append(key, len, data, &rec, &loc);
+    if (res == KV_OK) {
+        /* 垃圾回收可能移动了表项中的记录, 但不会移动表项 */
+        kv_index_set(entry, key, loc, &rec);
+    }
+
+    kv_unlock();
+    return res;
+}
+
+/**
+ * @brief 删除键
+ *
+ * @param key 键
+ * @return KV_OK, KV_ERR_NOT_FOUND, KV_ERR_FULL或KV_ERR_FLASH
+ */
+kv_status_t kv_delete(uint16_t key) {
+    kv_index_entry_t *entry;
+    kv_status_t res = KV_ERR_NOT_FOUND;
+    kv_rec_t rec;
+    uint16_t loc;
+    const uint8_t *p;
+
+    kv_lock();
+
+    entry = kv_ready ? kv_index_find(key, 0) : NULL;
+    if ((entry != NULL) && (entry->loc != KV_LOC_NONE)) {
+        p = kv_page_ptr(KV_LOC_PAGE(entry->loc)) + KV_LOC_OFF(entry->loc);
+        if ((*(const uint16_t *)(p + 2U) & KV_LEN_DELETED) == 0) {
+            res = kv_append(key, KV_LEN_DELETED, NULL, &rec, &loc);
+            if (res == KV_OK) {
+                kv_index_set(entry, key, loc, &rec);
+            }
+        }
+    }
+
+    kv_unlock();
+    return res;
+}
+
+/**
+ * @brief 获取统计
+ *
+ * @param[out] stats 统计
+ */
+void kv_get_stats(kv_stats_t *stats) {
+    kv_lock();
+
+    stats->keys = kv_keys;
+    stats->live_bytes = kv_live_bytes;
+    stats->free_bytes =
+        (kv_head == KV_HEAD_NONE) ? 0U : KV_PAGE_SIZE - kv_head_off;
+    stats->gc_count = kv_gc_count;
+    stats->erases = kv_erases;
+
+    kv_unlock();
+}
+
+/**
+ * @}
+ */
+
+#if (KV_BENCHMARK == 1)
+
+/**
+ * @brief 测量启动时建立索引的耗时和读取每个键的耗时
+ *
+ * @note 读取时关闭中断. 结果与键的数量和值的长度有关
+ */
+void kv_benchmark(void) {
+    static uint8_t buf[KV_VALUE_MAX];
+    kv_stats_t stats;
+    uint32_t primask;
+    uint32_t start;
+    uint32_t cycles;
+    uint32_t total = 0;
+    uint32_t max = 0;
+    uint32_t count = 0;
+    kv_status_t res;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    start = DWT->CYCCNT;
+    res = kv_init();
+    cycles = DWT->CYCCNT - start;
+    kv_get_stats(&stats);
+    printf("kv_init: %u cycles, %u keys, %u bytes, result %u \r\n",
+           (unsigned int)cycles, (unsigned int)stats.keys,
+           (unsigned int)stats.live_bytes, (unsigned int)res);
+
+    for (uint32_t i = 0; i < KV_INDEX_SIZE; ++i) {
+        if ((kv_index[i].key == KV_KEY_INVALID) ||
+            (kv_index[i].loc == KV_LOC_NONE)) {
+            continue;
+        }
+
+        primask = __get_PRIMASK();
+        __disable_irq();
+        start = DWT->CYCCNT;
+        res = kv_get(kv_index[i].key, buf, sizeof(buf), NULL);
+        cycles = DWT->CYCCNT - start;
+        __set_PRIMASK(primask);
+
+        if (res != KV_OK) {
+            continue;
+        }
+        total += cycles;
+        max = (cycles > max) ? cycles : max;
+        ++count;
+    }
+
+    printf("kv_get: avg %u cycles, max %u cycles, %u keys \r\n",
+           (unsigned int)(count ? total / count : 0), (unsigned int)max,
+           (unsigned int)count);
+}
+
+#endif /* KV_BENCHMARK == 1 */
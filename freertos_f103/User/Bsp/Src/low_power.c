@@ -0,0 +1,302 @@
+/**
+ * @file    low_power.c
+ * @author  Deadline039
+ * @brief   FreeRTOS tickless低功耗
+ * @version 1.0
+ * @date    2026-10-18
+ * @note    空闲时间较短时使用FreeRTOS移植层的vPortSuppressTicksAndSleep
+ *          进入睡眠模式(SysTick唤醒); 较长时停止SysTick进入STOP模式,
+ *          由RTC闹钟唤醒, 唤醒后按RTC计数补偿tick.
+ */
+
+#include "low_power.h"
+
+#include "FreeRTOS.h"
+#include "stm32f1xx_hal.h"
+#include "task.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+#if (configUSE_TICKLESS_IDLE == 1)
+
+extern void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime);
+
+static uint8_t lp_in_stop; /* 正在从STOP模式补偿tick */
+
+#if (LOW_POWER_STATS == 1)
+static low_power_stats_t lp_stats;
+static TickType_t lp_stats_start;
+#endif /* LOW_POWER_STATS == 1 */
+
+#if (LOW_POWER_USE_STOP == 1)
+
+static RTC_HandleTypeDef rtc_handle = {.Instance = RTC};
+
+/**
+ * @brief 初始化RTC, 以LOW_POWER_RTC_HZ计数
+ *
+ */
+static void low_power_rtc_init(void) {
+    HAL_StatusTypeDef res = HAL_OK;
+    RCC_OscInitTypeDef rcc_osc_init = {0};
+    RCC_PeriphCLKInitTypeDef rcc_periph_clk_init = {0};
+
+    __HAL_RCC_PWR_CLK_ENABLE();
+    __HAL_RCC_BKP_CLK_ENABLE();
+    HAL_PWR_EnableBkUpAccess();
+
+    rcc_osc_init.OscillatorType = RCC_OSCILLATORTYPE_LSE;
+    rcc_osc_init.LSEState = RCC_LSE_ON;
+    rcc_osc_init.PLL.PLLState = RCC_PLL_NONE;
+    res = HAL_RCC_OscConfig(&rcc_osc_init);
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+
+    rcc_periph_clk_init.PeriphClockSelection = RCC_PERIPHCLK_RTC;
+    rcc_periph_clk_init.RTCClockSelection = RCC_RTCCLKSOURCE_LSE;
+    res = HAL_RCCEx_PeriphCLKConfig(&rcc_periph_clk_init);
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+
+    __HAL_RCC_RTC_ENABLE();
+
+    rtc_handle.Init.AsynchPrediv = LSE_VALUE / LOW_POWER_RTC_HZ - 1;
+    rtc_handle.Init.OutPut = RTC_OUTPUTSOURCE_NONE;
+    res = HAL_RTC_Init(&rtc_handle);
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+    UNUSED(res);
+
+    /* RTC闹钟通过EXTI17唤醒STOP模式 */
+    __HAL_RTC_ALARM_EXTI_ENABLE_IT();
+    __HAL_RTC_ALARM_EXTI_ENABLE_RISING_EDGE();
+    __HAL_RTC_ALARM_ENABLE_IT(&rtc_handle, RTC_IT_ALRA);
+    HAL_NVIC_SetPriority(RTC_Alarm_IRQn, 15, 0);
+    HAL_NVIC_EnableIRQ(RTC_Alarm_IRQn);
+}
+
+/**
+ * @brief 读取RTC计数值
+ *
+ * @return 计数值
+ */
+static uint32_t low_power_rtc_counter(void) {
+    uint16_t high = (uint16_t)RTC->CNTH;
+    uint16_t low = (uint16_t)RTC->CNTL;
+
+    /* 读取过程中低16位溢出, 重新读取 */
+    if (high != (uint16_t)RTC->CNTH) {
+        high = (uint16_t)RTC->CNTH;
+        low = (uint16_t)RTC->CNTL;
+    }
+
+    return ((uint32_t)high << 16) | low;
+}
+
+/**
+ * @brief 设置RTC闹钟
+ *
+ * @param counter 闹钟触发时的计数值
+ */
+static void low_power_rtc_set_alarm(uint32_t counter) {
+    while ((RTC->CRL & RTC_CRL_RTOFF) == 0) {
+    }
+
+    __HAL_RTC_WRITEPROTECTION_DISABLE(&rtc_handle);
+    RTC->ALRH = counter >> 16;
+    RTC->ALRL = counter & 0xFFFFU;
+    __HAL_RTC_WRITEPROTECTION_ENABLE(&rtc_handle);
+
+    while ((RTC->CRL & RTC_CRL_RTOFF) == 0) {
+    }
+}
+
+/**
+ * @brief STOP模式唤醒后时钟为HSI, 重新切换到PLL
+ *
+ * @note PLL倍频和总线分频配置在STOP模式中保持, 只需重新打开HSE和PLL.
+ *       不调用HAL_RCC_ClockConfig, 以免HAL_InitTick改写SysTick配置
+ */
+static void low_power_restore_clock(void) {
+    __HAL_RCC_HSE_CONFIG(RCC_HSE_ON);
+    while (__HAL_RCC_GET_FLAG(RCC_FLAG_HSERDY) == RESET) {
+    }
+
+    __HAL_RCC_PLL_ENABLE();
+    while (__HAL_RCC_GET_FLAG(RCC_FLAG_PLLRDY) == RESET) {
+    }
+
+    __HAL_RCC_SYSCLK_CONFIG(RCC_SYSCLKSOURCE_PLLCLK);
+    while (__HAL_RCC_GET_SYSCLK_SOURCE() != RCC_SYSCLKSOURCE_STATUS_PLLCLK) {
+    }
+}
+
+/**
+ * @brief 停止SysTick, 进入STOP模式直到RTC闹钟或其他EXTI唤醒
+ *
+ * @param expected_idle_ticks 预计空闲时间(tick)
+ */
+static void low_power_enter_stop(TickType_t expected_idle_ticks) {
+    uint32_t systick_load;
+    uint32_t start;
+    uint32_t elapsed;
+
+    /* 关中断但WFI仍可被挂起的中断唤醒, 唤醒源的中断在补偿tick后再执行 */
+    __disable_irq();
+    __DSB();
+    __ISB();
+
+    if (eTaskConfirmSleepModeStatus() == eAbortSleep) {
+        __enable_irq();
+        return;
+    }
+
+    systick_load = SysTick->LOAD;
+    SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+
+    start = low_power_rtc_counter();
+    __HAL_RTC_ALARM_CLEAR_FLAG(&rtc_handle, RTC_FLAG_ALRAF);
+    __HAL_RTC_ALARM_EXTI_CLEAR_FLAG();
+    HAL_NVIC_ClearPendingIRQ(RTC_Alarm_IRQn);
+    low_power_rtc_set_alarm(
+        start + (uint32_t)((uint64_t)(expected_idle_ticks -
+                                      LOW_POWER_WAKEUP_TICKS) *
+                           LOW_POWER_RTC_HZ / configTICK_RATE_HZ));
+
+    HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+
+    low_power_restore_clock();
+    HAL_RTC_WaitForSynchro(&rtc_handle);
+
+    elapsed = (uint32_t)((uint64_t)(low_power_rtc_counter() - start) *
+                         configTICK_RATE_HZ / LOW_POWER_RTC_HZ);
+    if (elapsed > expected_idle_ticks - 1) {
+        elapsed = expected_idle_ticks - 1;
+    }
+
+    /* 从一个完整的tick周期重新开始计数 */
+    SysTick->LOAD = systick_load;
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+
+    lp_in_stop = 1;
+    vTaskStepTick(elapsed);
+    lp_in_stop = 0;
+
+    __enable_irq();
+}
+
+/**
+ * @brief RTC闹钟中断服务函数
+ */
+void RTC_Alarm_IRQHandler(void) {
+    HAL_RTC_AlarmIRQHandler(&rtc_handle);
+}
+
+#endif /* LOW_POWER_USE_STOP == 1 */
+
+/**
+ * @brief 空闲时停止tick并进入低功耗, 由portSUPPRESS_TICKS_AND_SLEEP调用
+ *
+ * @param expected_idle_ticks 预计空闲时间(tick)
+ */
+void low_power_suppress_ticks_and_sleep(uint32_t expected_idle_ticks) {
+#if (LOW_POWER_USE_STOP == 1)
+    if (expected_idle_ticks >= LOW_POWER_STOP_MIN_TICKS) {
+        low_power_enter_stop(expected_idle_ticks);
+        return;
+    }
+#endif /* LOW_POWER_USE_STOP == 1 */
+
+    vPortSuppressTicksAndSleep(expected_idle_ticks);
+}
+
+/**
+ * @brief 补偿低功耗期间的tick, 由traceINCREASE_TICK_COUNT调用
+ *
+ * @param ticks 补偿的tick数
+ * @note HAL库的tick同样由SysTick中断累加, 需要一起补偿
+ */
+void low_power_step_tick(uint32_t ticks) {
+    uwTick += ticks * (1000U / configTICK_RATE_HZ);
+
+#if (LOW_POWER_STATS == 1)
+    if (lp_in_stop) {
+        lp_stats.stop_ticks += ticks;
+        ++lp_stats.stop_count;
+    } else {
+        lp_stats.sleep_ticks += ticks;
+        ++lp_stats.sleep_count;
+    }
+#endif /* LOW_POWER_STATS == 1 */
+}
+
+#if (LOW_POWER_STATS == 1)
+
+/**
+ * @brief 获取低功耗统计
+ *
+ * @param[out] stats 统计结果
+ */
+void low_power_get_stats(low_power_stats_t *stats) {
+    taskENTER_CRITICAL();
+    *stats = lp_stats;
+    stats->total_ticks = xTaskGetTickCount() - lp_stats_start;
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief 清空低功耗统计
+ *
+ */
+void low_power_reset_stats(void) {
+    taskENTER_CRITICAL();
+    lp_stats = (low_power_stats_t){0};
+    lp_stats_start = xTaskGetTickCount();
+    taskEXIT_CRITICAL();
+}
+
+/**
+ * @brief 打印睡眠与唤醒时间
+ *
+ */
+void low_power_print_stats(void) {
+    low_power_stats_t stats;
+    uint32_t awake;
+
+    low_power_get_stats(&stats);
+    awake = stats.total_ticks - stats.sleep_ticks - stats.stop_ticks;
+
+    printf("Total: %u ticks, awake: %u (%u%%), sleep: %u (%u times), "
+           "stop: %u (%u times). \r\n",
+           (unsigned int)stats.total_ticks, (unsigned int)awake,
+           (unsigned int)(stats.total_ticks
+                              ? (uint64_t)awake * 100 / stats.total_ticks
+                              : 0),
+           (unsigned int)stats.sleep_ticks, (unsigned int)stats.sleep_count,
+           (unsigned int)stats.stop_ticks, (unsigned int)stats.stop_count);
+}
+
+#endif /* LOW_POWER_STATS == 1 */
+
+#endif /* configUSE_TICKLESS_IDLE == 1 */
+
+/**
+ * @brief 初始化低功耗相关外设
+ *
+ */
+void low_power_init(void) {
+#ifdef DEBUG
+    /* 调试时保持调试器连接 */
+    HAL_DBGMCU_EnableDBGSleepMode();
+    HAL_DBGMCU_EnableDBGStopMode();
+#endif /* DEBUG */
+
+#if ((configUSE_TICKLESS_IDLE == 1) && (LOW_POWER_USE_STOP == 1))
+    low_power_rtc_init();
+#endif /* configUSE_TICKLESS_IDLE == 1 && LOW_POWER_USE_STOP == 1 */
+}
@@ -10,9 +10,17 @@
 
 #include <string.h>
 
+#define rf_acquire() RING_FIFO_ACQUIRE()
+#define rf_release() RING_FIFO_RELEASE()
+
 #define min(a, b)      ((a) > (b) ? (b) : (a))
 #define fifo_max_depth (0xffffffff >> 1)
 
+/* 帧长字段大小 */
+#define frame_hdr_size sizeof(uint32_t)
+/* 帧数据按帧长字段对齐, 保证帧长字段始终对齐且不会回绕 */
+#define frame_align(x) (((x) + frame_hdr_size - 1) & ~(frame_hdr_size - 1))
+
 static inline uint32_t is_pow_of_2(uint32_t n) {
     return (0 != n) && (0 == (n & (n - 1)));
 }
@@ -37,6 +45,17 @@ ring_fifo_t *ring_fifo_init(void *buf, uint32_t size,
         return NULL;
     }
 
+    if (RF_TYPE_FRAME == type) {
+        /* 帧长字段需要对齐访问 */
+        if ((NULL != buf) && ((0 != ((uintptr_t)buf & (frame_hdr_size - 1))) ||
+                              (size < frame_hdr_size))) {
+            return NULL;
+        }
+        if (size < frame_hdr_size) {
+            size = frame_hdr_size;
+        }
+    }
+
     ring = malloc(sizeof(ring_fifo_t));
     if (NULL == ring) {
         return NULL;
@@ -61,6 +80,31 @@ ring_fifo_t *ring_fifo_init(void *buf, uint32_t size,
         ring->is_dynamic = 0;
     }
 
+    ring->is_static = 0;
+    ring->head = ring->tail = 0;
+    ring->size = size;
+    ring->mask = size - 1;
+    ring->type = type;
+
+    return ring;
+}
+
+ring_fifo_t *ring_fifo_init_static(ring_fifo_t *ring, void *buf, uint32_t size,
+                                   enum ring_fifo_type type) {
+    if ((NULL == ring) || (NULL == buf) || (0 == is_pow_of_2(size)) ||
+        (size > fifo_max_depth)) {
+        return NULL;
+    }
+
+    if ((RF_TYPE_FRAME == type) &&
+        ((0 != ((uintptr_t)buf & (frame_hdr_size - 1))) ||
+         (size < frame_hdr_size))) {
+        return NULL;
+    }
+
+    ring->buf = buf;
+    ring->is_dynamic = 0;
+    ring->is_static = 1;
     ring->head = ring->tail = 0;
     ring->size = size;
     ring->mask = size - 1;
@@ -75,104 +119,213 @@ void ring_fifo_destroy(ring_fifo_t *ring) {
         ring->buf = NULL;
     }
 
-    free(ring);
+    if (0 == ring->is_static) {
+        free(ring);
+    }
 }
 
-uint32_t ring_fifo_write(ring_fifo_t *ring, const void *buf, uint32_t len) {
+/**
+ * @brief    将从ptr开始长度为len的区域拆分为两段连续内存
+ * @param[in]    ring    环形缓冲区句柄
+ * @param[in]    ptr     起始位置
+ * @param[in]    len     长度(byte)
+ * @param[out]   span    连续内存
+ */
+static inline void make_span(ring_fifo_t *ring, uint32_t ptr, uint32_t len,
+                             ring_fifo_span_t span[2]) {
+    uint32_t off = ptr & ring->mask;
+    uint32_t l = min(len, ring->size - off);
+
+    span[0].buf = (uint8_t *)ring->buf + off;
+    span[0].len = l;
+    span[1].buf = ring->buf;
+    span[1].len = len - l;
+}
+
+/**
+ * @brief    读取ptr位置的帧长
+ * @param[in]    ring    环形缓冲区句柄
+ * @param[in]    ptr     帧起始位置
+ * @retval   帧长(byte)
+ */
+static inline uint32_t frame_len(ring_fifo_t *ring, uint32_t ptr) {
+    return *(uint32_t *)((uint8_t *)ring->buf + (ptr & ring->mask));
+}
+
+uint32_t ring_fifo_write_reserve(ring_fifo_t *ring, uint32_t len,
+                                 ring_fifo_span_t span[2]) {
     uint32_t wlen;
+    uint32_t head, tail;
     uint32_t unused;
-    uint32_t off, l;
-    uint32_t frame_off, skip;
+    uint32_t frame_off;
+
+    head = ring->head;
+    rf_acquire();
+    tail = ring->tail;
 
-    unused = ring->size - (ring->tail - ring->head);
+    unused = ring->size - (tail - head);
     switch (ring->type) {
         case RF_TYPE_FRAME:
-            frame_off = sizeof(uint32_t);
-            skip = 0;
-            if (ring->size - (ring->tail & ring->mask) < frame_off) {
-                skip = ring->size - (ring->tail & ring->mask);
-                /* 跳过尾部[1, frame_off - 1]字节 */
-                frame_off += skip;
-            }
+            frame_off = frame_hdr_size;
             /* 如果不能存下此帧，丢弃 */
-            if (len + frame_off > unused) {
-                return 0;
-            }
-            wlen = len;
-            if (0 == wlen) {
-                return 0;
+            if (frame_align(len) + frame_off > unused) {
+                wlen = 0;
+            } else {
+                wlen = len;
             }
-            /* 写入帧长 */
-            *(uint32_t *)(ring->buf + ((ring->tail + skip) & ring->mask)) =
-                wlen;
             break;
         default: /* RF_TYPE_STREAM */
             frame_off = 0;
             wlen = min(len, unused);
-            if (0 == wlen) {
-                return 0;
-            }
             break;
     }
 
-    /* 计算写入位置 */
-    off = (ring->tail + frame_off) & ring->mask;
-    l = min(wlen, ring->size - off);
-    memcpy((uint8_t *)ring->buf + off, buf, l);
-    memcpy(ring->buf, (uint8_t *)buf + l, wlen - l);
-
-    ring->tail += wlen + frame_off;
+    make_span(ring, tail + frame_off, wlen, span);
 
     return wlen;
 }
 
-uint32_t ring_fifo_read(ring_fifo_t *ring, void *buf, uint32_t len) {
-    uint32_t rlen;
-    uint32_t used;
-    uint32_t off, l;
-    uint32_t frame_off, skip;
+uint32_t ring_fifo_write_commit(ring_fifo_t *ring, uint32_t len) {
+    uint32_t head, tail;
+    uint32_t unused;
+    uint32_t step;
+
+    if (0 == len) {
+        return 0;
+    }
 
-    used = ring->tail - ring->head;
+    head = ring->head;
+    rf_acquire();
+    tail = ring->tail;
+
+    unused = ring->size - (tail - head);
     switch (ring->type) {
         case RF_TYPE_FRAME:
-            frame_off = sizeof(uint32_t);
-            skip = 0;
-            if (ring->size - (ring->head & ring->mask) < frame_off) {
-                skip = ring->size - (ring->head & ring->mask);
-                /* 跳过尾部[1, frame_off - 1]字节 */
-                frame_off += skip;
-            }
-            if (0 == used) {
+            step = frame_hdr_size + frame_align(len);
+            if (step > unused) {
                 return 0;
             }
+            /* 写入帧长 */
+            *(uint32_t *)((uint8_t *)ring->buf + (tail & ring->mask)) = len;
+            break;
+        default: /* RF_TYPE_STREAM */
+            len = min(len, unused);
+            step = len;
+            break;
+    }
+
+    /* 数据和帧长写入完成后再更新生产者指针 */
+    rf_release();
+    ring->tail = tail + step;
+
+    return len;
+}
+
+uint32_t ring_fifo_read_peek(ring_fifo_t *ring, ring_fifo_span_t span[2]) {
+    uint32_t rlen;
+    uint32_t head, tail;
+    uint32_t frame_off;
+
+    tail = ring->tail;
+    rf_acquire();
+    head = ring->head;
+
+    if (tail == head) {
+        make_span(ring, head, 0, span);
+        return 0;
+    }
+
+    switch (ring->type) {
+        case RF_TYPE_FRAME:
+            frame_off = frame_hdr_size;
             /* 读取帧长 */
-            rlen =
-                *(uint32_t *)(ring->buf + ((ring->head + skip) & ring->mask));
-            /* 给定的缓冲区小于要读出的帧长 */
-            if (len < rlen) {
-                return 0;
-            }
+            rlen = frame_len(ring, head);
             break;
         default: /* RF_TYPE_STREAM */
             frame_off = 0;
-            rlen = min(len, used);
-            if (0 == rlen) {
-                return 0;
-            }
+            rlen = tail - head;
             break;
     }
 
-    /* 计算读取位置 */
-    off = (ring->head + frame_off) & ring->mask;
-    l = min(rlen, ring->size - off);
-    memcpy(buf, (uint8_t *)ring->buf + off, l);
-    memcpy((uint8_t *)buf + l, ring->buf, rlen - l);
-
-    ring->head += rlen + frame_off;
+    make_span(ring, head + frame_off, rlen, span);
 
     return rlen;
 }
 
+uint32_t ring_fifo_read_commit(ring_fifo_t *ring, uint32_t len) {
+    uint32_t head, tail;
+    uint32_t used;
+    uint32_t step;
+
+    tail = ring->tail;
+    rf_acquire();
+    head = ring->head;
+
+    used = tail - head;
+    if (0 == used) {
+        return 0;
+    }
+
+    switch (ring->type) {
+        case RF_TYPE_FRAME:
+            /* 整帧出队 */
+            len = frame_len(ring, head);
+            step = frame_hdr_size + frame_align(len);
+            break;
+        default: /* RF_TYPE_STREAM */
+            len = min(len, used);
+            step = len;
+            break;
+    }
+
+    /* 数据读取完成后再更新消费者指针 */
+    rf_release();
+    ring->head = head + step;
+
+    return len;
+}
+
+uint32_t ring_fifo_write(ring_fifo_t *ring, const void *buf, uint32_t len) {
+    uint32_t wlen;
+    ring_fifo_span_t span[2];
+
+    wlen = ring_fifo_write_reserve(ring, len, span);
+    if (0 == wlen) {
+        return 0;
+    }
+
+    memcpy(span[0].buf, buf, span[0].len);
+    memcpy(span[1].buf, (const uint8_t *)buf + span[0].len, span[1].len);
+
+    return ring_fifo_write_commit(ring, wlen);
+}
+
+uint32_t ring_fifo_read(ring_fifo_t *ring, void *buf, uint32_t len) {
+    uint32_t rlen;
+    uint32_t l;
+    ring_fifo_span_t span[2];
+
+    rlen = ring_fifo_read_peek(ring, span);
+    if (0 == rlen) {
+        return 0;
+    }
+
+    if (RF_TYPE_FRAME == ring->type) {
+        /* 给定的缓冲区小于要读出的帧长 */
+        if (len < rlen) {
+            return 0;
+        }
+    } else {
+        rlen = min(rlen, len);
+    }
+
+    l = min(rlen, span[0].len);
+    memcpy(buf, span[0].buf, l);
+    memcpy((uint8_t *)buf + l, span[1].buf, rlen - l);
+
+    return ring_fifo_read_commit(ring, rlen);
+}
+
 uint32_t ring_fifo_is_full(ring_fifo_t *ring) {
     return ring->size == (ring->tail - ring->head);
 }
@@ -0,0 +1,314 @@
+/**
+ * @file    run_time_stats.c
+ * @author  Deadline039
+ * @brief   FreeRTOS运行时间统计
+ * @version 1.0
+ * @date    2026-10-18
+ */
+
+#include "run_time_stats.h"
+
+#include "FreeRTOS.h"
+#include "stm32f1xx_hal.h"
+#include "task.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+#if (configGENERATE_RUN_TIME_STATS == 1)
+
+static TIM_HandleTypeDef rts_tim_low_handle = {.Instance =
+                                                   RUN_TIME_STATS_TIM_LOW};
+static TIM_HandleTypeDef rts_tim_high_handle = {.Instance =
+                                                    RUN_TIME_STATS_TIM_HIGH};
+
+#if (RUN_TIME_STATS_ISR == 1)
+
+/* 系统异常16个 + 外部中断 */
+#define RTS_VECTOR_NUM   (16 + DMA2_Channel4_5_IRQn + 1)
+/* 第一个被统计的向量(SysTick), 之前的异常(含SVC, PendSV)不统计 */
+#define RTS_VECTOR_FIRST 15
+/* 最大中断嵌套层数 */
+#define RTS_NEST_MAX     16
+
+typedef void (*rts_handler_t)(void);
+
+/* VTOR要求按向量表大小向上取2的幂次方对齐 */
+static uint32_t rts_vectors[RTS_VECTOR_NUM] __attribute__((aligned(512)));
+static rts_handler_t rts_handlers[RTS_VECTOR_NUM];
+
+static uint32_t rts_isr_cycles[RTS_VECTOR_NUM];
+static uint32_t rts_isr_count[RTS_VECTOR_NUM];
+static uint8_t rts_isr_stack[RTS_NEST_MAX];
+static uint32_t rts_isr_depth;
+static uint32_t rts_isr_segment_start;
+
+/**
+ * @brief 所有被统计中断的入口, 统计时间后调用原中断服务函数
+ *
+ */
+static void rts_isr_entry(void) {
+    uint32_t vector = __get_IPSR();
+    uint32_t primask = __get_PRIMASK();
+    uint32_t now;
+
+    __disable_irq();
+    now = DWT->CYCCNT;
+    if (rts_isr_depth != 0) {
+        /* 被打断的中断先结算 */
+        rts_isr_cycles[rts_isr_stack[rts_isr_depth - 1]] +=
+            now - rts_isr_segment_start;
+    }
+    rts_isr_stack[rts_isr_depth++] = (uint8_t)vector;
+    rts_isr_segment_start = now;
+    __set_PRIMASK(primask);
+
+    rts_handlers[vector]();
+
+    __disable_irq();
+    now = DWT->CYCCNT;
+    rts_isr_cycles[vector] += now - rts_isr_segment_start;
+    ++rts_isr_count[vector];
+    --rts_isr_depth;
+    rts_isr_segment_start = now;
+    __set_PRIMASK(primask);
+}
+
+/**
+ * @brief 启用DWT周期计数器, 将向量表复制到RAM并替换中断入口
+ *
+ */
+static void rts_isr_init(void) {
+    const uint32_t *vectors = (const uint32_t *)SCB->VTOR;
+
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    for (uint32_t i = 0; i < RTS_VECTOR_NUM; ++i) {
+        rts_vectors[i] = vectors[i];
+        rts_handlers[i] = (rts_handler_t)vectors[i];
+        if (i >= RTS_VECTOR_FIRST) {
+            rts_vectors[i] = (uint32_t)rts_isr_entry;
+        }
+    }
+
+    __DSB();
+    SCB->VTOR = (uint32_t)rts_vectors;
+    __DSB();
+    __ISB();
+}
+
+#endif /* RUN_TIME_STATS_ISR == 1 */
+
+/**
+ * @brief 初始化运行时间计数器, 由portCONFIGURE_TIMER_FOR_RUN_TIME_STATS调用
+ *
+ * @note TIM2每个计数周期溢出时产生TRGO, TIM3以其为外部时钟计数,
+ *       组成32位计数器, 不需要中断
+ */
+void run_time_stats_timer_init(void) {
+    HAL_StatusTypeDef res = HAL_OK;
+    TIM_MasterConfigTypeDef master_config = {0};
+    TIM_SlaveConfigTypeDef slave_config = {0};
+    uint32_t tim_clk = HAL_RCC_GetPCLK1Freq();
+
+    /* APB1分频不为1时定时器时钟为PCLK1的2倍 */
+    if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_HCLK_DIV1) {
+        tim_clk *= 2;
+    }
+
+    RUN_TIME_STATS_CLK_ENABLE();
+
+    rts_tim_low_handle.Init.Prescaler = tim_clk / RUN_TIME_STATS_HZ - 1;
+    rts_tim_low_handle.Init.CounterMode = TIM_COUNTERMODE_UP;
+    rts_tim_low_handle.Init.Period = 0xFFFF;
+    rts_tim_low_handle.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    res = HAL_TIM_Base_Init(&rts_tim_low_handle);
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+
+    master_config.MasterOutputTrigger = TIM_TRGO_UPDATE;
+    master_config.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+    HAL_TIMEx_MasterConfigSynchronization(&rts_tim_low_handle, &master_config);
+
+    rts_tim_high_handle.Init.Prescaler = 0;
+    rts_tim_high_handle.Init.CounterMode = TIM_COUNTERMODE_UP;
+    rts_tim_high_handle.Init.Period = 0xFFFF;
+    rts_tim_high_handle.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+    res = HAL_TIM_Base_Init(&rts_tim_high_handle);
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+    UNUSED(res);
+
+    slave_config.SlaveMode = TIM_SLAVEMODE_EXTERNAL1;
+    slave_config.InputTrigger = RUN_TIME_STATS_TIM_ITR;
+    HAL_TIM_SlaveConfigSynchro(&rts_tim_high_handle, &slave_config);
+
+    HAL_TIM_Base_Start(&rts_tim_high_handle);
+    HAL_TIM_Base_Start(&rts_tim_low_handle);
+
+#if (RUN_TIME_STATS_ISR == 1)
+    rts_isr_init();
+#endif /* RUN_TIME_STATS_ISR == 1 */
+}
+
+/**
+ * @brief 获取运行时间计数值, 由portGET_RUN_TIME_COUNTER_VALUE调用
+ *
+ * @return 计数值
+ */
+uint32_t run_time_stats_counter(void) {
+    uint32_t high = RUN_TIME_STATS_TIM_HIGH->CNT;
+    uint32_t low = RUN_TIME_STATS_TIM_LOW->CNT;
+
+    /* 读取过程中低16位溢出, 重新读取 */
+    if (high != RUN_TIME_STATS_TIM_HIGH->CNT) {
+        high = RUN_TIME_STATS_TIM_HIGH->CNT;
+        low = RUN_TIME_STATS_TIM_LOW->CNT;
+    }
+
+    return (high << 16) | low;
+}
+
+/**
+ * @brief 计算千分比
+ *
+ * @param part 部分
+ * @param total 总数
+ * @return 千分比
+ */
+static uint32_t rts_permille(uint64_t part, uint64_t total) {
+    return total ? (uint32_t)(part * 1000 / total) : 0;
+}
+
+/**
+ * @brief 打印上次报告以来每个任务和中断的CPU占用
+ *
+ * @note 任务的运行时间包含其间执行的中断时间
+ */
+void run_time_stats_report(void) {
+    static TaskStatus_t task_status[RUN_TIME_STATS_MAX_TASKS];
+    static UBaseType_t last_number[RUN_TIME_STATS_MAX_TASKS];
+    static configRUN_TIME_COUNTER_TYPE last_run_time[RUN_TIME_STATS_MAX_TASKS];
+    static UBaseType_t last_task_num;
+    static configRUN_TIME_COUNTER_TYPE last_total;
+
+    configRUN_TIME_COUNTER_TYPE total;
+    configRUN_TIME_COUNTER_TYPE elapsed;
+    UBaseType_t task_num;
+
+    task_num = uxTaskGetSystemState(task_status, RUN_TIME_STATS_MAX_TASKS,
+                                    &total);
+    elapsed = total - last_total;
+    last_total = total;
+
+    printf("Task             Load\r\n");
+    for (UBaseType_t i = 0; i < task_num; ++i) {
+        configRUN_TIME_COUNTER_TYPE run_time = task_status[i].ulRunTimeCounter;
+
+        /* 按任务编号找到上次的运行时间, 新任务从0开始 */
+        for (UBaseType_t j = 0; j < last_task_num; ++j) {
+            if (last_number[j] == task_status[i].xTaskNumber) {
+                run_time -= last_run_time[j];
+                break;
+            }
+        }
+
+        uint32_t load = rts_permille(run_time, elapsed);
+        printf("%-16s %3u.%u%%\r\n", task_status[i].pcTaskName,
+               (unsigned int)(load / 10), (unsigned int)(load % 10));
+    }
+
+    for (UBaseType_t i = 0; i < task_num; ++i) {
+        last_number[i] = task_status[i].xTaskNumber;
+        last_run_time[i] = task_status[i].ulRunTimeCounter;
+    }
+    last_task_num = task_num;
+
+#if (RUN_TIME_STATS_ISR == 1)
+    uint64_t elapsed_cycles =
+        (uint64_t)elapsed * (SystemCoreClock / RUN_TIME_STATS_HZ);
+
+    printf("ISR              Count      Load\r\n");
+    for (uint32_t i = RTS_VECTOR_FIRST; i < RTS_VECTOR_NUM; ++i) {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        uint32_t cycles = rts_isr_cycles[i];
+        uint32_t count = rts_isr_count[i];
+        rts_isr_cycles[i] = 0;
+        rts_isr_count[i] = 0;
+        __set_PRIMASK(primask);
+
+        if (count == 0) {
+            continue;
+        }
+
+        uint32_t load = rts_permille(cycles, elapsed_cycles);
+        if (i == RTS_VECTOR_FIRST) {
+            printf("SysTick          ");
+        } else {
+            printf("IRQ%-3u           ", (unsigned int)(i - 16));
+        }
+        printf("%-10u %3u.%u%%\r\n", (unsigned int)count,
+               (unsigned int)(load / 10), (unsigned int)(load % 10));
+    }
+#endif /* RUN_TIME_STATS_ISR == 1 */
+}
+
+#if (RUN_TIME_STATS_REPORT_MS > 0)
+
+#define RTS_TASK_STACK_SIZE 256
+
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+static StaticTask_t rts_task_tcb;
+static StackType_t rts_task_stack[RTS_TASK_STACK_SIZE];
+#endif /* configSUPPORT_STATIC_ALLOCATION == 1 */
+
+/**
+ * @brief 负载报告任务
+ *
+ * @param pvParameters 传入参数(未用到)
+ */
+static void run_time_stats_task(void *pvParameters) {
+    UNUSED(pvParameters);
+
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (1) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(RUN_TIME_STATS_REPORT_MS));
+        run_time_stats_report();
+    }
+}
+
+#endif /* RUN_TIME_STATS_REPORT_MS > 0 */
+
+/**
+ * @brief 创建周期性负载报告任务
+ *
+ */
+void run_time_stats_reporter_start(void) {
+#if (RUN_TIME_STATS_REPORT_MS > 0)
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+    TaskHandle_t handle =
+        xTaskCreateStatic(run_time_stats_task, "rts_report",
+                          RTS_TASK_STACK_SIZE, NULL, 1, rts_task_stack,
+                          &rts_task_tcb);
+#ifdef DEBUG
+    assert(handle != NULL);
+#endif /* DEBUG */
+    UNUSED(handle);
+#else  /* configSUPPORT_STATIC_ALLOCATION == 1 */
+    BaseType_t res = xTaskCreate(run_time_stats_task, "rts_report",
+                                 RTS_TASK_STACK_SIZE, NULL, 1, NULL);
+#ifdef DEBUG
+    assert(res == pdPASS);
+#endif /* DEBUG */
+    UNUSED(res);
+#endif /* configSUPPORT_STATIC_ALLOCATION == 1 */
+#endif /* RUN_TIME_STATS_REPORT_MS > 0 */
+}
+
+#endif /* configGENERATE_RUN_TIME_STATS == 1 */
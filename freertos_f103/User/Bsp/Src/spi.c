@@ -0,0 +1,735 @@
+/**
+ * @file    spi.c
+ * @author  Deadline039
+ * @brief   SPI DMA传输队列
+ * @version 1.0
+ * @date    2026-10-18
+ * @note    DMA和SPI直接操作寄存器. 接收通道传输完成时最后一个字节已经收完,
+ *          总线空闲, 在该中断中切换片选并启动下一段或下一次传输.
+ */
+
+#include "spi.h"
+#include "ring_fifo.h"
+#include "uart.h"
+
+#include <assert.h>
+
+#if (SPI_USE_FREERTOS == 1)
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* DMA中断中会通知等待传输的任务, 需要允许调用FreeRTOS API */
+#define SPI_RTOS_PRIO_OK(preempt)                                              \
+    ((preempt) >= configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY)
+#else /* SPI_USE_FREERTOS == 1 */
+#define SPI_RTOS_PRIO_OK(preempt) 1
+#endif /* SPI_USE_FREERTOS == 1 */
+
+#if !RING_FIFO_IS_POW2(SPI_QUEUE_SIZE)
+#error "SPI_QUEUE_SIZE必须为2的幂次方"
+#endif /* SPI_QUEUE_SIZE */
+
+#if ((SPI1_ENABLE == 1) && (USART3_ENABLE == 1) &&                             \
+     ((USART3_USE_DMA_TX == 1) || (USART3_USE_DMA_RX == 1)))
+#error "SPI1与串口3使用相同的DMA通道"
+#endif /* SPI1_ENABLE == 1 */
+
+#if ((SPI2_ENABLE == 1) && (USART1_ENABLE == 1) &&                             \
+     ((USART1_USE_DMA_TX == 1) || (USART1_USE_DMA_RX == 1)))
+#error "SPI2与串口1使用相同的DMA通道"
+#endif /* SPI2_ENABLE == 1 */
+
+/**
+ * @brief SPI总线
+ */
+typedef struct {
+    SPI_TypeDef *spi;           /*!< SPI外设 */
+    DMA_HandleTypeDef *hdma_rx; /*!< 接收DMA句柄 */
+    DMA_HandleTypeDef *hdma_tx; /*!< 发送DMA句柄 */
+    IRQn_Type rx_irqn;          /*!< 接收DMA中断号 */
+    IRQn_Type tx_irqn;          /*!< 发送DMA中断号 */
+    uint8_t it_preempt;         /*!< DMA中断抢占优先级 */
+    uint8_t it_sub;             /*!< DMA中断子优先级 */
+
+    spi_xfer_t *queue[SPI_QUEUE_SIZE]; /*!< 等待的传输, 取消后置为NULL */
+    uint32_t queue_in;                 /*!< 入队计数 */
+    uint32_t queue_out;                /*!< 出队计数 */
+
+    spi_xfer_t *active;  /*!< 正在进行的传输(第一段), NULL时总线空闲 */
+    spi_xfer_t *segment; /*!< 正在传输的段 */
+    uint16_t cr1;        /*!< 当前SPI_CR1设置, 为0时总线未初始化 */
+    uint8_t rx_dummy;    /*!< 不需要接收时的接收目标 */
+} spi_bus_t;
+
+/* 不需要发送数据时发送0xFF */
+static const uint8_t spi_tx_dummy = 0xFFU;
+
+static void spi_dma_irq_handler(spi_bus_t *bus);
+
+#if (SPI1_ENABLE == 1)
+
+static DMA_HandleTypeDef spi1_dmarx_handle = {
+    .Instance = DMA1_Channel2,
+    .Init.Direction = DMA_PERIPH_TO_MEMORY,
+    .Init.MemDataAlignment = DMA_MDATAALIGN_BYTE,
+    .Init.MemInc = DMA_MINC_ENABLE,
+    .Init.Mode = DMA_NORMAL,
+    .Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE,
+    .Init.PeriphInc = DMA_PINC_DISABLE,
+    .Init.Priority = SPI1_DMA_PRIORITY};
+static DMA_HandleTypeDef spi1_dmatx_handle = {
+    .Instance = DMA1_Channel3,
+    .Init.Direction = DMA_MEMORY_TO_PERIPH,
+    .Init.MemDataAlignment = DMA_MDATAALIGN_BYTE,
+    .Init.MemInc = DMA_MINC_ENABLE,
+    .Init.Mode = DMA_NORMAL,
+    .Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE,
+    .Init.PeriphInc = DMA_PINC_DISABLE,
+    .Init.Priority = SPI1_DMA_PRIORITY};
+static spi_bus_t spi1_bus = {
+    .spi = SPI1,
+    .hdma_rx = &spi1_dmarx_handle,
+    .hdma_tx = &spi1_dmatx_handle,
+    .rx_irqn = DMA1_Channel2_IRQn,
+    .tx_irqn = DMA1_Channel3_IRQn,
+    .it_preempt = SPI1_DMA_IT_PREEMPT,
+    .it_sub = SPI1_DMA_IT_SUB,
+};
+
+#if !SPI_RTOS_PRIO_OK(SPI1_DMA_IT_PREEMPT)
+#error "SPI1 DMA中断优先级高于configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY"
+#endif /* SPI_RTOS_PRIO_OK */
+
+/**
+ * @brief SPI1接收DMA中断句柄
+ *
+ */
+void DMA1_Channel2_IRQHandler(void) {
+    spi_dma_irq_handler(&spi1_bus);
+}
+
+/**
+ * @brief SPI1发送DMA中断句柄
+ *
+ */
+void DMA1_Channel3_IRQHandler(void) {
+    spi_dma_irq_handler(&spi1_bus);
+}
+
+#endif /* SPI1_ENABLE == 1 */
+
+#if (SPI2_ENABLE == 1)
+
+static DMA_HandleTypeDef spi2_dmarx_handle = {
+    .Instance = DMA1_Channel4,
+    .Init.Direction = DMA_PERIPH_TO_MEMORY,
+    .Init.MemDataAlignment = DMA_MDATAALIGN_BYTE,
+    .Init.MemInc = DMA_MINC_ENABLE,
+    .Init.Mode = DMA_NORMAL,
+    .Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE,
+    .Init.PeriphInc = DMA_PINC_DISABLE,
+    .Init.Priority = SPI2_DMA_PRIORITY};
+static DMA_HandleTypeDef spi2_dmatx_handle = {
+    .Instance = DMA1_Channel5,
+    .Init.Direction = DMA_MEMORY_TO_PERIPH,
+    .Init.MemDataAlignment = DMA_MDATAALIGN_BYTE,
+    .Init.MemInc = DMA_MINC_ENABLE,
+    .Init.Mode = DMA_NORMAL,
+    .Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE,
+    .Init.PeriphInc = DMA_PINC_DISABLE,
+    .Init.Priority = SPI2_DMA_PRIORITY};
+static spi_bus_t spi2_bus = {
+    .spi = SPI2,
+    .hdma_rx = &spi2_dmarx_handle,
+    .hdma_tx = &spi2_dmatx_handle,
+    .rx_irqn = DMA1_Channel4_IRQn,
+    .tx_irqn = DMA1_Channel5_IRQn,
+    .it_preempt = SPI2_DMA_IT_PREEMPT,
+    .it_sub = SPI2_DMA_IT_SUB,
+};
+
+#if !SPI_RTOS_PRIO_OK(SPI2_DMA_IT_PREEMPT)
+#error "SPI2 DMA中断优先级高于configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY"
+#endif /* SPI_RTOS_PRIO_OK */
+
+/**
+ * @brief SPI2接收DMA中断句柄
+ *
+ */
+void DMA1_Channel4_IRQHandler(void) {
+    spi_dma_irq_handler(&spi2_bus);
+}
+
+/**
+ * @brief SPI2发送DMA中断句柄
+ *
+ */
+void DMA1_Channel5_IRQHandler(void) {
+    spi_dma_irq_handler(&spi2_bus);
+}
+
+#endif /* SPI2_ENABLE == 1 */
+
+/**
+ * @brief 根据SPI外设找到总线
+ *
+ * @param spi SPI外设
+ * @return 总线, 未启用时返回NULL
+ */
+static spi_bus_t *spi_bus_identify(SPI_TypeDef *spi) {
+#if (SPI1_ENABLE == 1)
+    if (spi == SPI1) {
+        return &spi1_bus;
+    }
+#endif /* SPI1_ENABLE == 1 */
+
+#if (SPI2_ENABLE == 1)
+    if (spi == SPI2) {
+        return &spi2_bus;
+    }
+#endif /* SPI2_ENABLE == 1 */
+
+    UNUSED(spi);
+    return NULL;
+}
+
+/*****************************************************************************
+ * @defgroup 初始化
+ * @{
+ */
+
+/**
+ * @brief 初始化SPI总线, 引脚和DMA
+ *
+ * @param spi SPI外设
+ * @note 总线上所有设备的片选需要在传输前用spi_device_init初始化
+ */
+void spi_bus_init(SPI_TypeDef *spi) {
+    HAL_StatusTypeDef res = HAL_OK;
+    GPIO_InitTypeDef gpio_init_struct = {.Pull = GPIO_NOPULL,
+                                         .Speed = GPIO_SPEED_FREQ_HIGH};
+    spi_bus_t *bus = spi_bus_identify(spi);
+
+#ifdef DEBUG
+    assert(bus != NULL);
+#endif /* DEBUG */
+
+    if (bus == NULL) {
+        return;
+    }
+
+#if (SPI1_ENABLE == 1)
+    if (spi == SPI1) {
+        __HAL_RCC_SPI1_CLK_ENABLE();
+
+        SPI1_SCK_GPIO_ENABLE();
+        gpio_init_struct.Pin = SPI1_SCK_GPIO_PIN;
+        gpio_init_struct.Mode = GPIO_MODE_AF_PP;
+        HAL_GPIO_Init(SPI1_SCK_GPIO_PORT, &gpio_init_struct);
+
+        SPI1_MOSI_GPIO_ENABLE();
+        gpio_init_struct.Pin = SPI1_MOSI_GPIO_PIN;
+        HAL_GPIO_Init(SPI1_MOSI_GPIO_PORT, &gpio_init_struct);
+
+        SPI1_MISO_GPIO_ENABLE();
+        gpio_init_struct.Pin = SPI1_MISO_GPIO_PIN;
+        gpio_init_struct.Mode = GPIO_MODE_AF_INPUT;
+        HAL_GPIO_Init(SPI1_MISO_GPIO_PORT, &gpio_init_struct);
+    }
+#endif /* SPI1_ENABLE == 1 */
+
+#if (SPI2_ENABLE == 1)
+    if (spi == SPI2) {
+        __HAL_RCC_SPI2_CLK_ENABLE();
+
+        SPI2_SCK_GPIO_ENABLE();
+        gpio_init_struct.Pin = SPI2_SCK_GPIO_PIN;
+        gpio_init_struct.Mode = GPIO_MODE_AF_PP;
+        HAL_GPIO_Init(SPI2_SCK_GPIO_PORT, &gpio_init_struct);
+
+        SPI2_MOSI_GPIO_ENABLE();
+        gpio_init_struct.Pin = SPI2_MOSI_GPIO_PIN;
+        HAL_GPIO_Init(SPI2_MOSI_GPIO_PORT, &gpio_init_struct);
+
+        SPI2_MISO_GPIO_ENABLE();
+        gpio_init_struct.Pin = SPI2_MISO_GPIO_PIN;
+        gpio_init_struct.Mode = GPIO_MODE_AF_INPUT;
+        HAL_GPIO_Init(SPI2_MISO_GPIO_PORT, &gpio_init_struct);
+    }
+#endif /* SPI2_ENABLE == 1 */
+
+    UNUSED(gpio_init_struct);
+    __HAL_RCC_DMA1_CLK_ENABLE();
+
+    res = HAL_DMA_Init(bus->hdma_rx);
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+    res = HAL_DMA_Init(bus->hdma_tx);
+#ifdef DEBUG
+    assert(res == HAL_OK);
+#endif /* DEBUG */
+    UNUSED(res);
+
+    /* 外设地址固定, 之后每次传输只改存储器地址和长度 */
+    bus->hdma_rx->Instance->CPAR = (uint32_t)&spi->DR;
+    bus->hdma_tx->Instance->CPAR = (uint32_t)&spi->DR;
+    SET_BIT(bus->hdma_rx->Instance->CCR, DMA_CCR_TCIE | DMA_CCR_TEIE);
+    SET_BIT(bus->hdma_tx->Instance->CCR, DMA_CCR_TEIE);
+
+    HAL_NVIC_SetPriority(bus->rx_irqn, bus->it_preempt, bus->it_sub);
+    HAL_NVIC_EnableIRQ(bus->rx_irqn);
+    HAL_NVIC_SetPriority(bus->tx_irqn, bus->it_preempt, bus->it_sub);
+    HAL_NVIC_EnableIRQ(bus->tx_irqn);
+
+    /* 主机, 软件片选. 模式和分频在切换设备时写入 */
+    bus->cr1 = SPI_CR1_MSTR | SPI_CR1_SSM | SPI_CR1_SSI;
+    spi->CR1 = bus->cr1;
+    spi->CR2 = SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN;
+}
+
+/**
+ * @brief 初始化SPI设备和片选引脚
+ *
+ * @param dev 设备
+ * @param spi 所在总线
+ * @param cs_port 片选GPIO端口, NULL时不控制片选
+ * @param cs_pin 片选GPIO引脚
+ * @param mode SPI模式0~3, (CPOL << 1) | CPHA
+ * @param max_hz 最高时钟频率, 取不超过此频率的最大分频结果
+ */
+void spi_device_init(spi_device_t *dev, SPI_TypeDef *spi,
+                     GPIO_TypeDef *cs_port, uint16_t cs_pin, uint32_t mode,
+                     uint32_t max_hz) {
+    GPIO_InitTypeDef gpio_init_struct = {.Pin = cs_pin,
+                                         .Mode = GPIO_MODE_OUTPUT_PP,
+                                         .Pull = GPIO_NOPULL,
+                                         .Speed = GPIO_SPEED_FREQ_HIGH};
+    /* SPI1在APB2上, SPI2在APB1上 */
+    uint32_t pclk =
+        (spi == SPI1) ? HAL_RCC_GetPCLK2Freq() : HAL_RCC_GetPCLK1Freq();
+    uint32_t br = 0;
+
+#ifdef DEBUG
+    assert(dev != NULL);
+    assert(mode <= 3U);
+#endif /* DEBUG */
+
+    /* 分频系数为2^(br + 1) */
+    while ((br < 7U) && ((pclk >> (br + 1U)) > max_hz)) {
+        ++br;
+    }
+
+    dev->spi = spi;
+    dev->cs_port = cs_port;
+    dev->cs_pin = cs_pin;
+    /* CPOL和CPHA分别为CR1的bit1和bit0 */
+    dev->cr1 = (uint16_t)(SPI_CR1_MSTR | SPI_CR1_SSM | SPI_CR1_SSI |
+                          (br << SPI_CR1_BR_Pos) |
+                          (mode & (SPI_CR1_CPOL | SPI_CR1_CPHA)));
+
+    if (cs_port == NULL) {
+        return;
+    }
+
+    /* GPIOA~GPIOG的时钟使能位在RCC_APB2ENR中连续 */
+    SET_BIT(RCC->APB2ENR,
+            RCC_APB2ENR_IOPAEN << (((uint32_t)cs_port - GPIOA_BASE) /
+                                   (GPIOB_BASE - GPIOA_BASE)));
+    (void)READ_BIT(RCC->APB2ENR, RCC_APB2ENR_IOPAEN);
+
+    HAL_GPIO_WritePin(cs_port, cs_pin, GPIO_PIN_SET);
+    HAL_GPIO_Init(cs_port, &gpio_init_struct);
+}
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup 传输调度
+ * @{
+ */
+
+/**
+ * @brief 选中设备, 设置与上一个设备不同时重新写入CR1
+ *
+ * @param bus 总线
+ * @param dev 设备
+ */
+static void spi_select(spi_bus_t *bus, spi_device_t *dev) {
+    SPI_TypeDef *spi = bus->spi;
+
+    if (bus->cr1 != dev->cr1) {
+        /* 模式和分频只能在SPI关闭时修改 */
+        while (READ_BIT(spi->SR, SPI_SR_BSY)) {
+        }
+        CLEAR_BIT(spi->CR1, SPI_CR1_SPE);
+        spi->CR1 = dev->cr1;
+        bus->cr1 = dev->cr1;
+    }
+    SET_BIT(spi->CR1, SPI_CR1_SPE);
+
+    if (dev->cs_port != NULL) {
+        dev->cs_port->BRR = dev->cs_pin;
+    }
+}
+
+/**
+ * @brief 释放片选
+ *
+ * @param dev 设备
+ */
+static inline void spi_deselect(spi_device_t *dev) {
+    if (dev->cs_port != NULL) {
+        dev->cs_port->BSRR = dev->cs_pin;
+    }
+}
+
+/**
+ * @brief 启动一段DMA传输
+ *
+ * @param bus 总线
+ * @param seg 传输段
+ */
+static void spi_dma_start(spi_bus_t *bus, spi_xfer_t *seg) {
+    DMA_Channel_TypeDef *rx = bus->hdma_rx->Instance;
+    DMA_Channel_TypeDef *tx = bus->hdma_tx->Instance;
+
+    CLEAR_BIT(rx->CCR, DMA_CCR_EN);
+    CLEAR_BIT(tx->CCR, DMA_CCR_EN);
+    bus->hdma_rx->DmaBaseAddress->IFCR =
+        (DMA_IFCR_CGIF1 << bus->hdma_rx->ChannelIndex) |
+        (DMA_IFCR_CGIF1 << bus->hdma_tx->ChannelIndex);
+
+    rx->CNDTR = seg->len;
+    tx->CNDTR = seg->len;
+
+    if (seg->rx_buf != NULL) {
+        rx->CMAR = (uint32_t)seg->rx_buf;
+        SET_BIT(rx->CCR, DMA_CCR_MINC);
+    } else {
+        rx->CMAR = (uint32_t)&bus->rx_dummy;
+        CLEAR_BIT(rx->CCR, DMA_CCR_MINC);
+    }
+
+    if (seg->tx_buf != NULL) {
+        tx->CMAR = (uint32_t)seg->tx_buf;
+        SET_BIT(tx->CCR, DMA_CCR_MINC);
+    } else {
+        tx->CMAR = (uint32_t)&spi_tx_dummy;
+        CLEAR_BIT(tx->CCR, DMA_CCR_MINC);
+    }
+
+    /* 先使能接收通道, 发送的第一个字节开始移出时接收已经就绪 */
+    SET_BIT(rx->CCR, DMA_CCR_EN);
+    SET_BIT(tx->CCR, DMA_CCR_EN);
+}
+
+/**
+ * @brief 总线空闲时启动队列中的下一次传输
+ *
+ * @param bus 总线
+ * @note 需要在关中断时调用
+ */
+static void spi_bus_start_next(spi_bus_t *bus) {
+    spi_xfer_t *xfer;
+
+    if (bus->active != NULL) {
+        return;
+    }
+
+    while (bus->queue_out != bus->queue_in) {
+        xfer = bus->queue[bus->queue_out & (SPI_QUEUE_SIZE - 1U)];
+        ++bus->queue_out;
+
+        if (xfer == NULL) {
+            /* 已被取消 */
+            continue;
+        }
+
+        xfer->status = SPI_XFER_ACTIVE;
+        bus->active = xfer;
+        bus->segment = xfer;
+        spi_select(bus, xfer->dev);
+        spi_dma_start(bus, xfer);
+        return;
+    }
+}
+
+/**
+ * @brief 传输结束, 调用回调并唤醒等待的任务
+ *
+ * @param xfer 传输
+ * @param status 结果
+ */
+static void spi_xfer_finish(spi_xfer_t *xfer, spi_xfer_status_t status) {
+    void *waiter = xfer->waiter;
+
+    xfer->waiter = NULL;
+    xfer->status = status;
+
+    if (xfer->callback != NULL) {
+        xfer->callback(xfer);
+    }
+
+#if (SPI_USE_FREERTOS == 1)
+    if (waiter != NULL) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR((TaskHandle_t)waiter, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+#else  /* SPI_USE_FREERTOS == 1 */
+    UNUSED(waiter);
+#endif /* SPI_USE_FREERTOS == 1 */
+}
+
+/**
+ * @brief DMA中断处理
+ *
+ * @param bus 总线
+ */
+static void spi_dma_irq_handler(spi_bus_t *bus) {
+    DMA_TypeDef *dma = bus->hdma_rx->DmaBaseAddress;
+    uint32_t rx_index = bus->hdma_rx->ChannelIndex;
+    uint32_t tx_index = bus->hdma_tx->ChannelIndex;
+    uint32_t isr = dma->ISR;
+    spi_xfer_t *xfer = bus->active;
+    spi_xfer_status_t status;
+    uint32_t primask;
+
+    if (isr & ((DMA_ISR_TEIF1 << rx_index) | (DMA_ISR_TEIF1 << tx_index))) {
+        status = SPI_XFER_ERROR;
+    } else if (isr & (DMA_ISR_TCIF1 << rx_index)) {
+        status = SPI_XFER_DONE;
+    } else {
+        return;
+    }
+
+    dma->IFCR = (DMA_IFCR_CGIF1 << rx_index) | (DMA_IFCR_CGIF1 << tx_index);
+
+    if (xfer == NULL) {
+        return;
+    }
+
+    if ((status == SPI_XFER_DONE) && (bus->segment->next != NULL)) {
+        /* 保持片选, 传输下一段 */
+        bus->segment = bus->segment->next;
+        spi_dma_start(bus, bus->segment);
+        return;
+    }
+
+    if (status == SPI_XFER_ERROR) {
+        CLEAR_BIT(bus->hdma_rx->Instance->CCR, DMA_CCR_EN);
+        CLEAR_BIT(bus->hdma_tx->Instance->CCR, DMA_CCR_EN);
+        /* 丢弃未读出的数据并清除溢出标志 */
+        (void)bus->spi->DR;
+        (void)bus->spi->SR;
+    }
+
+    spi_deselect(xfer->dev);
+
+    /* 先启动下一次传输, 再处理完成的传输, 缩短总线空闲时间 */
+    primask = __get_PRIMASK();
+    __disable_irq();
+    bus->active = NULL;
+    spi_bus_start_next(bus);
+    __set_PRIMASK(primask);
+
+    spi_xfer_finish(xfer, status);
+}
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup 提交和等待
+ * @{
+ */
+
+/**
+ * @brief 提交传输, 总线空闲时立即开始
+ *
+ * @param xfer 传输, 多段时传入第一段
+ * @return 1: 已入队; 0: 队列满或总线未初始化
+ * @note 完成后在DMA中断中调用回调, 可以在中断和回调中调用
+ */
+uint32_t spi_submit(spi_xfer_t *xfer) {
+    spi_bus_t *bus;
+    uint32_t primask;
+
+    if ((xfer == NULL) || (xfer->dev == NULL)) {
+        return 0;
+    }
+
+    bus = spi_bus_identify(xfer->dev->spi);
+    if ((bus == NULL) || (bus->cr1 == 0)) {
+        return 0;
+    }
+
+#ifdef DEBUG
+    for (spi_xfer_t *seg = xfer; seg != NULL; seg = seg->next) {
+        assert(seg->len != 0);
+    }
+#endif /* DEBUG */
+
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (bus->queue_in - bus->queue_out >= SPI_QUEUE_SIZE) {
+        __set_PRIMASK(primask);
+        return 0;
+    }
+
+    xfer->status = SPI_XFER_QUEUED;
+    bus->queue[bus->queue_in & (SPI_QUEUE_SIZE - 1U)] = xfer;
+    ++bus->queue_in;
+    spi_bus_start_next(bus);
+
+    __set_PRIMASK(primask);
+    return 1;
+}
+
+/**
+ * @brief 取消还未开始的传输
+ *
+ * @param xfer 传输
+ * @return 1: 已取消; 0: 已经开始或已经结束
+ */
+static uint32_t spi_xfer_cancel(spi_xfer_t *xfer) {
+    spi_bus_t *bus = spi_bus_identify(xfer->dev->spi);
+    uint32_t cancelled = 0;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    if (xfer->status == SPI_XFER_QUEUED) {
+        /* 从队列中移除, 调用者返回后传输可能已经失效 */
+        for (uint32_t i = bus->queue_out; i != bus->queue_in; ++i) {
+            if (bus->queue[i & (SPI_QUEUE_SIZE - 1U)] == xfer) {
+                bus->queue[i & (SPI_QUEUE_SIZE - 1U)] = NULL;
+            }
+        }
+        xfer->status = SPI_XFER_CANCELLED;
+        xfer->waiter = NULL;
+        cancelled = 1;
+    }
+
+    __set_PRIMASK(primask);
+    return cancelled;
+}
+
+/**
+ * @brief 传输是否还未结束
+ *
+ * @param xfer 传输
+ * @return 1: 在队列中或正在传输
+ */
+static inline uint32_t spi_xfer_pending(spi_xfer_t *xfer) {
+    spi_xfer_status_t status = xfer->status;
+
+    return (status == SPI_XFER_QUEUED) || (status == SPI_XFER_ACTIVE);
+}
+
+/**
+ * @brief 提交传输并等待完成
+ *
+ * @param xfer 传输, 多段时传入第一段
+ * @param timeout 超时时间. FreeRTOS中单位为tick, 裸机中单位为ms
+ * @return 传输结果. 队列满时返回SPI_XFER_IDLE;
+ *         超时时还未开始的传输被取消, 返回SPI_XFER_CANCELLED,
+ *         已经开始的传输不能中止, 等待其完成
+ * @note 不能在中断中调用. FreeRTOS调度器运行时挂起任务等待,
+ *       由DMA中断通知唤醒; 否则轮询等待
+ */
+spi_xfer_status_t spi_transfer(spi_xfer_t *xfer, uint32_t timeout) {
+#if (SPI_USE_FREERTOS == 1)
+    if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) {
+        TickType_t start = xTaskGetTickCount();
+        TickType_t elapsed;
+        uint32_t taken = 0;
+        uint32_t notified;
+        uint32_t primask;
+
+        xfer->waiter = xTaskGetCurrentTaskHandle();
+        if (spi_submit(xfer) == 0) {
+            xfer->waiter = NULL;
+            return SPI_XFER_IDLE;
+        }
+
+        while (spi_xfer_pending(xfer)) {
+            elapsed = xTaskGetTickCount() - start;
+            if ((timeout != portMAX_DELAY) && (elapsed >= timeout)) {
+                if (spi_xfer_cancel(xfer)) {
+                    break;
+                }
+                /* 已经开始, 等待DMA完成 */
+                taken = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                continue;
+            }
+            taken = ulTaskNotifyTake(pdTRUE, (timeout == portMAX_DELAY)
+                                                 ? portMAX_DELAY
+                                                 : timeout - elapsed);
+        }
+
+        /* 中断已通知但没有被取走时清除, 以免影响下一次等待 */
+        primask = __get_PRIMASK();
+        __disable_irq();
+        notified = (xfer->waiter == NULL) &&
+                   (xfer->status != SPI_XFER_CANCELLED);
+        xfer->waiter = NULL;
+        __set_PRIMASK(primask);
+
+        if (notified && (taken == 0)) {
+            ulTaskNotifyTake(pdTRUE, 0);
+        }
+
+        return xfer->status;
+    }
+#endif /* SPI_USE_FREERTOS == 1 */
+
+    uint32_t tick_start;
+
+    xfer->waiter = NULL;
+    if (spi_submit(xfer) == 0) {
+        return SPI_XFER_IDLE;
+    }
+
+    tick_start = HAL_GetTick();
+    while (spi_xfer_pending(xfer)) {
+        /* 超时后只取消未开始的传输, 已经开始的等待完成 */
+        if ((HAL_GetTick() - tick_start >= timeout) &&
+            spi_xfer_cancel(xfer)) {
+            break;
+        }
+    }
+
+    return xfer->status;
+}
+
+/**
+ * @brief 单段收发
+ *
+ * @param dev 设备
+ * @param tx_buf 发送数据, NULL时发送0xFF
+ * @param rx_buf 接收缓冲区, NULL时丢弃接收的数据
+ * @param len 长度
+ * @param timeout 超时时间, 同spi_transfer
+ * @return 传输结果, 同spi_transfer
+ */
+spi_xfer_status_t spi_write_read(spi_device_t *dev, const void *tx_buf,
+                                 void *rx_buf, uint16_t len,
+                                 uint32_t timeout) {
+    spi_xfer_t xfer = {
+        .dev = dev,
+        .tx_buf = tx_buf,
+        .rx_buf = rx_buf,
+        .len = len,
+    };
+
+    return spi_transfer(&xfer, timeout);
+}
+
+/**
+ * @}
+ */
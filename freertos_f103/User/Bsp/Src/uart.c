@@ -8,112 +8,111 @@
 
 #include "uart.h"
 #include "bsp.h"
+#include "uart_port.h"
 
 #include <stdarg.h>
 #include <string.h>
 
-/* uart_printf函数缓冲区 */
-static char print_buffer[256];
-
 extern void uart_dmatx_init(UART_HandleTypeDef *huart);
 extern void uart_dmatx_clear_tc_flag(UART_HandleTypeDef *huart);
+extern uint32_t uart_dmatx_vprintf(UART_HandleTypeDef *huart,
+                                   const char *format, va_list ap);
 
 extern void uart_dmarx_init(UART_HandleTypeDef *huart);
 extern void uart_dmarx_idle_callback(UART_HandleTypeDef *huart);
 extern void uart_dmarx_halfdone_callback(UART_HandleTypeDef *huart);
 extern void uart_dmarx_done_callback(UART_HandleTypeDef *huart);
 
-#if (USART1_ENABLE == 1)
-UART_HandleTypeDef usart1_handle = {.Instance = USART1};
+extern void uart_it_irq_handler(UART_HandleTypeDef *huart);
+extern void uart_stats_error(UART_HandleTypeDef *huart, uint32_t error_code);
+extern void uart_stats_tx_stall(UART_HandleTypeDef *huart);
 
 /**
- * @brief 串口1中断服务函数
+ * @brief 串口引脚
  */
-void USART1_IRQHandler(void) {
-
-#if (USART1_USE_IDLE_IT == 1)
-    if (__HAL_UART_GET_FLAG(&usart1_handle, UART_FLAG_IDLE)) {
-        __HAL_UART_CLEAR_IDLEFLAG(&usart1_handle);
-        uart_dmarx_idle_callback(&usart1_handle);
-    }
-#endif /* USART1_USE_IDLE_IT == 1 */
-
-    HAL_UART_IRQHandler(&usart1_handle); /* 调用HAL库中断处理公用函数 */
-}
-
-#endif /* USART1_ENABLE == 1 */
-
-#if (USART2_ENABLE == 1)
-UART_HandleTypeDef usart2_handle = {.Instance = USART2};
+typedef struct {
+    GPIO_TypeDef *port; /*!< GPIO端口, NULL时没有此引脚 */
+    uint16_t pin;       /*!< 引脚号 */
+} uart_pin_t;
 
 /**
- * @brief 串口2中断服务函数
+ * @brief 串口硬件描述, 由HAL_UART_MspInit和串口中断处理函数使用
  */
-void USART2_IRQHandler(void) {
-
-#if (USART2_USE_IDLE_IT == 1)
-    if (__HAL_UART_GET_FLAG(&usart2_handle, UART_FLAG_IDLE)) {
-        __HAL_UART_CLEAR_IDLEFLAG(&usart2_handle);
-        uart_dmarx_idle_callback(&usart2_handle);
-    }
-#endif /* USART2_USE_IDLE_IT == 1 */
-
-    HAL_UART_IRQHandler(&usart2_handle); /* 调用HAL库中断处理公用函数 */
-}
-
-#endif /* USART2_ENABLE == 1 */
-
-#if (USART3_ENABLE == 1)
-UART_HandleTypeDef usart3_handle = {.Instance = USART3};
+typedef struct {
+    void (*clk_enable)(void); /*!< 打开串口时钟 */
+    IRQn_Type irqn;           /*!< 串口中断号 */
+    uint8_t it_preempt;       /*!< 串口中断抢占优先级 */
+    uint8_t it_sub;           /*!< 串口中断子优先级 */
+    uint8_t use_it;           /*!< 是否使用RXNE/TXE中断收发 */
+    uint8_t use_idle_it;      /*!< 是否启用DMA接收的空闲中断 */
+    uint8_t use_hal;          /*!< 是否调用HAL库中断处理 */
+    uint8_t soft_rts;         /*!< RTS是否由软件按接收fifo水位控制 */
+    uart_pin_t tx;            /*!< 发送引脚 */
+    uart_pin_t rx;            /*!< 接收引脚 */
+    uart_pin_t cts;           /*!< CTS引脚 */
+    uart_pin_t rts;           /*!< RTS引脚 */
+} uart_port_t;
+
+/* 串口描述, 串口时钟使能函数, 串口句柄和串口中断服务函数 */
+#define UART_PORT_DEFINE(name, p, ...)                                         \
+    UART_IF(p##ENABLE)(                                                        \
+        static void name##_clk_enable(void) {                                  \
+            __HAL_RCC_##p##CLK_ENABLE();                                       \
+        }                                                                      \
+        static const uart_port_t name##_port = {                               \
+            .clk_enable = name##_clk_enable,                                   \
+            .irqn = p##IRQn,                                                   \
+            .it_preempt = p##IT_PREEMPT,                                       \
+            .it_sub = p##IT_SUB,                                               \
+            .use_it = p##USE_IT,                                               \
+            .use_idle_it = UART_IF(p##USE_DMA_RX)(p##USE_IDLE_IT +) 0,         \
+            .use_hal = !p##USE_IT || p##USE_DMA_TX || p##USE_DMA_RX,           \
+            .soft_rts = p##RX_FLOW_CTRL,                                       \
+            .tx = {p##TX_GPIO_PORT, p##TX_GPIO_PIN},                           \
+            .rx = {p##RX_GPIO_PORT, p##RX_GPIO_PIN},                           \
+            .cts = {p##CTS_GPIO_PORT, p##CTS_GPIO_PIN},                        \
+            .rts = {p##RTS_GPIO_PORT, p##RTS_GPIO_PIN},                        \
+        };                                                                     \
+        UART_HandleTypeDef name##_handle = {                                   \
+            .Instance = (USART_TypeDef *)p##BASE};                             \
+        void p##IRQHandler(void) {                                             \
+            uart_irq_handler(&name##_handle, &name##_port);                    \
+        })
+
+/* 按串口编号索引的串口描述, 未启用的串口为NULL */
+#define UART_PORT_ENTRY(name, p, ...)                                          \
+    UART_IF(p##ENABLE)([UART_PORT_INDEX(p##BASE)] = &name##_port, )
 
 /**
- * @brief 串口3中断服务函数
+ * @brief 串口中断处理
+ *
+ * @param huart 串口句柄
+ * @param port 串口描述
+ * @note 由各串口的中断服务函数内联调用, 描述为常量, 不使用的分支在编译时去掉
  */
-void USART3_IRQHandler(void) {
-
-#if (USART3_USE_IDLE_IT == 1)
-    if (__HAL_UART_GET_FLAG(&usart3_handle, UART_FLAG_IDLE)) {
-        __HAL_UART_CLEAR_IDLEFLAG(&usart3_handle);
-        uart_dmarx_idle_callback(&usart3_handle);
+static inline void uart_irq_handler(UART_HandleTypeDef *huart,
+                                    const uart_port_t *port) {
+    if (port->use_it) {
+        uart_it_irq_handler(huart);
     }
-#endif /* USART3_USE_IDLE_IT == 1 */
 
-    HAL_UART_IRQHandler(&usart3_handle); /* 调用HAL库中断处理公用函数 */
-}
-
-#endif /* USART3_ENABLE == 1 */
-
-#if (UART4_ENABLE == 1)
-UART_HandleTypeDef uart4_handle = {.Instance = UART4};
-
-/**
- * @brief 串口4中断服务函数
- */
-void UART4_IRQHandler(void) {
-
-#if (UART4_USE_IDLE_IT == 1)
-    if (__HAL_UART_GET_FLAG(&uart4_handle, UART_FLAG_IDLE)) {
-        __HAL_UART_CLEAR_IDLEFLAG(&uart4_handle);
-        uart_dmarx_idle_callback(&uart4_handle);
+    if (port->use_idle_it && __HAL_UART_GET_FLAG(huart, UART_FLAG_IDLE)) {
+        __HAL_UART_CLEAR_IDLEFLAG(huart);
+        uart_dmarx_idle_callback(huart);
     }
-#endif /* UART4_USE_IDLE_IT == 1 */
 
-    HAL_UART_IRQHandler(&uart4_handle); /* 调用HAL库中断处理公用函数 */
+    if (port->use_hal) {
+        HAL_UART_IRQHandler(huart); /* 调用HAL库中断处理公用函数 */
+    }
 }
 
-#endif /* UART4_ENABLE == 1 */
+UART_PORT_LIST(UART_PORT_DEFINE)
 
-#if (UART5_ENABLE == 1)
-UART_HandleTypeDef uart5_handle = {.Instance = UART5};
-
-/**
- * @brief 串口5中断服务函数
- */
-void UART5_IRQHandler(void) {
-    HAL_UART_IRQHandler(&uart5_handle); /* 调用HAL库中断处理公用函数 */
-}
-
-#endif /* UART5_ENABLE == 1 */
+/* 编号0不对应串口, 保证没有启用串口时初始化列表不为空 */
+static const uart_port_t *const uart_port_table[UART_PORT_NUM] = {
+    [0] = NULL,
+    UART_PORT_LIST(UART_PORT_ENTRY)
+};
 
 /**
  * @brief 串口初始化
@@ -139,6 +138,8 @@ void UART5_IRQHandler(void) {
  *  @arg `UART_MODE_TX_RX` 启用发送和接收
  *  @arg `UART_MODE_TX` 只启用发送
  *  @arg `UART_MODE_RX` 只启用接收
+ * @note 串口1~3启用接收流控时, RTS由软件按接收fifo水位控制.
+ *       CTS始终由硬件控制, 对端置高CTS时DMA发送自动暂停, 不会丢失数据
  */
 void uart_init(UART_HandleTypeDef *huart, uint32_t baud_rate,
                uint32_t word_length, uint32_t stop_bits, uint32_t parity,
@@ -163,163 +164,65 @@ void uart_init(UART_HandleTypeDef *huart, uint32_t baud_rate,
 }
 
 /**
- * @brief 串口底层初始化
+ * @brief 配置串口引脚, 同时打开GPIO端口时钟
  *
- * @param huart 串口句柄
+ * @param pin 引脚
+ * @param mode 引脚模式, 推挽输出时初始为低电平
  */
-void HAL_UART_MspInit(UART_HandleTypeDef *huart) {
-    GPIO_InitTypeDef gpio_init_struct = {.Pull = GPIO_PULLUP,
+static void uart_gpio_init(const uart_pin_t *pin, uint32_t mode) {
+    GPIO_InitTypeDef gpio_init_struct = {.Pin = pin->pin,
+                                         .Mode = mode,
+                                         .Pull = GPIO_PULLUP,
                                          .Speed = GPIO_SPEED_FREQ_HIGH};
 
-    if (huart->Instance == USART1) {
-
-#if (USART1_ENABLE == 1)
-        __HAL_RCC_USART1_CLK_ENABLE();
+    /* GPIOA~GPIOG的时钟使能位在RCC_APB2ENR中连续 */
+    SET_BIT(RCC->APB2ENR,
+            RCC_APB2ENR_IOPAEN << (((uint32_t)pin->port - GPIOA_BASE) /
+                                   (GPIOB_BASE - GPIOA_BASE)));
+    (void)READ_BIT(RCC->APB2ENR, RCC_APB2ENR_IOPAEN);
 
-        if (huart->Init.Mode & UART_MODE_TX) {
-            USART1_TX_GPIO_ENABLE();
-            gpio_init_struct.Pin = USART1_TX_GPIO_PIN;
-            gpio_init_struct.Mode = GPIO_MODE_AF_PP;
-            HAL_GPIO_Init(USART1_TX_GPIO_PORT, &gpio_init_struct);
-        }
-        if (huart->Init.Mode & UART_MODE_RX) {
-            USART1_RX_GPIO_ENABLE();
-            gpio_init_struct.Pin = USART1_RX_GPIO_PIN;
-            gpio_init_struct.Mode = GPIO_MODE_AF_INPUT;
-            HAL_GPIO_Init(USART1_RX_GPIO_PORT, &gpio_init_struct);
-        }
-
-        if (huart->Init.HwFlowCtl & UART_HWCONTROL_RTS) {
-            USART1_RTS_GPIO_ENABLE();
-            gpio_init_struct.Mode = GPIO_MODE_AF_PP;
-            gpio_init_struct.Pin = USART1_RTS_GPIO_PIN;
-            HAL_GPIO_Init(USART1_RTS_GPIO_PORT, &gpio_init_struct);
-        }
-        if (huart->Init.HwFlowCtl & UART_HWCONTROL_CTS) {
-            USART1_CTS_GPIO_ENABLE();
-            gpio_init_struct.Pin = USART1_CTS_GPIO_PIN;
-            gpio_init_struct.Mode = GPIO_MODE_AF_INPUT;
-            HAL_GPIO_Init(USART1_CTS_GPIO_PORT, &gpio_init_struct);
-        }
-
-        HAL_NVIC_EnableIRQ(USART1_IRQn);
-        HAL_NVIC_SetPriority(USART1_IRQn, USART1_IT_PREEMPT, USART1_IT_SUB);
-#endif /* USART1_ENABLE == 1 */
-
-    } else if (huart->Instance == USART2) {
-
-#if (USART2_ENABLE == 1)
-        __HAL_RCC_USART2_CLK_ENABLE();
-
-        if (huart->Init.Mode & UART_MODE_TX) {
-            USART2_TX_GPIO_ENABLE();
-            gpio_init_struct.Pin = USART2_TX_GPIO_PIN;
-            gpio_init_struct.Mode = GPIO_MODE_AF_PP;
-            HAL_GPIO_Init(USART2_TX_GPIO_PORT, &gpio_init_struct);
-        }
-        if (huart->Init.Mode & UART_MODE_RX) {
-            USART2_RX_GPIO_ENABLE();
-            gpio_init_struct.Pin = USART2_RX_GPIO_PIN;
-            gpio_init_struct.Mode = GPIO_MODE_AF_INPUT;
-            HAL_GPIO_Init(USART2_RX_GPIO_PORT, &gpio_init_struct);
-        }
-
-        if (huart->Init.HwFlowCtl & UART_HWCONTROL_RTS) {
-            USART2_RTS_GPIO_ENABLE();
-            gpio_init_struct.Pin = USART2_RTS_GPIO_PIN;
-            gpio_init_struct.Mode = GPIO_MODE_AF_PP;
-            HAL_GPIO_Init(USART2_RTS_GPIO_PORT, &gpio_init_struct);
-        }
-        if (huart->Init.HwFlowCtl & UART_HWCONTROL_CTS) {
-            USART2_CTS_GPIO_ENABLE();
-            gpio_init_struct.Pin = USART2_CTS_GPIO_PIN;
-            gpio_init_struct.Mode = GPIO_MODE_AF_INPUT;
-            HAL_GPIO_Init(USART2_CTS_GPIO_PORT, &gpio_init_struct);
-        }
-
-        HAL_NVIC_EnableIRQ(USART2_IRQn);
-        HAL_NVIC_SetPriority(USART2_IRQn, USART2_IT_PREEMPT, USART2_IT_SUB);
-#endif /* USART2_ENABLE == 1 */
-
-    } else if (huart->Instance == USART3) {
-
-#if (USART3_ENABLE == 1)
-        __HAL_RCC_USART3_CLK_ENABLE();
-
-        if (huart->Init.Mode & UART_MODE_TX) {
-            USART3_TX_GPIO_ENABLE();
-            gpio_init_struct.Pin = USART3_TX_GPIO_PIN;
-            gpio_init_struct.Mode = GPIO_MODE_AF_PP;
-            HAL_GPIO_Init(USART3_TX_GPIO_PORT, &gpio_init_struct);
-        }
-        if (huart->Init.Mode & UART_MODE_RX) {
-            USART3_RX_GPIO_ENABLE();
-            gpio_init_struct.Pin = USART3_RX_GPIO_PIN;
-            gpio_init_struct.Mode = GPIO_MODE_AF_INPUT;
-            HAL_GPIO_Init(USART3_RX_GPIO_PORT, &gpio_init_struct);
-        }
-
-        if (huart->Init.HwFlowCtl & UART_HWCONTROL_RTS) {
-            USART3_RTS_GPIO_ENABLE();
-            gpio_init_struct.Pin = USART3_RTS_GPIO_PIN;
-            gpio_init_struct.Mode = GPIO_MODE_AF_PP;
-            HAL_GPIO_Init(USART3_RTS_GPIO_PORT, &gpio_init_struct);
-        }
-        if (huart->Init.HwFlowCtl & UART_HWCONTROL_CTS) {
-            USART3_CTS_GPIO_ENABLE();
-            gpio_init_struct.Pin = USART3_CTS_GPIO_PIN;
-            gpio_init_struct.Mode = GPIO_MODE_AF_INPUT;
-            HAL_GPIO_Init(USART3_CTS_GPIO_PORT, &gpio_init_struct);
-        }
-
-        HAL_NVIC_EnableIRQ(USART3_IRQn);
-        HAL_NVIC_SetPriority(USART3_IRQn, USART3_IT_PREEMPT, USART3_IT_SUB);
-#endif /* USART3_ENABLE == 1 */
-
-    } else if (huart->Instance == UART4) {
-
-#if (UART4_ENABLE == 1)
-        __HAL_RCC_UART4_CLK_ENABLE();
-
-        if (huart->Init.Mode & UART_MODE_TX) {
-            UART4_TX_GPIO_ENABLE();
-            gpio_init_struct.Pin = UART4_TX_GPIO_PIN;
-            gpio_init_struct.Mode = GPIO_MODE_AF_PP;
-            HAL_GPIO_Init(UART4_TX_GPIO_PORT, &gpio_init_struct);
-        }
-        if (huart->Init.Mode & UART_MODE_RX) {
-            UART4_RX_GPIO_ENABLE();
-            gpio_init_struct.Pin = UART4_RX_GPIO_PIN;
-            gpio_init_struct.Mode = GPIO_MODE_AF_INPUT;
-            HAL_GPIO_Init(UART4_RX_GPIO_PORT, &gpio_init_struct);
-        }
+    if (mode == GPIO_MODE_OUTPUT_PP) {
+        HAL_GPIO_WritePin(pin->port, pin->pin, GPIO_PIN_RESET);
+    }
+    HAL_GPIO_Init(pin->port, &gpio_init_struct);
+}
 
-        HAL_NVIC_EnableIRQ(UART4_IRQn);
-        HAL_NVIC_SetPriority(UART4_IRQn, UART4_IT_PREEMPT, UART4_IT_SUB);
-#endif /* UART4_ENABLE == 1 */
+/**
+ * @brief 串口底层初始化
+ *
+ * @param huart 串口句柄
+ * @note 引脚, 中断号和优先级取自串口描述
+ */
+void HAL_UART_MspInit(UART_HandleTypeDef *huart) {
+    const uart_port_t *port =
+        uart_port_table[UART_PORT_INDEX(huart->Instance)];
 
-    } else if (huart->Instance == UART5) {
+    if (port == NULL) {
+        return;
+    }
 
-#if (UART5_ENABLE == 1)
-        __HAL_RCC_UART5_CLK_ENABLE();
+    port->clk_enable();
 
-        if (huart->Init.Mode & UART_MODE_TX) {
-            UART5_TX_GPIO_ENABLE();
-            gpio_init_struct.Pin = UART5_TX_GPIO_PIN;
-            gpio_init_struct.Mode = GPIO_MODE_AF_PP;
-            HAL_GPIO_Init(UART5_TX_GPIO_PORT, &gpio_init_struct);
-        }
-        if (huart->Init.Mode & UART_MODE_RX) {
-            UART5_RX_GPIO_ENABLE();
-            gpio_init_struct.Pin = UART5_RX_GPIO_PIN;
-            gpio_init_struct.Mode = GPIO_MODE_AF_INPUT;
-            HAL_GPIO_Init(UART5_RX_GPIO_PORT, &gpio_init_struct);
-        }
+    if (huart->Init.Mode & UART_MODE_TX) {
+        uart_gpio_init(&port->tx, GPIO_MODE_AF_PP);
+    }
+    if (huart->Init.Mode & UART_MODE_RX) {
+        uart_gpio_init(&port->rx, GPIO_MODE_AF_INPUT);
+    }
 
-        HAL_NVIC_EnableIRQ(UART5_IRQn);
-        HAL_NVIC_SetPriority(UART5_IRQn, UART5_IT_PREEMPT, UART5_IT_SUB);
-#endif /* UART5_ENABLE == 1 */
+    if ((huart->Init.HwFlowCtl & UART_HWCONTROL_RTS) &&
+        (port->rts.port != NULL)) {
+        /* 软件RTS初始为低电平, 允许对端发送 */
+        uart_gpio_init(&port->rts, port->soft_rts ? GPIO_MODE_OUTPUT_PP
+                                                  : GPIO_MODE_AF_PP);
+    }
+    if ((huart->Init.HwFlowCtl & UART_HWCONTROL_CTS) &&
+        (port->cts.port != NULL)) {
+        uart_gpio_init(&port->cts, GPIO_MODE_AF_INPUT);
     }
+
+    HAL_NVIC_EnableIRQ(port->irqn);
+    HAL_NVIC_SetPriority(port->irqn, port->it_preempt, port->it_sub);
 }
 
 /**
@@ -327,21 +230,48 @@ void HAL_UART_MspInit(UART_HandleTypeDef *huart) {
  *
  * @param huart 串口句柄
  * @param __format 格式字符串
+ * @return 输出的长度
+ * @note 使用DMA或中断发送时, 结果直接格式化到发送缓冲区后立即返回,
+ *       可在多个任务和中断中调用. FreeRTOS任务中同一串口正被其他任务写入时
+ *       挂起等待, 最多等待`UART_TX_LOCK_TIMEOUT`; 中断中不等待,
+ *       同一串口正被写入时本次输出被丢弃并返回0.
+ *       其他情况阻塞发送, 最多等待按波特率发送完所需的时间.
+ *       串口正在阻塞发送(如被中断打断的任务)时本次输出被丢弃并返回0,
+ *       对端流控暂停导致超时时返回已发送的长度.
+ *       输出不完整时`uart_stats_t`的`tx_stalls`加1
  */
-void uart_printf(UART_HandleTypeDef *huart, const char *__format, ...) {
+uint32_t uart_printf(UART_HandleTypeDef *huart, const char *__format, ...) {
+    uint32_t len;
     va_list ap;
     va_start(ap, __format);
 
+    if (uart_tx_is_buffered(huart)) {
+        len = uart_dmatx_vprintf(huart, __format, ap);
+        va_end(ap);
+
+        uart_dmatx_send(huart);
+        return len;
+    }
+
+    char print_buffer[UART_PRINTF_BUF_SIZE];
     vsnprintf(print_buffer, sizeof(print_buffer), __format, ap);
     va_end(ap);
 
-    uint16_t len = strlen(print_buffer);
+    len = strlen(print_buffer);
+    if (len == 0) {
+        return 0;
+    }
 
-    if (huart->hdmatx == NULL) {
-        HAL_UART_Transmit(huart, (uint8_t *)print_buffer, len, 0xFFFF);
-    } else {
-        HAL_UART_Transmit_DMA(huart, (uint8_t *)print_buffer, len);
+    /* 每字节按11位(含校验位)计算, 多等2ms抵消节拍误差 */
+    uint32_t timeout = len * 11U * 1000U / huart->Init.BaudRate + 2U;
+    HAL_StatusTypeDef res = HAL_UART_Transmit(huart, (uint8_t *)print_buffer,
+                                              (uint16_t)len, timeout);
+    if (res == HAL_OK) {
+        return len;
     }
+
+    uart_stats_tx_stall(huart);
+    return (res == HAL_TIMEOUT) ? (len - huart->TxXferCount) : 0;
 }
 
 /**
@@ -357,6 +287,8 @@ void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
         return;
     }
 
+    uart_stats_error(huart, error_code);
+
     switch (error_code) {
         case HAL_UART_ERROR_PE: {
             __HAL_UART_CLEAR_PEFLAG(huart);
@@ -386,7 +318,9 @@ void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart) {
             HAL_UART_Receive_DMA(huart, huart->pRxBuffPtr, huart->RxXferSize)) {
             __HAL_UNLOCK(huart);
         }
-    } else {
+    } else if (huart->pRxBuffPtr != NULL) {
+        /* 中断收发模式不经过HAL库接收, pRxBuffPtr为NULL, 无需恢复 */
+
         /* 恢复接收地址指针到初始 buffer 位置 ，初始地址 = 当前地址 -
          * 已接收的数据个数，已接收的数据个数 = 需要接收数 - 还未接收数*/
         while (HAL_UART_Receive_IT(
@@ -0,0 +1,434 @@
+/**
+ * @file    uart_frame.c
+ * @author  Deadline039
+ * @brief   串口帧封装(COBS + CRC16)
+ * @version 1.0
+ * @date    2026-10-18
+ */
+
+#include "uart_frame.h"
+
+#include <assert.h>
+#include <string.h>
+
+#if ((UART_FRAME_FIFO_SIZE & (UART_FRAME_FIFO_SIZE - 1)) != 0)
+#error "UART_FRAME_FIFO_SIZE必须为2的幂次方"
+#endif /* UART_FRAME_FIFO_SIZE */
+
+#if (UART_FRAME_FIFO_SIZE < UART_FRAME_MAX_LEN + 4)
+#error "UART_FRAME_FIFO_SIZE至少要能存放一个最大帧"
+#endif /* UART_FRAME_FIFO_SIZE */
+
+/* COBS编码块最多254字节数据, 块长码0xFF表示块后没有0x00 */
+#define COBS_MAX_CODE 0xFFU
+
+#if (UART_FRAME_USE_CRC == 1)
+
+#define CRC16_INIT    0xFFFFU
+
+/* CRC-16/CCITT-FALSE, 多项式0x1021 */
+static const uint16_t crc16_table[256] = {
+    0x0000U, 0x1021U, 0x2042U, 0x3063U, 0x4084U, 0x50A5U, 0x60C6U, 0x70E7U,
+    0x8108U, 0x9129U, 0xA14AU, 0xB16BU, 0xC18CU, 0xD1ADU, 0xE1CEU, 0xF1EFU,
+    0x1231U, 0x0210U, 0x3273U, 0x2252U, 0x52B5U, 0x4294U, 0x72F7U, 0x62D6U,
+    0x9339U, 0x8318U, 0xB37BU, 0xA35AU, 0xD3BDU, 0xC39CU, 0xF3FFU, 0xE3DEU,
+    0x2462U, 0x3443U, 0x0420U, 0x1401U, 0x64E6U, 0x74C7U, 0x44A4U, 0x5485U,
+    0xA56AU, 0xB54BU, 0x8528U, 0x9509U, 0xE5EEU, 0xF5CFU, 0xC5ACU, 0xD58DU,
+    0x3653U, 0x2672U, 0x1611U, 0x0630U, 0x76D7U, 0x66F6U, 0x5695U, 0x46B4U,
+    0xB75BU, 0xA77AU, 0x9719U, 0x8738U, 0xF7DFU, 0xE7FEU, 0xD79DU, 0xC7BCU,
+    0x48C4U, 0x58E5U, 0x6886U, 0x78A7U, 0x0840U, 0x1861U, 0x2802U, 0x3823U,
+    0xC9CCU, 0xD9EDU, 0xE98EU, 0xF9AFU, 0x8948U, 0x9969U, 0xA90AU, 0xB92BU,
+    0x5AF5U, 0x4AD4U, 0x7AB7U, 0x6A96U, 0x1A71U, 0x0A50U, 0x3A33U, 0x2A12U,
+    0xDBFDU, 0xCBDCU, 0xFBBFU, 0xEB9EU, 0x9B79U, 0x8B58U, 0xBB3BU, 0xAB1AU,
+    0x6CA6U, 0x7C87U, 0x4CE4U, 0x5CC5U, 0x2C22U, 0x3C03U, 0x0C60U, 0x1C41U,
+    0xEDAEU, 0xFD8FU, 0xCDECU, 0xDDCDU, 0xAD2AU, 0xBD0BU, 0x8D68U, 0x9D49U,
+    0x7E97U, 0x6EB6U, 0x5ED5U, 0x4EF4U, 0x3E13U, 0x2E32U, 0x1E51U, 0x0E70U,
+    0xFF9FU, 0xEFBEU, 0xDFDDU, 0xCFFCU, 0xBF1BU, 0xAF3AU, 0x9F59U, 0x8F78U,
+    0x9188U, 0x81A9U, 0xB1CAU, 0xA1EBU, 0xD10CU, 0xC12DU, 0xF14EU, 0xE16FU,
+    0x1080U, 0x00A1U, 0x30C2U, 0x20E3U, 0x5004U, 0x4025U, 0x7046U, 0x6067U,
+    0x83B9U, 0x9398U, 0xA3FBU, 0xB3DAU, 0xC33DU, 0xD31CU, 0xE37FU, 0xF35EU,
+    0x02B1U, 0x1290U, 0x22F3U, 0x32D2U, 0x4235U, 0x5214U, 0x6277U, 0x7256U,
+    0xB5EAU, 0xA5CBU, 0x95A8U, 0x8589U, 0xF56EU, 0xE54FU, 0xD52CU, 0xC50DU,
+    0x34E2U, 0x24C3U, 0x14A0U, 0x0481U, 0x7466U, 0x6447U, 0x5424U, 0x4405U,
+    0xA7DBU, 0xB7FAU, 0x8799U, 0x97B8U, 0xE75FU, 0xF77EU, 0xC71DU, 0xD73CU,
+    0x26D3U, 0x36F2U, 0x0691U, 0x16B0U, 0x6657U, 0x7676U, 0x4615U, 0x5634U,
+    0xD94CU, 0xC96DU, 0xF90EU, 0xE92FU, 0x99C8U, 0x89E9U, 0xB98AU, 0xA9ABU,
+    0x5844U, 0x4865U, 0x7806U, 0x6827U, 0x18C0U, 0x08E1U, 0x3882U, 0x28A3U,
+    0xCB7DU, 0xDB5CU, 0xEB3FU, 0xFB1EU, 0x8BF9U, 0x9BD8U, 0xABBBU, 0xBB9AU,
+    0x4A75U, 0x5A54U, 0x6A37U, 0x7A16U, 0x0AF1U, 0x1AD0U, 0x2AB3U, 0x3A92U,
+    0xFD2EU, 0xED0FU, 0xDD6CU, 0xCD4DU, 0xBDAAU, 0xAD8BU, 0x9DE8U, 0x8DC9U,
+    0x7C26U, 0x6C07U, 0x5C64U, 0x4C45U, 0x3CA2U, 0x2C83U, 0x1CE0U, 0x0CC1U,
+    0xEF1FU, 0xFF3EU, 0xCF5DU, 0xDF7CU, 0xAF9BU, 0xBFBAU, 0x8FD9U, 0x9FF8U,
+    0x6E17U, 0x7E36U, 0x4E55U, 0x5E74U, 0x2E93U, 0x3EB2U, 0x0ED1U, 0x1EF0U,
+};
+
+/**
+ * @brief 计算CRC16
+ *
+ * @param crc 初值, 分段计算时为上一段的结果
+ * @param data 数据
+ * @param len 数据长度
+ * @return CRC值
+ */
+static uint16_t crc16_update(uint16_t crc, const uint8_t *data, uint32_t len) {
+    while (len--) {
+        crc = (uint16_t)(crc << 8) ^ crc16_table[(crc >> 8) ^ *data++];
+    }
+
+    return crc;
+}
+
+#endif /* UART_FRAME_USE_CRC == 1 */
+
+/*****************************************************************************
+ * @defgroup 编解码
+ * @{
+ */
+
+/**
+ * @brief COBS编码状态
+ */
+typedef struct {
+    ring_fifo_span_t *span; /* 输出空间, 可分为两段 */
+    uint32_t code_pos;      /* 当前块长码的位置 */
+    uint32_t pos;           /* 下一个输出字节的位置 */
+    uint8_t code;           /* 当前块长码 */
+} cobs_encoder_t;
+
+/**
+ * @brief 获取输出空间中第pos个字节的地址
+ *
+ * @param span 输出空间
+ * @param pos 位置
+ * @return 地址
+ */
+static inline uint8_t *cobs_span_at(ring_fifo_span_t *span, uint32_t pos) {
+    if (pos < span[0].len) {
+        return (uint8_t *)span[0].buf + pos;
+    }
+
+    return (uint8_t *)span[1].buf + (pos - span[0].len);
+}
+
+/**
+ * @brief 编码一段数据
+ *
+ * @param enc 编码状态
+ * @param data 数据
+ * @param len 数据长度
+ */
+static void cobs_encode_bytes(cobs_encoder_t *enc, const uint8_t *data,
+                              uint32_t len) {
+    while (len--) {
+        uint8_t byte = *data++;
+
+        if (byte != UART_FRAME_DELIM) {
+            *cobs_span_at(enc->span, enc->pos++) = byte;
+            ++enc->code;
+        }
+
+        /* 遇到0x00或块满, 回填块长码并开始新块 */
+        if ((byte == UART_FRAME_DELIM) || (enc->code == COBS_MAX_CODE)) {
+            *cobs_span_at(enc->span, enc->code_pos) = enc->code;
+            enc->code_pos = enc->pos++;
+            enc->code = 1;
+        }
+    }
+}
+
+/**
+ * @brief 编码一帧(数据 + CRC + 帧尾)
+ *
+ * @param data 数据
+ * @param len 数据长度
+ * @param span 输出空间, 长度不小于UART_FRAME_ENCODED_SIZE(len)
+ * @return 编码后的长度
+ */
+static uint32_t cobs_encode_frame(const uint8_t *data, uint32_t len,
+                                  ring_fifo_span_t *span) {
+    cobs_encoder_t enc = {.span = span, .code_pos = 0, .pos = 1, .code = 1};
+
+    cobs_encode_bytes(&enc, data, len);
+
+#if (UART_FRAME_USE_CRC == 1)
+    uint16_t crc = crc16_update(CRC16_INIT, data, len);
+    uint8_t crc_buf[UART_FRAME_CRC_SIZE] = {(uint8_t)(crc >> 8),
+                                            (uint8_t)crc};
+    cobs_encode_bytes(&enc, crc_buf, sizeof(crc_buf));
+#endif /* UART_FRAME_USE_CRC == 1 */
+
+    *cobs_span_at(span, enc.code_pos) = enc.code;
+    *cobs_span_at(span, enc.pos++) = UART_FRAME_DELIM;
+
+    return enc.pos;
+}
+
+/**
+ * @brief 编码一帧到缓冲区
+ *
+ * @param data 数据
+ * @param len 数据长度
+ * @param[out] buf 输出缓冲区
+ * @param size 输出缓冲区大小, 不小于UART_FRAME_ENCODED_SIZE(len)
+ * @return 编码后的长度(含帧尾), 缓冲区不足时返回0
+ */
+uint32_t uart_frame_encode(const void *data, uint32_t len, void *buf,
+                           uint32_t size) {
+    if ((buf == NULL) || ((data == NULL) && (len != 0)) ||
+        (size < UART_FRAME_ENCODED_SIZE(len))) {
+        return 0;
+    }
+
+    ring_fifo_span_t span[2] = {{.buf = buf, .len = size},
+                                {.buf = NULL, .len = 0}};
+
+    return cobs_encode_frame(data, len, span);
+}
+
+/**
+ * @brief 原地解码一帧
+ *
+ * @param buf 编码数据, 不含帧尾. 解码结果覆盖在原处
+ * @param len 编码数据长度
+ * @return 解码后的长度(含CRC), 数据格式错误时返回-1
+ * @note 只做COBS解码, 不校验CRC
+ */
+int32_t uart_frame_decode(void *buf, uint32_t len) {
+    uint8_t *p = buf;
+    uint32_t in = 0;
+    uint32_t out = 0;
+
+    while (in < len) {
+        uint32_t code = p[in++];
+
+        if ((code == UART_FRAME_DELIM) || (code - 1U > len - in)) {
+            return -1;
+        }
+
+        /* 解码结果不会超过编码数据, 可以原地前移 */
+        memmove(p + out, p + in, code - 1U);
+        in += code - 1U;
+        out += code - 1U;
+
+        if ((code != COBS_MAX_CODE) && (in < len)) {
+            p[out++] = UART_FRAME_DELIM;
+        }
+    }
+
+    return (int32_t)out;
+}
+
+/**
+ * @brief 查找帧尾
+ *
+ * @param buf 数据
+ * @param len 数据长度
+ * @return 帧尾的位置, 没有找到时返回`len`
+ * @note 对齐后每次检查4字节, 数据中没有帧尾时每个字只需一次判断
+ */
+static uint32_t uart_frame_find_delim(const uint8_t *buf, uint32_t len) {
+    uint32_t i = 0;
+    uint32_t word;
+
+    while ((i < len) && (((uintptr_t)(buf + i) & 0x03U) != 0)) {
+        if (buf[i] == UART_FRAME_DELIM) {
+            return i;
+        }
+        ++i;
+    }
+
+    /* (x - 0x01010101) & ~x & 0x80808080不为0时, x中有为0的字节 */
+    for (; i + sizeof(word) <= len; i += sizeof(word)) {
+        memcpy(&word, buf + i, sizeof(word));
+        if (((word - 0x01010101U) & ~word & 0x80808080U) != 0) {
+            break;
+        }
+    }
+
+    for (; i < len; ++i) {
+        if (buf[i] == UART_FRAME_DELIM) {
+            return i;
+        }
+    }
+
+    return len;
+}
+
+/**
+ * @}
+ */
+
+/*****************************************************************************
+ * @defgroup 串口收发
+ * @{
+ */
+
+/**
+ * @brief 初始化帧接收句柄
+ *
+ * @param frame 帧接收句柄
+ * @param huart 串口句柄, 需要开启该串口的DMA接收或中断收发
+ */
+void uart_frame_init(uart_frame_t *frame, UART_HandleTypeDef *huart) {
+#ifdef DEBUG
+    assert(frame != NULL);
+#endif /* DEBUG */
+
+    memset(frame, 0, sizeof(uart_frame_t));
+    frame->huart = huart;
+    frame->frames = ring_fifo_init_static(&frame->ring, frame->fifo_buf,
+                                          UART_FRAME_FIFO_SIZE, RF_TYPE_FRAME);
+#ifdef DEBUG
+    assert(frame->frames != NULL);
+#endif /* DEBUG */
+}
+
+/**
+ * @brief 编码并发送一帧
+ *
+ * @param huart 串口句柄
+ * @param data 数据
+ * @param len 数据长度, 不超过UART_FRAME_MAX_LEN
+ * @return 成功时返回`len`. 发送缓冲区空间不足,
+ *         或其他任务或中断正在写入同一串口时返回0, 整帧不发送
+ * @note 直接编码到串口发送FIFO中, 编码完成后启动发送
+ */
+uint32_t uart_frame_send(UART_HandleTypeDef *huart, const void *data,
+                         uint32_t len) {
+    ring_fifo_span_t span[2];
+
+    if ((data == NULL) || (len == 0) || (len > UART_FRAME_MAX_LEN)) {
+        return 0;
+    }
+
+    if (uart_dmatx_reserve(huart, UART_FRAME_ENCODED_SIZE(len), span) == 0) {
+        return 0;
+    }
+
+    uart_dmatx_commit(huart, cobs_encode_frame(data, len, span));
+    uart_dmatx_send(huart);
+
+    return len;
+}
+
+/**
+ * @brief 校验接收到的一帧, 存入帧FIFO
+ *
+ * @param frame 帧接收句柄
+ * @param buf 编码数据, 不含帧尾
+ * @param len 编码数据长度
+ * @return 1: 接收成功; 0: 帧被丢弃
+ */
+static uint32_t uart_frame_accept(uart_frame_t *frame, uint8_t *buf,
+                                  uint32_t len) {
+    int32_t n = uart_frame_decode(buf, len);
+
+    if (n <= (int32_t)UART_FRAME_CRC_SIZE) {
+        ++frame->stats.decode_errors;
+        return 0;
+    }
+
+#if (UART_FRAME_USE_CRC == 1)
+    /* 数据连同CRC一起计算, 结果为0则校验通过 */
+    if (crc16_update(CRC16_INIT, buf, (uint32_t)n) != 0) {
+        ++frame->stats.crc_errors;
+        return 0;
+    }
+    n -= UART_FRAME_CRC_SIZE;
+#endif /* UART_FRAME_USE_CRC == 1 */
+
+    if (n > UART_FRAME_MAX_LEN) {
+        ++frame->stats.overflows;
+        return 0;
+    }
+
+    if (ring_fifo_write(frame->frames, buf, (uint32_t)n) == 0) {
+        ++frame->stats.dropped;
+        return 0;
+    }
+
+    ++frame->stats.frames;
+    return 1;
+}
+
+/**
+ * @brief 从串口接收FIFO读取数据并解码
+ *
+ * @param frame 帧接收句柄
+ * @return 本次接收成功的帧数
+ * @note 需要周期性调用(裸机在主循环中, FreeRTOS在接收任务中).
+ *       串口接收FIFO只能有一个读者, 不要同时调用`uart_dmarx_read`
+ */
+uint32_t uart_frame_poll(uart_frame_t *frame) {
+    uint32_t count = 0;
+    uint32_t len;
+    uint32_t scan;
+    uint32_t start;
+    uint32_t end;
+
+    if ((frame == NULL) || (frame->frames == NULL)) {
+        return 0;
+    }
+
+    while (1) {
+        if (frame->rx_len == sizeof(frame->rx_buf)) {
+            /* 缓冲区满仍未收到帧尾, 丢弃直到下一个帧尾 */
+            if (!frame->discard) {
+                ++frame->stats.overflows;
+                frame->discard = 1;
+            }
+            frame->rx_len = 0;
+        }
+
+        /* 直接读到帧缓冲区末尾, 只查找新读入的数据 */
+        scan = frame->rx_len;
+        len = uart_dmarx_read(frame->huart, frame->rx_buf + scan,
+                              sizeof(frame->rx_buf) - scan);
+        if (len == 0) {
+            break;
+        }
+        frame->rx_len += len;
+
+        start = 0;
+        while ((end = scan + uart_frame_find_delim(frame->rx_buf + scan,
+                                                   frame->rx_len - scan)) <
+               frame->rx_len) {
+            if (frame->discard) {
+                frame->discard = 0;
+            } else if (end > start) {
+                count += uart_frame_accept(frame, frame->rx_buf + start,
+                                           end - start);
+            }
+            start = end + 1;
+            scan = start;
+        }
+
+        /* 未收完的帧移到缓冲区开头 */
+        if (start != 0) {
+            frame->rx_len -= start;
+            memmove(frame->rx_buf, frame->rx_buf + start, frame->rx_len);
+        }
+    }
+
+    return count;
+}
+
+/**
+ * @brief 读出一帧
+ *
+ * @param frame 帧接收句柄
+ * @param[out] buf 接收缓冲区
+ * @param len 缓冲区长度, 不小于UART_FRAME_MAX_LEN
+ * @return 帧长, 没有帧或缓冲区小于帧长时返回0
+ */
+uint32_t uart_frame_read(uart_frame_t *frame, void *buf, uint32_t len) {
+    if ((frame == NULL) || (frame->frames == NULL) || (buf == NULL)) {
+        return 0;
+    }
+
+    return ring_fifo_read(frame->frames, buf, len);
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,53 @@
+/**
+ * @file    bench.h
+ * @author  Deadline039
+ * @brief   主机性能测试计时
+ * @version 1.0
+ * @date    2026-10-18
+ *
+ * x86上使用TSC计数, 其他平台以纳秒代替周期数.
+ */
+
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT "cycles"
+#else /* __x86_64__ || __i386__ */
+#define BENCH_UNIT "ns"
+#endif /* __x86_64__ || __i386__ */
+
+/**
+ * @brief 单调时钟(s)
+ *
+ * @return 当前时刻
+ */
+static inline double bench_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief 周期计数, 单位为BENCH_UNIT
+ *
+ * @return 当前计数
+ */
+static inline uint64_t bench_ticks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else  /* __x86_64__ || __i386__ */
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000U + (uint64_t)ts.tv_nsec;
+#endif /* __x86_64__ || __i386__ */
+}
+
+/* 防止编译器优化掉测试结果 */
+#define BENCH_KEEP(x) __asm__ volatile("" : : "g"(x) : "memory")
+
+#endif /* __BENCH_H */
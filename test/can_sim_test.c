@@ -0,0 +1,810 @@
+/**
+ * @file    can_sim_test.c
+ * @author  Deadline039
+ * @brief   can发送队列和过滤器分配的主机回环模拟测试
+ * @version 1.0
+ * @date    2026-10-18
+ *
+ * 用模拟的寄存器代替CAN1: 模拟器实现发送邮箱, 总线仲裁, 按过滤器寄存器
+ * 匹配报文和3级接收FIFO, 发送的报文经过过滤器回环到接收端.
+ * 覆盖发送队列按优先级放入邮箱, 同ID报文按发送顺序上总线,
+ * 随机过滤器组合分配后过滤器编号(FMI)到接收类别的映射, 以及硬件FIFO溢出.
+ * 直接包含can.c, 通过CAN_REGS等宏接入模拟器.
+ */
+
+#include "can.h"
+
+static CAN_TypeDef can_sim_regs;
+
+static void can_sim_tx_request(uint32_t mb);
+static void can_sim_tsr_clear(uint32_t bits);
+static void can_sim_rfr_clear(uint32_t fifo, uint32_t bits);
+
+#define CAN_REGS                  (&can_sim_regs)
+#define CAN_TX_REQUEST(mb)        can_sim_tx_request(mb)
+#define CAN_TSR_CLEAR(bits)       can_sim_tsr_clear(bits)
+#define CAN_RFR_CLEAR(fifo, bits) can_sim_rfr_clear(fifo, bits)
+
+#include "can.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHECK(cond)                                                            \
+    do {                                                                       \
+        if (!(cond)) {                                                         \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);    \
+            exit(1);                                                           \
+        }                                                                      \
+    } while (0)
+
+/*****************************************************************************
+ * HAL
+ */
+
+HAL_StatusTypeDef HAL_CAN_Init(CAN_HandleTypeDef *hcan) {
+    hcan->State = HAL_CAN_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_CAN_Start(CAN_HandleTypeDef *hcan) {
+    hcan->State = HAL_CAN_STATE_LISTENING;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_CAN_Stop(CAN_HandleTypeDef *hcan) {
+    hcan->State = HAL_CAN_STATE_READY;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_CAN_ActivateNotification(CAN_HandleTypeDef *hcan,
+                                               uint32_t ActiveITs) {
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_CAN_AbortTxRequest(CAN_HandleTypeDef *hcan,
+                                         uint32_t TxMailboxes) {
+    return HAL_OK;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void) {
+    return 36000000U;
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init) {
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority,
+                          uint32_t SubPriority) {
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn) {
+}
+
+/*****************************************************************************
+ * 发送检查: 记录已交给can_send还未放入邮箱的报文
+ */
+
+/* 发送的报文种类, 仲裁值互不相同. 0x123和扩展帧0x048C0005的基本ID相同 */
+static const struct {
+    uint32_t id;
+    uint8_t ide;
+    uint8_t rtr;
+} tx_ids[] = {
+    {0x000, 0, 0},        {0x001, 0, 0},        {0x100, 0, 0},
+    {0x100, 0, 1},        {0x123, 0, 0},        {0x123, 0, 1},
+    {0x7FF, 0, 0},        {0x00000100, 1, 0},   {0x048C0005, 1, 0},
+    {0x048C0005, 1, 1},   {0x048C0006, 1, 0},   {0x1FFFFFFF, 1, 0},
+};
+
+#define TX_ID_NUM (sizeof(tx_ids) / sizeof(tx_ids[0]))
+
+typedef struct {
+    uint32_t arb; /* 总线仲裁值, 小的优先 */
+    uint32_t seq; /* 测试中的发送序号 */
+} tx_pending_t;
+
+static tx_pending_t tx_pending[CAN_TX_QUEUE_SIZE + 1U];
+static uint32_t tx_pending_num;
+static uint32_t tx_last_seq[TX_ID_NUM]; /* 每种报文上一次上总线的序号 */
+static uint32_t tx_bus_frames;
+
+/**
+ * @brief 标识符寄存器(TIR/RIR)在总线上的仲裁值, 小的优先
+ *
+ * @note 仲裁顺序为基本ID, RTR(扩展帧为SRR, 隐性), IDE, 扩展ID, RTR
+ */
+static uint32_t sim_arbitration(uint32_t ir) {
+    uint32_t arb = (ir >> CAN_TI0R_STID_Pos) << 21;
+
+    if ((ir & CAN_TI0R_IDE) == 0) {
+        return arb | ((ir & CAN_TI0R_RTR) ? (1UL << 20) : 0U);
+    }
+
+    return arb | (1UL << 20) | (1UL << 19) |
+           (((ir >> CAN_TI0R_EXID_Pos) & 0x3FFFFU) << 1) |
+           ((ir & CAN_TI0R_RTR) ? 1U : 0U);
+}
+
+/**
+ * @brief 报文的标识符寄存器值, 不使用can.c中的实现
+ */
+static uint32_t frame_ir(uint32_t id, uint32_t ide, uint32_t rtr) {
+    uint32_t ir = ide ? ((id << CAN_TI0R_EXID_Pos) | CAN_TI0R_IDE)
+                      : (id << CAN_TI0R_STID_Pos);
+    return ir | (rtr ? CAN_TI0R_RTR : 0U);
+}
+
+/**
+ * @brief 驱动请求发送邮箱中的报文
+ *
+ * @note 放入邮箱的必须是等待中仲裁值最小的报文, 仲裁值相同时为最先发送的;
+ *       且不能与其他邮箱中的报文仲裁值相同
+ */
+static void tx_check_request(uint32_t mb) {
+    CAN_TxMailBox_TypeDef *mailbox = &can_sim_regs.sTxMailBox[mb];
+    uint32_t arb = sim_arbitration(mailbox->TIR);
+    uint32_t seq = mailbox->TDLR;
+    uint32_t idx = mailbox->TDHR & 0xFFU;
+    uint32_t found = tx_pending_num;
+
+    CHECK(idx < TX_ID_NUM);
+    CHECK((mailbox->TIR & ~(CAN_TI0R_TXRQ)) ==
+          frame_ir(tx_ids[idx].id, tx_ids[idx].ide, tx_ids[idx].rtr));
+    CHECK((mailbox->TDTR & CAN_TDT0R_DLC) == 8U);
+
+    for (uint32_t i = 0; i < tx_pending_num; ++i) {
+        if (tx_pending[i].seq == seq) {
+            found = i;
+            continue;
+        }
+        CHECK((tx_pending[i].arb > arb) ||
+              ((tx_pending[i].arb == arb) && (tx_pending[i].seq > seq)));
+    }
+    CHECK(found < tx_pending_num);
+    tx_pending[found] = tx_pending[--tx_pending_num];
+
+    for (uint32_t i = 0; i < CAN_TX_MAILBOXES; ++i) {
+        if ((i != mb) && !(can_sim_regs.TSR & (CAN_TSR_TME0 << i))) {
+            CHECK(sim_arbitration(can_sim_regs.sTxMailBox[i].TIR) != arb);
+        }
+    }
+}
+
+/**
+ * @brief 有空闲邮箱时, 等待的报文只能是被同仲裁值的邮箱阻塞
+ */
+static void tx_check_idle(void) {
+    uint32_t arb = UINT32_MAX;
+    uint32_t blocked = 0;
+
+    if ((tx_pending_num == 0) ||
+        !(can_sim_regs.TSR & (CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2))) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < tx_pending_num; ++i) {
+        arb = (tx_pending[i].arb < arb) ? tx_pending[i].arb : arb;
+    }
+    for (uint32_t i = 0; i < CAN_TX_MAILBOXES; ++i) {
+        blocked |= !(can_sim_regs.TSR & (CAN_TSR_TME0 << i)) &&
+                   (sim_arbitration(can_sim_regs.sTxMailBox[i].TIR) == arb);
+    }
+    CHECK(blocked);
+}
+
+/*****************************************************************************
+ * 模拟CAN外设
+ */
+
+#define SIM_FIFO_DEPTH 3U
+
+typedef struct {
+    uint32_t rir;
+    uint32_t rdtr;
+    uint32_t rdlr;
+    uint32_t rdhr;
+} sim_rx_frame_t;
+
+typedef struct {
+    sim_rx_frame_t frames[SIM_FIFO_DEPTH];
+    uint32_t count;
+    uint32_t overrun;
+} sim_fifo_t;
+
+static sim_fifo_t sim_fifo[2];
+static uint32_t sim_overwritten; /* 硬件FIFO满时被覆盖的报文数 */
+
+/**
+ * @brief 更新TSR的CODE为编号最小的空闲邮箱
+ */
+static void sim_tsr_update(void) {
+    uint32_t tsr = can_sim_regs.TSR & ~CAN_TSR_CODE;
+
+    for (uint32_t mb = 0; mb < CAN_TX_MAILBOXES; ++mb) {
+        if (tsr & (CAN_TSR_TME0 << mb)) {
+            tsr |= mb << CAN_TSR_CODE_Pos;
+            break;
+        }
+    }
+    can_sim_regs.TSR = tsr;
+}
+
+static void can_sim_tx_request(uint32_t mb) {
+    CHECK(mb < CAN_TX_MAILBOXES);
+    CHECK(can_sim_regs.TSR & (CAN_TSR_TME0 << mb));
+
+    SET_BIT(can_sim_regs.sTxMailBox[mb].TIR, CAN_TI0R_TXRQ);
+    CLEAR_BIT(can_sim_regs.TSR, CAN_TSR_TME0 << mb);
+    sim_tsr_update();
+
+    tx_check_request(mb);
+}
+
+static void can_sim_tsr_clear(uint32_t bits) {
+    /* 每个邮箱的标志占8位, 写RQCP同时清除TXOK, ALST和TERR */
+    for (uint32_t mb = 0; mb < CAN_TX_MAILBOXES; ++mb) {
+        if (bits & (CAN_TSR_RQCP0 << (8U * mb))) {
+            CLEAR_BIT(can_sim_regs.TSR,
+                      (CAN_TSR_RQCP0 | CAN_TSR_TXOK0 | CAN_TSR_ALST0 |
+                       CAN_TSR_TERR0)
+                          << (8U * mb));
+        }
+    }
+}
+
+/**
+ * @brief 由接收FIFO的状态更新RFR和输出邮箱
+ */
+static void sim_fifo_update(uint32_t fifo) {
+    sim_fifo_t *f = &sim_fifo[fifo];
+    CAN_FIFOMailBox_TypeDef *out = &can_sim_regs.sFIFOMailBox[fifo];
+
+    *CAN_RFR(fifo) = f->count |
+                     ((f->count == SIM_FIFO_DEPTH) ? CAN_RF0R_FULL0 : 0U) |
+                     (f->overrun ? CAN_RF0R_FOVR0 : 0U);
+
+    if (f->count != 0) {
+        out->RIR = f->frames[0].rir;
+        out->RDTR = f->frames[0].rdtr;
+        out->RDLR = f->frames[0].rdlr;
+        out->RDHR = f->frames[0].rdhr;
+    }
+}
+
+static void can_sim_rfr_clear(uint32_t fifo, uint32_t bits) {
+    sim_fifo_t *f = &sim_fifo[fifo];
+
+    CHECK(fifo < 2);
+
+    if (bits & CAN_RF0R_RFOM0) {
+        CHECK(f->count != 0);
+        --f->count;
+        memmove(&f->frames[0], &f->frames[1],
+                f->count * sizeof(f->frames[0]));
+    }
+    if (bits & CAN_RF0R_FOVR0) {
+        f->overrun = 0;
+    }
+
+    sim_fifo_update(fifo);
+}
+
+/**
+ * @brief 报文放入接收FIFO
+ *
+ * @note FIFO不锁定, 满时覆盖最后一帧
+ */
+static void sim_fifo_push(uint32_t fifo, const sim_rx_frame_t *frame) {
+    sim_fifo_t *f = &sim_fifo[fifo];
+
+    if (f->count == SIM_FIFO_DEPTH) {
+        f->frames[SIM_FIFO_DEPTH - 1U] = *frame;
+        f->overrun = 1;
+        ++sim_overwritten;
+    } else {
+        f->frames[f->count++] = *frame;
+    }
+
+    sim_fifo_update(fifo);
+}
+
+/**
+ * @brief 接收FIFO中有报文时进入接收中断
+ */
+static void sim_rx_irq(uint32_t fifo) {
+    if ((sim_fifo[fifo].count == 0) && !sim_fifo[fifo].overrun) {
+        return;
+    }
+
+    if (fifo == 0) {
+        USB_LP_CAN1_RX0_IRQHandler();
+    } else {
+        CAN1_RX1_IRQHandler();
+    }
+
+    CHECK(sim_fifo[fifo].count == 0);
+    CHECK(!sim_fifo[fifo].overrun);
+}
+
+/**
+ * @brief 按过滤器寄存器匹配报文
+ *
+ * @param rir 报文的标识符寄存器
+ * @param[out] fifo 放入的FIFO
+ * @param[out] fmi 过滤器编号
+ * @return 1: 匹配; 0: 丢弃
+ * @note 过滤器编号在每个FIFO中按过滤器组顺序计数, 包括未激活的组.
+ *       测试中的过滤器互不重叠, 不模拟多个过滤器匹配时的优先级
+ */
+static uint32_t sim_filter_match(uint32_t rir, uint32_t *fifo, uint32_t *fmi) {
+    /* 16位过滤器: STID[10:0], RTR, IDE, EXID[17:15] */
+    uint32_t r16 = ((rir >> CAN_RI0R_STID_Pos) << 5) |
+                   ((rir & CAN_RI0R_RTR) ? 0x10U : 0U) |
+                   ((rir & CAN_RI0R_IDE) ? 0x08U : 0U) | ((rir >> 18) & 7U);
+    uint32_t num[2] = {0, 0};
+
+    for (uint32_t bank = 0; bank < CAN_FILTER_BANKS; ++bank) {
+        uint32_t bit = 1UL << bank;
+        uint32_t f = (can_sim_regs.FFA1R & bit) ? 1U : 0U;
+        uint32_t wide = can_sim_regs.FS1R & bit;
+        uint32_t list = can_sim_regs.FM1R & bit;
+        uint32_t fr[2] = {can_sim_regs.sFilterRegister[bank].FR1,
+                          can_sim_regs.sFilterRegister[bank].FR2};
+        uint32_t per = wide ? (list ? 2U : 1U) : (list ? 4U : 2U);
+        uint32_t hit = 0;
+
+        for (uint32_t k = 0; (can_sim_regs.FA1R & bit) && (k < per); ++k) {
+            if (wide && list) {
+                hit = (rir == fr[k]);
+            } else if (wide) {
+                hit = (((rir ^ fr[0]) & fr[1]) == 0);
+            } else if (list) {
+                hit = (r16 == ((fr[k / 2U] >> (16U * (k % 2U))) & 0xFFFFU));
+            } else {
+                hit = (((r16 ^ fr[k]) & (fr[k] >> 16) & 0xFFFFU) == 0);
+            }
+
+            if (hit) {
+                *fifo = f;
+                *fmi = num[f] + k;
+                return 1;
+            }
+        }
+
+        num[f] += per;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief 报文经过滤器放入接收FIFO
+ *
+ * @return 放入的FIFO; 2: 没有匹配的过滤器
+ */
+static uint32_t sim_receive(uint32_t rir, uint32_t dlc, uint32_t rdlr,
+                            uint32_t rdhr) {
+    sim_rx_frame_t frame;
+    uint32_t fifo;
+    uint32_t fmi;
+
+    if (!sim_filter_match(rir, &fifo, &fmi)) {
+        return 2;
+    }
+
+    frame.rir = rir;
+    frame.rdtr = dlc | (fmi << CAN_RDT0R_FMI_Pos);
+    frame.rdlr = rdlr;
+    frame.rdhr = rdhr;
+    sim_fifo_push(fifo, &frame);
+
+    return fifo;
+}
+
+/**
+ * @brief 仲裁胜出的邮箱发送一帧, 回环到接收端, 然后进入发送完成中断
+ *
+ * @param rx_irq 1: 立即进入接收中断; 0: 推迟, 模拟中断延迟
+ * @return 0: 没有等待发送的邮箱
+ */
+static uint32_t sim_bus_transmit(uint32_t rx_irq) {
+    CAN_TxMailBox_TypeDef *mailbox;
+    uint32_t best = CAN_TX_MAILBOXES;
+    uint32_t fifo;
+    uint32_t tir;
+
+    /* 仲裁值相同时邮箱号小的先发送 */
+    for (uint32_t mb = 0; mb < CAN_TX_MAILBOXES; ++mb) {
+        if ((can_sim_regs.TSR & (CAN_TSR_TME0 << mb)) ||
+            ((best < CAN_TX_MAILBOXES) &&
+             (sim_arbitration(can_sim_regs.sTxMailBox[mb].TIR) >=
+              sim_arbitration(can_sim_regs.sTxMailBox[best].TIR)))) {
+            continue;
+        }
+        best = mb;
+    }
+    if (best == CAN_TX_MAILBOXES) {
+        return 0;
+    }
+
+    mailbox = &can_sim_regs.sTxMailBox[best];
+    tir = mailbox->TIR & ~CAN_TI0R_TXRQ;
+    CHECK(mailbox->TIR & CAN_TI0R_TXRQ);
+    mailbox->TIR = tir;
+
+    /* 同种报文按发送顺序上总线. 远程帧在总线上没有数据,
+     * 模拟器仍传递数据寄存器用于跟踪 */
+    CHECK((mailbox->TDHR & 0xFFU) < TX_ID_NUM);
+    CHECK(mailbox->TDLR > tx_last_seq[mailbox->TDHR & 0xFFU]);
+    tx_last_seq[mailbox->TDHR & 0xFFU] = mailbox->TDLR;
+    ++tx_bus_frames;
+
+    fifo = sim_receive(tir, mailbox->TDTR & CAN_TDT0R_DLC, mailbox->TDLR,
+                       mailbox->TDHR);
+    if (rx_irq && (fifo < 2)) {
+        sim_rx_irq(fifo);
+    }
+
+    SET_BIT(can_sim_regs.TSR, (CAN_TSR_TME0 << best) |
+                                  ((CAN_TSR_RQCP0 | CAN_TSR_TXOK0)
+                                   << (8U * best)));
+    sim_tsr_update();
+    USB_HP_CAN1_TX_IRQHandler();
+    CHECK(!(can_sim_regs.TSR & (CAN_TSR_RQCP0 << (8U * best))));
+
+    return 1;
+}
+
+/*****************************************************************************
+ * 过滤器
+ */
+
+/* 测试登记的过滤器, 互不重叠 */
+static struct {
+    uint32_t id;
+    uint32_t mask;
+    uint32_t flags;
+    uint32_t rx_class;
+} ref_filters[CAN_FILTER_MAX];
+
+static uint32_t ref_filter_num;
+
+static uint32_t ref_filter_add(uint32_t id, uint32_t mask, uint32_t flags,
+                               uint32_t rx_class) {
+    if (can_filter_add(id, mask, flags, rx_class) == 0) {
+        return 0;
+    }
+
+    CHECK(ref_filter_num < CAN_FILTER_MAX);
+    ref_filters[ref_filter_num].id = id;
+    ref_filters[ref_filter_num].mask = mask;
+    ref_filters[ref_filter_num].flags = flags;
+    ref_filters[ref_filter_num].rx_class = rx_class;
+    ++ref_filter_num;
+    return 1;
+}
+
+static void ref_filter_reset(void) {
+    can_filter_reset();
+    ref_filter_num = 0;
+}
+
+/**
+ * @brief 参考模型: 报文匹配的过滤器
+ *
+ * @return 过滤器序号; ref_filter_num: 没有匹配
+ */
+static uint32_t ref_filter_match(uint32_t id, uint32_t ide, uint32_t rtr) {
+    uint32_t found = ref_filter_num;
+
+    for (uint32_t i = 0; i < ref_filter_num; ++i) {
+        uint32_t ext = (ref_filters[i].flags & CAN_FILTER_FLAG_EXT) ? 1U : 0U;
+        uint32_t full = ext ? CAN_EXT_ID_MASK : CAN_STD_ID_MASK;
+        uint32_t mask = ref_filters[i].mask;
+
+        /* 列表类型只接收数据帧, 掩码类型不检查RTR */
+        if ((ext != ide) || ((mask == full) && rtr) ||
+            (((ref_filters[i].id ^ id) & mask) != 0)) {
+            continue;
+        }
+        CHECK(found == ref_filter_num);
+        found = i;
+    }
+
+    return found;
+}
+
+/**
+ * @brief 报文送入接收端, 检查放入的类别和FIFO与参考模型一致
+ */
+static void probe(uint32_t id, uint32_t ide, uint32_t rtr) {
+    uint32_t expect = ref_filter_match(id, ide, rtr);
+    uint32_t fifo = sim_receive(frame_ir(id, ide, rtr), 5, id, ~id);
+    can_frame_t frame;
+
+    if (expect == ref_filter_num) {
+        CHECK(fifo == 2);
+        return;
+    }
+
+    CHECK(fifo == ((ref_filters[expect].flags & CAN_FILTER_FLAG_FIFO1) ? 1U
+                                                                       : 0U));
+    sim_rx_irq(fifo);
+
+    for (uint32_t c = 0; c < CAN_RX_CLASS_NUM; ++c) {
+        if (c != ref_filters[expect].rx_class) {
+            CHECK(can_rx_count(c) == 0);
+            continue;
+        }
+
+        CHECK(can_receive(c, &frame) == 1);
+        CHECK((frame.id == id) && (frame.ide == ide) && (frame.rtr == rtr));
+        CHECK((frame.fifo == fifo) && (frame.dlc == 5));
+        CHECK(memcmp(frame.data, &id, sizeof(id)) == 0);
+        CHECK(can_rx_count(c) == 0);
+    }
+}
+
+/**
+ * @brief 过滤器组容量和参数检查
+ */
+static void test_filter_capacity(void) {
+    ref_filter_reset();
+
+    CHECK(ref_filter_add(0x800, CAN_STD_ID_MASK, 0, 0) == 0);
+    CHECK(ref_filter_add(0x001, CAN_STD_ID_MASK, 0, CAN_RX_CLASS_NUM) == 0);
+    CHECK(ref_filter_add(0x20000000, 0, CAN_FILTER_FLAG_EXT, 0) == 0);
+
+    /* 16位列表每组4个, 两个FIFO各一半时正好用完全部过滤器 */
+    for (uint32_t i = 0; i < CAN_FILTER_MAX; ++i) {
+        CHECK(ref_filter_add(i * 3U, CAN_STD_ID_MASK,
+                             (i & 4U) ? CAN_FILTER_FLAG_FIFO1 : 0U,
+                             i % CAN_RX_CLASS_NUM));
+    }
+    CHECK(ref_filter_add(0x7FF, CAN_STD_ID_MASK, 0, 0) == 0);
+    for (uint32_t id = 0; id < CAN_FILTER_MAX * 3U + 8U; ++id) {
+        probe(id, 0, 0);
+        probe(id, 0, 1);
+        probe(id, 1, 0);
+    }
+
+    /* 32位掩码每组1个 */
+    ref_filter_reset();
+    for (uint32_t i = 0; i < CAN_FILTER_BANKS; ++i) {
+        CHECK(ref_filter_add(0x10000000U | (i << 8), 0x1FFFFF00U,
+                             CAN_FILTER_FLAG_EXT |
+                                 ((i & 1U) ? CAN_FILTER_FLAG_FIFO1 : 0U),
+                             i % CAN_RX_CLASS_NUM));
+    }
+    CHECK(ref_filter_add(0x0FFFFF00U, 0x1FFFFF00U, CAN_FILTER_FLAG_EXT, 0) ==
+          0);
+    for (uint32_t i = 0; i < CAN_FILTER_BANKS + 2U; ++i) {
+        probe(0x10000000U | (i << 8) | (i * 37U & 0xFFU), 1, i & 1U);
+    }
+}
+
+/**
+ * @brief 随机登记互不重叠的过滤器直到过滤器组不足, 检查过滤器编号到类别的
+ *        映射
+ *
+ * @note 标准帧列表ID在0x000~0x1FF, 标准帧掩码每块16个ID在0x200~0x7FF;
+ *       扩展帧列表ID在0x00000~0xFFFFF, 扩展帧掩码每块256个ID从0x10000000开始
+ */
+static void test_filter_map(void) {
+    static uint8_t std_used[0x200];
+    static uint8_t std_block[96];
+    static uint8_t ext_block[4096];
+    uint32_t id;
+    uint32_t k;
+
+    for (uint32_t round = 0; round < 200; ++round) {
+        memset(std_used, 0, sizeof(std_used));
+        memset(std_block, 0, sizeof(std_block));
+        memset(ext_block, 0, sizeof(ext_block));
+        ref_filter_reset();
+
+        for (uint32_t tries = 0; tries < 80; ++tries) {
+            uint32_t flags = (rand() % 2) ? CAN_FILTER_FLAG_FIFO1 : 0U;
+            uint32_t rx_class = (uint32_t)rand() % CAN_RX_CLASS_NUM;
+
+            switch (rand() % 4) {
+                case 0: {
+                    id = (uint32_t)rand() % 0x200U;
+                    if (!std_used[id] &&
+                        ref_filter_add(id, CAN_STD_ID_MASK, flags, rx_class)) {
+                        std_used[id] = 1;
+                    }
+                } break;
+
+                case 1: {
+                    k = (uint32_t)rand() % sizeof(std_block);
+                    if (!std_block[k] &&
+                        ref_filter_add(0x200U + k * 16U, 0x7F0, flags,
+                                       rx_class)) {
+                        std_block[k] = 1;
+                    }
+                } break;
+
+                case 2: {
+                    id = (uint32_t)rand() % 0x100000U;
+                    if (ref_filter_match(id, 1, 0) == ref_filter_num) {
+                        ref_filter_add(id, CAN_EXT_ID_MASK,
+                                       flags | CAN_FILTER_FLAG_EXT, rx_class);
+                    }
+                } break;
+
+                default: {
+                    k = (uint32_t)rand() % sizeof(ext_block);
+                    if (!ext_block[k] &&
+                        ref_filter_add(0x10000000U | (k << 8), 0x1FFFFF00U,
+                                       flags | CAN_FILTER_FLAG_EXT,
+                                       rx_class)) {
+                        ext_block[k] = 1;
+                    }
+                } break;
+            }
+        }
+
+        for (uint32_t n = 0; n < 500; ++n) {
+            uint32_t ide;
+
+            /* 一半命中登记的过滤器, 一半随机 */
+            if ((rand() % 2) && (ref_filter_num != 0)) {
+                k = (uint32_t)rand() % ref_filter_num;
+                ide = (ref_filters[k].flags & CAN_FILTER_FLAG_EXT) ? 1U : 0U;
+                id = ref_filters[k].id |
+                     ((uint32_t)rand() & ~ref_filters[k].mask &
+                      (ide ? CAN_EXT_ID_MASK : CAN_STD_ID_MASK));
+                ide ^= (rand() % 8 == 0);
+            } else {
+                ide = (uint32_t)rand() % 2U;
+                id = (uint32_t)rand();
+            }
+
+            id &= ide ? CAN_EXT_ID_MASK : CAN_STD_ID_MASK;
+            probe(id, ide, (rand() % 8 == 0));
+        }
+    }
+}
+
+/*****************************************************************************
+ * 发送
+ */
+
+static uint32_t rx_last_seq[TX_ID_NUM];
+static uint32_t rx_frames;
+
+/**
+ * @brief 读出接收队列, 每种报文的序号递增, 中间的缺失为溢出或队列满丢弃
+ */
+static void rx_drain(void) {
+    can_frame_t frame;
+    uint32_t seq;
+    uint32_t idx;
+
+    for (uint32_t c = 0; c < CAN_RX_CLASS_NUM; ++c) {
+        while (can_receive(c, &frame)) {
+            memcpy(&seq, frame.data, sizeof(seq));
+            idx = frame.data[4];
+
+            CHECK(idx < TX_ID_NUM);
+            CHECK(c == tx_ids[idx].ide);
+            CHECK(frame.fifo == tx_ids[idx].ide);
+            CHECK((frame.id == tx_ids[idx].id) &&
+                  (frame.ide == tx_ids[idx].ide) &&
+                  (frame.rtr == tx_ids[idx].rtr) && (frame.dlc == 8));
+            CHECK(seq > rx_last_seq[idx]);
+            rx_last_seq[idx] = seq;
+            ++rx_frames;
+        }
+    }
+}
+
+/**
+ * @brief 随机发送和总线发送交替进行, 发送的报文全部回环接收
+ */
+static void test_tx_order(void) {
+    can_frame_t frame = {.dlc = 8};
+    can_stats_t stats;
+    uint32_t seq = 0;
+    uint32_t accepted = 0;
+    uint32_t idx;
+
+    ref_filter_reset();
+    CHECK(ref_filter_add(0, 0, 0, 0));
+    CHECK(ref_filter_add(0, 0, CAN_FILTER_FLAG_EXT | CAN_FILTER_FLAG_FIFO1, 1));
+
+    can_sim_regs.TSR = CAN_TSR_TME0 | CAN_TSR_TME1 | CAN_TSR_TME2;
+    sim_tsr_update();
+    can_get_stats(&stats, 1);
+
+    CHECK(can_send(&frame) == 0);
+    can_start();
+
+    for (uint32_t it = 0; it < 300000; ++it) {
+        switch (rand() % 10) {
+            case 0:
+            case 1:
+            case 2:
+            case 3:
+            case 4: {
+                /* 先记录, can_send中就可能放入邮箱 */
+                idx = (uint32_t)rand() % TX_ID_NUM;
+                frame.id = tx_ids[idx].id;
+                frame.ide = tx_ids[idx].ide;
+                frame.rtr = tx_ids[idx].rtr;
+                ++seq;
+                memcpy(frame.data, &seq, sizeof(seq));
+                frame.data[4] = (uint8_t)idx;
+
+                tx_pending[tx_pending_num].arb = sim_arbitration(frame_ir(
+                    frame.id, frame.ide, frame.rtr));
+                tx_pending[tx_pending_num].seq = seq;
+                ++tx_pending_num;
+
+                if (can_send(&frame)) {
+                    ++accepted;
+                } else {
+                    /* 只有队列满时拒绝, 报文不能已放入邮箱 */
+                    CHECK(tx_pending[tx_pending_num - 1U].seq == seq);
+                    --tx_pending_num;
+                    CHECK(can_tx_count == CAN_TX_QUEUE_SIZE);
+                }
+            } break;
+
+            case 5:
+            case 6:
+            case 7:
+            case 8: {
+                sim_bus_transmit(rand() % 2);
+            } break;
+
+            default: {
+                sim_rx_irq(0);
+                sim_rx_irq(1);
+                rx_drain();
+            } break;
+        }
+
+        tx_check_idle();
+    }
+
+    while (sim_bus_transmit(1)) {
+    }
+    sim_rx_irq(0);
+    sim_rx_irq(1);
+    rx_drain();
+
+    can_get_stats(&stats, 0);
+    printf("sent %u, refused %u, overwritten %u, queue drops %u, peak %u\n",
+           (unsigned int)accepted, (unsigned int)stats.tx_drops,
+           (unsigned int)sim_overwritten, (unsigned int)stats.rx_drops,
+           (unsigned int)stats.tx_queue_peak);
+
+    CHECK(tx_pending_num == 0);
+    CHECK(can_tx_count == 0);
+    CHECK(tx_bus_frames == accepted);
+    CHECK(stats.tx_frames == accepted);
+    CHECK(stats.tx_drops == seq - accepted);
+    CHECK(stats.tx_queue_peak == CAN_TX_QUEUE_SIZE);
+    CHECK(stats.rx_frames == rx_frames);
+    CHECK(rx_frames + stats.rx_drops + sim_overwritten == accepted);
+    CHECK((stats.rx_overruns != 0) == (sim_overwritten != 0));
+
+    can_stop();
+    CHECK(can_send(&frame) == 0);
+}
+
+int main(void) {
+    srand(24);
+
+    can_init();
+
+    test_filter_capacity();
+    test_filter_map();
+    test_tx_order();
+
+    printf("can_sim_test: pass\n");
+    return 0;
+}
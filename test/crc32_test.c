@@ -0,0 +1,197 @@
+/**
+ * @file    crc32_test.c
+ * @author  Deadline039
+ * @brief   crc32软件计算和CRC单元计算的单元测试
+ * @version 1.0
+ * @date    2026-10-18
+ *
+ * 用逐位计算的参考实现校验查表实现: 标准CRC-32的校验值, 任意起始对齐和
+ * 长度(包括不足4字节的尾部)以及分段计算; CRC单元原生的按字CRC.
+ * CRC单元由模拟器逐位计算, 校验crc32_calc和crc32_word_calc在使用CRC单元,
+ * 单元被占用和未初始化时的结果都与软件计算相同.
+ * 直接包含crc32.c, 通过CRC32_REGS等宏接入模拟器. DMA写入只能在目标板上
+ * 测试(crc32_benchmark), 这里关闭.
+ */
+
+#include "crc32.h"
+
+#undef CRC32_USE_DMA
+#define CRC32_USE_DMA 0
+
+#include "stm32f1xx_hal.h"
+
+static CRC_TypeDef crc_sim_regs;
+static uint32_t crc_sim_words;
+
+static void crc_sim_write(uint32_t word);
+static void crc_sim_reset(void);
+
+#define CRC32_REGS           (&crc_sim_regs)
+#define CRC32_HW_WRITE(word) crc_sim_write(word)
+#define CRC32_HW_RESET()     crc_sim_reset()
+
+#include "crc32.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHECK(cond)                                                            \
+    do {                                                                       \
+        if (!(cond)) {                                                         \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);    \
+            exit(1);                                                           \
+        }                                                                      \
+    } while (0)
+
+/*****************************************************************************
+ * 参考实现
+ */
+
+/**
+ * @brief 逐位计算标准CRC-32
+ */
+static uint32_t ref_crc32(const uint8_t *data, uint32_t len) {
+    uint32_t crc = 0xFFFFFFFFU;
+
+    while (len--) {
+        crc ^= *data++;
+        for (uint32_t i = 0; i < 8; ++i) {
+            crc = (crc >> 1) ^ ((crc & 1U) ? 0xEDB88320U : 0);
+        }
+    }
+
+    return ~crc;
+}
+
+/**
+ * @brief 逐位计算一个字, 多项式0x04C11DB7, 高位在前
+ */
+static uint32_t ref_word_update(uint32_t crc, uint32_t word) {
+    crc ^= word;
+    for (uint32_t i = 0; i < 32; ++i) {
+        crc = (crc << 1) ^ ((crc & 0x80000000U) ? 0x04C11DB7U : 0);
+    }
+
+    return crc;
+}
+
+static uint32_t ref_word(const uint32_t *data, uint32_t nwords) {
+    uint32_t crc = 0xFFFFFFFFU;
+
+    while (nwords--) {
+        crc = ref_word_update(crc, *data++);
+    }
+
+    return crc;
+}
+
+/*****************************************************************************
+ * 模拟CRC单元
+ */
+
+static void crc_sim_write(uint32_t word) {
+    crc_sim_regs.DR = ref_word_update(crc_sim_regs.DR, word);
+    ++crc_sim_words;
+}
+
+static void crc_sim_reset(void) {
+    crc_sim_regs.DR = CRC32_WORD_INIT;
+}
+
+/*****************************************************************************
+ * 测试
+ */
+
+static uint32_t test_buf[80];
+
+static void test_check_value(void) {
+    static const char check[] = "123456789";
+
+    CHECK(ref_crc32((const uint8_t *)check, 9) == 0xCBF43926U);
+    CHECK(crc32_soft_update(0, check, 9) == 0xCBF43926U);
+
+    crc_sim_words = 0;
+    CHECK(crc32_calc(check, 9) == 0xCBF43926U);
+    CHECK(crc_sim_words == 2);
+
+    CHECK(crc32_calc(check, 0) == 0);
+    CHECK(crc32_soft_update(0, check, 0) == 0);
+}
+
+/**
+ * @brief 每种起始对齐和长度, 尾部0~3字节
+ */
+static void test_bytes(void) {
+    const uint8_t *base = (const uint8_t *)test_buf;
+
+    for (uint32_t off = 0; off < 4; ++off) {
+        for (uint32_t len = 0; len <= 67; ++len) {
+            uint32_t ref = ref_crc32(base + off, len);
+
+            CHECK(crc32_soft_update(0, base + off, len) == ref);
+
+            crc_sim_words = 0;
+            CHECK(crc32_calc(base + off, len) == ref);
+            CHECK(crc_sim_words == len / 4U);
+
+            /* 分段计算 */
+            for (uint32_t cut = 0; cut <= len; cut += 5) {
+                uint32_t crc = crc32_soft_update(0, base + off, cut);
+                CHECK(crc32_soft_update(crc, base + off + cut, len - cut) ==
+                      ref);
+            }
+        }
+    }
+}
+
+static void test_words(void) {
+    const uint32_t nwords = sizeof(test_buf) / sizeof(test_buf[0]);
+
+    for (uint32_t n = 0; n <= nwords; ++n) {
+        uint32_t ref = ref_word(test_buf, n);
+
+        CHECK(crc32_word_soft(test_buf, n) == ref);
+
+        crc_sim_words = 0;
+        CHECK(crc32_word_calc(test_buf, n) == ref);
+        CHECK(crc_sim_words == n);
+    }
+}
+
+/**
+ * @brief CRC单元被占用或未初始化时由软件计算, 结果相同
+ */
+static void test_fallback(void) {
+    const uint8_t *base = (const uint8_t *)test_buf;
+
+    for (uint32_t state = 0; state < 2; ++state) {
+        crc32_hw_busy = (state == 0);
+        crc32_hw_ready = (state != 0) ? 0 : 1;
+        crc_sim_words = 0;
+
+        CHECK(crc32_calc(base + 1, 63) == ref_crc32(base + 1, 63));
+        CHECK(crc32_word_calc(test_buf, 16) == ref_word(test_buf, 16));
+        CHECK(crc_sim_words == 0);
+    }
+
+    crc32_hw_busy = 0;
+    crc32_hw_ready = 1;
+}
+
+int main(void) {
+    srand(15);
+    for (uint32_t i = 0; i < sizeof(test_buf) / sizeof(test_buf[0]); ++i) {
+        test_buf[i] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+    }
+
+    /* crc32_init只打开时钟, 在主机上直接标记CRC单元可用 */
+    crc32_hw_ready = 1;
+
+    test_check_value();
+    test_bytes();
+    test_words();
+    test_fallback();
+
+    printf("crc32_test: pass\n");
+    return 0;
+}
@@ -0,0 +1,268 @@
+/**
+ * @file    dma_uart_rx_test.c
+ * @author  Deadline039
+ * @brief   串口DMA直接接收到fifo时溢出和重新同步的主机模拟测试
+ * @version 1.0
+ * @date    2026-10-18
+ *
+ * 模拟循环DMA把数据写入fifo存储区, 按硬件顺序产生半满, 溢满和空闲中断.
+ * 读取方不及时读出时DMA覆盖未读出的数据, 检查溢出的一段整段丢弃,
+ * 溢出后接收中断不再提交, 下一次读出和按行读出从溢出后收到的数据开始,
+ * 与发送的数据对齐.
+ * 直接包含dma_uart.c, 串口1改为DMA直接接收到fifo, 寄存器由模拟器实现.
+ */
+
+#include "uart.h"
+
+/* 串口1改为DMA直接接收到fifo, fifo较小以便制造溢出 */
+#undef USART1_USE_DMA_RX
+#define USART1_USE_DMA_RX        1
+#define USART1_RX_BUF_SIZE       64
+#define USART1_RX_FIFO_SZIE      64
+#define USART1_DMA_RX_TO_FIFO    1
+#define USART1_DMA_RX_PRIORITY   DMA_PRIORITY_HIGH
+#define USART1_DMA_RX_IT_PREEMPT 0
+#define USART1_DMA_RX_IT_SUB     0
+#define USART1_USE_IDLE_IT       1
+#define USART1_RX_COALESCE_BATCH 0
+#define USART1_RX_COALESCE_US    1000
+
+static RCC_TypeDef sim_rcc;
+static DMA_Channel_TypeDef sim_dma_channel;
+
+/* 串口编号取外设地址的第10~13位, 模拟的串口1寄存器放在对应的偏移处 */
+static uint8_t sim_periph[16 * 1024] __attribute__((aligned(16 * 1024)));
+#define SIM_USART1                                                             \
+    ((USART_TypeDef *)(sim_periph + (UART_PORT_INDEX(USART1_BASE) << 10)))
+
+#undef RCC
+#define RCC (&sim_rcc)
+#undef DMA1_Channel5
+#define DMA1_Channel5 (&sim_dma_channel)
+
+#include "dma_uart.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHECK(cond)                                                            \
+    do {                                                                       \
+        if (!(cond)) {                                                         \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);    \
+            exit(1);                                                           \
+        }                                                                      \
+    } while (0)
+
+UART_HandleTypeDef usart1_handle;
+
+/*****************************************************************************
+ * HAL
+ */
+
+uint32_t HAL_GetTick(void) {
+    return 0;
+}
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma) {
+    return HAL_OK;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority,
+                          uint32_t SubPriority) {
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn) {
+}
+
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma) {
+}
+
+HAL_StatusTypeDef
+HAL_UART_RegisterCallback(UART_HandleTypeDef *huart,
+                          HAL_UART_CallbackIDTypeDef CallbackID,
+                          pUART_CallbackTypeDef pCallback) {
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart,
+                                       uint8_t *pData, uint16_t Size) {
+    huart->pRxBuffPtr = pData;
+    huart->RxXferSize = Size;
+    huart->hdmarx->Instance->CNDTR = Size;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart,
+                                        const uint8_t *pData, uint16_t Size) {
+    return HAL_ERROR;
+}
+
+/*****************************************************************************
+ * 模拟DMA接收
+ */
+
+/**
+ * @brief 对端发送一段数据, 发送结束后产生空闲中断
+ */
+static void sim_receive(const char *data, uint32_t len) {
+    UART_HandleTypeDef *huart = &usart1_handle;
+
+    for (uint32_t i = 0; i < len; ++i) {
+        uint32_t pos = huart->RxXferSize - sim_dma_channel.CNDTR;
+
+        huart->pRxBuffPtr[pos] = (uint8_t)data[i];
+        if (--sim_dma_channel.CNDTR == huart->RxXferSize / 2U) {
+            uart_dmarx_halfdone_callback(huart);
+        } else if (sim_dma_channel.CNDTR == 0) {
+            sim_dma_channel.CNDTR = huart->RxXferSize;
+            uart_dmarx_done_callback(huart);
+        }
+    }
+
+    uart_dmarx_idle_callback(huart);
+}
+
+static void sim_receive_str(const char *str) {
+    sim_receive(str, strlen(str));
+}
+
+/**
+ * @brief 对端发送一段填充数据
+ */
+static void sim_receive_fill(char c, uint32_t len) {
+    char buf[USART1_RX_FIFO_SZIE];
+
+    memset(buf, c, len);
+    sim_receive(buf, len);
+}
+
+static uart_stats_t sim_stats(void) {
+    uart_stats_t stats;
+
+    uart_get_stats(&usart1_handle, &stats, 0);
+    return stats;
+}
+
+/*****************************************************************************
+ * 测试
+ */
+
+static void test_normal(void) {
+    char buf[USART1_RX_FIFO_SZIE];
+
+    /* 多次回绕, 每次都及时读出 */
+    for (uint32_t i = 0; i < 40; ++i) {
+        char line[16];
+        uint32_t len = (uint32_t)snprintf(line, sizeof(line), "line%u\n", i);
+
+        sim_receive(line, len);
+        CHECK(uart_readline(&usart1_handle, buf, sizeof(buf), 0) == len);
+        CHECK(memcmp(buf, line, len) == 0);
+    }
+
+    CHECK(sim_stats().rx_overruns == 0);
+    CHECK(sim_stats().rx_drops == 0);
+}
+
+/**
+ * @brief 溢出的一段整段丢弃, 不提交其中一部分
+ */
+static void test_no_partial_commit(void) {
+    uart_rx_fifo_t *uart_rx_fifo = uart_rx_identify(&usart1_handle);
+    char buf[USART1_RX_FIFO_SZIE];
+
+    sim_receive_fill('a', 60);
+    CHECK(ring_fifo_count(uart_rx_fifo->rx_fifo) == 60);
+
+    /* 只剩4字节空间, 8字节中的前4字节已经覆盖了最早的未读数据 */
+    sim_receive_fill('b', 8);
+    CHECK(uart_rx_fifo->overrun);
+    CHECK(ring_fifo_count(uart_rx_fifo->rx_fifo) == 60);
+    CHECK(sim_stats().rx_overruns == 1);
+    CHECK(sim_stats().rx_drops == 8);
+
+    /* 溢出后读出之前收到的数据同样不提交, 溢出只计一次 */
+    sim_receive_fill('c', 20);
+    CHECK(ring_fifo_count(uart_rx_fifo->rx_fifo) == 60);
+    CHECK(sim_stats().rx_overruns == 1);
+    CHECK(sim_stats().rx_drops == 28);
+
+    /* 读出时重新同步, 之前的数据全部丢弃 */
+    CHECK(uart_dmarx_read(&usart1_handle, buf, sizeof(buf)) == 0);
+    CHECK(!uart_rx_fifo->overrun);
+
+    sim_receive_str("0123456789");
+    CHECK(uart_dmarx_read(&usart1_handle, buf, sizeof(buf)) == 10);
+    CHECK(memcmp(buf, "0123456789", 10) == 0);
+}
+
+/**
+ * @brief 溢出后按行读出, 行尾位置与数据对齐
+ */
+static void test_readline_after_overrun(void) {
+    uart_rx_fifo_t *uart_rx_fifo = uart_rx_identify(&usart1_handle);
+    char buf[USART1_RX_FIFO_SZIE];
+
+    for (uint32_t i = 0; i < 9; ++i) {
+        /* 每行8字节, 8行正好填满fifo, 第9行溢出 */
+        char line[16];
+        snprintf(line, sizeof(line), "old%04u\n", i);
+        sim_receive_str(line);
+    }
+
+    /* 溢出前的行尾都在未读数据中 */
+    CHECK(uart_rx_fifo->overrun);
+    CHECK(uart_rx_fifo->line_in - uart_rx_fifo->line_out == 8);
+
+    sim_receive_str("drop\n");
+    CHECK(uart_rx_fifo->line_in - uart_rx_fifo->line_out == 8);
+
+    CHECK(uart_readline(&usart1_handle, buf, sizeof(buf), 0) == 0);
+    CHECK(uart_rx_fifo->line_in == uart_rx_fifo->line_out);
+
+    sim_receive_str("new0\nnew1\n");
+    CHECK(uart_readline(&usart1_handle, buf, sizeof(buf), 0) == 5);
+    CHECK(memcmp(buf, "new0\n", 5) == 0);
+    CHECK(uart_readline(&usart1_handle, buf, sizeof(buf), 0) == 5);
+    CHECK(memcmp(buf, "new1\n", 5) == 0);
+    CHECK(uart_dmarx_read(&usart1_handle, buf, sizeof(buf)) == 0);
+}
+
+/**
+ * @brief 溢出后读出之前, 在最近一次接收中断之后收到的数据保留
+ */
+static void test_resync_keeps_pending(void) {
+    UART_HandleTypeDef *huart = &usart1_handle;
+    char buf[USART1_RX_FIFO_SZIE];
+
+    sim_receive_fill('x', 64);
+    sim_receive_fill('y', 4);
+    CHECK(uart_rx_identify(huart)->overrun);
+
+    /* 数据还在传输, 没有产生空闲中断 */
+    for (const char *p = "tail"; *p != '\0'; ++p) {
+        uint32_t pos = huart->RxXferSize - sim_dma_channel.CNDTR;
+        huart->pRxBuffPtr[pos] = (uint8_t)*p;
+        --sim_dma_channel.CNDTR;
+    }
+
+    CHECK(uart_dmarx_read(huart, buf, sizeof(buf)) == 0);
+    uart_dmarx_idle_callback(huart);
+    CHECK(uart_dmarx_read(huart, buf, sizeof(buf)) == 4);
+    CHECK(memcmp(buf, "tail", 4) == 0);
+}
+
+int main(void) {
+    usart1_handle.Instance = SIM_USART1;
+    uart_dmarx_init(&usart1_handle);
+    CHECK(usart1_handle.pRxBuffPtr == usart1_rx_fifo_buf);
+    uart_dmarx_set_delim(&usart1_handle, '\n');
+
+    test_normal();
+    test_no_partial_commit();
+    test_readline_after_overrun();
+    test_resync_keeps_pending();
+
+    printf("dma_uart_rx_test: pass\n");
+    return 0;
+}
@@ -0,0 +1,413 @@
+/**
+ * @file    kv_sim_test.c
+ * @author  Deadline039
+ * @brief   kv在模拟Flash上的掉电测试
+ * @version 1.0
+ * @date    2026-10-18
+ *
+ * 模拟Flash按STM32F1的限制擦写: 按半字写入, 只能写入已擦除(0xFFFF)的半字
+ * 或写为0x0000, 按页擦除. 掉电时正在写入的半字只清零了一部分位,
+ * 正在擦除的页只擦除了一部分半字.
+ *
+ * 从空白存储区执行一段包含写入, 删除和垃圾回收的固定操作序列,
+ * 依次在第1, 2, 3...次擦写时掉电, 其中一部分在重启恢复时再次掉电.
+ * 重启后正在进行的操作的键为旧值或新值, 其他键与参考模型一致,
+ * 然后继续执行剩下的操作, 最后再与参考模型比对.
+ * 直接包含kv.c, 通过KV_FLASH_SIM接入模拟Flash.
+ */
+
+#include "kv.h"
+#include "stm32f1xx_hal.h"
+
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KV_FLASH_SIM
+
+static uint32_t sim_flash[KV_PAGE_NUM * KV_PAGE_SIZE / sizeof(uint32_t)];
+
+#define KV_FLASH_MEM ((const uint8_t *)sim_flash)
+
+static HAL_StatusTypeDef kv_hw_erase(const uint8_t *p);
+static HAL_StatusTypeDef kv_hw_program(const uint8_t *p, uint16_t data);
+
+#include "kv.c"
+
+#define CHECK(cond)                                                            \
+    do {                                                                       \
+        if (!(cond)) {                                                         \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);    \
+            exit(1);                                                           \
+        }                                                                      \
+    } while (0)
+
+/*****************************************************************************
+ * 模拟Flash
+ */
+
+static jmp_buf sim_power;
+static uint32_t sim_budget; /* 到第几次擦写时掉电, 0为不掉电 */
+static uint32_t sim_steps;  /* 擦写次数 */
+static uint32_t sim_erase_cut; /* 1: 在擦除时掉电 */
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void) {
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void) {
+    return HAL_OK;
+}
+
+/**
+ * @brief 模拟Flash中的半字
+ */
+static uint16_t *sim_cell(const uint8_t *p) {
+    uint32_t off = (uint32_t)(p - (const uint8_t *)sim_flash);
+
+    CHECK((p >= (const uint8_t *)sim_flash) && (off < sizeof(sim_flash)));
+    CHECK((off % 2U) == 0);
+
+    return (uint16_t *)sim_flash + off / 2U;
+}
+
+/**
+ * @brief 计一次擦写
+ *
+ * @return 1: 本次擦写进行中掉电
+ */
+static uint32_t sim_step(void) {
+    ++sim_steps;
+    return (sim_budget != 0) && (--sim_budget == 0);
+}
+
+static HAL_StatusTypeDef kv_hw_program(const uint8_t *p, uint16_t data) {
+    uint16_t *cell = sim_cell(p);
+
+    /* 写入未擦除的半字: PGERR, 不写入 */
+    if ((*cell != 0xFFFFU) && (data != 0)) {
+        return HAL_ERROR;
+    }
+
+    if (sim_step()) {
+        /* 需要清零的位只清零了一部分 */
+        *cell &= (uint16_t)~((uint16_t)rand() & (uint16_t)~data);
+        longjmp(sim_power, 1);
+    }
+
+    *cell = data;
+    return HAL_OK;
+}
+
+static HAL_StatusTypeDef kv_hw_erase(const uint8_t *p) {
+    uint16_t *cell = sim_cell(p);
+    uint32_t erased;
+
+    CHECK(((p - (const uint8_t *)sim_flash) % KV_PAGE_SIZE) == 0);
+
+    if (sim_step()) {
+        sim_erase_cut = 1;
+
+        /* 0~3/4的半字已擦除 */
+        erased = (uint32_t)rand() % 4U;
+        for (uint32_t i = 0; i < KV_PAGE_SIZE / 2U; ++i) {
+            if ((uint32_t)rand() % 4U < erased) {
+                cell[i] = 0xFFFFU;
+            }
+        }
+        longjmp(sim_power, 1);
+    }
+
+    memset(cell, 0xFF, KV_PAGE_SIZE);
+    return HAL_OK;
+}
+
+/**
+ * @brief 按字计算CRC32, 多项式与硬件CRC单元相同
+ */
+uint32_t crc32_word_calc(const uint32_t *data, uint32_t nwords) {
+    uint32_t crc = 0xFFFFFFFFU;
+
+    for (uint32_t i = 0; i < nwords; ++i) {
+        crc ^= data[i];
+        for (uint32_t bit = 0; bit < 32; ++bit) {
+            crc = (crc << 1) ^ ((crc & 0x80000000U) ? 0x04C11DB7U : 0U);
+        }
+    }
+
+    return crc;
+}
+
+/*****************************************************************************
+ * 参考模型
+ */
+
+#define KEY_NUM      24U
+#define LEN_MAX      100U
+#define ERASE_REPEAT 64U
+
+static uint8_t ref_value[KEY_NUM][LEN_MAX];
+static int32_t ref_len[KEY_NUM]; /* -1: 不存在 */
+
+/* 正在进行的操作 */
+static uint32_t op_key;
+static uint8_t op_value[LEN_MAX];
+static int32_t op_len;
+
+static uint16_t key_of(uint32_t k) {
+    return (uint16_t)(k * 0x0101U + 1U);
+}
+
+static void ref_reset(void) {
+    for (uint32_t k = 0; k < KEY_NUM; ++k) {
+        ref_len[k] = -1;
+    }
+}
+
+static void ref_apply(uint32_t k, const uint8_t *value, int32_t len) {
+    ref_len[k] = len;
+    if (len > 0) {
+        memcpy(ref_value[k], value, (uint32_t)len);
+    }
+}
+
+/**
+ * @brief 读出的值与value相同
+ *
+ * @param len 值的长度, -1为不存在
+ */
+static uint32_t kv_equal(uint32_t k, const uint8_t *value, int32_t len) {
+    uint8_t buf[KV_VALUE_MAX];
+    uint16_t got = 0;
+    kv_status_t res = kv_get(key_of(k), buf, sizeof(buf), &got);
+
+    if (len < 0) {
+        return res == KV_ERR_NOT_FOUND;
+    }
+
+    return (res == KV_OK) && (got == (uint16_t)len) &&
+           (memcmp(buf, value, got) == 0);
+}
+
+/**
+ * @brief 与参考模型比对
+ *
+ * @param pending 1: 正在进行的操作的键可以为新值, 是新值时更新参考模型
+ */
+static void ref_verify(uint32_t pending) {
+    kv_stats_t stats;
+    uint32_t keys = 0;
+
+    for (uint32_t k = 0; k < KEY_NUM; ++k) {
+        if (pending && (k == op_key) &&
+            !kv_equal(k, ref_value[k], ref_len[k])) {
+            CHECK(kv_equal(k, op_value, op_len));
+            ref_apply(k, op_value, op_len);
+        }
+        CHECK(kv_equal(k, ref_value[k], ref_len[k]));
+        keys += (ref_len[k] >= 0);
+    }
+
+    kv_get_stats(&stats);
+    CHECK(stats.keys == keys);
+}
+
+/*****************************************************************************
+ * 操作序列
+ */
+
+static uint32_t script_state;
+
+/**
+ * @brief 操作序列使用的随机数, 与掉电时的随机数分开, 保证每次序列相同
+ */
+static uint32_t script_rand(void) {
+    script_state = script_state * 1103515245U + 12345U;
+    return script_state >> 8;
+}
+
+/**
+ * @brief 执行第n个操作: 7/10写入, 3/10删除
+ */
+static void script_op(void) {
+    kv_status_t res;
+
+    op_key = script_rand() % KEY_NUM;
+
+    if (script_rand() % 10U < 7U) {
+        op_len = (int32_t)(script_rand() % (LEN_MAX + 1U));
+        for (int32_t i = 0; i < op_len; ++i) {
+            op_value[i] = (uint8_t)script_rand();
+        }
+        res = kv_set(key_of(op_key), op_value, (uint16_t)op_len);
+        CHECK(res == KV_OK);
+    } else {
+        op_len = -1;
+        res = kv_delete(key_of(op_key));
+        CHECK(res == (kv_status_t)((ref_len[op_key] < 0) ? KV_ERR_NOT_FOUND
+                                                        : KV_OK));
+    }
+
+    ref_apply(op_key, op_value, op_len);
+}
+
+/* 在setjmp和longjmp之间修改, 不使用局部变量 */
+static uint32_t run_op;
+
+/**
+ * @brief 从空白存储区执行ops个操作
+ *
+ * @param cut 在第cut次擦写时掉电, 0为不掉电
+ * @param recover_cut 重启恢复时在第recover_cut次擦写时再次掉电, 0为不掉电
+ * @return 1: 发生了掉电
+ */
+static uint32_t run(uint32_t ops, uint32_t cut, uint32_t recover_cut) {
+    volatile uint32_t lost = 0;
+
+    memset(sim_flash, 0xFF, sizeof(sim_flash));
+    ref_reset();
+    script_state = 25;
+    sim_budget = 0;
+    CHECK(kv_init() == KV_OK);
+
+    sim_budget = cut;
+    if (setjmp(sim_power) != 0) {
+        /* 重启 */
+        lost = 1;
+        sim_budget = recover_cut;
+        if (setjmp(sim_power) != 0) {
+            sim_budget = 0;
+        }
+        CHECK(kv_init() == KV_OK);
+        sim_budget = 0;
+
+        ref_verify(1);
+        ++run_op;
+    } else {
+        run_op = 0;
+    }
+
+    for (; run_op < ops; ++run_op) {
+        script_op();
+    }
+    sim_budget = 0;
+
+    ref_verify(0);
+    CHECK(kv_init() == KV_OK);
+    ref_verify(0);
+
+    return lost;
+}
+
+/*****************************************************************************
+ * 测试
+ */
+
+static void test_basic(void) {
+    static uint8_t big[KV_VALUE_MAX];
+    uint8_t buf[KV_VALUE_MAX];
+    uint32_t steps;
+    uint16_t len = 0;
+    uint32_t k;
+
+    memset(sim_flash, 0x5A, sizeof(sim_flash));
+    CHECK(kv_set(key_of(0), "x", 1) == KV_ERR_PARAM);
+    CHECK(kv_init() == KV_OK);
+
+    CHECK(kv_set(KV_KEY_INVALID, "x", 1) == KV_ERR_PARAM);
+    CHECK(kv_set(key_of(0), big, KV_VALUE_MAX + 1U) == KV_ERR_PARAM);
+    CHECK(kv_set(key_of(0), NULL, 1) == KV_ERR_PARAM);
+    CHECK(kv_get(key_of(0), buf, sizeof(buf), &len) == KV_ERR_NOT_FOUND);
+    CHECK(kv_delete(key_of(0)) == KV_ERR_NOT_FOUND);
+
+    CHECK(kv_set(key_of(0), "hello", 5) == KV_OK);
+    CHECK(kv_set(key_of(1), NULL, 0) == KV_OK);
+    CHECK(kv_get(key_of(0), buf, 3, &len) == KV_OK);
+    CHECK((len == 5) && (memcmp(buf, "hel", 3) == 0));
+    CHECK(kv_get(key_of(1), buf, sizeof(buf), &len) == KV_OK && (len == 0));
+
+    /* 值相同时不写入 */
+    steps = sim_steps;
+    CHECK(kv_set(key_of(0), "hello", 5) == KV_OK);
+    CHECK(sim_steps == steps);
+
+    CHECK(kv_delete(key_of(1)) == KV_OK);
+    CHECK(kv_delete(key_of(1)) == KV_ERR_NOT_FOUND);
+
+    /* 写满: 有效数据超过除空白页外的容量 */
+    for (k = 2; k < KV_INDEX_SIZE; ++k) {
+        memset(big, (int)k, sizeof(big));
+        if (kv_set(key_of(k), big, sizeof(big)) != KV_OK) {
+            break;
+        }
+    }
+    CHECK(k < KV_INDEX_SIZE);
+    CHECK(kv_set(key_of(k), big, sizeof(big)) == KV_ERR_FULL);
+
+    /* 重启后数据不变 */
+    CHECK(kv_init() == KV_OK);
+    CHECK(kv_get(key_of(0), buf, sizeof(buf), &len) == KV_OK);
+    CHECK((len == 5) && (memcmp(buf, "hello", 5) == 0));
+    CHECK(kv_get(key_of(1), buf, sizeof(buf), &len) == KV_ERR_NOT_FOUND);
+    for (uint32_t i = 2; i < k; ++i) {
+        CHECK(kv_get(key_of(i), buf, sizeof(buf), &len) == KV_OK);
+        CHECK((len == sizeof(big)) && (buf[0] == (uint8_t)i) &&
+              (buf[sizeof(big) - 1U] == (uint8_t)i));
+    }
+
+    /* 删除后腾出空间 */
+    CHECK(kv_delete(key_of(2)) == KV_OK);
+    CHECK(kv_delete(key_of(3)) == KV_OK);
+    CHECK(kv_set(key_of(k), big, sizeof(big)) == KV_OK);
+
+    CHECK(kv_format() == KV_OK);
+    CHECK(kv_get(key_of(0), buf, sizeof(buf), &len) == KV_ERR_NOT_FOUND);
+}
+
+/**
+ * @brief 在操作序列的每一次擦写时掉电
+ *
+ * @param ops 操作数
+ */
+static void test_power_cut(uint32_t ops) {
+    uint32_t total;
+    uint32_t gc;
+    uint32_t erases;
+
+    sim_steps = 0;
+    gc = kv_gc_count;
+    erases = kv_erases;
+    CHECK(run(ops, 0, 0) == 0);
+    total = sim_steps;
+    gc = kv_gc_count - gc;
+    erases = kv_erases - erases;
+
+    /* 操作序列需要覆盖多次垃圾回收 */
+    CHECK(gc >= 3);
+
+    /* 擦除中掉电的结果是随机的, 每个擦除重复多次 */
+    for (uint32_t cut = 1; cut <= total; ++cut) {
+        for (uint32_t n = 0; n < ERASE_REPEAT; ++n) {
+            sim_erase_cut = 0;
+            CHECK(run(ops, cut, (cut % 3U == 0) ? 1U + cut % 7U : 0U) == 1);
+            if (!sim_erase_cut) {
+                break;
+            }
+        }
+    }
+
+    printf("%u ops, %u flash steps, %u gc, %u erases: every step cut\n",
+           (unsigned int)ops, (unsigned int)total, (unsigned int)gc,
+           (unsigned int)erases);
+}
+
+int main(void) {
+    srand(25);
+
+    test_basic();
+    test_power_cut(300);
+
+    printf("kv_sim_test: pass\n");
+    return 0;
+}
@@ -0,0 +1,253 @@
+/**
+ * @file    ring_fifo_stress.c
+ * @author  Deadline039
+ * @brief   ring_fifo单生产者单消费者多线程压力测试
+ * @version 1.0
+ * @date    2026-10-18
+ *
+ * 生产者线程和消费者线程分别代表中断和任务, 同时读写同一个fifo.
+ * 每帧带有序号, 帧长和内容由序号决定, 消费者逐帧校验:
+ * 帧长或内容与序号不符即为读到了未写完的帧(撕裂).
+ *
+ * 用法: ring_fifo_stress [帧数]
+ */
+
+#include "bench.h"
+#include "ring_fifo.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FIFO_SIZE 4096U
+#define FRAME_MAX 256U
+
+typedef struct {
+    ring_fifo_t *ring;
+    uint32_t frames;
+    uint32_t zero_copy; /* 生产者和消费者使用零拷贝接口 */
+} stress_t;
+
+/**
+ * @brief 第seq帧的长度, 4~FRAME_MAX字节
+ */
+static uint32_t frame_size(uint32_t seq) {
+    uint32_t x = seq * 2654435761U;
+    return 4U + (x >> 8) % (FRAME_MAX - 3U);
+}
+
+/**
+ * @brief 生成第seq帧: 前4字节为序号, 之后为由序号决定的字节
+ */
+static void frame_make(uint8_t *buf, uint32_t seq, uint32_t len) {
+    memcpy(buf, &seq, sizeof(seq));
+    for (uint32_t i = sizeof(seq); i < len; ++i) {
+        buf[i] = (uint8_t)(seq * 7U + i);
+    }
+}
+
+static uint32_t frame_check(const uint8_t *buf, uint32_t seq, uint32_t len) {
+    uint32_t got;
+
+    memcpy(&got, buf, sizeof(got));
+    if ((got != seq) || (len != frame_size(seq))) {
+        return 0;
+    }
+    for (uint32_t i = sizeof(seq); i < len; ++i) {
+        if (buf[i] != (uint8_t)(seq * 7U + i)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void *producer(void *arg) {
+    stress_t *st = arg;
+    ring_fifo_span_t span[2];
+    uint8_t buf[FRAME_MAX];
+
+    for (uint32_t seq = 0; seq < st->frames; ++seq) {
+        uint32_t len = frame_size(seq);
+        frame_make(buf, seq, len);
+
+        if (st->zero_copy) {
+            while (ring_fifo_write_reserve(st->ring, len, span) == 0) {
+                sched_yield();
+            }
+            memcpy(span[0].buf, buf, span[0].len);
+            memcpy(span[1].buf, buf + span[0].len, span[1].len);
+            ring_fifo_write_commit(st->ring, len);
+        } else {
+            while (ring_fifo_write(st->ring, buf, len) == 0) {
+                sched_yield();
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief 消费者, 在主线程中运行
+ *
+ * @return 撕裂的帧数
+ */
+static uint32_t consumer(stress_t *st) {
+    ring_fifo_span_t span[2];
+    uint8_t buf[FRAME_MAX];
+    uint32_t torn = 0;
+    uint32_t len;
+
+    for (uint32_t seq = 0; seq < st->frames; ++seq) {
+        if (st->zero_copy) {
+            while ((len = ring_fifo_read_peek(st->ring, span)) == 0) {
+                sched_yield();
+            }
+            if (len <= FRAME_MAX) {
+                memcpy(buf, span[0].buf, span[0].len);
+                memcpy(buf + span[0].len, span[1].buf, span[1].len);
+            }
+            ring_fifo_read_commit(st->ring, len);
+        } else {
+            while ((len = ring_fifo_read(st->ring, buf, sizeof(buf))) == 0) {
+                sched_yield();
+            }
+        }
+
+        if ((len > FRAME_MAX) || !frame_check(buf, seq, len)) {
+            if (torn == 0) {
+                printf("torn frame %u, len %u\n", (unsigned int)seq,
+                       (unsigned int)len);
+            }
+            ++torn;
+        }
+    }
+
+    return torn;
+}
+
+/**
+ * @brief 帧模式: 逐帧校验帧长和内容
+ *
+ * @param frames 帧数
+ * @param zero_copy 是否使用零拷贝接口
+ * @return 撕裂的帧数
+ */
+static uint32_t run_frame(uint32_t frames, uint32_t zero_copy) {
+    stress_t st = {
+        .ring = ring_fifo_init(NULL, FIFO_SIZE, RF_TYPE_FRAME),
+        .frames = frames,
+        .zero_copy = zero_copy,
+    };
+    pthread_t thread;
+
+    if (st.ring == NULL) {
+        return frames;
+    }
+
+    double start = bench_seconds();
+    pthread_create(&thread, NULL, producer, &st);
+    uint32_t torn = consumer(&st);
+    pthread_join(thread, NULL);
+    double elapsed = bench_seconds() - start;
+
+    printf("%-10s %10u frames %6u torn %8.2f Mframes/s\n",
+           zero_copy ? "peek" : "copy", (unsigned int)frames,
+           (unsigned int)torn, frames / elapsed / 1e6);
+
+    ring_fifo_destroy(st.ring);
+    return torn;
+}
+
+/**
+ * @brief 流模式生产者, 写入递增的字节
+ */
+static void *stream_producer(void *arg) {
+    stress_t *st = arg;
+    uint8_t buf[FRAME_MAX];
+    uint8_t next = 0;
+    uint64_t total = (uint64_t)st->frames * 64U;
+
+    for (uint64_t done = 0; done < total;) {
+        uint32_t len = frame_size((uint32_t)done);
+        for (uint32_t i = 0; i < len; ++i) {
+            buf[i] = (uint8_t)(next + i);
+        }
+        len = ring_fifo_write(st->ring, buf, len);
+        if (len == 0) {
+            sched_yield();
+        }
+        next += (uint8_t)len;
+        done += len;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief 流模式: 消费者按任意长度读出并校验字节顺序
+ *
+ * @param frames 数据量为帧数的64倍(byte)
+ * @return 顺序错误的字节数
+ */
+static uint32_t run_stream(uint32_t frames) {
+    stress_t st = {
+        .ring = ring_fifo_init(NULL, FIFO_SIZE, RF_TYPE_STREAM),
+        .frames = frames,
+    };
+    uint64_t total = (uint64_t)frames * 64U;
+    ring_fifo_span_t span[2];
+    uint32_t errors = 0;
+    uint8_t next = 0;
+    pthread_t thread;
+
+    if (st.ring == NULL) {
+        return 1;
+    }
+
+    double start = bench_seconds();
+    pthread_create(&thread, NULL, stream_producer, &st);
+    for (uint64_t done = 0; done < total;) {
+        uint32_t len = ring_fifo_read_peek(st.ring, span);
+        if (len == 0) {
+            sched_yield();
+            continue;
+        }
+        for (uint32_t i = 0; i < len; ++i) {
+            const uint8_t *p = (i < span[0].len)
+                                   ? (const uint8_t *)span[0].buf + i
+                                   : (const uint8_t *)span[1].buf + i -
+                                         span[0].len;
+            errors += (*p != next++);
+        }
+        ring_fifo_read_commit(st.ring, len);
+        done += len;
+    }
+    pthread_join(thread, NULL);
+    double elapsed = bench_seconds() - start;
+
+    printf("%-10s %10llu bytes  %6u bad  %8.2f MB/s\n", "stream",
+           (unsigned long long)total, (unsigned int)errors,
+           total / elapsed / 1e6);
+
+    ring_fifo_destroy(st.ring);
+    return errors;
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t frames = 2000000U;
+    uint32_t failed = 0;
+
+    if (argc > 1) {
+        frames = (uint32_t)strtoul(argv[1], NULL, 0);
+    }
+
+    failed += run_frame(frames, 0);
+    failed += run_frame(frames, 1);
+    failed += run_stream(frames);
+
+    printf("ring_fifo_stress: %s\n", failed ? "FAIL" : "pass");
+    return failed != 0;
+}
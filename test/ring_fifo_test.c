@@ -0,0 +1,284 @@
+/**
+ * @file    ring_fifo_test.c
+ * @author  Deadline039
+ * @brief   ring_fifo单元测试
+ * @version 1.0
+ * @date    2026-10-18
+ *
+ * 覆盖参数检查, 回绕时的两段连续内存, 帧模式的预留和提交,
+ * 以及拷贝接口和零拷贝接口随机混合操作与参考模型的比对.
+ */
+
+#include "ring_fifo.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CHECK(cond)                                                            \
+    do {                                                                       \
+        if (!(cond)) {                                                         \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);    \
+            exit(1);                                                           \
+        }                                                                      \
+    } while (0)
+
+/* 参考模型: 按顺序记录写入的字节和帧长 */
+#define REF_SIZE 4096U
+
+static uint8_t ref_data[REF_SIZE];
+static uint32_t ref_head, ref_tail;
+static uint32_t ref_len[REF_SIZE];
+static uint32_t len_head, len_tail;
+
+static void ref_reset(void) {
+    ref_head = ref_tail = 0;
+    len_head = len_tail = 0;
+}
+
+static void ref_push(const uint8_t *data, uint32_t len,
+                     enum ring_fifo_type type) {
+    for (uint32_t i = 0; i < len; ++i) {
+        ref_data[ref_tail++ % REF_SIZE] = data[i];
+    }
+    if ((type == RF_TYPE_FRAME) && (len != 0)) {
+        ref_len[len_tail++ % REF_SIZE] = len;
+    }
+}
+
+/**
+ * @brief 读取两段连续内存中的第i个字节
+ */
+static uint8_t span_byte(const ring_fifo_span_t span[2], uint32_t i) {
+    if (i < span[0].len) {
+        return ((const uint8_t *)span[0].buf)[i];
+    }
+    return ((const uint8_t *)span[1].buf)[i - span[0].len];
+}
+
+static void span_fill(ring_fifo_span_t span[2], const uint8_t *data,
+                      uint32_t len) {
+    uint32_t l = (len < span[0].len) ? len : span[0].len;
+    memcpy(span[0].buf, data, l);
+    memcpy(span[1].buf, data + l, len - l);
+}
+
+static void test_init(void) {
+    static uint32_t buf[16];
+    ring_fifo_t ring;
+
+    CHECK(ring_fifo_init_static(&ring, buf, 48, RF_TYPE_STREAM) == NULL);
+    CHECK(ring_fifo_init_static(&ring, (uint8_t *)buf + 1, 32,
+                                RF_TYPE_FRAME) == NULL);
+    CHECK(ring_fifo_init_static(&ring, (uint8_t *)buf + 1, 32,
+                                RF_TYPE_STREAM) == &ring);
+    CHECK(ring_fifo_init_static(NULL, buf, 64, RF_TYPE_STREAM) == NULL);
+    CHECK(ring_fifo_init(buf, 48, RF_TYPE_STREAM) == NULL);
+
+    /* 动态分配时大小向上取2的幂次方 */
+    ring_fifo_t *dyn = ring_fifo_init(NULL, 100, RF_TYPE_STREAM);
+    CHECK(dyn != NULL);
+    CHECK(dyn->size == 128);
+    CHECK(ring_fifo_is_empty(dyn) && ring_fifo_avail(dyn) == 128);
+    ring_fifo_destroy(dyn);
+}
+
+static void test_stream_span(void) {
+    static uint8_t buf[16];
+    uint8_t data[16];
+    ring_fifo_t ring;
+    ring_fifo_span_t span[2];
+
+    for (uint32_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (uint8_t)(0x40 + i);
+    }
+
+    CHECK(ring_fifo_init_static(&ring, buf, sizeof(buf), RF_TYPE_STREAM));
+
+    /* 空时没有可读数据 */
+    CHECK(ring_fifo_read_peek(&ring, span) == 0);
+    CHECK(span[0].len == 0 && span[1].len == 0);
+
+    /* 写指针移到12, 再预留8字节时跨越末尾 */
+    CHECK(ring_fifo_write(&ring, data, 12) == 12);
+    CHECK(ring_fifo_read_commit(&ring, 12) == 12);
+    CHECK(ring_fifo_write_reserve(&ring, 8, span) == 8);
+    CHECK(span[0].buf == buf + 12 && span[0].len == 4);
+    CHECK(span[1].buf == buf && span[1].len == 4);
+    span_fill(span, data, 8);
+
+    /* 提交前对消费者不可见 */
+    CHECK(ring_fifo_count(&ring) == 0);
+    CHECK(ring_fifo_write_commit(&ring, 6) == 6);
+    CHECK(ring_fifo_count(&ring) == 6);
+
+    CHECK(ring_fifo_read_peek(&ring, span) == 6);
+    CHECK(span[0].len == 4 && span[1].len == 2);
+    for (uint32_t i = 0; i < 6; ++i) {
+        CHECK(span_byte(span, i) == data[i]);
+    }
+
+    /* 部分出队后剩余数据不回绕 */
+    CHECK(ring_fifo_read_commit(&ring, 5) == 5);
+    CHECK(ring_fifo_read_peek(&ring, span) == 1);
+    CHECK(span[0].buf == buf + 1 && span[1].len == 0);
+    CHECK(ring_fifo_read_commit(&ring, 100) == 1);
+    CHECK(ring_fifo_is_empty(&ring));
+
+    /* 空间不足时流模式预留剩余的全部空间 */
+    CHECK(ring_fifo_write(&ring, data, 10) == 10);
+    CHECK(ring_fifo_write_reserve(&ring, 10, span) == 6);
+    CHECK(ring_fifo_write_commit(&ring, 6) == 6);
+    CHECK(ring_fifo_is_full(&ring));
+    CHECK(ring_fifo_write_reserve(&ring, 1, span) == 0);
+    CHECK(ring_fifo_write_commit(&ring, 0) == 0);
+}
+
+static void test_frame(void) {
+    static uint32_t buf[16];
+    uint8_t data[64];
+    uint8_t out[64];
+    ring_fifo_t ring;
+    ring_fifo_span_t span[2];
+
+    for (uint32_t i = 0; i < sizeof(data); ++i) {
+        data[i] = (uint8_t)(0x80 + i);
+    }
+
+    CHECK(ring_fifo_init_static(&ring, buf, sizeof(buf), RF_TYPE_FRAME));
+
+    /* 每帧占用4字节帧长加按4字节对齐的数据 */
+    CHECK(ring_fifo_write(&ring, data, 5) == 5);
+    CHECK(ring_fifo_count(&ring) == 12);
+    CHECK(ring_fifo_write(&ring, data, 0) == 0);
+
+    /* 整帧存不下时不预留 */
+    CHECK(ring_fifo_write_reserve(&ring, 49, span) == 0);
+    CHECK(ring_fifo_write_reserve(&ring, 48, span) == 48);
+    CHECK(((uintptr_t)span[0].buf & 3) == 0);
+    span_fill(span, data + 10, 7);
+    CHECK(ring_fifo_write_commit(&ring, 7) == 7);
+
+    /* 缓冲区不足一帧时不出队 */
+    CHECK(ring_fifo_read(&ring, out, 4) == 0);
+    CHECK(ring_fifo_read(&ring, out, sizeof(out)) == 5);
+    CHECK(memcmp(out, data, 5) == 0);
+
+    /* 读出的长度为实际提交的帧长, 忽略出队长度 */
+    CHECK(ring_fifo_read_peek(&ring, span) == 7);
+    for (uint32_t i = 0; i < 7; ++i) {
+        CHECK(span_byte(span, i) == data[10 + i]);
+    }
+    CHECK(ring_fifo_read_commit(&ring, 1) == 7);
+    CHECK(ring_fifo_is_empty(&ring));
+
+    /* 帧数据跨越末尾 */
+    CHECK(ring_fifo_write(&ring, data, 28) == 28);
+    CHECK(ring_fifo_read(&ring, out, sizeof(out)) == 28);
+    CHECK(ring_fifo_write(&ring, data, 30) == 30);
+    CHECK(ring_fifo_read_peek(&ring, span) == 30);
+    CHECK(span[0].len == 4 && span[1].len == 26);
+    CHECK(ring_fifo_read(&ring, out, sizeof(out)) == 30);
+    CHECK(memcmp(out, data, 30) == 0);
+}
+
+/**
+ * @brief 随机混合拷贝接口和零拷贝接口, 与参考模型比对
+ *
+ * @param type fifo类型
+ * @param size fifo大小
+ */
+static void test_random(enum ring_fifo_type type, uint32_t size) {
+    ring_fifo_t *ring = ring_fifo_init(NULL, size, type);
+    ring_fifo_span_t span[2];
+    uint8_t buf[128];
+    uint8_t seq = 0;
+
+    CHECK(ring != NULL);
+    ref_reset();
+    srand(size + type);
+
+    for (uint32_t it = 0; it < 200000; ++it) {
+        uint32_t n = (uint32_t)rand() % 40 + (type == RF_TYPE_FRAME);
+        uint32_t got;
+
+        switch (rand() % 4) {
+            case 0:
+                for (uint32_t i = 0; i < n; ++i) {
+                    buf[i] = seq + i;
+                }
+                got = ring_fifo_write(ring, buf, n);
+                CHECK(got == 0 || got == n || type == RF_TYPE_STREAM);
+                ref_push(buf, got, type);
+                seq += got;
+                break;
+
+            case 1:
+                got = ring_fifo_write_reserve(ring, n, span);
+                CHECK(span[0].len + span[1].len == got);
+                if (got == 0) {
+                    break;
+                }
+                /* 提交的长度可以小于预留的长度 */
+                got = (uint32_t)rand() % got + 1;
+                for (uint32_t i = 0; i < got; ++i) {
+                    buf[i] = seq + i;
+                }
+                span_fill(span, buf, got);
+                CHECK(ring_fifo_write_commit(ring, got) == got);
+                ref_push(buf, got, type);
+                seq += got;
+                break;
+
+            case 2:
+                got = ring_fifo_read(ring, buf,
+                                     (type == RF_TYPE_FRAME) ? sizeof(buf) : n);
+                if ((type == RF_TYPE_FRAME) && (got != 0)) {
+                    CHECK(got == ref_len[len_head++ % REF_SIZE]);
+                }
+                for (uint32_t i = 0; i < got; ++i) {
+                    CHECK(buf[i] == ref_data[ref_head++ % REF_SIZE]);
+                }
+                break;
+
+            default:
+                got = ring_fifo_read_peek(ring, span);
+                CHECK(span[0].len + span[1].len == got);
+                if (got == 0) {
+                    CHECK(ref_head == ref_tail);
+                    break;
+                }
+                if (type == RF_TYPE_FRAME) {
+                    CHECK(got == ref_len[len_head++ % REF_SIZE]);
+                }
+                for (uint32_t i = 0; i < got; ++i) {
+                    CHECK(span_byte(span, i) ==
+                          ref_data[(ref_head + i) % REF_SIZE]);
+                }
+                n = (type == RF_TYPE_FRAME) ? got : (uint32_t)rand() % got + 1;
+                CHECK(ring_fifo_read_commit(ring, n) == n);
+                ref_head += n;
+                break;
+        }
+
+        if (type == RF_TYPE_STREAM) {
+            CHECK(ring_fifo_count(ring) == ref_tail - ref_head);
+        }
+    }
+
+    ring_fifo_destroy(ring);
+}
+
+int main(void) {
+    test_init();
+    test_stream_span();
+    test_frame();
+
+    test_random(RF_TYPE_STREAM, 64);
+    test_random(RF_TYPE_STREAM, 1024);
+    test_random(RF_TYPE_FRAME, 64);
+    test_random(RF_TYPE_FRAME, 1024);
+
+    printf("ring_fifo_test: pass\n");
+    return 0;
+}
@@ -0,0 +1,141 @@
+/**
+ * @file    cmsis_gcc.h
+ * @author  Deadline039
+ * @brief   主机测试用的CMSIS编译器相关定义
+ * @version 1.0
+ * @date    2026-10-18
+ *
+ * 工程的CMSIS只带有ARM编译器的定义, 主机测试用这个文件代替cmsis_gcc.h,
+ * 使HAL头文件能在PC上编译. 内核寄存器访问和中断开关均为空操作,
+ * 测试在单线程中调用中断处理函数来模拟中断.
+ */
+
+#ifndef __CMSIS_GCC_H
+#define __CMSIS_GCC_H
+
+#include <stdint.h>
+
+#define __ASM __asm
+#define __INLINE inline
+#define __STATIC_INLINE static inline
+#define __STATIC_FORCEINLINE static inline __attribute__((always_inline))
+#define __NO_RETURN __attribute__((__noreturn__))
+#define __USED __attribute__((used))
+#define __WEAK __attribute__((weak))
+#define __PACKED __attribute__((packed, aligned(1)))
+#define __PACKED_STRUCT struct __attribute__((packed, aligned(1)))
+#define __PACKED_UNION union __attribute__((packed, aligned(1)))
+#define __ALIGNED(x) __attribute__((aligned(x)))
+#define __RESTRICT __restrict
+#define __COMPILER_BARRIER() __asm volatile("" ::: "memory")
+#define __UNALIGNED_UINT32_READ(addr) (*((const uint32_t *)(addr)))
+#define __UNALIGNED_UINT32_WRITE(addr, val) (*((uint32_t *)(addr)) = (val))
+#define __UNALIGNED_UINT16_READ(addr) (*((const uint16_t *)(addr)))
+#define __UNALIGNED_UINT16_WRITE(addr, val) (*((uint16_t *)(addr)) = (val))
+
+static inline void __enable_irq(void) {
+}
+
+static inline void __disable_irq(void) {
+}
+
+static inline uint32_t __get_PRIMASK(void) {
+    return 0;
+}
+
+static inline void __set_PRIMASK(uint32_t x) {
+    (void)x;
+}
+
+static inline uint32_t __get_BASEPRI(void) {
+    return 0;
+}
+
+static inline void __set_BASEPRI(uint32_t x) {
+    (void)x;
+}
+
+static inline uint32_t __get_IPSR(void) {
+    return 0;
+}
+
+static inline uint32_t __get_CONTROL(void) {
+    return 0;
+}
+
+static inline uint32_t __get_MSP(void) {
+    return 0;
+}
+
+static inline void __set_MSP(uint32_t x) {
+    (void)x;
+}
+
+static inline uint32_t __get_PSP(void) {
+    return 0;
+}
+
+static inline void __set_PSP(uint32_t x) {
+    (void)x;
+}
+
+static inline uint32_t __get_FAULTMASK(void) {
+    return 0;
+}
+
+static inline void __set_FAULTMASK(uint32_t x) {
+    (void)x;
+}
+
+#define __NOP() __asm volatile("nop")
+#define __WFI() __asm volatile("")
+#define __WFE() __asm volatile("")
+#define __SEV() __asm volatile("")
+#define __ISB() __COMPILER_BARRIER()
+#define __DSB() __COMPILER_BARRIER()
+#define __DMB() __COMPILER_BARRIER()
+#define __REV(x) __builtin_bswap32(x)
+#define __REV16(x) ((uint32_t)__builtin_bswap16(x))
+
+static inline uint32_t __RBIT(uint32_t v) {
+    v = ((v >> 1) & 0x55555555U) | ((v & 0x55555555U) << 1);
+    v = ((v >> 2) & 0x33333333U) | ((v & 0x33333333U) << 2);
+    v = ((v >> 4) & 0x0F0F0F0FU) | ((v & 0x0F0F0F0FU) << 4);
+    return __builtin_bswap32(v);
+}
+
+#define __CLZ(x) ((uint8_t)__builtin_clz(x))
+static inline uint32_t __LDREXW(volatile uint32_t *p) {
+    return *p;
+}
+
+static inline uint32_t __STREXW(uint32_t v, volatile uint32_t *p) {
+    *p = v;
+    return 0;
+}
+
+static inline uint8_t __LDREXB(volatile uint8_t *p) {
+    return *p;
+}
+
+static inline uint32_t __STREXB(uint8_t v, volatile uint8_t *p) {
+    *p = v;
+    return 0;
+}
+
+static inline uint16_t __LDREXH(volatile uint16_t *p) {
+    return *p;
+}
+
+static inline uint32_t __STREXH(uint16_t v, volatile uint16_t *p) {
+    *p = v;
+    return 0;
+}
+
+static inline void __CLREX(void) {
+}
+
+#define __BKPT(v) __asm volatile("")
+
+
+#endif /* __CMSIS_GCC_H */
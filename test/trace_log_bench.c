@@ -0,0 +1,149 @@
+/**
+ * @file    trace_log_bench.c
+ * @author  Deadline039
+ * @brief   trace_log与printf格式化的单次调用开销比较
+ * @version 1.0
+ * @date    2026-10-18
+ *
+ * TRACE_LOG只把格式化字符串地址和参数写入fifo, printf路径需要在调用处
+ * 完成格式化. 两者使用相同的格式化字符串和参数, printf路径用snprintf
+ * 格式化到缓冲区, 不包含输出到串口的时间.
+ * 日志缓冲区每批调用后重新初始化, 保证测到的是入队而不是丢弃的开销.
+ *
+ * 用法: trace_log_bench [批数]
+ */
+
+#include "bench.h"
+#include "trace_log.h"
+#include "uart_frame.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* 每批的调用次数, 最长的记录(6个参数)也能全部放入缓冲区 */
+#define BATCH_CALLS (TRACE_BUF_SIZE / 64U)
+
+static char line[128];
+static uint32_t tick;
+
+uint32_t HAL_GetTick(void) {
+    return tick;
+}
+
+/* trace_flush用uart_frame封装记录, 不测量串口收发 */
+uint32_t uart_dmarx_read(UART_HandleTypeDef *huart, void *buf, size_t len) {
+    return 0;
+}
+
+uint32_t uart_dmatx_reserve(UART_HandleTypeDef *huart, uint32_t len,
+                            ring_fifo_span_t span[2]) {
+    return 0;
+}
+
+uint32_t uart_dmatx_commit(UART_HandleTypeDef *huart, uint32_t len) {
+    return 0;
+}
+
+uint32_t uart_dmatx_send(UART_HandleTypeDef *huart) {
+    return 0;
+}
+
+typedef struct {
+    uint64_t trace; /* TRACE_LOG的总开销 */
+    uint64_t print; /* snprintf的总开销 */
+    uint32_t calls;
+} bench_result_t;
+
+/**
+ * @brief 测量一种参数个数下两条路径的开销
+ *
+ * @param nargs 参数个数
+ * @param batches 批数
+ * @param result 测量结果
+ */
+static void run(uint32_t nargs, uint32_t batches, bench_result_t *result) {
+    result->trace = result->print = 0;
+    result->calls = 0;
+
+    for (uint32_t b = 0; b < batches; ++b) {
+        uint32_t v = b * BATCH_CALLS;
+        uint64_t t0, t1;
+
+        trace_log_init();
+        t0 = bench_ticks();
+        for (uint32_t i = 0; i < BATCH_CALLS; ++i, ++v) {
+            switch (nargs) {
+                case 0:
+                    TRACE_LOG("motor stop\r\n");
+                    break;
+                case 2:
+                    TRACE_LOG("adc ch=%u val=%u\r\n", v & 7U, v);
+                    break;
+                default:
+                    TRACE_LOG("t=%u pos=%d,%d spd=%d,%d err=%x\r\n", v,
+                              (int32_t)v, -(int32_t)v, (int32_t)(v >> 1),
+                              -(int32_t)(v >> 1), v ^ 0x5AU);
+                    break;
+            }
+        }
+        t1 = bench_ticks();
+        result->trace += t1 - t0;
+
+        v = b * BATCH_CALLS;
+        t0 = bench_ticks();
+        for (uint32_t i = 0; i < BATCH_CALLS; ++i, ++v) {
+            int len;
+            switch (nargs) {
+                case 0:
+                    len = snprintf(line, sizeof(line), "motor stop\r\n");
+                    break;
+                case 2:
+                    len = snprintf(line, sizeof(line), "adc ch=%u val=%u\r\n",
+                                   (unsigned int)(v & 7U), (unsigned int)v);
+                    break;
+                default:
+                    len = snprintf(line, sizeof(line),
+                                   "t=%u pos=%d,%d spd=%d,%d err=%x\r\n",
+                                   (unsigned int)v, (int)v, -(int)v,
+                                   (int)(v >> 1), -(int)(v >> 1),
+                                   (unsigned int)(v ^ 0x5AU));
+                    break;
+            }
+            BENCH_KEEP(len);
+        }
+        t1 = bench_ticks();
+        result->print += t1 - t0;
+
+        result->calls += BATCH_CALLS;
+        ++tick;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    static const uint32_t nargs[] = {0, 2, 6};
+    uint32_t batches = 100000U;
+    bench_result_t result;
+
+    if (argc > 1) {
+        batches = (uint32_t)strtoul(argv[1], NULL, 0);
+    }
+
+    printf("%5s %14s %14s %8s\n", "args", "trace " BENCH_UNIT,
+           "printf " BENCH_UNIT, "speedup");
+
+    for (uint32_t i = 0; i < sizeof(nargs) / sizeof(nargs[0]); ++i) {
+        run(nargs[i], batches, &result);
+
+        if (trace_get_dropped() != 0) {
+            printf("trace_log_bench: records dropped\n");
+            return 1;
+        }
+
+        double trace = (double)result.trace / result.calls;
+        double print = (double)result.print / result.calls;
+        printf("%5u %14.1f %14.1f %7.2fx\n", (unsigned int)nargs[i], trace,
+               print, print / trace);
+    }
+
+    return 0;
+}
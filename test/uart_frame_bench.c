@@ -0,0 +1,171 @@
+/**
+ * @file    uart_frame_bench.c
+ * @author  Deadline039
+ * @brief   uart_frame接收解码吞吐
+ * @version 1.0
+ * @date    2026-10-18
+ *
+ * 预先编码一段帧流, 模拟串口每次到达RX_BURST字节, 测量
+ * uart_frame_poll(查找帧尾, COBS解码, CRC校验, 存入帧FIFO)加
+ * uart_frame_read的吞吐, 以及只调用uart_frame_decode的吞吐.
+ * 吞吐按编码后的字节数计算.
+ *
+ * 用法: uart_frame_bench [数据量(MB)]
+ */
+
+#include "bench.h"
+#include "uart_frame.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* 两次uart_frame_poll之间到达的字节数, 相当于DMA半满中断的数据量 */
+#define RX_BURST    256U
+#define STREAM_SIZE (1024U * 1024U)
+
+static uint8_t stream[STREAM_SIZE];
+static uint32_t stream_len, stream_pos, rx_budget;
+
+uint32_t uart_dmarx_read(UART_HandleTypeDef *huart, void *buf, size_t len) {
+    uint32_t n = stream_len - stream_pos;
+
+    if (n > len) {
+        n = (uint32_t)len;
+    }
+    if (n > rx_budget) {
+        n = rx_budget;
+    }
+    memcpy(buf, stream + stream_pos, n);
+    stream_pos += n;
+    rx_budget -= n;
+
+    return n;
+}
+
+uint32_t uart_dmatx_reserve(UART_HandleTypeDef *huart, uint32_t len,
+                            ring_fifo_span_t span[2]) {
+    return 0;
+}
+
+uint32_t uart_dmatx_commit(UART_HandleTypeDef *huart, uint32_t len) {
+    return 0;
+}
+
+uint32_t uart_dmatx_send(UART_HandleTypeDef *huart) {
+    return 0;
+}
+
+/**
+ * @brief 生成帧长为frame_len的帧流, 数据中约1/16为0x00
+ *
+ * @return 帧数
+ */
+static uint32_t make_stream(uint32_t frame_len) {
+    uint8_t data[UART_FRAME_MAX_LEN];
+    uint32_t frames = 0;
+
+    stream_len = 0;
+    while (stream_len + UART_FRAME_ENCODED_SIZE(frame_len) <= STREAM_SIZE) {
+        for (uint32_t i = 0; i < frame_len; ++i) {
+            data[i] = (rand() % 16 == 0) ? 0 : (uint8_t)(rand() % 255 + 1);
+        }
+        stream_len += uart_frame_encode(data, frame_len, stream + stream_len,
+                                        STREAM_SIZE - stream_len);
+        ++frames;
+    }
+
+    return frames;
+}
+
+/**
+ * @brief 通过uart_frame_poll接收整个帧流
+ *
+ * @return 收到的帧数
+ */
+static uint32_t run_poll(uart_frame_t *frame) {
+    uint8_t buf[UART_FRAME_MAX_LEN];
+    uint32_t frames = 0;
+
+    stream_pos = 0;
+    while (stream_pos < stream_len) {
+        rx_budget = RX_BURST;
+        uart_frame_poll(frame);
+        while (uart_frame_read(frame, buf, sizeof(buf)) != 0) {
+            ++frames;
+        }
+    }
+
+    return frames;
+}
+
+/**
+ * @brief 逐帧只做COBS解码
+ *
+ * @param copy 帧流的副本, 原地解码
+ * @return 解码的帧数
+ */
+static uint32_t run_decode(uint8_t *copy) {
+    uint32_t frames = 0;
+    uint8_t *start = copy;
+    uint8_t *end;
+
+    while ((end = memchr(start, UART_FRAME_DELIM,
+                         stream_len - (uint32_t)(start - copy))) != NULL) {
+        frames += (uart_frame_decode(start, (uint32_t)(end - start)) > 0);
+        start = end + 1;
+    }
+
+    return frames;
+}
+
+int main(int argc, char *argv[]) {
+    static const uint32_t frame_lens[] = {8, 32, 128, UART_FRAME_MAX_LEN};
+    static uart_frame_t frame;
+    static UART_HandleTypeDef huart;
+    static uint8_t copy[STREAM_SIZE];
+    uint32_t total_mb = 64;
+
+    if (argc > 1) {
+        total_mb = (uint32_t)strtoul(argv[1], NULL, 0);
+    }
+
+    srand(1);
+    uart_frame_init(&frame, &huart);
+
+    printf("%6s %12s %12s\n", "frame", "poll MB/s", "decode MB/s");
+
+    for (uint32_t i = 0; i < sizeof(frame_lens) / sizeof(frame_lens[0]); ++i) {
+        uint32_t frames = make_stream(frame_lens[i]);
+        uint32_t rounds = (uint32_t)((uint64_t)total_mb * 1024U * 1024U /
+                                     stream_len) + 1U;
+        uint32_t got = 0;
+
+        double t0 = bench_seconds();
+        for (uint32_t r = 0; r < rounds; ++r) {
+            got += run_poll(&frame);
+        }
+        double t_poll = bench_seconds() - t0;
+
+        /* 原地解码会改写数据, 每轮在新的副本上进行, 拷贝不计时 */
+        double t_decode = 0;
+        for (uint32_t r = 0; r < rounds; ++r) {
+            memcpy(copy, stream, stream_len);
+            t0 = bench_seconds();
+            got -= run_decode(copy);
+            t_decode += bench_seconds() - t0;
+        }
+
+        if ((got != 0) || (frame.stats.frames != frames * rounds)) {
+            printf("uart_frame_bench: frames lost\n");
+            return 1;
+        }
+        frame.stats.frames = 0;
+
+        double bytes = (double)stream_len * rounds;
+        printf("%6u %12.0f %12.0f\n", (unsigned int)frame_lens[i],
+               bytes / t_poll / 1e6, bytes / t_decode / 1e6);
+    }
+
+    return 0;
+}
@@ -0,0 +1,404 @@
+/**
+ * @file    uart_frame_test.c
+ * @author  Deadline039
+ * @brief   uart_frame单元测试
+ * @version 1.0
+ * @date    2026-10-18
+ *
+ * 覆盖编解码往返, 最大帧长, 帧尾查找, 发送时跨越FIFO末尾的编码,
+ * 以及接收数据损坏, 丢失和插入杂散字节后在下一个帧尾重新同步.
+ * 直接包含uart_frame.c以测试内部的uart_frame_find_delim,
+ * 串口收发接口由本文件模拟.
+ */
+
+#include "uart_frame.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHECK(cond)                                                            \
+    do {                                                                       \
+        if (!(cond)) {                                                         \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);    \
+            exit(1);                                                           \
+        }                                                                      \
+    } while (0)
+
+#define ENC_MAX UART_FRAME_ENCODED_SIZE(UART_FRAME_MAX_LEN + 64U)
+
+/*****************************************************************************
+ * 模拟串口
+ */
+
+/* 接收: 每次uart_frame_poll之前到达rx_budget字节 */
+static uint8_t rx_stream[256 * 1024];
+static uint32_t rx_len, rx_pos, rx_budget;
+
+/* 发送: FIFO末尾剩余tx_split字节, 预留的空间在此处分为两段 */
+static uint8_t tx_fifo[2 * ENC_MAX];
+static uint32_t tx_split, tx_reserved, tx_committed;
+
+uint32_t uart_dmarx_read(UART_HandleTypeDef *huart, void *buf, size_t len) {
+    uint32_t n = rx_len - rx_pos;
+
+    if (n > len) {
+        n = (uint32_t)len;
+    }
+    if (n > rx_budget) {
+        n = rx_budget;
+    }
+    memcpy(buf, rx_stream + rx_pos, n);
+    rx_pos += n;
+    rx_budget -= n;
+
+    return n;
+}
+
+uint32_t uart_dmatx_reserve(UART_HandleTypeDef *huart, uint32_t len,
+                            ring_fifo_span_t span[2]) {
+    uint32_t first = (len < tx_split) ? len : tx_split;
+
+    span[0].buf = tx_fifo + sizeof(tx_fifo) - tx_split;
+    span[0].len = first;
+    span[1].buf = tx_fifo;
+    span[1].len = len - first;
+    tx_reserved = len;
+
+    return len;
+}
+
+uint32_t uart_dmatx_commit(UART_HandleTypeDef *huart, uint32_t len) {
+    CHECK(len <= tx_reserved);
+    tx_committed = len;
+    return len;
+}
+
+uint32_t uart_dmatx_send(UART_HandleTypeDef *huart) {
+    return 0;
+}
+
+/*****************************************************************************
+ * 测试数据
+ */
+
+/**
+ * @brief 生成测试数据, zeros为0x00所占的比例(1/zeros), 0表示全为0x00
+ */
+static void make_data(uint8_t *buf, uint32_t len, uint32_t zeros) {
+    for (uint32_t i = 0; i < len; ++i) {
+        if ((zeros == 0) || ((uint32_t)rand() % zeros == 0)) {
+            buf[i] = 0;
+        } else {
+            buf[i] = (uint8_t)(rand() % 255 + 1);
+        }
+    }
+}
+
+static void test_roundtrip(void) {
+    static const uint32_t zeros[] = {0, 1, 2, 16, 1000};
+    uint8_t data[UART_FRAME_MAX_LEN];
+    uint8_t enc[ENC_MAX];
+
+    for (uint32_t z = 0; z < sizeof(zeros) / sizeof(zeros[0]); ++z) {
+        for (uint32_t len = 0; len <= UART_FRAME_MAX_LEN; ++len) {
+            make_data(data, len, zeros[z]);
+
+            uint32_t n = uart_frame_encode(data, len, enc, sizeof(enc));
+            CHECK(n != 0 && n <= UART_FRAME_ENCODED_SIZE(len));
+            CHECK(enc[n - 1] == UART_FRAME_DELIM);
+            CHECK(uart_frame_find_delim(enc, n) == n - 1);
+
+            CHECK(uart_frame_decode(enc, n - 1) ==
+                  (int32_t)(len + UART_FRAME_CRC_SIZE));
+            CHECK(memcmp(enc, data, len) == 0);
+#if (UART_FRAME_USE_CRC == 1)
+            CHECK(crc16_update(CRC16_INIT, enc, len + UART_FRAME_CRC_SIZE) ==
+                  0);
+#endif /* UART_FRAME_USE_CRC == 1 */
+        }
+    }
+
+    /* 输出缓冲区按最大编码长度检查 */
+    make_data(data, 10, 4);
+    CHECK(uart_frame_encode(data, 10, enc, UART_FRAME_ENCODED_SIZE(10) - 1) ==
+          0);
+    CHECK(uart_frame_encode(NULL, 10, enc, sizeof(enc)) == 0);
+    CHECK(uart_frame_encode(data, 10, NULL, sizeof(enc)) == 0);
+}
+
+static void test_decode_errors(void) {
+    uint8_t buf[8];
+
+    /* 块长码超过剩余数据 */
+    memcpy(buf, "\x05\x11\x22\x33", 4);
+    CHECK(uart_frame_decode(buf, 4) == -1);
+
+    /* 编码数据中出现0x00 */
+    memcpy(buf, "\x03\x11\x22\x00\x01", 5);
+    CHECK(uart_frame_decode(buf, 5) == -1);
+
+    /* 块长码1表示0x00 */
+    memcpy(buf, "\x01\x01\x02\x11", 4);
+    CHECK(uart_frame_decode(buf, 4) == 3);
+    CHECK(memcmp(buf, "\x00\x00\x11", 3) == 0);
+
+    CHECK(uart_frame_decode(buf, 0) == 0);
+}
+
+static void test_find_delim(void) {
+    uint8_t buf[64 + 4];
+
+    /* 帧尾在每个位置, 每种起始对齐 */
+    for (uint32_t align = 0; align < 4; ++align) {
+        uint8_t *p = buf + align;
+        for (uint32_t len = 0; len <= 64; ++len) {
+            for (uint32_t pos = 0; pos <= len; ++pos) {
+                memset(p, 0x80, len);
+                if (pos < len) {
+                    p[pos] = UART_FRAME_DELIM;
+                    /* 之后的0x00不影响结果 */
+                    if (pos + 2 < len) {
+                        p[pos + 2] = UART_FRAME_DELIM;
+                    }
+                }
+                CHECK(uart_frame_find_delim(p, len) == pos);
+            }
+        }
+    }
+
+    /* 0x01和0x80组合不能被误判为0x00 */
+    memset(buf, 0x01, sizeof(buf));
+    CHECK(uart_frame_find_delim(buf, sizeof(buf)) == sizeof(buf));
+    for (uint32_t i = 0; i < sizeof(buf); i += 2) {
+        buf[i] = 0x80;
+    }
+    CHECK(uart_frame_find_delim(buf, sizeof(buf)) == sizeof(buf));
+}
+
+static void test_send_wrap(void) {
+    uint8_t data[UART_FRAME_MAX_LEN];
+    uint8_t enc[ENC_MAX];
+    UART_HandleTypeDef huart = {0};
+
+    CHECK(uart_frame_send(&huart, data, 0) == 0);
+    CHECK(uart_frame_send(&huart, data, UART_FRAME_MAX_LEN + 1) == 0);
+
+    for (uint32_t len = 1; len <= UART_FRAME_MAX_LEN; len += 17) {
+        make_data(data, len, 8);
+        uint32_t n = uart_frame_encode(data, len, enc, sizeof(enc));
+
+        /* 预留空间在每个位置分段, 结果与连续编码相同 */
+        for (tx_split = 0; tx_split <= n; ++tx_split) {
+            memset(tx_fifo, 0xEE, sizeof(tx_fifo));
+            CHECK(uart_frame_send(&huart, data, len) == len);
+            CHECK(tx_committed == n);
+
+            uint32_t first = (n < tx_split) ? n : tx_split;
+            CHECK(memcmp(tx_fifo + sizeof(tx_fifo) - tx_split, enc, first) ==
+                  0);
+            CHECK(memcmp(tx_fifo, enc + first, n - first) == 0);
+        }
+    }
+}
+
+/*****************************************************************************
+ * 接收和重新同步
+ */
+
+/* 期望收到的帧 */
+#define EXPECT_MAX 4096U
+
+typedef struct {
+    uint32_t offset; /* 在expect_data中的位置 */
+    uint32_t len;
+} expect_t;
+
+static uint8_t expect_data[EXPECT_MAX * UART_FRAME_MAX_LEN];
+static expect_t expect[EXPECT_MAX];
+static uint32_t expect_num, expect_used;
+
+/**
+ * @brief 把编码后的一帧加入接收数据流
+ *
+ * @param data 数据
+ * @param len 数据长度
+ * @param good 是否应被接收
+ */
+static void stream_frame(const uint8_t *data, uint32_t len, uint32_t good) {
+    uint32_t n = uart_frame_encode(data, len, rx_stream + rx_len,
+                                   sizeof(rx_stream) - rx_len);
+    CHECK(n != 0);
+    rx_len += n;
+
+    if (good) {
+        CHECK(expect_num < EXPECT_MAX);
+        expect[expect_num].offset = expect_used;
+        expect[expect_num].len = len;
+        memcpy(expect_data + expect_used, data, len);
+        expect_used += len;
+        ++expect_num;
+    }
+}
+
+static void stream_reset(void) {
+    rx_len = rx_pos = 0;
+    expect_num = expect_used = 0;
+}
+
+/**
+ * @brief 接收全部数据, 逐帧与期望比较
+ *
+ * @param chunk 两次调用uart_frame_poll之间到达的数据长度
+ * @param stats 接收统计
+ */
+static void receive_all(uint32_t chunk, uart_frame_stats_t *stats) {
+    static uart_frame_t frame;
+    static UART_HandleTypeDef huart;
+    uint8_t buf[UART_FRAME_MAX_LEN];
+    uint32_t got = 0;
+    uint32_t len;
+
+    uart_frame_init(&frame, &huart);
+    rx_pos = 0;
+
+    do {
+        rx_budget = chunk;
+        uart_frame_poll(&frame);
+        while ((len = uart_frame_read(&frame, buf, sizeof(buf))) != 0) {
+            CHECK(got < expect_num);
+            CHECK(len == expect[got].len);
+            CHECK(memcmp(buf, expect_data + expect[got].offset, len) == 0);
+            ++got;
+        }
+    } while (rx_pos < rx_len);
+
+    CHECK(got == expect_num);
+    CHECK(frame.stats.frames == expect_num);
+    *stats = frame.stats;
+}
+
+static void test_max_len(void) {
+    static const uint32_t chunks[] = {1, 7, 64, 512};
+    uint8_t data[UART_FRAME_MAX_LEN + 64];
+    uart_frame_stats_t stats;
+
+    stream_reset();
+
+    /* 最大帧长, 全为0x00和不含0x00的最大帧 */
+    make_data(data, UART_FRAME_MAX_LEN, 16);
+    stream_frame(data, UART_FRAME_MAX_LEN, 1);
+    make_data(data, UART_FRAME_MAX_LEN, 0);
+    stream_frame(data, UART_FRAME_MAX_LEN, 1);
+    make_data(data, UART_FRAME_MAX_LEN, 1000);
+    stream_frame(data, UART_FRAME_MAX_LEN, 1);
+
+    /* 超长帧被丢弃, 后面的帧不受影响 */
+    make_data(data, UART_FRAME_MAX_LEN + 1, 1000);
+    stream_frame(data, UART_FRAME_MAX_LEN + 1, 0);
+    make_data(data, 5, 4);
+    stream_frame(data, 5, 1);
+    make_data(data, UART_FRAME_MAX_LEN + 64, 8);
+    stream_frame(data, UART_FRAME_MAX_LEN + 64, 0);
+    make_data(data, UART_FRAME_MAX_LEN, 8);
+    stream_frame(data, UART_FRAME_MAX_LEN, 1);
+
+    for (uint32_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); ++i) {
+        receive_all(chunks[i], &stats);
+        CHECK(stats.overflows == 2);
+        CHECK(stats.crc_errors == 0 && stats.decode_errors == 0);
+    }
+}
+
+static void test_corruption(void) {
+    static const uint32_t chunks[] = {1, 3, 61, 300};
+    uint8_t data[UART_FRAME_MAX_LEN];
+    uint32_t bad = 0;
+    uart_frame_stats_t stats;
+
+    stream_reset();
+    srand(14);
+
+    while (rx_len + 2 * ENC_MAX < sizeof(rx_stream)) {
+        uint32_t len = (uint32_t)rand() % UART_FRAME_MAX_LEN + 1;
+        uint32_t start = rx_len;
+
+        make_data(data, len, (uint32_t)rand() % 32);
+
+        switch (rand() % 8) {
+            case 0: {
+                /* 改错一个字节, 不改成帧尾 */
+                stream_frame(data, len, 0);
+                uint8_t *p =
+                    rx_stream + start + (uint32_t)rand() % (rx_len - start - 1);
+                uint8_t v;
+                do {
+                    v = (uint8_t)(rand() % 255 + 1);
+                } while (v == *p);
+                *p = v;
+                ++bad;
+                break;
+            }
+
+            case 1:
+                /* 丢失帧尾, 与下一帧连成一帧被丢弃 */
+                stream_frame(data, len, 0);
+                --rx_len;
+                make_data(data, len, 16);
+                stream_frame(data, len, 0);
+                ++bad;
+                break;
+
+            case 2:
+                /* 帧尾之前丢失至少一个字节 */
+                stream_frame(data, len, 0);
+                rx_len -= (uint32_t)rand() % (rx_len - start - 2) + 2;
+                rx_stream[rx_len++] = UART_FRAME_DELIM;
+                ++bad;
+                break;
+
+            case 3:
+                /* 帧之间的杂散字节, 以帧尾结束 */
+                for (uint32_t i = (uint32_t)rand() % 8 + 1; i != 0; --i) {
+                    rx_stream[rx_len++] = (uint8_t)(rand() % 255 + 1);
+                }
+                rx_stream[rx_len++] = UART_FRAME_DELIM;
+                ++bad;
+                break;
+
+            case 4:
+                /* 连续的帧尾(空帧)被忽略 */
+                rx_stream[rx_len++] = UART_FRAME_DELIM;
+                stream_frame(data, len, 1);
+                break;
+
+            default:
+                stream_frame(data, len, 1);
+                break;
+        }
+    }
+
+    for (uint32_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); ++i) {
+        receive_all(chunks[i], &stats);
+        /* 损坏的帧按CRC或解码错误丢弃, 可能恰好成为合法帧的概率可以忽略 */
+        CHECK(stats.crc_errors + stats.decode_errors + stats.overflows == bad);
+        CHECK(stats.dropped == 0);
+    }
+
+    printf("corruption: %u good, %u bad, %u crc, %u decode\n",
+           (unsigned int)expect_num, (unsigned int)bad,
+           (unsigned int)stats.crc_errors, (unsigned int)stats.decode_errors);
+}
+
+int main(void) {
+    srand(1);
+
+    test_roundtrip();
+    test_decode_errors();
+    test_find_delim();
+    test_send_wrap();
+    test_max_len();
+    test_corruption();
+
+    printf("uart_frame_test: pass\n");
+    return 0;
+}
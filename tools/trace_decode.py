@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+"""
+trace_decode.py - 还原trace_log输出的二进制日志
+
+每条记录封装为 | 0x00 | COBS(记录 + CRC16) | 0x00 |, 与printf文本混合在
+同一个串口上. 按0x00分段, 解码和校验通过的段还原为日志, 其余段原样输出.
+
+用法:
+    python trace_decode.py firmware.elf < capture.bin
+    python trace_decode.py firmware.elf capture.bin
+
+依赖: pip install pyelftools
+"""
+
+import re
+import struct
+import sys
+
+from elftools.elf.elffile import ELFFile
+
+TRACE_MAGIC = 0xA5
+TRACE_MAX_ARGS = 8
+FRAME_DELIM = b"\0"
+
+FMT_RE = re.compile(r"%([-+ #0]*)(\d+|\*)?(?:\.(\d+))?(hh|h|ll|l|z|j|t)?([diuxXoscpf%])")
+
+
+class Strings:
+    """从ELF的只读段中读取字符串"""
+
+    def __init__(self, elf_path):
+        self.segments = []
+        with open(elf_path, "rb") as f:
+            elf = ELFFile(f)
+            for sec in elf.iter_sections():
+                if sec["sh_addr"] and sec["sh_type"] == "SHT_PROGBITS":
+                    self.segments.append((sec["sh_addr"], sec.data()))
+
+    def read(self, addr):
+        for base, data in self.segments:
+            if base <= addr < base + len(data):
+                end = data.find(b"\0", addr - base)
+                return data[addr - base:end].decode("utf-8", "replace")
+        return None
+
+
+def format_record(strings, fmt, args):
+    args = list(args)
+
+    def sub(m):
+        flags, width, prec, _, conv = m.groups()
+        if conv == "%":
+            return "%"
+        value = args.pop(0) if args else 0
+        if conv == "s":
+            text = strings.read(value)
+            value = text if text is not None else "<0x%08X>" % value
+        elif conv in "di":
+            value = struct.unpack("<i", struct.pack("<I", value))[0]
+        elif conv == "p":
+            conv, value = "x", value
+        elif conv == "f":
+            conv = "s"
+            value = "<float>"
+        spec = "%" + flags + (width or "") + ("." + prec if prec else "") + conv
+        return spec % value
+
+    return FMT_RE.sub(sub, fmt)
+
+
+def cobs_decode(data):
+    """COBS解码, 编码错误时返回None"""
+    out = bytearray()
+    pos = 0
+    while pos < len(data):
+        code = data[pos]
+        if code == 0 or pos + code > len(data):
+            return None
+        out += data[pos + 1:pos + code]
+        pos += code
+        if code != 0xFF and pos < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE"""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def parse_record(strings, frame):
+    """解码一帧, 不是日志记录时返回None"""
+    data = cobs_decode(frame)
+    if data is None or len(data) < 12:
+        return None
+    if len(data) % 4 == 2:
+        # 带CRC16, 高字节在前
+        if crc16(data[:-2]) != (data[-2] << 8 | data[-1]):
+            return None
+        data = data[:-2]
+
+    hdr, tick, fmt_addr = struct.unpack_from("<III", data)
+    nargs = (hdr >> 8) & 0xFF
+    if ((hdr & 0xFF) != TRACE_MAGIC or nargs > TRACE_MAX_ARGS
+            or len(data) != 12 + nargs * 4):
+        return None
+    fmt = strings.read(fmt_addr)
+    if fmt is None:
+        return None
+
+    args = struct.unpack_from("<%dI" % nargs, data, 12)
+    return hdr >> 16, tick, fmt, args
+
+
+def decode(strings, data, out):
+    expect_seq = None
+    for chunk in data.split(FRAME_DELIM):
+        if not chunk:
+            continue
+        record = parse_record(strings, chunk)
+        if record is None:
+            # printf等输出的文本
+            out.write(chunk.decode("utf-8", "replace").replace("\r\n", "\n"))
+            continue
+
+        seq, tick, fmt, args = record
+        if expect_seq is not None and seq != expect_seq:
+            out.write("[lost %d records]\n" % ((seq - expect_seq) & 0xFFFF))
+        expect_seq = (seq + 1) & 0xFFFF
+
+        text = format_record(strings, fmt, args)
+        out.write("[%10u] %s" % (tick, text.replace("\r\n", "\n")))
+        if not text.endswith("\n"):
+            out.write("\n")
+
+
+def main():
+    if len(sys.argv) < 2:
+        print(__doc__)
+        return 1
+    strings = Strings(sys.argv[1])
+    if len(sys.argv) > 2:
+        with open(sys.argv[2], "rb") as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+    decode(strings, data, sys.stdout)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())